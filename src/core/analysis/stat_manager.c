@@ -37,6 +37,7 @@
 
 #include "core/analysis/analysis.h"
 #include "core/constants.h"
+#include "core/db/db_shard.h"
 #include "core/misc.h"
 #include "core/types/gamesman_types.h"
 #include "libs/lz4_utils/lz4_utils.h"
@@ -167,7 +168,8 @@ int StatManagerSaveDiscoveryMap(const BitStream *stream, Tier tier) {
     if (filename == NULL) return kMallocFailureError;
 
     int64_t res =
-        Lz4UtilsCompressStream(stream->stream, stream->num_bytes, 0, filename);
+        Lz4UtilsParallelCompressStream(stream->stream, stream->num_bytes, 0,
+                                       filename);
     free(filename);
     switch (res) {
         case -1:
@@ -198,11 +200,16 @@ int StatManagerRemoveDiscoveryMap(Tier tier) {
 
 static char *SetupStatPath(ReadOnlyString game_name, int variant,
                            ReadOnlyString data_path) {
-    // path = "<data_path>/<game_name>/<variant>/analysis/"
+    // path = "<data_path>/<game_name>/<variant>/analysis/", where data_path
+    // is the primary data path if multiple data paths are listed.
     if (data_path == NULL) data_path = "data";
     static ConstantReadOnlyString kAnalysisDirName = "analysis";
     char *path = NULL;
 
+    DbShardMap roots;
+    if (DbShardMapInit(&roots, data_path, NULL) != kNoError) return NULL;
+    data_path = DbShardMapGetPrimaryPath(&roots);
+
     int path_length = (int)strlen(data_path) + 1;  // +1 for '/'.
     path_length += (int)strlen(game_name) + 1;
     path_length += kInt32Base10StringLengthMax + 1;
@@ -210,10 +217,12 @@ static char *SetupStatPath(ReadOnlyString game_name, int variant,
     path = (char *)calloc((path_length + 1), sizeof(char));
     if (path == NULL) {
         fprintf(stderr, "SetupStatPath: failed to calloc path.\n");
+        DbShardMapDestroy(&roots);
         return NULL;
     }
     int actual_length = snprintf(path, path_length, "%s/%s/%d/%s/", data_path,
                                  game_name, variant, kAnalysisDirName);
+    DbShardMapDestroy(&roots);
     if (actual_length >= path_length) {
         fprintf(stderr,
                 "SetupStatPath: (BUG) not enough space was allocated for "
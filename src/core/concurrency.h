@@ -42,6 +42,9 @@
 
 #define PRAGMA_OMP_PARALLEL_FOR PRAGMA(omp parallel for)
 #define PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_DYNAMIC(k) PRAGMA(omp parallel for schedule(dynamic, k))
+#define PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_STATIC PRAGMA(omp parallel for schedule(static))
+#define PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_STATIC_IF(cond) PRAGMA(omp parallel for schedule(static) if(cond))
+#define PRAGMA_OMP_PARALLEL_FOR_REDUCTION_MAX(var) PRAGMA(omp parallel for reduction(max: var))
 
 #define PRAGMA_OMP_CRITICAL(name) PRAGMA(omp critical(name))
 
@@ -57,6 +60,9 @@ typedef atomic_int ConcurrentInt;
 
 #define PRAGMA_OMP_PARALLEL_FOR
 #define PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_DYNAMIC(k)
+#define PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_STATIC
+#define PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_STATIC_IF(cond)
+#define PRAGMA_OMP_PARALLEL_FOR_REDUCTION_MAX(var)
 
 #define PRAGMA_OMP_CRITICAL(name)
 
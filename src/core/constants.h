@@ -70,6 +70,8 @@ enum CommonConstants {
 enum GamesmanConstants {
     /** Illegal remoteness which can be returned as an error. */
     kErrorRemoteness = -1,
+    /** Remoteness returned by databases that only store values. */
+    kUnknownRemoteness = -2,
     /** Illegal variant which can be returned as an error. */
     kIllegalVariantIndex = -1,
 };
@@ -30,14 +30,15 @@
 #include <stddef.h>   // NULL
 #include <stdint.h>   // uint8_t, int64_t
 #include <stdio.h>    // fprintf, stderr
-#include <stdlib.h>   // calloc, free
 #include <string.h>   // memset
 
+#include "core/large_alloc.h"
+
 int BitStreamInit(BitStream *stream, int64_t size) {
     stream->num_bytes = (size + 7) / 8;  // Round up division.
-    stream->stream = (uint8_t *)calloc(stream->num_bytes, sizeof(uint8_t));
+    stream->stream = (uint8_t *)LargeCalloc(stream->num_bytes);
     if (stream->stream == NULL) {
-        fprintf(stderr, "BitStreamInit: failed to calloc stream\n");
+        fprintf(stderr, "BitStreamInit: failed to allocate stream\n");
         return 1;
     }
 
@@ -48,7 +49,7 @@ int BitStreamInit(BitStream *stream, int64_t size) {
 }
 
 void BitStreamDestroy(BitStream *stream) {
-    free(stream->stream);
+    LargeFree(stream->stream, stream->num_bytes);
     memset(stream, 0, sizeof(*stream));
 }
 
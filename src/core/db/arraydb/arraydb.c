@@ -5,8 +5,12 @@
  *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
  * @brief Simple array database which stores value-remoteness pairs in a 16-bit
  * record array.
- * @details The in-memory database is an uncompressed 16-bit record array of
- * length equal to the size of the given tier. The array is block-compressed
+ * @details The in-memory database is an uncompressed record array of length
+ * equal to the size of the given tier. Solving tiers start with 8-bit records
+ * and are widened into 16-bit records once a remoteness larger than 31 is set.
+ * Both widths, as well as the 3-bit value-only format, are stored on disk as
+ * is and can be loaded and probed regardless of the current options. The array
+ * is block-compressed
  * using LZMA provided by the XZ Utils library wrapped in the XZRA (XZ with
  * random access) library.
  * @version 1.1.1
@@ -34,21 +38,29 @@
 #include <assert.h>   // assert
 #include <stdbool.h>  // bool, true, false
 #include <stddef.h>   // NULL, size_t
-#include <stdint.h>   // intptr_t, uint64_t, int64_t
+#include <stdint.h>   // intptr_t, uint8_t, uint64_t, int64_t
 #include <stdio.h>    // fprintf, stderr
 #include <stdlib.h>   // malloc, calloc, free
-#include <string.h>   // strcpy
+#include <string.h>   // strcpy, strcat
 
 #ifdef _OPENMP
 #include <omp.h>
 #endif  // _OPENMP
 
+#include "core/concurrency.h"
 #include "core/constants.h"
+#include "core/db/arraydb/compressed_record_array.h"
 #include "core/db/arraydb/record.h"
 #include "core/db/arraydb/record_array.h"
+#include "core/db/db_block_cache.h"
+#include "core/db/db_file_pool.h"
+#include "core/db/db_probe_batch.h"
+#include "core/db/db_shard.h"
+#include "core/db/db_tier_summary.h"
 #include "core/misc.h"
 #include "core/types/gamesman_types.h"
 #include "libs/lz4_utils/lz4_utils.h"
+#include "libs/lz4ra/lz4ra.h"
 #include "libs/xzra/xzra.h"
 
 // DB API
@@ -61,10 +73,12 @@ static void ArrayDbFinalize(void);
 static int ArrayDbCreateSolvingTier(Tier tier, int64_t size);
 static int ArrayDbFlushSolvingTier(void *aux);
 static int ArrayDbFreeSolvingTier(void);
+static int ArrayDbConvertTier(Tier tier, int64_t size);
 
 static int ArrayDbSetGameSolved(void);
 static int ArrayDbSetValue(Position position, Value value);
 static int ArrayDbSetRemoteness(Position position, int remoteness);
+static int ArrayDbReserveRemoteness(int remoteness);
 static Value ArrayDbGetValue(Position position);
 static int ArrayDbGetRemoteness(Position position);
 static bool ArrayDbCheckpointExists(Tier tier);
@@ -76,16 +90,23 @@ static int ArrayDbCheckpointRemove(Tier tier);
 static intptr_t ArrayDbTierMemUsage(Tier tier, int64_t size);
 static int ArrayDbLoadTier(Tier tier, int64_t size);
 static int ArrayDbUnloadTier(Tier tier);
+static intptr_t ArrayDbLoadedTierMemUsage(Tier tier, int64_t size);
 static bool ArrayDbIsTierLoaded(Tier tier);
 static Value ArrayDbGetValueFromLoaded(Tier tier, Position position);
 static int ArrayDbGetRemotenessFromLoaded(Tier tier, Position position);
+static int ArrayDbGetLoadedTierHandle(Tier tier, DbTierHandle *handle);
 
 static int ArrayDbProbeInit(DbProbe *probe);
 static int ArrayDbProbeDestroy(DbProbe *probe);
 static Value ArrayDbProbeValue(DbProbe *probe, TierPosition tier_position);
 static int ArrayDbProbeRemoteness(DbProbe *probe, TierPosition tier_position);
+static int ArrayDbProbeRecordsBatch(DbProbe *probe, int64_t size,
+                                    const TierPosition *tier_positions,
+                                    Value *values, int *remotenesses);
 static int ArrayDbTierStatus(Tier tier);
 static int ArrayDbGameStatus(void);
+static int ArrayDbGetTierSummary(Tier tier, int64_t size,
+                                 DbTierSummary *summary);
 
 const Database kArrayDb = {
     .name = "arraydb",
@@ -98,10 +119,12 @@ const Database kArrayDb = {
     .CreateSolvingTier = ArrayDbCreateSolvingTier,
     .FlushSolvingTier = ArrayDbFlushSolvingTier,
     .FreeSolvingTier = ArrayDbFreeSolvingTier,
+    .ConvertTier = ArrayDbConvertTier,
 
     .SetGameSolved = ArrayDbSetGameSolved,
     .SetValue = ArrayDbSetValue,
     .SetRemoteness = ArrayDbSetRemoteness,
+    .ReserveRemoteness = ArrayDbReserveRemoteness,
     .GetValue = ArrayDbGetValue,
     .GetRemoteness = ArrayDbGetRemoteness,
     .CheckpointExists = ArrayDbCheckpointExists,
@@ -110,11 +133,13 @@ const Database kArrayDb = {
 
     // Loading
     .TierMemUsage = ArrayDbTierMemUsage,
+    .LoadedTierMemUsage = ArrayDbLoadedTierMemUsage,
     .LoadTier = ArrayDbLoadTier,
     .UnloadTier = ArrayDbUnloadTier,
     .IsTierLoaded = ArrayDbIsTierLoaded,
     .GetValueFromLoaded = ArrayDbGetValueFromLoaded,
     .GetRemotenessFromLoaded = ArrayDbGetRemotenessFromLoaded,
+    .GetLoadedTierHandle = ArrayDbGetLoadedTierHandle,
     .CheckpointRemove = ArrayDbCheckpointRemove,
 
     // Probing
@@ -122,15 +147,46 @@ const Database kArrayDb = {
     .ProbeDestroy = ArrayDbProbeDestroy,
     .ProbeValue = ArrayDbProbeValue,
     .ProbeRemoteness = ArrayDbProbeRemoteness,
+    .ProbeRecordsBatch = ArrayDbProbeRecordsBatch,
     .TierStatus = ArrayDbTierStatus,
     .GameStatus = ArrayDbGameStatus,
+    .GetTierSummary = ArrayDbGetTierSummary,
 };
 
 // Types
 
+// Tier file opened for random access in either supported container.
 typedef struct {
-    XzraFile *file;
-    bool init;
+    XzraFile *xz;    // Non-NULL if the tier is stored in an .adb.xz file.
+    Lz4raFile *lz4;  // Non-NULL if the tier is stored in an .adb.lz4 file.
+} AdbFile;
+
+// Block of a tier file acquired from the process-wide block cache and kept by
+// a probe.
+typedef struct {
+    Tier tier;           // Tier of the block, or kIllegalTier if unused.
+    int format;          // RecordArrayFormat of the tier file.
+    XzraBlockInfo info;  // Location of the block in the tier file.
+
+    // Decompressed block.
+    const DbCachedBlock *cached;
+
+    // Value of the probe clock at the most recent access.
+    int64_t last_used;
+} AdbProbeBlock;
+
+typedef struct {
+    // Pooled AdbFile of probe->tier, or NULL if none is acquired.
+    const DbPooledFile *file;
+    int format;  // RecordArrayFormat of the file being probed.
+
+    // Least-recently-used set of blocks shared by all tiers, backed by the
+    // process-wide block cache.
+    AdbProbeBlock *blocks;
+    int num_blocks;
+    int64_t clock;
+    int64_t hits;
+    int64_t misses;
 } AdbProbeInternal;
 
 // Constants
@@ -138,28 +194,66 @@ typedef struct {
 enum { kArrayDbNumLoadedTiersMax = 256 };
 const int kArrayDbRecordSize = sizeof(Record);
 const ArrayDbOptions kArrayDbOptionsInit = {
-    .block_size = 1 << 20,         // 1 MiB.
-    .compression_level = 6,        // LZMA level 6.
-    .extreme_compression = false,  // Extreme compression disabled.
+    .block_size = 1 << 20,          // 1 MiB.
+    .compression_level = 6,         // LZMA level 6.
+    .extreme_compression = false,   // Extreme compression disabled.
+    .value_only = false,            // Store remotenesses.
+    .probe_cache_blocks = 8,        // 8 cached blocks per probe.
+    .lz4_compression = false,       // Store tiers as XZ.
+    .lz4_block_size = 64 << 10,     // 64 KiB.
+    .status_scan = false,           // Check each tier file on disk.
+    .summary = false,               // No tier summaries.
+    .out_of_core_dir = NULL,        // Keep all records in memory.
+    .out_of_core_budget = 1 << 30,  // 1 GiB.
+    .compressed_loading = false,    // Decompress loaded tiers.
+    .loaded_block_size = 4 << 10,   // 4 KiB.
 };
-static const int kDefaultLz4Level = 0;  //
+static const int kLz4BlockSizeMin = 4 << 10;  // 4 KiB.
+static const int kDefaultLz4Level = 0;        // Default (fast) LZ4 frame level.
+static const int kLoadedBlockSizeMin = 1 << 10;  // 1 KiB.
+static const int kLoadedBlockSizeMax = 1 << 20;  // 1 MiB.
 
 // Global options
 
 static int block_size;  // For XZ compression.
 static int lzma_level;
 static bool enable_extreme_compression;
+static bool value_only;  // Format of new solving tiers.
+static int probe_cache_blocks;
+static bool lz4_compression;  // Container of new tier files.
+static int lz4_block_size;
+static bool status_scan;       // Whether tier statuses use directory listings.
+static bool write_summary;     // Whether flushed tiers are summarized.
+static char *out_of_core_dir;  // Directory of file-backed record arrays.
+static int64_t out_of_core_budget;  // Largest record array kept in memory.
+static bool compressed_loading;     // Whether loaded tiers stay compressed.
+static int loaded_block_size;
+
+// Tiers written since initialization. Only maintained if status_scan is set,
+// in which case the tiers missing from the directory listings are looked up
+// here.
+static TierHashSet written_tiers;
 
 // Global state variables
 
 static char current_game_name[kGameNameLengthMax + 1];
 static int current_variant;
 static GetTierNameFunc CurrentGetTierName;
-static char *sandbox_path;
+static DbShardMap shards;     // Directories that store the tier files.
+static int64_t cache_source;  // Source ID in the process-wide block cache.
 static Tier current_tier;
 static TierHashMapSC loaded_tier_to_index;
 static RecordArray loaded_records[kArrayDbNumLoadedTiersMax];
 
+// Loaded tiers kept compressed, indexed in the same way as loaded_records.
+// Each loaded tier is stored in exactly one of the two arrays.
+static CompressedRecordArray loaded_compressed[kArrayDbNumLoadedTiersMax];
+
+// Caches of decompressed blocks of loaded_compressed, one for each thread.
+// Allocated when the first compressed tier is loaded.
+static CompressedRecordArrayCache *loaded_caches;
+static int num_loaded_caches;
+
 static int ArrayDbInit(ReadOnlyString game_name, int variant,
                        ReadOnlyString path, GetTierNameFunc GetTierName,
                        void *aux) {
@@ -168,32 +262,93 @@ static int ArrayDbInit(ReadOnlyString game_name, int variant,
     block_size = options->block_size;
     lzma_level = options->compression_level;
     enable_extreme_compression = options->extreme_compression;
+    value_only = options->value_only;
+    probe_cache_blocks = options->probe_cache_blocks;
+    if (probe_cache_blocks < 1) probe_cache_blocks = 1;
+    lz4_compression = options->lz4_compression;
+    lz4_block_size = options->lz4_block_size;
+    if (lz4_block_size < kLz4BlockSizeMin) lz4_block_size = kLz4BlockSizeMin;
+    status_scan = options->status_scan;
+    write_summary = options->summary;
+    out_of_core_budget = options->out_of_core_budget;
+    assert(out_of_core_dir == NULL);
+    if (options->out_of_core_dir != NULL) {
+        out_of_core_dir = (char *)malloc(strlen(options->out_of_core_dir) + 1);
+        if (out_of_core_dir == NULL) return kMallocFailureError;
+        strcpy(out_of_core_dir, options->out_of_core_dir);
+    }
+    compressed_loading = options->compressed_loading;
+    loaded_block_size = options->loaded_block_size;
+    if (loaded_block_size < kLoadedBlockSizeMin) {
+        loaded_block_size = kLoadedBlockSizeMin;
+    } else if (loaded_block_size > kLoadedBlockSizeMax) {
+        loaded_block_size = kLoadedBlockSizeMax;
+    }
 
-    assert(sandbox_path == NULL);
-    sandbox_path = (char *)malloc((strlen(path) + 1) * sizeof(char));
-    if (sandbox_path == NULL) {
-        fprintf(stderr, "ArrayDbInit: failed to malloc path.\n");
-        return kMallocFailureError;
+    cache_source = DbBlockCacheNewSource();
+
+    assert(shards.paths == NULL);
+    int error = DbShardMapInit(&shards, path, NULL);
+    if (error != kNoError) {
+        fprintf(stderr, "ArrayDbInit: failed to parse path.\n");
+        return error;
     }
 
-    strcpy(sandbox_path, path);
     strcpy(current_game_name, game_name);
     current_variant = variant;
     CurrentGetTierName = GetTierName;
     current_tier = kIllegalTier;
     TierHashMapSCInit(&loaded_tier_to_index, 0.5);
     memset(&loaded_records, 0, sizeof(loaded_records));
+    memset(&loaded_compressed, 0, sizeof(loaded_compressed));
+    TierHashSetInit(&written_tiers, 0.5);
 
     return kNoError;
 }
 
 static void ArrayDbFinalize(void) {
-    free(sandbox_path);
-    sandbox_path = NULL;
+    DbShardMapDestroy(&shards);
+    TierHashSetDestroy(&written_tiers);
     TierHashMapSCDestroy(&loaded_tier_to_index);
     for (int i = 0; i < kArrayDbNumLoadedTiersMax; ++i) {
         RecordArrayDestroy(&loaded_records[i]);
+        CompressedRecordArrayDestroy(&loaded_compressed[i]);
+    }
+    for (int i = 0; i < num_loaded_caches; ++i) {
+        CompressedRecordArrayCacheDestroy(&loaded_caches[i]);
     }
+    free(loaded_caches);
+    loaded_caches = NULL;
+    num_loaded_caches = 0;
+    free(out_of_core_dir);
+    out_of_core_dir = NULL;
+}
+
+// Returns the directory in which a record array of RAW_SIZE bytes should be
+// backed by a file, or NULL if it should be kept in memory.
+static const char *GetBackingDir(int64_t raw_size) {
+    if (out_of_core_dir == NULL || raw_size <= out_of_core_budget) return NULL;
+
+    return out_of_core_dir;
+}
+
+static int InitSolvingRecords(int64_t size) {
+    int format =
+        value_only ? kRecordArrayFormatValueOnly : kRecordArrayFormatNarrow;
+
+    // Leave room for widening, which doubles the size of narrow arrays.
+    int64_t raw_size =
+        value_only ? RecordArrayGetFormatRawSize(format, size)
+                   : RecordArrayGetFormatRawSize(kRecordArrayFormatWide, size);
+    const char *dir = GetBackingDir(raw_size);
+    int error =
+        RecordArrayInitFormatFileBacked(&loaded_records[0], size, format, dir);
+    if (error != kNoError) return error;
+
+    // Solvers set the records of parent positions in no particular order.
+    RecordArrayAdvise(&loaded_records[0], kLargeAccessRandom);
+
+    return kNoError;
 }
 
 static int ArrayDbCreateSolvingTier(Tier tier, int64_t size) {
@@ -205,7 +360,7 @@ static int ArrayDbCreateSolvingTier(Tier tier, int64_t size) {
     }
 
     // Initialize the 0-th loaded record as the solving tier's record array.
-    int error = RecordArrayInit(&loaded_records[0], size);
+    int error = InitSolvingRecords(size);
     if (error != kNoError) return error;
 
     // Add the solving tier's index to the map.
@@ -219,18 +374,20 @@ static int ArrayDbCreateSolvingTier(Tier tier, int64_t size) {
 }
 
 /**
- * @brief Returns the full path to the DB file for the given tier. The user is
- * responsible for freeing the pointer returned by this function. Returns
- * NULL on failure.
+ * @brief Returns the full path to the DB file for the given tier with the
+ * given EXTENSION. The user is responsible for freeing the pointer returned by
+ * this function. Returns NULL on failure.
  */
-static char *GetFullPathToFile(Tier tier, GetTierNameFunc GetTierName) {
+static char *GetFullPathWithExtension(Tier tier, GetTierNameFunc GetTierName,
+                                      ReadOnlyString extension) {
     // Full path: "<path>/<file_name><ext>", +2 for '/' and '\0'.
-    static const char extension[] = ".adb.xz";
+    ReadOnlyString sandbox_path = DbShardMapGetPath(&shards, tier);
     char *full_path = (char *)calloc(
-        (strlen(sandbox_path) + kDbFileNameLengthMax + sizeof(extension) + 2),
+        (strlen(sandbox_path) + kDbFileNameLengthMax + strlen(extension) + 2),
         sizeof(char));
     if (full_path == NULL) {
-        fprintf(stderr, "GetFullPathToFile: failed to calloc full_path.\n");
+        fprintf(stderr,
+                "GetFullPathWithExtension: failed to calloc full_path.\n");
         return NULL;
     }
 
@@ -245,6 +402,28 @@ static char *GetFullPathToFile(Tier tier, GetTierNameFunc GetTierName) {
     return full_path;
 }
 
+/**
+ * @brief Returns the full path to the XZ DB file for the given tier. The user
+ * is responsible for freeing the pointer returned by this function. Returns
+ * NULL on failure.
+ */
+static char *GetFullPathToFile(Tier tier, GetTierNameFunc GetTierName) {
+    return GetFullPathWithExtension(tier, GetTierName, ".adb.xz");
+}
+
+/**
+ * @brief Returns the full path to the LZ4 DB file for the given tier. The user
+ * is responsible for freeing the pointer returned by this function. Returns
+ * NULL on failure.
+ */
+static char *GetFullPathToLz4File(Tier tier, GetTierNameFunc GetTierName) {
+    return GetFullPathWithExtension(tier, GetTierName, ".adb.lz4");
+}
+
+static char *GetFullPathToSummary(Tier tier, GetTierNameFunc GetTierName) {
+    return GetFullPathWithExtension(tier, GetTierName, ".adb.sum");
+}
+
 static char *GetFullPathPlusExtension(Tier tier, GetTierNameFunc GetTierName,
                                       ReadOnlyString extension) {
     char *full_path_to_tier_file = GetFullPathToFile(tier, GetTierName);
@@ -278,6 +457,7 @@ static char *GetFullPathToTempCheckpoint(Tier tier,
 static char *GetFullPathToFinishFlag(void) {
     // Full path: "<path>/.finish", +2 for '/' and '\0'.
     static const char finish_flag_name[] = ".finish";
+    ReadOnlyString sandbox_path = DbShardMapGetPrimaryPath(&shards);
     char *full_path = (char *)calloc(
         (strlen(sandbox_path) + sizeof(finish_flag_name) + 2), sizeof(char));
     if (full_path == NULL) {
@@ -298,33 +478,57 @@ static int GetNumThreads(void) {
 #endif  // _OPENMP
 }
 
-static int ArrayDbFlushSolvingTier(void *aux) {
-    (void)aux;  // Unused.
+// Compresses RECORDS into the file at FULL_PATH in the container selected by
+// the current options. Returns kNoError on success or an error code otherwise.
+static int CompressTierFile(ReadOnlyString full_path, RecordArray *records) {
+    if (lz4_compression) {
+        int64_t compressed_size = Lz4raCompressStream(
+            full_path, lz4_block_size, kDefaultLz4Level, GetNumThreads(),
+            RecordArrayGetReadOnlyData(records),
+            RecordArrayGetRawSize(records));
+        switch (compressed_size) {
+            case -1:
+                return kIllegalArgumentError;
+            case -2:
+                return kMallocFailureError;
+            case -3:
+                return kFileSystemError;
+        }
+        return kNoError;
+    }
 
-    // Create db file.
+    int64_t compressed_size = XzraCompressStream(
+        full_path, false, block_size, lzma_level, enable_extreme_compression,
+        GetNumThreads(), RecordArrayGetData(records),
+        RecordArrayGetRawSize(records));
+    switch (compressed_size) {
+        case -2:
+            return kFileSystemError;
+        case -3:
+            return kRuntimeError;
+    }
+    return kNoError;
+}
+
+// Writes RECORDS as the DB file of TIER in the container selected by the
+// current options, and removes the file of TIER in the other container, which
+// would otherwise be stale.
+static int WriteTierFile(Tier tier, RecordArray *records) {
     int error = kNoError;
-    char *full_path = GetFullPathToFile(current_tier, CurrentGetTierName);
-    char *tmp_full_path =
-        GetFullPathToTempFile(current_tier, CurrentGetTierName);
-    if (full_path == NULL || tmp_full_path == NULL) {
+    char *xz_full_path = GetFullPathToFile(tier, CurrentGetTierName);
+    char *lz4_full_path = GetFullPathToLz4File(tier, CurrentGetTierName);
+    char *tmp_full_path = GetFullPathToTempFile(tier, CurrentGetTierName);
+    if (xz_full_path == NULL || lz4_full_path == NULL ||
+        tmp_full_path == NULL) {
         error = kMallocFailureError;
         goto _bailout;
     }
+    const char *full_path = lz4_compression ? lz4_full_path : xz_full_path;
+    const char *stale_path = lz4_compression ? xz_full_path : lz4_full_path;
 
     // First compress to a temp file.
-    int64_t compressed_size =
-        XzraCompressStream(tmp_full_path, false, block_size, lzma_level,
-                           enable_extreme_compression, GetNumThreads(),
-                           RecordArrayGetData(&loaded_records[0]),
-                           RecordArrayGetRawSize(&loaded_records[0]));
-    switch (compressed_size) {
-        case -2:
-            error = kFileSystemError;
-            goto _bailout;
-        case -3:
-            error = kRuntimeError;
-            goto _bailout;
-    }
+    error = CompressTierFile(tmp_full_path, records);
+    if (error != kNoError) goto _bailout;
 
     // If successful, rename the temp file into the desired tier DB name.
     int rename_error = GuardedRename(tmp_full_path, full_path);
@@ -332,14 +536,90 @@ static int ArrayDbFlushSolvingTier(void *aux) {
         error = kFileSystemError;
         goto _bailout;
     }
+    if (FileExists(stale_path) && GuardedRemove(stale_path) != 0) {
+        error = kFileSystemError;
+    }
+    DbBlockCacheInvalidate(cache_source, tier);
+    DbFilePoolInvalidate(cache_source, tier);
+
+    // The tier file now exists under its final name.
+    if (status_scan) {
+        bool success;
+        PRAGMA_OMP_CRITICAL(arraydb_written_tiers) {
+            success = TierHashSetAdd(&written_tiers, tier);
+        }
+        if (!success && error == kNoError) error = kMallocFailureError;
+    }
 
 _bailout:
-    free(full_path);
+    free(xz_full_path);
+    free(lz4_full_path);
     free(tmp_full_path);
 
     return error;
 }
 
+// Removes the summary file of TIER if it exists.
+static int RemoveTierSummary(Tier tier) {
+    char *full_path = GetFullPathToSummary(tier, CurrentGetTierName);
+    if (full_path == NULL) return kMallocFailureError;
+
+    int error = kNoError;
+    if (FileExists(full_path) && GuardedRemove(full_path) != 0) {
+        error = kFileSystemError;
+    }
+    free(full_path);
+
+    return error;
+}
+
+static void GetSolvingRecordAt(int64_t i, const void *aux, Value *value,
+                               int *remoteness) {
+    const RecordArray *records = (const RecordArray *)aux;
+    *value = RecordArrayGetValue(records, i);
+    *remoteness = RecordArrayGetRemoteness(records, i);
+}
+
+// Summarizes RECORDS of TIER into the summary file of TIER.
+static int WriteTierSummary(Tier tier, const RecordArray *records) {
+    char *full_path = GetFullPathToSummary(tier, CurrentGetTierName);
+    DbTierSummary *summary = (DbTierSummary *)malloc(sizeof(DbTierSummary));
+    int error = kMallocFailureError;
+    if (full_path != NULL && summary != NULL) {
+        error = DbTierSummaryBuild(summary, RecordArrayGetSize(records),
+                                   &GetSolvingRecordAt, records);
+    }
+    if (error == kNoError) error = DbTierSummaryWrite(summary, full_path);
+    free(full_path);
+    free(summary);
+
+    return error;
+}
+
+static int ArrayDbFlushSolvingTier(void *aux) {
+    (void)aux;  // Unused.
+
+    // The old summary must not outlive the old contents of the tier, even if
+    // the new summary cannot be written.
+    int error = RemoveTierSummary(current_tier);
+    if (error != kNoError) return error;
+
+    // The records are compressed and summarized in sequential passes.
+    RecordArrayAdvise(&loaded_records[0], kLargeAccessSequential);
+    error = WriteTierFile(current_tier, &loaded_records[0]);
+    if (error != kNoError || !write_summary) return error;
+
+    // Summaries are optional. Readers fall back to the records without one.
+    if (WriteTierSummary(current_tier, &loaded_records[0]) != kNoError) {
+        fprintf(stderr,
+                "ArrayDbFlushSolvingTier: failed to write the summary of tier "
+                "%" PRITier "\n",
+                current_tier);
+    }
+
+    return kNoError;
+}
+
 static int ArrayDbFreeSolvingTier(void) {
     RecordArrayDestroy(&loaded_records[0]);
     TierHashMapSCRemove(&loaded_tier_to_index, current_tier);
@@ -369,9 +649,11 @@ static int ArrayDbSetValue(Position position, Value value) {
 }
 
 static int ArrayDbSetRemoteness(Position position, int remoteness) {
-    RecordArraySetRemoteness(&loaded_records[0], position, remoteness);
+    return RecordArraySetRemoteness(&loaded_records[0], position, remoteness);
+}
 
-    return kNoError;
+static int ArrayDbReserveRemoteness(int remoteness) {
+    return RecordArrayReserveRemoteness(&loaded_records[0], remoteness);
 }
 
 static Value ArrayDbGetValue(Position position) {
@@ -391,7 +673,10 @@ bool ArrayDbCheckpointExists(Tier tier) {
 }
 
 int ArrayDbCheckpointSave(const void *status, size_t status_size) {
-    int error = kNoError;
+    // Checkpoints always store 16-bit records unless solving for values only.
+    int error = RecordArrayWiden(&loaded_records[0]);
+    if (error != kNoError) return error;
+
     char *full_path = GetFullPathToCheckpoint(current_tier, CurrentGetTierName);
     char *tmp_full_path =
         GetFullPathToTempCheckpoint(current_tier, CurrentGetTierName);
@@ -404,7 +689,7 @@ int ArrayDbCheckpointSave(const void *status, size_t status_size) {
                             status};
     const size_t input_sizes[] = {RecordArrayGetRawSize(&loaded_records[0]),
                                   status_size};
-    int64_t compressed_size = Lz4UtilsCompressStreams(
+    int64_t compressed_size = Lz4UtilsParallelCompressStreams(
         inputs, input_sizes, 2, kDefaultLz4Level, tmp_full_path);
     switch (compressed_size) {
         case -1:
@@ -442,7 +727,9 @@ int ArrayDbCheckpointLoad(Tier tier, int64_t size, void *status,
     }
 
     // Initialize the 0-th loaded record as the solving tier's record array.
-    int error = RecordArrayInit(&loaded_records[0], size);
+    int format =
+        value_only ? kRecordArrayFormatValueOnly : kRecordArrayFormatWide;
+    int error = RecordArrayInitFormat(&loaded_records[0], size, format);
     if (error != kNoError) return error;
 
     // Get full path to the checkpoint file.
@@ -485,57 +772,257 @@ static int ArrayDbCheckpointRemove(Tier tier) {
 
 static intptr_t ArrayDbTierMemUsage(Tier tier, int64_t size) {
     (void)tier;
-    return size * 2;
+    // Upper bound: the tier may have been stored with 16-bit records.
+    int64_t raw_size =
+        value_only
+            ? RecordArrayGetFormatRawSize(kRecordArrayFormatValueOnly, size)
+            : RecordArrayGetFormatRawSize(kRecordArrayFormatWide, size);
+
+    // Records backed by a file only take up the resident budget.
+    if (GetBackingDir(raw_size) != NULL) return (intptr_t)out_of_core_budget;
+
+    return (intptr_t)raw_size;
 }
 
 static int GetFirstUnusedRecordArrayIndex(void) {
     int i;  // The 0-th space is reserved for the solving tier.
     for (i = 1; i < kArrayDbNumLoadedTiersMax; ++i) {
-        if (loaded_records[i].records == NULL) break;
+        if (RecordArrayGetData(&loaded_records[i]) == NULL &&
+            loaded_compressed[i].groups == NULL) {
+            break;
+        }
     }
 
     return i;
 }
 
-static int ArrayDbLoadTier(Tier tier, int64_t size) {
-    // Find the first unused slot in the loaded records array.
-    int i = GetFirstUnusedRecordArrayIndex();
-    if (i == kArrayDbNumLoadedTiersMax) {
-        fprintf(stderr,
-                "ArrayDbLoadTier: cannot load more than %d tiers at the same "
-                "time\n",
-                kArrayDbNumLoadedTiersMax);
-        return kRuntimeError;
+// Opens the DB file of TIER for reading, preferring the LZ4 container if the
+// tier is stored in both. Returns NULL if neither file can be opened.
+static AdbFile *AdbFileOpen(Tier tier) {
+    AdbFile *file = (AdbFile *)calloc(1, sizeof(AdbFile));
+    if (file == NULL) return NULL;
+
+    char *full_path = GetFullPathToLz4File(tier, CurrentGetTierName);
+    if (full_path == NULL) {
+        free(file);
+        return NULL;
     }
 
-    int error = RecordArrayInit(&loaded_records[i], size);
-    if (error != kNoError) return kMallocFailureError;
+    if (FileExists(full_path)) {
+        file->lz4 = Lz4raFileOpen(full_path);
+    } else {
+        free(full_path);
+        full_path = GetFullPathToFile(tier, CurrentGetTierName);
+        if (full_path != NULL) file->xz = XzraFileOpen(full_path);
+    }
+    free(full_path);
+    if (file->xz == NULL && file->lz4 == NULL) {
+        free(file);
+        return NULL;
+    }
 
-    char *full_path = GetFullPathToFile(tier, CurrentGetTierName);
-    if (full_path == NULL) {
-        RecordArrayDestroy(&loaded_records[i]);
-        return kMallocFailureError;
+    return file;
+}
+
+static void AdbFileClose(AdbFile *file) {
+    if (file == NULL) return;
+    XzraFileClose(file->xz);
+    Lz4raFileClose(file->lz4);
+    free(file);
+}
+
+// Same as XzraFileLocateBlock, but works for both containers.
+static int AdbFileLocateBlock(AdbFile *file, int64_t offset,
+                              XzraBlockInfo *info) {
+    if (file->xz != NULL) return XzraFileLocateBlock(file->xz, offset, info);
+
+    Lz4raBlockInfo lz4_info;
+    if (Lz4raFileLocateBlock(file->lz4, offset, &lz4_info) != 0) return -1;
+    info->number = lz4_info.number;
+    info->uncompressed_offset = lz4_info.uncompressed_offset;
+    info->uncompressed_size = lz4_info.uncompressed_size;
+
+    return 0;
+}
+
+// Same as XzraFileDecodeBlock, but works for both containers.
+static int AdbFileDecodeBlock(void *dest, AdbFile *file,
+                              const XzraBlockInfo *info) {
+    if (file->xz != NULL) return XzraFileDecodeBlock(dest, file->xz, info);
+
+    Lz4raBlockInfo lz4_info = {
+        .number = info->number,
+        .uncompressed_offset = info->uncompressed_offset,
+        .uncompressed_size = info->uncompressed_size,
+    };
+    return Lz4raFileDecodeBlock(dest, file->lz4, &lz4_info);
+}
+
+// Returns the RecordArrayFormat of FILE, or -1 if the file cannot be read or
+// is in an unsupported format.
+static int GetFileFormat(AdbFile *file) {
+    if (file->xz != NULL) {
+        RecordArrayHeader header;
+        size_t bytes_read = XzraFileRead(&header, sizeof(header), file->xz);
+        return RecordArrayGetFormatFromPrefix(&header, bytes_read);
+    }
+
+    // The header is at the beginning of the first block.
+    XzraBlockInfo info;
+    if (AdbFileLocateBlock(file, 0, &info) != 0) return -1;
+    void *block = malloc(info.uncompressed_size);
+    int format = -1;
+    if (block != NULL && AdbFileDecodeBlock(block, file, &info) == 0) {
+        format = RecordArrayGetFormatFromPrefix(block,
+                                                (size_t)info.uncompressed_size);
+    }
+    free(block);
+
+    return format;
+}
+
+// Decompresses FILE, which is the DB file of TIER, into RECORDS using all
+// available threads. Returns the number of bytes decompressed or a negative
+// value on failure.
+static int64_t DecompressTierFile(AdbFile *file, Tier tier,
+                                  RecordArray *records) {
+    if (file->lz4 != NULL) {
+        return Lz4raFileDecompress(RecordArrayGetData(records),
+                                   RecordArrayGetRawSize(records),
+                                   GetNumThreads(), file->lz4);
     }
 
+    char *full_path = GetFullPathToFile(tier, CurrentGetTierName);
+    if (full_path == NULL) return -1;
+
     uint64_t mem = XzraDecompressionMemUsage(
         block_size, lzma_level, enable_extreme_compression, GetNumThreads());
-    int64_t decomp_size = XzraDecompressFile(
-        RecordArrayGetData(&loaded_records[i]), size * kArrayDbRecordSize,
-        GetNumThreads(), mem, full_path);
+    int64_t decomp_size = XzraDecompressFile(RecordArrayGetData(records),
+                                             RecordArrayGetRawSize(records),
+                                             GetNumThreads(), mem, full_path);
     free(full_path);
+
+    return decomp_size;
+}
+
+// Loads the DB file of TIER of SIZE positions into RECORDS, which is
+// initialized in the format of the file.
+static int ReadTierFile(Tier tier, int64_t size, RecordArray *records) {
+    AdbFile *file = AdbFileOpen(tier);
+    if (file == NULL) return kFileSystemError;
+
+    // The format of the tier file may be different from the format of new
+    // solving tiers.
+    int format = GetFileFormat(file);
+    int error = kRuntimeError;
+    if (format >= 0) {
+        const char *dir =
+            GetBackingDir(RecordArrayGetFormatRawSize(format, size));
+        error = RecordArrayInitFormatFileBacked(records, size, format, dir);
+    }
+    if (error != kNoError) {
+        AdbFileClose(file);
+        return error;
+    }
+
+    int64_t decomp_size = DecompressTierFile(file, tier, records);
+    AdbFileClose(file);
     if (decomp_size < 0) {
-        RecordArrayDestroy(&loaded_records[i]);
+        RecordArrayDestroy(records);
+        return kRuntimeError;
+    }
+
+    // Loaded tiers are probed in no particular order.
+    RecordArrayAdvise(records, kLargeAccessRandom);
+
+    return kNoError;
+}
+
+// Allocates one cache of decompressed blocks for each thread if not already
+// allocated.
+static int InitLoadedCaches(void) {
+    if (loaded_caches != NULL) return kNoError;
+
+    int num_threads = GetNumThreads();
+    loaded_caches = (CompressedRecordArrayCache *)calloc(
+        num_threads, sizeof(CompressedRecordArrayCache));
+    if (loaded_caches == NULL) return kMallocFailureError;
+
+    for (num_loaded_caches = 0; num_loaded_caches < num_threads;
+         ++num_loaded_caches) {
+        int error = CompressedRecordArrayCacheInit(
+            &loaded_caches[num_loaded_caches], loaded_block_size);
+        if (error != kNoError) return error;
+    }
+
+    return kNoError;
+}
+
+// Loads the DB file of TIER of SIZE positions into loaded_compressed[INDEX].
+// The tier is decompressed into a temporary record array first.
+static int ReadTierCompressed(Tier tier, int64_t size, int index) {
+    int error = InitLoadedCaches();
+    if (error != kNoError) return error;
+
+    RecordArray records;
+    error = ReadTierFile(tier, size, &records);
+    if (error != kNoError) return error;
+
+    RecordArrayAdvise(&records, kLargeAccessSequential);
+    error = CompressedRecordArrayInit(&loaded_compressed[index], &records,
+                                      loaded_block_size);
+    RecordArrayDestroy(&records);
+
+    return error;
+}
+
+static int ArrayDbLoadTier(Tier tier, int64_t size) {
+    // Find the first unused slot in the loaded records array.
+    int i = GetFirstUnusedRecordArrayIndex();
+    if (i == kArrayDbNumLoadedTiersMax) {
+        fprintf(stderr,
+                "ArrayDbLoadTier: cannot load more than %d tiers at the same "
+                "time\n",
+                kArrayDbNumLoadedTiersMax);
         return kRuntimeError;
     }
 
+    int error = compressed_loading
+                    ? ReadTierCompressed(tier, size, i)
+                    : ReadTierFile(tier, size, &loaded_records[i]);
+    if (error != kNoError) return error;
+
     if (!TierHashMapSCSet(&loaded_tier_to_index, tier, i)) {
         RecordArrayDestroy(&loaded_records[i]);
+        CompressedRecordArrayDestroy(&loaded_compressed[i]);
         return kMallocFailureError;
     }
 
     return kNoError;
 }
 
+// Rewrites the file of TIER in the container selected by the current options,
+// e.g., converts an existing .adb.xz file into an .adb.lz4 file if LZ4
+// compression is enabled. The file in the old container is removed on success.
+static int ArrayDbConvertTier(Tier tier, int64_t size) {
+    AdbFile *file = AdbFileOpen(tier);
+    if (file == NULL) return kFileSystemError;
+
+    // Nothing to do if the tier is already stored in the desired container.
+    bool is_lz4 = (file->lz4 != NULL);
+    AdbFileClose(file);
+    if (is_lz4 == lz4_compression) return kNoError;
+
+    RecordArray records;
+    int error = ReadTierFile(tier, size, &records);
+    if (error != kNoError) return error;
+
+    error = WriteTierFile(tier, &records);
+    RecordArrayDestroy(&records);
+
+    return error;
+}
+
 static int GetLoadedTierIndex(Tier tier) {
     int64_t index;
     if (!TierHashMapSCGet(&loaded_tier_to_index, tier, &index)) return -1;
@@ -551,22 +1038,50 @@ static int ArrayDbUnloadTier(Tier tier) {
     if (index <= 0) return kRuntimeError;
 
     RecordArrayDestroy(&loaded_records[index]);
+    CompressedRecordArrayDestroy(&loaded_compressed[index]);
     TierHashMapSCRemove(&loaded_tier_to_index, tier);
 
     return kNoError;
 }
 
+static intptr_t ArrayDbLoadedTierMemUsage(Tier tier, int64_t size) {
+    int index = GetLoadedTierIndex(tier);
+    if (index > 0 && loaded_compressed[index].groups != NULL) {
+        return (intptr_t)CompressedRecordArrayMemUsage(
+            &loaded_compressed[index]);
+    }
+
+    return ArrayDbTierMemUsage(tier, size);
+}
+
 static bool ArrayDbIsTierLoaded(Tier tier) {
     int index = GetLoadedTierIndex(tier);
     if (index < 0) return false;
 
-    return loaded_records[index].records != NULL;
+    return RecordArrayGetData(&loaded_records[index]) != NULL ||
+           loaded_compressed[index].groups != NULL;
+}
+
+// Returns the block cache of the calling thread, or NULL if there is none.
+static CompressedRecordArrayCache *GetLoadedCache(void) {
+#ifdef _OPENMP
+    int tid = omp_get_thread_num();
+#else   // _OPENMP not defined, thread 0 is the only available thread.
+    int tid = 0;
+#endif  // _OPENMP
+
+    return tid < num_loaded_caches ? &loaded_caches[tid] : NULL;
 }
 
 static Value ArrayDbGetValueFromLoaded(Tier tier, Position position) {
     int index = GetLoadedTierIndex(tier);
     if (index < 0) return kErrorValue;
 
+    if (loaded_compressed[index].groups != NULL) {
+        return CompressedRecordArrayGetValue(&loaded_compressed[index],
+                                             GetLoadedCache(), position);
+    }
+
     return RecordArrayGetValue(&loaded_records[index], position);
 }
 
@@ -574,97 +1089,405 @@ static int ArrayDbGetRemotenessFromLoaded(Tier tier, Position position) {
     int index = GetLoadedTierIndex(tier);
     if (index < 0) return -1;
 
+    if (loaded_compressed[index].groups != NULL) {
+        return CompressedRecordArrayGetRemoteness(&loaded_compressed[index],
+                                                  GetLoadedCache(), position);
+    }
+
     return RecordArrayGetRemoteness(&loaded_records[index], position);
 }
 
+static int ArrayDbGetLoadedTierHandle(Tier tier, DbTierHandle *handle) {
+    int index = GetLoadedTierIndex(tier);
+    if (index < 0) return kIllegalArgumentError;
+
+    // The solving tier may be widened while it is being read, and compressed
+    // tiers have no plain records. Both are read through the loading API.
+    if (index == 0 || loaded_compressed[index].groups != NULL) {
+        return kNoError;
+    }
+
+    handle->records = RecordArrayGetPlainRecords(
+        &loaded_records[index], &handle->record_size, &handle->value_shift,
+        &handle->remoteness_mask);
+
+    return kNoError;
+}
+
 static int ArrayDbProbeInit(DbProbe *probe) {
-    probe->buffer = calloc(1, sizeof(AdbProbeInternal));
-    if (probe->buffer == NULL) return kMallocFailureError;
+    AdbProbeInternal *probe_internal =
+        (AdbProbeInternal *)calloc(1, sizeof(AdbProbeInternal));
+    if (probe_internal == NULL) return kMallocFailureError;
+
+    probe_internal->blocks =
+        (AdbProbeBlock *)calloc(probe_cache_blocks, sizeof(AdbProbeBlock));
+    if (probe_internal->blocks == NULL) {
+        free(probe_internal);
+        return kMallocFailureError;
+    }
+    probe_internal->num_blocks = probe_cache_blocks;
+    for (int i = 0; i < probe_internal->num_blocks; ++i) {
+        probe_internal->blocks[i].tier = kIllegalTier;
+    }
 
+    probe->buffer = probe_internal;
     probe->tier = kIllegalTier;
     // probe->begin and probe->size are unused.
 
     return kNoError;
 }
 
+// Releases all blocks kept by PROBE_INTERNAL back to the block cache.
+static void ProbeReleaseBlocks(AdbProbeInternal *probe_internal) {
+    for (int i = 0; i < probe_internal->num_blocks; ++i) {
+        DbBlockCacheRelease(probe_internal->blocks[i].cached);
+        probe_internal->blocks[i].cached = NULL;
+        probe_internal->blocks[i].tier = kIllegalTier;
+    }
+}
+
+// Releases all blocks kept by PROBE_INTERNAL if the blocks acquired by all
+// probes exceed the budget of the block cache. Called after each block miss,
+// so that probes do not keep blocks past a read while the cache is full.
+static void ProbeTrimBlocks(AdbProbeInternal *probe_internal) {
+    if (DbBlockCacheOverBudget(0)) ProbeReleaseBlocks(probe_internal);
+}
+
 static int ArrayDbProbeDestroy(DbProbe *probe) {
     AdbProbeInternal *probe_internal = (AdbProbeInternal *)probe->buffer;
-    XzraFileClose(probe_internal->file);
+    DbFilePoolRelease(probe_internal->file);
+    ProbeReleaseBlocks(probe_internal);
+    free(probe_internal->blocks);
     free(probe->buffer);
     memset(probe, 0, sizeof(*probe));
 
     return kNoError;
 }
 
-static bool ProbeSameFile(const DbProbe *probe, TierPosition tier_position) {
-    return probe->tier == tier_position.tier;
+void ArrayDbProbeGetCacheStats(const DbProbe *probe, int64_t *hits,
+                               int64_t *misses) {
+    const AdbProbeInternal *probe_internal =
+        (const AdbProbeInternal *)probe->buffer;
+    *hits = probe_internal->hits;
+    *misses = probe_internal->misses;
 }
 
-static int ProbeLoadNewTier(DbProbe *probe, Tier tier) {
-    AdbProbeInternal *probe_internal = (AdbProbeInternal *)probe->buffer;
-    if (probe_internal->init) {
-        int error = XzraFileClose(probe_internal->file);
-        if (error != 0) return kRuntimeError;
-    }
+static void *PooledFileOpen(void *aux) {
+    return AdbFileOpen(*(const Tier *)aux);
+}
 
-    char *full_path = GetFullPathToFile(tier, CurrentGetTierName);
-    if (full_path == NULL) return kMallocFailureError;
+static void PooledFileClose(void *handle) { AdbFileClose((AdbFile *)handle); }
 
-    probe_internal->file = XzraFileOpen(full_path);
-    free(full_path);
+static AdbFile *ProbeGetFile(const AdbProbeInternal *probe_internal) {
+    return (AdbFile *)probe_internal->file->handle;
+}
+
+// Acquires the file of TIER from the process-wide file pool for reading,
+// releasing the previous file if exists. The format of the new file is not
+// detected.
+static int ProbeOpenTier(DbProbe *probe, Tier tier) {
+    AdbProbeInternal *probe_internal = (AdbProbeInternal *)probe->buffer;
+    DbFilePoolRelease(probe_internal->file);
+    probe->tier = kIllegalTier;
+    probe_internal->file = DbFilePoolAcquire(cache_source, tier, PooledFileOpen,
+                                             PooledFileClose, &tier);
     if (probe_internal->file == NULL) return kFileSystemError;
 
-    probe_internal->init = true;
     probe->tier = tier;
     return kNoError;
 }
 
-static Record ProbeGetRecord(const DbProbe *probe, Position position) {
-    int64_t offset = position * (int64_t)sizeof(Record);
-    Record rec;
+// Returns the cached block of TIER that contains the byte at OFFSET, or NULL
+// if the block is not in the cache.
+static AdbProbeBlock *ProbeFindBlock(AdbProbeInternal *probe_internal,
+                                     Tier tier, int64_t offset) {
+    for (int i = 0; i < probe_internal->num_blocks; ++i) {
+        AdbProbeBlock *block = &probe_internal->blocks[i];
+        if (block->tier == tier && offset >= block->info.uncompressed_offset &&
+            offset < block->info.uncompressed_offset +
+                         block->info.uncompressed_size) {
+            return block;
+        }
+    }
+
+    return NULL;
+}
+
+typedef struct {
+    AdbFile *file;
+    const XzraBlockInfo *info;
+} ProbeBlockLoaderArgs;
+
+static void *ProbeBlockLoader(void *aux, int64_t *size) {
+    const ProbeBlockLoaderArgs *args = (const ProbeBlockLoaderArgs *)aux;
+    void *data = malloc(args->info->uncompressed_size);
+    if (data == NULL) return NULL;
+
+    if (AdbFileDecodeBlock(data, args->file, args->info) != 0) {
+        free(data);
+        return NULL;
+    }
+    *size = args->info->uncompressed_size;
+
+    return data;
+}
+
+// Acquires the block of the tier file being probed that contains the byte at
+// OFFSET from the process-wide block cache into the least recently used entry
+// and returns the entry, or NULL on failure.
+static AdbProbeBlock *ProbeFillBlock(DbProbe *probe, int64_t offset) {
     AdbProbeInternal *probe_internal = (AdbProbeInternal *)probe->buffer;
-    XzraFileSeek(probe_internal->file, offset, XZRA_SEEK_SET);
-    size_t bytes_read = XzraFileRead(&rec, sizeof(rec), probe_internal->file);
-    if (bytes_read != sizeof(rec)) {
-        fprintf(stderr, "ProbeGetRecord: (BUG) corrupt record\n");
+    XzraBlockInfo info;
+    if (AdbFileLocateBlock(ProbeGetFile(probe_internal), offset, &info) != 0) {
+        return NULL;
     }
 
-    return rec;
+    AdbProbeBlock *victim = &probe_internal->blocks[0];
+    for (int i = 1; i < probe_internal->num_blocks; ++i) {
+        if (probe_internal->blocks[i].last_used < victim->last_used) {
+            victim = &probe_internal->blocks[i];
+        }
+    }
+    DbBlockCacheRelease(victim->cached);
+    victim->cached = NULL;
+    victim->tier = kIllegalTier;
+
+    // Blocks kept by probes are charged against the budget of the block
+    // cache. Keep only the new block if they would take up the whole budget.
+    if (DbBlockCacheOverBudget(info.uncompressed_size)) {
+        ProbeReleaseBlocks(probe_internal);
+    }
+
+    DbBlockCacheKey key = {
+        .source = cache_source,
+        .tier = probe->tier,
+        .block = info.number,
+    };
+    ProbeBlockLoaderArgs args = {
+        .file = ProbeGetFile(probe_internal),
+        .info = &info,
+    };
+    victim->cached = DbBlockCacheAcquire(&key, ProbeBlockLoader, &args);
+    if (victim->cached == NULL) return NULL;
+
+    victim->tier = probe->tier;
+    victim->format = probe_internal->format;
+    victim->info = info;
+    ++probe_internal->misses;
+
+    return victim;
 }
 
-static Value ArrayDbProbeValue(DbProbe *probe, TierPosition tier_position) {
-    if (!ProbeSameFile(probe, tier_position)) {
-        int error = ProbeLoadNewTier(probe, tier_position.tier);
-        if (error != kNoError) {
-            fprintf(stderr,
-                    "ArrayDbProbeValue: failed to load tier %" PRITier "\n",
-                    tier_position.tier);
-            return kErrorValue;
+// Returns the RecordArrayFormat of the file of TIER, opening the file and
+// reading its header through the block cache if the format is not yet known.
+// Returns -1 on failure.
+static int ProbeGetFormat(DbProbe *probe, Tier tier) {
+    AdbProbeInternal *probe_internal = (AdbProbeInternal *)probe->buffer;
+    if (probe->tier == tier) return probe_internal->format;
+
+    for (int i = 0; i < probe_internal->num_blocks; ++i) {
+        if (probe_internal->blocks[i].tier == tier) {
+            return probe_internal->blocks[i].format;
+        }
+    }
+
+    // Detect the format of the tier file from its header, which is at the
+    // beginning of the first block.
+    if (ProbeOpenTier(probe, tier) != kNoError) return -1;
+    probe_internal->format = -1;
+    AdbProbeBlock *block = ProbeFillBlock(probe, 0);
+    if (block != NULL) {
+        int64_t prefix_size = block->info.uncompressed_size;
+        probe_internal->format = RecordArrayGetFormatFromPrefix(
+            block->cached->data, (size_t)prefix_size);
+        block->format = probe_internal->format;
+        block->last_used = ++probe_internal->clock;
+    }
+    if (probe_internal->format < 0) {
+        if (block != NULL) block->tier = kIllegalTier;
+        DbFilePoolRelease(probe_internal->file);
+        probe_internal->file = NULL;
+        probe->tier = kIllegalTier;
+    }
+    ProbeTrimBlocks(probe_internal);
+
+    return probe_internal->format;
+}
+
+// Reads SIZE bytes starting at OFFSET from the file of TIER in FORMAT into
+// DEST through the block cache.
+static int ProbeRead(DbProbe *probe, Tier tier, int format, int64_t offset,
+                     void *dest, int64_t size) {
+    AdbProbeInternal *probe_internal = (AdbProbeInternal *)probe->buffer;
+    uint8_t *out = (uint8_t *)dest;
+    bool filled = false;
+    while (size > 0) {
+        AdbProbeBlock *block = ProbeFindBlock(probe_internal, tier, offset);
+        if (block != NULL) {
+            ++probe_internal->hits;
+        } else {
+            if (probe->tier != tier) {
+                int error = ProbeOpenTier(probe, tier);
+                if (error != kNoError) return error;
+                probe_internal->format = format;
+            }
+            block = ProbeFillBlock(probe, offset);
+            if (block == NULL) return kRuntimeError;
+            filled = true;
         }
+        block->last_used = ++probe_internal->clock;
+
+        // A chunk may straddle two blocks if the block size is not a multiple
+        // of the chunk size.
+        int64_t block_offset = offset - block->info.uncompressed_offset;
+        int64_t copy_size = block->info.uncompressed_size - block_offset;
+        if (copy_size > size) copy_size = size;
+        memcpy(out, (const uint8_t *)block->cached->data + block_offset,
+               copy_size);
+        out += copy_size;
+        offset += copy_size;
+        size -= copy_size;
+    }
+
+    if (filled) ProbeTrimBlocks(probe_internal);
+
+    return kNoError;
+}
+
+// Reads the chunk of the file of TIER in FORMAT that holds the record of
+// POSITION into CHUNK. See RecordArrayGetChunkOffset for details.
+static int ProbeGetChunk(DbProbe *probe, Tier tier, int format,
+                         Position position, uint64_t *chunk) {
+    union {
+        uint8_t narrow;
+        Record wide;
+        uint64_t word;
+    } buf;
+    int error = ProbeRead(probe, tier, format,
+                          RecordArrayGetChunkOffset(format, position), &buf,
+                          RecordArrayGetChunkSize(format));
+    if (error != kNoError) return error;
+
+    switch (format) {
+        case kRecordArrayFormatNarrow:
+            *chunk = buf.narrow;
+            break;
+        case kRecordArrayFormatValueOnly:
+            *chunk = buf.word;
+            break;
+        default:
+            *chunk = buf.wide;
+            break;
+    }
+
+    return kNoError;
+}
+
+static Value ArrayDbProbeValue(DbProbe *probe, TierPosition tier_position) {
+    int format = ProbeGetFormat(probe, tier_position.tier);
+    uint64_t chunk;
+    if (format < 0 ||
+        ProbeGetChunk(probe, tier_position.tier, format, tier_position.position,
+                      &chunk) != kNoError) {
+        fprintf(stderr, "ArrayDbProbeValue: failed to load tier %" PRITier "\n",
+                tier_position.tier);
+        return kErrorValue;
     }
 
-    Record rec = ProbeGetRecord(probe, tier_position.position);
-    return RecordGetValue(&rec);
+    return RecordArrayGetValueFromChunk(format, chunk, tier_position.position);
 }
 
 static int ArrayDbProbeRemoteness(DbProbe *probe, TierPosition tier_position) {
-    if (!ProbeSameFile(probe, tier_position)) {
-        int error = ProbeLoadNewTier(probe, tier_position.tier);
-        if (error != kNoError) {
-            fprintf(stderr,
-                    "ArrayDbProbeRemoteness: failed to load tier %" PRITier
-                    "\n",
-                    tier_position.tier);
-            return kErrorRemoteness;
+    int format = ProbeGetFormat(probe, tier_position.tier);
+    uint64_t chunk;
+    if (format < 0 ||
+        ProbeGetChunk(probe, tier_position.tier, format, tier_position.position,
+                      &chunk) != kNoError) {
+        fprintf(stderr,
+                "ArrayDbProbeRemoteness: failed to load tier %" PRITier "\n",
+                tier_position.tier);
+        return kErrorRemoteness;
+    }
+
+    return RecordArrayGetRemotenessFromChunk(format, chunk,
+                                             tier_position.position);
+}
+
+// Reads both the value and the remoteness from a single probed chunk.
+static int ArrayDbProbeRecord(DbProbe *probe, TierPosition tier_position,
+                              Value *value, int *remoteness) {
+    int format = ProbeGetFormat(probe, tier_position.tier);
+    uint64_t chunk;
+    if (format < 0 ||
+        ProbeGetChunk(probe, tier_position.tier, format, tier_position.position,
+                      &chunk) != kNoError) {
+        fprintf(stderr,
+                "ArrayDbProbeRecord: failed to load tier %" PRITier "\n",
+                tier_position.tier);
+        return kFileSystemError;
+    }
+
+    *value =
+        RecordArrayGetValueFromChunk(format, chunk, tier_position.position);
+    if (remoteness != NULL) {
+        *remoteness = RecordArrayGetRemotenessFromChunk(format, chunk,
+                                                        tier_position.position);
+    }
+
+    return kNoError;
+}
+
+static int ArrayDbProbeRecordsBatch(DbProbe *probe, int64_t size,
+                                    const TierPosition *tier_positions,
+                                    Value *values, int *remotenesses) {
+    return DbProbeBatchRun(probe, size, tier_positions, values, remotenesses,
+                           ArrayDbProbeRecord);
+}
+
+// Returns the status of TIER according to the directory listings and the
+// tiers written since initialization, or kDbTierStatusCheckError if a
+// directory cannot be listed.
+static int ScannedTierStatus(Tier tier) {
+    bool written;
+    PRAGMA_OMP_CRITICAL(arraydb_written_tiers) {
+        written = TierHashSetContains(&written_tiers, tier);
+    }
+    if (written) return kDbTierStatusSolved;
+
+    static ConstantReadOnlyString kExtensions[] = {".adb.lz4", ".adb.xz"};
+    for (int i = 0; i < 2; ++i) {
+        char file_name[kDbFileNameLengthMax + 16];
+        if (CurrentGetTierName != NULL) {
+            CurrentGetTierName(tier, file_name);
+        } else {
+            sprintf(file_name, "%" PRITier, tier);
         }
+        strcat(file_name, kExtensions[i]);
+
+        bool exists;
+        int error =
+            DbShardMapListingContains(&shards, tier, file_name, &exists);
+        if (error != kNoError) return kDbTierStatusCheckError;
+        if (exists) return kDbTierStatusSolved;
     }
 
-    Record rec = ProbeGetRecord(probe, tier_position.position);
-    return RecordGetRemoteness(&rec);
+    return kDbTierStatusMissing;
 }
 
 static int ArrayDbTierStatus(Tier tier) {
-    char *full_path = GetFullPathToFile(tier, CurrentGetTierName);
+    // Fall back to checking the files if the directory cannot be listed.
+    if (status_scan) {
+        int status = ScannedTierStatus(tier);
+        if (status != kDbTierStatusCheckError) return status;
+    }
+
+    char *full_path = GetFullPathToLz4File(tier, CurrentGetTierName);
+    if (full_path == NULL) return kDbTierStatusCheckError;
+    bool lz4_exists = FileExists(full_path);
+    free(full_path);
+    if (lz4_exists) return kDbTierStatusSolved;
+
+    full_path = GetFullPathToFile(tier, CurrentGetTierName);
     if (full_path == NULL) return kDbTierStatusCheckError;
 
     FILE *db_file = fopen(full_path, "rb");
@@ -686,3 +1509,14 @@ static int ArrayDbGameStatus(void) {
 
     return exists ? kDbGameStatusSolved : kDbGameStatusIncomplete;
 }
+
+static int ArrayDbGetTierSummary(Tier tier, int64_t size,
+                                 DbTierSummary *summary) {
+    char *full_path = GetFullPathToSummary(tier, CurrentGetTierName);
+    if (full_path == NULL) return kMallocFailureError;
+
+    int error = DbTierSummaryRead(summary, full_path, size);
+    free(full_path);
+
+    return error;
+}
@@ -32,11 +32,13 @@
 #ifndef GAMESMANONE_CORE_DB_ARRAYDB_ARRAYDB_H_
 #define GAMESMANONE_CORE_DB_ARRAYDB_ARRAYDB_H_
 
+#include <stdint.h>  // int64_t
+
 #include "core/types/gamesman_types.h"
 
 /**
- * @brief Simple array database which stores value-remoteness pairs in a 16-bit
- * record array.
+ * @brief Simple array database which stores value-remoteness pairs in an 8-bit
+ * or 16-bit record array, or values only in a 3-bit packed array.
  */
 extern const Database kArrayDb;
 
@@ -59,6 +61,72 @@ typedef struct ArrayDbOptions {
      * improves compression ratio at the cost of significantly increased
      * (typically doubled) compression time. */
     int extreme_compression;
+
+    /** Set this to 1 to create solving tiers in value-only format, which
+     * stores 3 bits per position and discards remotenesses. Tiers in either
+     * format can always be loaded and probed. Default: 0. */
+    int value_only;
+
+    /** Number of decompressed blocks kept by each probe. Blocks are acquired
+     * from the process-wide block cache (see db_block_cache.h), which is
+     * shared by all probes and threads, and the probe keeps the most recently
+     * used ones so that alternating between a parent tier and its child tiers
+     * does not go back to the shared cache on every switch. Blocks kept by a
+     * probe are never evicted from the shared cache. Values smaller than 1
+     * are treated as 1. Default: 8. */
+    int probe_cache_blocks;
+
+    /** Set this to 1 to store new tier files as independently LZ4-compressed
+     * blocks of \c lz4_block_size bytes with an offset index (.adb.lz4)
+     * instead of XZ (.adb.xz). LZ4 files are larger, but a random probe only
+     * decompresses one small block, which takes tens of microseconds instead
+     * of milliseconds. Tiers in either container can always be loaded and
+     * probed. Default: 0. */
+    int lz4_compression;
+
+    /** Size of each LZ4 compression block in bytes. Values smaller than 4096
+     * are treated as 4096. Default: 65536 (64 KiB). */
+    int lz4_block_size;
+
+    /** Set this to 1 to answer tier status checks from a listing of each data
+     * directory taken on the first check, plus the tiers written by this
+     * process since. This replaces one file system lookup per tier with one
+     * directory scan per data directory, but tier files created or removed
+     * by other processes afterwards are not seen. Default: 0. */
+    int status_scan;
+
+    /** Set this to 1 to store the summary of each solving tier (see
+     * db_tier_summary.h) in an .adb.sum file next to the tier file when the
+     * tier is flushed. Flushing a tier with this option disabled removes any
+     * existing summary of the tier, which would otherwise be stale.
+     * Default: 0. */
+    int summary;
+
+    /** Directory on fast local storage, such as an NVMe drive, in which
+     * record arrays larger than \c out_of_core_budget bytes are backed by
+     * memory-mapped temporary files instead of memory, so that tiers larger
+     * than the physical memory can be solved and loaded. NULL to keep all
+     * record arrays in memory. The string is copied. Default: NULL. */
+    const char *out_of_core_dir;
+
+    /** Resident memory budget in bytes of each record array backed by a
+     * file. Record arrays no larger than this are kept in memory, and
+     * \c kArrayDb::TierMemUsage reports this budget for larger tiers. Ignored
+     * if \c out_of_core_dir is NULL. Default: 1073741824 (1 GiB). */
+    int64_t out_of_core_budget;
+
+    /** Set this to 1 to keep tiers loaded with \c kArrayDb::LoadTier in
+     * memory as independently LZ4-compressed blocks of \c loaded_block_size
+     * bytes instead of decompressed record arrays. Records of such tiers are
+     * looked up through a small per-thread cache of decompressed blocks, and
+     * \c kArrayDb::LoadedTierMemUsage reports their compressed size. Does not
+     * affect the solving tier. Default: 0. */
+    int compressed_loading;
+
+    /** Number of raw bytes in each block of compressed loaded tiers, between
+     * 1 KiB and 1 MiB and rounded down to a power of 2. Ignored if
+     * \c compressed_loading is 0. Default: 4096 (4 KiB). */
+    int loaded_block_size;
 } ArrayDbOptions;
 
 /**
@@ -72,4 +140,17 @@ extern const ArrayDbOptions kArrayDbOptionsInit;
  */
 extern const int kArrayDbRecordSize;
 
+/**
+ * @brief Retrieves the number of hits and misses on the blocks kept by
+ * \p probe since its initialization. Each miss acquires a block from the
+ * process-wide block cache, which decompresses the block only if no other
+ * probe has it cached.
+ *
+ * @param probe Probe initialized while \c kArrayDb is the current database.
+ * @param hits Output parameter for the number of cache hits.
+ * @param misses Output parameter for the number of cache misses.
+ */
+void ArrayDbProbeGetCacheStats(const DbProbe *probe, int64_t *hits,
+                               int64_t *misses);
+
 #endif  // GAMESMANONE_CORE_DB_ARRAYDB_ARRAYDB_H_
@@ -0,0 +1,261 @@
+/**
+ * @file compressed_record_array.c
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Implementation of the read-only RecordArray held in memory as
+ * independently LZ4-compressed blocks.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/db/arraydb/compressed_record_array.h"
+
+#include <lz4.h>      // LZ4_compress_default, LZ4_decompress_safe
+#include <stdbool.h>  // bool, true, false
+#include <stddef.h>   // NULL
+#include <stdint.h>   // int64_t, uint8_t, uint32_t, uint64_t
+#include <stdlib.h>   // malloc, calloc, free
+#include <string.h>   // memcpy, memset
+
+#include "core/concurrency.h"
+#include "core/constants.h"
+#include "core/db/arraydb/record.h"
+#include "core/db/arraydb/record_array.h"
+#include "core/misc.h"
+#include "core/types/gamesman_types.h"
+
+// Number of consecutive blocks compressed into each allocation.
+enum { kBlocksPerGroup = 256 };
+
+// Array IDs start from 1 so that zero-filled cache entries never match.
+static int64_t next_array_id = 1;
+
+// Compresses the blocks of group G of the raw data RAW into SCRATCH, which
+// holds at least CAPACITY bytes, and copies the result into a new allocation.
+// Returns the number of compressed bytes, or -1 on failure.
+static int64_t CompressGroup(CompressedRecordArray *array, const char *raw,
+                             int64_t g, char *scratch, int capacity) {
+    int64_t first = g * kBlocksPerGroup;
+    int64_t last = first + kBlocksPerGroup;
+    if (last > array->num_blocks) last = array->num_blocks;
+
+    uint32_t end = 0;
+    for (int64_t b = first; b < last; ++b) {
+        int64_t begin = b * array->block_size;
+        int64_t n = array->raw_size - begin < array->block_size
+                        ? array->raw_size - begin
+                        : array->block_size;
+        int size = LZ4_compress_default(raw + begin, scratch + end, (int)n,
+                                        capacity - (int)end);
+        if (size <= 0) return -1;
+        end += (uint32_t)size;
+        array->block_ends[b] = end;
+    }
+
+    array->groups[g] = (char *)malloc(end);
+    if (array->groups[g] == NULL) return -1;
+    memcpy(array->groups[g], scratch, end);
+
+    return end;
+}
+
+int CompressedRecordArrayInit(CompressedRecordArray *array,
+                              const RecordArray *records, int block_size) {
+    memset(array, 0, sizeof(*array));
+    // Chunks, which are at most 8 bytes long, never straddle two blocks.
+    if (block_size < 8) return kIllegalArgumentError;
+    while ((block_size >> (array->block_shift + 1)) > 0) ++array->block_shift;
+    block_size = 1 << array->block_shift;
+
+    array->format = RecordArrayGetFormat(records);
+    array->block_size = block_size;
+    array->size = RecordArrayGetSize(records);
+    array->raw_size = RecordArrayGetRawSize(records);
+    array->num_blocks = RoundUpDivide(array->raw_size, block_size);
+    array->num_groups = RoundUpDivide(array->num_blocks, kBlocksPerGroup);
+    array->groups = (char **)calloc(array->num_groups, sizeof(char *));
+    array->block_ends =
+        (uint32_t *)malloc(array->num_blocks * sizeof(uint32_t));
+    if (array->groups == NULL || array->block_ends == NULL) {
+        CompressedRecordArrayDestroy(array);
+        return kMallocFailureError;
+    }
+
+    const char *raw = (const char *)RecordArrayGetReadOnlyData(records);
+    int capacity = LZ4_compressBound(block_size) * kBlocksPerGroup;
+    ConcurrentBool success;
+    ConcurrentBoolInit(&success, true);
+    PRAGMA_OMP_PARALLEL {
+        char *scratch = (char *)malloc(capacity);
+        if (scratch == NULL) ConcurrentBoolStore(&success, false);
+        PRAGMA_OMP_FOR_SCHEDULE_DYNAMIC(1)
+        for (int64_t g = 0; g < array->num_groups; ++g) {
+            if (scratch == NULL) continue;
+            if (CompressGroup(array, raw, g, scratch, capacity) < 0) {
+                ConcurrentBoolStore(&success, false);
+            }
+        }
+        free(scratch);
+    }
+    if (!ConcurrentBoolLoad(&success)) {
+        CompressedRecordArrayDestroy(array);
+        return kRuntimeError;
+    }
+
+    array->mem_usage = array->num_groups * (int64_t)sizeof(char *) +
+                       array->num_blocks * (int64_t)sizeof(uint32_t);
+    for (int64_t g = 0; g < array->num_groups; ++g) {
+        int64_t last = (g + 1) * kBlocksPerGroup - 1;
+        if (last >= array->num_blocks) last = array->num_blocks - 1;
+        array->mem_usage += array->block_ends[last];
+    }
+    array->id = next_array_id++;
+
+    return kNoError;
+}
+
+void CompressedRecordArrayDestroy(CompressedRecordArray *array) {
+    if (array->groups != NULL) {
+        for (int64_t g = 0; g < array->num_groups; ++g) {
+            free(array->groups[g]);
+        }
+    }
+    free(array->groups);
+    free(array->block_ends);
+    memset(array, 0, sizeof(*array));
+}
+
+int64_t CompressedRecordArrayMemUsage(const CompressedRecordArray *array) {
+    return array->mem_usage;
+}
+
+int CompressedRecordArrayCacheInit(CompressedRecordArrayCache *cache,
+                                   int block_size) {
+    memset(cache, 0, sizeof(*cache));
+    cache->data = (char *)malloc((size_t)block_size *
+                                 kCompressedRecordArrayCacheEntries);
+    if (cache->data == NULL) return kMallocFailureError;
+    cache->block_size = block_size;
+
+    return kNoError;
+}
+
+void CompressedRecordArrayCacheDestroy(CompressedRecordArrayCache *cache) {
+    free(cache->data);
+    memset(cache, 0, sizeof(*cache));
+}
+
+// Decompresses block B of ARRAY into DEST. Returns true on success.
+static bool DecodeBlock(const CompressedRecordArray *array, int64_t b,
+                        char *dest) {
+    int64_t g = b / kBlocksPerGroup;
+    uint32_t begin = (b % kBlocksPerGroup == 0) ? 0 : array->block_ends[b - 1];
+    int64_t n = array->raw_size - (b << array->block_shift);
+    if (n > array->block_size) n = array->block_size;
+    int size = LZ4_decompress_safe(array->groups[g] + begin, dest,
+                                   (int)(array->block_ends[b] - begin),
+                                   (int)n);
+
+    return size == n;
+}
+
+// Returns the decompressed block B of ARRAY, which is kept in CACHE, or NULL
+// on failure.
+static const char *GetCachedBlock(const CompressedRecordArray *array,
+                                  CompressedRecordArrayCache *cache,
+                                  int64_t b) {
+    // Consecutive blocks of the same array and the current blocks of
+    // different arrays tend to use different entries.
+    int slot = (int)((uint64_t)(b + array->id * 5) %
+                     kCompressedRecordArrayCacheEntries);
+    char *data = cache->data + (int64_t)slot * cache->block_size;
+    if (cache->ids[slot] == array->id && cache->blocks[slot] == b) return data;
+
+    if (!DecodeBlock(array, b, data)) {
+        cache->ids[slot] = 0;
+        return NULL;
+    }
+    cache->ids[slot] = array->id;
+    cache->blocks[slot] = b;
+
+    return data;
+}
+
+// Reads the chunk of ARRAY that holds the record of POSITION into CHUNK. See
+// RecordArrayGetChunkOffset for details. Returns true on success.
+static bool GetChunk(const CompressedRecordArray *array,
+                     CompressedRecordArrayCache *cache, Position position,
+                     uint64_t *chunk) {
+    int64_t offset = RecordArrayGetChunkOffset(array->format, position);
+    int64_t b = offset >> array->block_shift;
+    const char *block;
+    char *uncached = NULL;
+    if (cache != NULL && cache->block_size >= array->block_size) {
+        block = GetCachedBlock(array, cache, b);
+    } else {
+        uncached = (char *)malloc(array->block_size);
+        block = uncached;
+        if (uncached != NULL && !DecodeBlock(array, b, uncached)) block = NULL;
+    }
+    if (block == NULL) {
+        free(uncached);
+        return false;
+    }
+
+    const char *src = block + (offset & (array->block_size - 1));
+    switch (array->format) {
+        case kRecordArrayFormatNarrow:
+            *chunk = *(const uint8_t *)src;
+            break;
+        case kRecordArrayFormatValueOnly: {
+            uint64_t word;
+            memcpy(&word, src, sizeof(word));
+            *chunk = word;
+            break;
+        }
+        default: {
+            Record wide;
+            memcpy(&wide, src, sizeof(wide));
+            *chunk = wide;
+            break;
+        }
+    }
+    free(uncached);
+
+    return true;
+}
+
+Value CompressedRecordArrayGetValue(const CompressedRecordArray *array,
+                                    CompressedRecordArrayCache *cache,
+                                    Position position) {
+    uint64_t chunk;
+    if (!GetChunk(array, cache, position, &chunk)) return kErrorValue;
+
+    return RecordArrayGetValueFromChunk(array->format, chunk, position);
+}
+
+int CompressedRecordArrayGetRemoteness(const CompressedRecordArray *array,
+                                       CompressedRecordArrayCache *cache,
+                                       Position position) {
+    uint64_t chunk;
+    if (!GetChunk(array, cache, position, &chunk)) return kErrorRemoteness;
+
+    return RecordArrayGetRemotenessFromChunk(array->format, chunk, position);
+}
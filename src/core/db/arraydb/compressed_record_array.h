@@ -0,0 +1,139 @@
+/**
+ * @file compressed_record_array.h
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Read-only RecordArray held in memory as independently LZ4-compressed
+ * blocks.
+ * @details Used by the Array Database to keep loaded tiers compressed, so that
+ * many more of them fit in memory at the same time. Records are looked up
+ * through a small per-thread cache of decompressed blocks.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAMESMANONE_CORE_DB_ARRAYDB_COMPRESSED_RECORD_ARRAY_H_
+#define GAMESMANONE_CORE_DB_ARRAYDB_COMPRESSED_RECORD_ARRAY_H_
+
+#include <stdint.h>  // int64_t, uint32_t
+
+#include "core/db/arraydb/record_array.h"
+#include "core/types/gamesman_types.h"
+
+/** @brief Number of decompressed blocks kept by each cache. */
+enum { kCompressedRecordArrayCacheEntries = 16 };
+
+/**
+ * @brief Read-only \c RecordArray stored as independently LZ4-compressed
+ * blocks of its raw data.
+ *
+ * @details Blocks are grouped so that each group of consecutive blocks is
+ * allocated at once. The compressed data of block \c b ends at byte
+ * \c block_ends[b] of its group and begins where the previous block of the
+ * same group ends.
+ */
+typedef struct CompressedRecordArray {
+    int64_t id;          /**< Unique ID of the array, used as cache key. */
+    int format;          /**< RecordArrayFormat of the raw data. */
+    int block_size;      /**< Number of raw bytes in each block. */
+    int block_shift;     /**< Base 2 logarithm of \c block_size. */
+    int64_t size;        /**< Number of records in the array. */
+    int64_t raw_size;    /**< Size of the raw data in bytes. */
+    int64_t num_blocks;  /**< Number of blocks. */
+    int64_t num_groups;  /**< Number of block groups. */
+    char **groups;       /**< Compressed data of each group of blocks. */
+    uint32_t *block_ends; /**< End offset of each block within its group. */
+    int64_t mem_usage;   /**< Total number of bytes allocated. */
+} CompressedRecordArray;
+
+/**
+ * @brief Per-thread cache of decompressed blocks of any number of
+ * \c CompressedRecordArray objects. A cache must only be used by one thread at
+ * a time.
+ */
+typedef struct CompressedRecordArrayCache {
+    int block_size; /**< Largest block size supported by the cache. */
+    int64_t ids[kCompressedRecordArrayCacheEntries];    /**< Array IDs. */
+    int64_t blocks[kCompressedRecordArrayCacheEntries]; /**< Block indices. */
+    char *data; /**< Decompressed blocks, \c block_size bytes each. */
+} CompressedRecordArrayCache;
+
+/**
+ * @brief Compresses \p records into \p array using all available threads.
+ * @note \p records is not modified and may be destroyed afterwards.
+ *
+ * @param array Array to be initialized.
+ * @param records Source records.
+ * @param block_size Number of raw bytes in each block, which is rounded down
+ * to a power of 2.
+ * @return \c kNoError on success,
+ * @return \c kIllegalArgumentError if \p block_size is smaller than 8 bytes,
+ * @return \c kMallocFailureError on failure to allocate memory, or
+ * @return \c kRuntimeError if LZ4 fails to compress a block.
+ */
+int CompressedRecordArrayInit(CompressedRecordArray *array,
+                              const RecordArray *records, int block_size);
+
+/** @brief Deallocates \p array. Does nothing if \p array is zero-filled. */
+void CompressedRecordArrayDestroy(CompressedRecordArray *array);
+
+/**
+ * @brief Returns the number of bytes allocated for \p array, or 0 if \p array
+ * is zero-filled.
+ */
+int64_t CompressedRecordArrayMemUsage(const CompressedRecordArray *array);
+
+/**
+ * @brief Initializes \p cache for arrays with blocks of at most \p block_size
+ * bytes.
+ *
+ * @return \c kNoError on success, or
+ * @return \c kMallocFailureError on failure to allocate memory.
+ */
+int CompressedRecordArrayCacheInit(CompressedRecordArrayCache *cache,
+                                   int block_size);
+
+/** @brief Deallocates \p cache. */
+void CompressedRecordArrayCacheDestroy(CompressedRecordArrayCache *cache);
+
+/**
+ * @brief Returns the \c Value of \p position in \p array, decompressing the
+ * block that holds it into \p cache if necessary.
+ *
+ * @param array Source array.
+ * @param cache Cache of the calling thread, or NULL to decompress the block
+ * without caching it.
+ * @param position Position, which must be smaller than the size of \p array.
+ * @return \c Value of \p position, or
+ * @return \c kErrorValue if the block holding \p position is corrupted.
+ */
+Value CompressedRecordArrayGetValue(const CompressedRecordArray *array,
+                                    CompressedRecordArrayCache *cache,
+                                    Position position);
+
+/**
+ * @brief Same as \c CompressedRecordArrayGetValue, but returns the remoteness
+ * of \p position, \c kUnknownRemoteness if \p array is in value-only format,
+ * or -1 if the block holding \p position is corrupted.
+ */
+int CompressedRecordArrayGetRemoteness(const CompressedRecordArray *array,
+                                       CompressedRecordArrayCache *cache,
+                                       Position position);
+
+#endif  // GAMESMANONE_CORE_DB_ARRAYDB_COMPRESSED_RECORD_ARRAY_H_
@@ -34,7 +34,7 @@
 #include "core/types/gamesman_types.h"
 
 static const int kRecordBits = sizeof(Record) * kBitsPerByte;
-static const int kValueBits = 4;
+static const int kValueBits = kRecordValueBits;
 static const int kRemotenessBits = kRecordBits - kValueBits;
 static const uint16_t kRemotenessMask = (1 << kRemotenessBits) - 1;
 
@@ -35,6 +35,16 @@
 /** @brief The record type. */
 typedef uint16_t Record;
 
+/**
+ * @brief Layout of a \c Record. The value is stored in the highest
+ * \c kRecordValueBits bits, followed by the remoteness in the lowest
+ * \c kRecordRemotenessBits bits.
+ */
+enum RecordLayout {
+    kRecordValueBits = 4,       /**< Number of value bits. */
+    kRecordRemotenessBits = 12, /**< Number of remoteness bits. */
+};
+
 /**
  * @brief Sets the value field of record \p rec to \p val.
  *
@@ -27,54 +27,377 @@
 
 #include "core/db/arraydb/record_array.h"
 
-#include <assert.h>  // assert
-#include <stddef.h>  // NULL
-#include <stdint.h>  // int64_t
-#include <stdlib.h>  // calloc, free
+#include <assert.h>   // assert
+#include <stdbool.h>  // bool, true, false
+#include <stddef.h>   // NULL, size_t
+#include <stdint.h>   // int64_t, uint8_t, uint64_t
+#include <stdio.h>    // fprintf, stderr
+#include <string.h>   // memcmp, memcpy, memset
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // _OPENMP
+
+#include "core/concurrency.h"
+#include "core/constants.h"
 #include "core/db/arraydb/record.h"
+#include "core/large_alloc.h"
+#include "core/misc.h"
+#include "core/types/gamesman_types.h"
+
+static const char kRecordArrayMagic[8] = {'G', 'M', 'R', 'E',
+                                          'C', 'A', 'R', 'R'};
+static const uint32_t kRecordArrayVersion = 2;
+
+// Version 1 only had the value-only format and no record_bits field. Its
+// record_bits field is 0 as it was part of the reserved space.
+static const uint32_t kRecordArrayVersionValueOnly = 1;
+
+// Narrow format: 3 value bits followed by 5 remoteness bits.
+enum {
+    kNarrowRemotenessBits = 5,
+    kNarrowRemotenessMax = (1 << kNarrowRemotenessBits) - 1,
+};
+
+// Value-only format: 3 bits per value, 21 values per 64-bit word. The highest
+// bit of each word is unused.
+enum {
+    kValueOnlyBits = 3,
+    kValuesPerWord = 64 / kValueOnlyBits,
+};
+static const uint64_t kValueOnlyMask = (1 << kValueOnlyBits) - 1;
+
+static int64_t GetNumValueOnlyWords(int64_t size) {
+    return RoundUpDivide(size, kValuesPerWord);
+}
 
 int RecordArrayInit(RecordArray *array, int64_t size) {
-    array->records = (Record *)calloc(size, sizeof(Record));
-    if (array->records == NULL) return kMallocFailureError;
+    return RecordArrayInitFormat(array, size, kRecordArrayFormatWide);
+}
+
+int RecordArrayInitFormat(RecordArray *array, int64_t size, int format) {
+    return RecordArrayInitFormatFileBacked(array, size, format, NULL);
+}
+
+int RecordArrayInitFormatFileBacked(RecordArray *array, int64_t size,
+                                    int format, const char *dir) {
+    int64_t raw_size = RecordArrayGetFormatRawSize(format, size);
+    void *data = LargeCallocFileBacked(raw_size, dir);
+    if (data == NULL) return kMallocFailureError;
+
+    // File-backed pages already read as zeros, and touching them would only
+    // write the whole file out once more.
+    if (dir == NULL) LargeFirstTouch(data, (size_t)raw_size);
+    memset(array, 0, sizeof(*array));
     array->size = size;
+    array->backing_dir = dir;
+    if (format == kRecordArrayFormatWide) {
+        array->records = (Record *)data;
+        return kNoError;
+    }
+
+    array->header = (RecordArrayHeader *)data;
+    memcpy(array->header->magic, kRecordArrayMagic, sizeof(kRecordArrayMagic));
+    array->header->version = kRecordArrayVersion;
+    array->header->size = size;
+    if (format == kRecordArrayFormatNarrow) {
+        array->header->record_bits = 8;
+        array->narrow_records = (uint8_t *)(array->header + 1);
+    } else {
+        assert(format == kRecordArrayFormatValueOnly);
+        array->header->flags = kRecordArrayFlagValueOnly;
+        array->header->record_bits = kValueOnlyBits;
+        array->values = (RecordArrayWord *)(array->header + 1);
+    }
 
     return kNoError;
 }
 
+void RecordArrayAdvise(RecordArray *array, LargeAccessPattern pattern) {
+    if (array->backing_dir == NULL) return;
+    LargeAdvise(RecordArrayGetData(array), RecordArrayGetRawSize(array),
+                pattern);
+}
+
 void RecordArrayDestroy(RecordArray *array) {
-    free(array->records);
-    array->records = NULL;
-    array->size = 0;
+    LargeFree(RecordArrayGetData(array), RecordArrayGetRawSize(array));
+    memset(array, 0, sizeof(*array));
+}
+
+static uint8_t MakeNarrowRecord(Value val, int remoteness) {
+    return (uint8_t)((val << kNarrowRemotenessBits) | remoteness);
+}
+
+static Value GetNarrowValue(uint8_t rec) {
+    return (Value)(rec >> kNarrowRemotenessBits);
+}
+
+static int GetNarrowRemoteness(uint8_t rec) {
+    return rec & kNarrowRemotenessMax;
+}
+
+int RecordArrayWiden(RecordArray *array) {
+    if (array->narrow_records == NULL) return kNoError;
+
+    RecordArray wide;
+    int error = RecordArrayInitFormatFileBacked(
+        &wide, array->size, kRecordArrayFormatWide, array->backing_dir);
+    if (error != kNoError) return error;
+
+    // The narrow records are read once from the beginning to the end.
+    RecordArrayAdvise(array, kLargeAccessSequential);
+
+    PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_STATIC
+    for (int64_t i = 0; i < array->size; ++i) {
+        uint8_t rec = array->narrow_records[i];
+        RecordSetValue(&wide.records[i], GetNarrowValue(rec));
+        RecordSetRemoteness(&wide.records[i], GetNarrowRemoteness(rec));
+    }
+    RecordArrayDestroy(array);
+    *array = wide;
+
+    return kNoError;
+}
+
+int RecordArrayReserveRemoteness(RecordArray *array, int remoteness) {
+    if (remoteness <= RecordArrayGetRemotenessMax(array)) return kNoError;
+
+    return RecordArrayWiden(array);
+}
+
+int RecordArrayGetRemotenessMax(const RecordArray *array) {
+    if (array->narrow_records != NULL) return kNarrowRemotenessMax;
+
+    return kRemotenessMax;
+}
+
+static void SetPackedValue(RecordArray *array, Position position, Value val) {
+    RecordArrayWord *word = &array->values[position / kValuesPerWord];
+    int shift = (int)(position % kValuesPerWord) * kValueOnlyBits;
+    uint64_t mask = kValueOnlyMask << shift;
+    uint64_t bits = (uint64_t)val << shift;
+#ifdef _OPENMP
+    // Other threads may be setting the values of other positions in the same
+    // word at the same time.
+    uint64_t old = atomic_load_explicit(word, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(word, &old,
+                                                  (old & ~mask) | bits,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed)) {
+    }
+#else   // _OPENMP not defined
+    *word = (*word & ~mask) | bits;
+#endif  // _OPENMP
 }
 
 void RecordArraySetValue(RecordArray *array, Position position, Value val) {
     assert(position >= 0 && position < array->size);
+    if (array->values != NULL) {
+        SetPackedValue(array, position, val);
+        return;
+    } else if (array->narrow_records != NULL) {
+        uint8_t *rec = &array->narrow_records[position];
+        *rec = MakeNarrowRecord(val, GetNarrowRemoteness(*rec));
+        return;
+    }
+
     RecordSetValue(&array->records[position], val);
 }
 
-void RecordArraySetRemoteness(RecordArray *array, Position position,
-                              int remoteness) {
+int RecordArraySetRemoteness(RecordArray *array, Position position,
+                             int remoteness) {
     assert(position >= 0 && position < array->size);
+    if (array->values != NULL) return kNoError;  // Value-only.
+
+    // Negative remotenesses such as kUnknownRemoteness would overwrite the
+    // value bits of narrow records.
+    if (remoteness < 0) {
+        fprintf(stderr,
+                "RecordArraySetRemoteness: (BUG) illegal remoteness %d\n",
+                remoteness);
+        return kIllegalArgumentError;
+    }
+    if (remoteness > RecordArrayGetRemotenessMax(array)) {
+#ifdef _OPENMP
+        if (omp_in_parallel()) {
+            fprintf(stderr,
+                    "RecordArraySetRemoteness: (BUG) cannot widen the array "
+                    "inside a parallel region\n");
+            return kRuntimeError;
+        }
+#endif  // _OPENMP
+        int error = RecordArrayWiden(array);
+        if (error != kNoError) return error;
+    }
+
+    if (array->narrow_records != NULL) {
+        uint8_t *rec = &array->narrow_records[position];
+        *rec = MakeNarrowRecord(GetNarrowValue(*rec), remoteness);
+        return kNoError;
+    }
     RecordSetRemoteness(&array->records[position], remoteness);
+
+    return kNoError;
 }
 
 Value RecordArrayGetValue(const RecordArray *array, Position position) {
+    if (array->values != NULL) {
+#ifdef _OPENMP
+        uint64_t word = atomic_load_explicit(
+            &array->values[position / kValuesPerWord], memory_order_relaxed);
+#else   // _OPENMP not defined
+        uint64_t word = array->values[position / kValuesPerWord];
+#endif  // _OPENMP
+        return RecordArrayGetValueFromChunk(kRecordArrayFormatValueOnly, word,
+                                            position);
+    } else if (array->narrow_records != NULL) {
+        return GetNarrowValue(array->narrow_records[position]);
+    }
+
     return RecordGetValue(&array->records[position]);
 }
 
 int RecordArrayGetRemoteness(const RecordArray *array, Position position) {
+    if (array->values != NULL) return kUnknownRemoteness;
+    if (array->narrow_records != NULL) {
+        return GetNarrowRemoteness(array->narrow_records[position]);
+    }
+
     return RecordGetRemoteness(&array->records[position]);
 }
 
+int RecordArrayGetFormat(const RecordArray *array) {
+    if (array->values != NULL) return kRecordArrayFormatValueOnly;
+    if (array->narrow_records != NULL) return kRecordArrayFormatNarrow;
+
+    return kRecordArrayFormatWide;
+}
+
+int RecordArrayGetFormatFromPrefix(const void *prefix, size_t prefix_size) {
+    if (prefix_size < sizeof(RecordArrayHeader)) return kRecordArrayFormatWide;
+
+    RecordArrayHeader header;
+    memcpy(&header, prefix, sizeof(header));
+    if (memcmp(header.magic, kRecordArrayMagic, sizeof(kRecordArrayMagic))) {
+        return kRecordArrayFormatWide;
+    } else if (header.version == kRecordArrayVersionValueOnly) {
+        if (header.flags & kRecordArrayFlagValueOnly) {
+            return kRecordArrayFormatValueOnly;
+        }
+        return -1;
+    } else if (header.version != kRecordArrayVersion) {
+        return -1;
+    } else if (header.flags & kRecordArrayFlagValueOnly) {
+        return kRecordArrayFormatValueOnly;
+    } else if (header.record_bits == 8) {
+        return kRecordArrayFormatNarrow;
+    }
+
+    return -1;
+}
+
+int64_t RecordArrayGetFormatRawSize(int format, int64_t size) {
+    switch (format) {
+        case kRecordArrayFormatNarrow:
+            return (int64_t)sizeof(RecordArrayHeader) + size;
+
+        case kRecordArrayFormatValueOnly:
+            return (int64_t)sizeof(RecordArrayHeader) +
+                   GetNumValueOnlyWords(size) * (int64_t)sizeof(uint64_t);
+    }
+
+    return size * (int64_t)sizeof(Record);
+}
+
+int64_t RecordArrayGetChunkOffset(int format, Position position) {
+    switch (format) {
+        case kRecordArrayFormatNarrow:
+            return (int64_t)sizeof(RecordArrayHeader) + position;
+
+        case kRecordArrayFormatValueOnly:
+            return (int64_t)sizeof(RecordArrayHeader) +
+                   (position / kValuesPerWord) * (int64_t)sizeof(uint64_t);
+    }
+
+    return position * (int64_t)sizeof(Record);
+}
+
+int RecordArrayGetChunkSize(int format) {
+    switch (format) {
+        case kRecordArrayFormatNarrow:
+            return (int)sizeof(uint8_t);
+
+        case kRecordArrayFormatValueOnly:
+            return (int)sizeof(uint64_t);
+    }
+
+    return (int)sizeof(Record);
+}
+
+Value RecordArrayGetValueFromChunk(int format, uint64_t chunk,
+                                   Position position) {
+    switch (format) {
+        case kRecordArrayFormatNarrow:
+            return GetNarrowValue((uint8_t)chunk);
+
+        case kRecordArrayFormatValueOnly: {
+            int shift = (int)(position % kValuesPerWord) * kValueOnlyBits;
+            return (Value)((chunk >> shift) & kValueOnlyMask);
+        }
+    }
+    Record rec = (Record)chunk;
+
+    return RecordGetValue(&rec);
+}
+
+int RecordArrayGetRemotenessFromChunk(int format, uint64_t chunk,
+                                      Position position) {
+    (void)position;  // Remotenesses are never packed across chunks.
+    switch (format) {
+        case kRecordArrayFormatNarrow:
+            return GetNarrowRemoteness((uint8_t)chunk);
+
+        case kRecordArrayFormatValueOnly:
+            return kUnknownRemoteness;
+    }
+    Record rec = (Record)chunk;
+
+    return RecordGetRemoteness(&rec);
+}
+
 const void *RecordArrayGetReadOnlyData(const RecordArray *array) {
+    if (array->header != NULL) return (const void *)array->header;
+
     return (const void *)array->records;
 }
 
-void *RecordArrayGetData(RecordArray *array) { return (void *)array->records; }
+void *RecordArrayGetData(RecordArray *array) {
+    if (array->header != NULL) return (void *)array->header;
+
+    return (void *)array->records;
+}
+
+const void *RecordArrayGetPlainRecords(const RecordArray *array,
+                                       int *record_size, int *value_shift,
+                                       int *remoteness_mask) {
+    if (array->values != NULL) return NULL;
+    if (array->narrow_records != NULL) {
+        *record_size = (int)sizeof(uint8_t);
+        *value_shift = kNarrowRemotenessBits;
+        *remoteness_mask = kNarrowRemotenessMax;
+        return array->narrow_records;
+    }
+
+    *record_size = (int)sizeof(Record);
+    *value_shift = kRecordRemotenessBits;
+    *remoteness_mask = (1 << kRecordRemotenessBits) - 1;
+
+    return array->records;
+}
 
 int64_t RecordArrayGetSize(const RecordArray *array) { return array->size; }
 
 int64_t RecordArrayGetRawSize(const RecordArray *array) {
-    return array->size * (int64_t)sizeof(Record);
+    return RecordArrayGetFormatRawSize(RecordArrayGetFormat(array),
+                                       array->size);
 }
@@ -27,18 +27,91 @@
 #ifndef GAMESMANONE_CORE_DB_BPDB_RECORD_ARRAY_H_
 #define GAMESMANONE_CORE_DB_BPDB_RECORD_ARRAY_H_
 
-#include <stdint.h>  // int64_t
+#include <stdbool.h>  // bool
+#include <stddef.h>   // size_t
+#include <stdint.h>   // int64_t, uint8_t, uint32_t, uint64_t
 
 #include "core/db/arraydb/record.h"
+#include "core/large_alloc.h"
+#include "core/types/gamesman_types.h"
+
+#ifdef _OPENMP
+#include <stdatomic.h>
+#endif  // _OPENMP
+
+/**
+ * @brief Header at the beginning of a \c RecordArray in a compact format.
+ *
+ * @details A \c RecordArray of 16-bit records is stored as is, without a
+ * header. Compact formats store this header in front of the records so that
+ * readers can tell them apart. When the first two bytes of the magic string are
+ * interpreted as a 16-bit \c Record, the remoteness field is larger than
+ * \c kRemotenessMax, which never happens in a valid array of 16-bit records.
+ */
+typedef struct RecordArrayHeader {
+    char magic[8];         /**< Always equal to "GMRECARR". */
+    uint32_t version;      /**< Format version, currently 2. */
+    uint32_t flags;        /**< Bitwise OR of \c RecordArrayFlags. */
+    int64_t size;          /**< Number of records in the array. */
+    uint32_t record_bits;  /**< Number of bits per record, 8 or 3. */
+    uint32_t reserved;     /**< Reserved, always 0. */
+} RecordArrayHeader;
+
+/** @brief Format flags stored in \c RecordArrayHeader::flags. */
+enum RecordArrayFlags {
+    /** Only values are stored, 3 bits per record, and the remoteness of every
+     * record is \c kUnknownRemoteness. */
+    kRecordArrayFlagValueOnly = 1 << 0,
+};
+
+/** @brief Storage formats of a \c RecordArray. */
+enum RecordArrayFormat {
+    /** 16-bit records without a header. */
+    kRecordArrayFormatWide,
+
+    /** Header followed by 8-bit records, each holding a 3-bit value and a
+     * 5-bit remoteness. Widened automatically into \c kRecordArrayFormatWide
+     * when a remoteness larger than 31 is set. */
+    kRecordArrayFormatNarrow,
+
+    /** Header followed by 3-bit values packed 21 per 64-bit word. */
+    kRecordArrayFormatValueOnly,
+};
+
+#ifdef _OPENMP
+typedef _Atomic uint64_t RecordArrayWord;
+#else   // _OPENMP not defined
+typedef uint64_t RecordArrayWord;
+#endif  // _OPENMP
 
 /** @brief Fixed-length \c Record array. */
 typedef struct RecordArray {
+    /** 16-bit records, or NULL if the array is in a compact format. */
     Record *records;
+
+    /** Header in front of the compact records, or NULL if the array is not in
+     * a compact format. */
+    RecordArrayHeader *header;
+
+    /** 8-bit records following the header, or NULL if the array is not in
+     * narrow format. */
+    uint8_t *narrow_records;
+
+    /** Packed values following the header, or NULL if the array is not in
+     * value-only format. */
+    RecordArrayWord *values;
+
+    /** Number of records in the array. */
     int64_t size;
+
+    /** Directory of the temporary file backing the records, or NULL if the
+     * records are stored in memory. Not owned by the array. */
+    const char *backing_dir;
 } RecordArray;
 
 /**
- * @brief Initializes \p array to \p size elements.
+ * @brief Initializes \p array to \p size elements in the default 16-bit
+ * format.
  * @note Assumes \p array is uninitialized. Results in undefined behavior if
  * \p array has been initialized with a prior call to the same function.
  *
@@ -50,6 +123,42 @@ typedef struct RecordArray {
  */
 int RecordArrayInit(RecordArray *array, int64_t size);
 
+/**
+ * @brief Initializes \p array to \p size elements in the given \p format.
+ * @note Assumes \p array is uninitialized.
+ *
+ * @param array Array to be initialized.
+ * @param size Size of the new array in number of \c Records.
+ * @param format One of the values from enum \c RecordArrayFormat.
+ * @return \c kNoError on success, or
+ * @return \c kMallocFailureError if malloc fails to allocate enough space for
+ * \p size records.
+ */
+int RecordArrayInitFormat(RecordArray *array, int64_t size, int format);
+
+/**
+ * @brief Same as \c RecordArrayInitFormat, except that the records are
+ * backed by a temporary file in the directory \p dir instead of memory if
+ * \p dir is not NULL. See \c LargeCallocFileBacked. An array that is widened
+ * later stays backed by a file in the same directory.
+ * @note \p dir must remain valid until \p array is destroyed.
+ * @param array Array to be initialized.
+ * @param size Size of the new array in number of \c Records.
+ * @param format One of the values from enum \c RecordArrayFormat.
+ * @param dir Directory on fast local storage, or NULL.
+ * @return \c kNoError on success, or
+ * @return \c kMallocFailureError if the backing file or memory cannot be
+ * allocated.
+ */
+int RecordArrayInitFormatFileBacked(RecordArray *array, int64_t size,
+                                    int format, const char *dir);
+
+/**
+ * @brief Advises the kernel that the records of \p array will be accessed
+ * following \p pattern. Does nothing unless \p array is backed by a file.
+ */
+void RecordArrayAdvise(RecordArray *array, LargeAccessPattern pattern);
+
 /**
  * @brief Deallocates the \p array.
  *
@@ -57,6 +166,38 @@ int RecordArrayInit(RecordArray *array, int64_t size);
  */
 void RecordArrayDestroy(RecordArray *array);
 
+/**
+ * @brief Converts \p array from narrow format into the 16-bit format, keeping
+ * all of its records. Does nothing if \p array is not in narrow format.
+ * @note Not thread-safe. No other thread may access \p array while it is being
+ * widened.
+ *
+ * @param array Target array.
+ * @return \c kNoError on success, or
+ * @return \c kMallocFailureError on failure to allocate the new records, in
+ * which case \p array is left unchanged.
+ */
+int RecordArrayWiden(RecordArray *array);
+
+/**
+ * @brief Widens \p array if necessary so that remotenesses up to
+ * \p remoteness can be stored in it. This must be called outside of parallel
+ * regions before remotenesses larger than the current
+ * \c RecordArrayGetRemotenessMax are set from multiple threads.
+ *
+ * @param array Target array.
+ * @param remoteness Largest remoteness to be stored.
+ * @return \c kNoError on success, or
+ * @return \c kMallocFailureError on failure to widen \p array.
+ */
+int RecordArrayReserveRemoteness(RecordArray *array, int remoteness);
+
+/**
+ * @brief Returns the largest remoteness that can be stored in \p array without
+ * widening it.
+ */
+int RecordArrayGetRemotenessMax(const RecordArray *array);
+
 /**
  * @brief Sets the value of position \p position in \p array to \p val. Assumes
  * \p position is greater than or equal to 0 and smaller than the size of \p
@@ -70,15 +211,21 @@ void RecordArraySetValue(RecordArray *array, Position position, Value val);
 
 /**
  * @brief Sets the remoteness of position \p position in \p array to
- * \p remoteness. Assumes \p position is greater than or equal to 0 and smaller
- * than the size of \p array.
+ * \p remoteness, widening \p array first if \p remoteness does not fit. Assumes
+ * \p position is greater than or equal to 0 and smaller than the size of
+ * \p array. Does nothing if \p array is in value-only format.
  *
  * @param array Target array.
  * @param position Position.
  * @param remoteness New remoteness for the \p position.
+ * @return \c kNoError on success,
+ * @return \c kIllegalArgumentError if \p remoteness is negative,
+ * @return \c kMallocFailureError on failure to widen \p array, or
+ * @return \c kRuntimeError if \p array needs to be widened inside a parallel
+ * region. See \c RecordArrayReserveRemoteness.
  */
-void RecordArraySetRemoteness(RecordArray *array, Position position,
-                              int remoteness);
+int RecordArraySetRemoteness(RecordArray *array, Position position,
+                             int remoteness);
 
 /**
  * @brief Returns the \c Value of \p position in the given \p array, assumes
@@ -98,16 +245,70 @@ Value RecordArrayGetValue(const RecordArray *array, Position position);
  *
  * @param array Source array.
  * @param position Position.
- * @return Remoteness of \p position.
+ * @return Remoteness of \p position, or
+ * @return \c kUnknownRemoteness if \p array is in value-only format.
  */
 int RecordArrayGetRemoteness(const RecordArray *array, Position position);
 
+/**
+ * @brief Returns the storage format of \p array, which is one of the values
+ * from enum \c RecordArrayFormat.
+ */
+int RecordArrayGetFormat(const RecordArray *array);
+
+/**
+ * @brief Returns the storage format of the \c RecordArray whose raw data
+ * begins with \p prefix, which holds the first \p prefix_size bytes of the
+ * data.
+ *
+ * @param prefix Beginning of the raw data of a \c RecordArray.
+ * @param prefix_size Number of bytes in \p prefix.
+ * @return One of the values from enum \c RecordArrayFormat, or
+ * @return -1 if \p prefix begins with a header of an unsupported version.
+ */
+int RecordArrayGetFormatFromPrefix(const void *prefix, size_t prefix_size);
+
+/**
+ * @brief Returns the size in bytes of a \c RecordArray of \p size records in
+ * the given \p format, including the header.
+ */
+int64_t RecordArrayGetFormatRawSize(int format, int64_t size);
+
+/**
+ * @brief Returns the byte offset into the raw data of a \c RecordArray in the
+ * given \p format of the chunk that holds the record of \p position. The chunk
+ * is 2 bytes long in the 16-bit format, 1 byte long in narrow format, and 8
+ * bytes long in value-only format.
+ */
+int64_t RecordArrayGetChunkOffset(int format, Position position);
+
+/** @brief Returns the size in bytes of each chunk in the given \p format. */
+int RecordArrayGetChunkSize(int format);
+
+/**
+ * @brief Returns the value of \p position extracted from \p chunk, which must
+ * hold the chunk at \c RecordArrayGetChunkOffset(format, position) in the raw
+ * data of a \c RecordArray in the given \p format.
+ */
+Value RecordArrayGetValueFromChunk(int format, uint64_t chunk,
+                                   Position position);
+
+/**
+ * @brief Returns the remoteness of \p position extracted from \p chunk, which
+ * must hold the chunk at \c RecordArrayGetChunkOffset(format, position) in
+ * the raw data of a \c RecordArray in the given \p format.
+ */
+int RecordArrayGetRemotenessFromChunk(int format, uint64_t chunk,
+                                      Position position);
+
 /**
  * @brief Returns a read-only direct pointer to the memory array used internally
  * by the \c RecordArray to store its elements.
  *
  * @param array Source array.
- * @return Read-only direct pointer to the memory array.
+ * @return Read-only direct pointer to the memory array, which begins with the
+ * header if \p array is in a compact format, or NULL if \p array is
+ * uninitialized.
  */
 const void *RecordArrayGetReadOnlyData(const RecordArray *array);
 
@@ -116,10 +317,23 @@ const void *RecordArrayGetReadOnlyData(const RecordArray *array);
  * by the \c RecordArray to store its elements.
  *
  * @param array Source array.
- * @return Direct pointer to the memory array.
+ * @return Direct pointer to the memory array, which begins with the header if
+ * \p array is in a compact format, or NULL if \p array is uninitialized.
  */
 void *RecordArrayGetData(RecordArray *array);
 
+/**
+ * @brief Returns a read-only pointer to the records of \p array if each record
+ * is stored as a plain unsigned integer, or NULL if \p array is in
+ * \c kRecordArrayFormatValueOnly. On success, stores the size of each record
+ * in bytes into \p record_size, the position of the lowest value bit into
+ * \p value_shift, and the mask of the remoteness bits into
+ * \p remoteness_mask.
+ */
+const void *RecordArrayGetPlainRecords(const RecordArray *array,
+                                       int *record_size, int *value_shift,
+                                       int *remoteness_mask);
+
 /**
  * @brief Returns the size of \p array in number of \c Records.
  *
@@ -129,7 +343,8 @@ void *RecordArrayGetData(RecordArray *array);
 int64_t RecordArrayGetSize(const RecordArray *array);
 
 /**
- * @brief Returns the size of \p array in bytes.
+ * @brief Returns the size of \p array in bytes, including the header if
+ * \p array is in a compact format.
  *
  * @param array Target array.
  * @return Size of \p array in bytes.
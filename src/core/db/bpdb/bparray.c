@@ -35,8 +35,8 @@
 #include <stddef.h>   // NULL
 #include <stdint.h>   // int8_t, uint8_t, int32_t, int64_t, uint64_t
 #include <stdio.h>    // fprintf, stderr
-#include <stdlib.h>   // calloc, free
-#include <string.h>   // memset
+#include <stdlib.h>   // calloc, realloc, free
+#include <string.h>   // memcpy, memset
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -79,6 +79,15 @@ static bool ExpansionNeeded(const BpArray *array, uint64_t entry);
 static int BpArrayExpand(BpArray *array);
 static int ExpandHelper(BpArray *array, int new_bits_per_entry);
 
+static int BuildStep0CollectEntries(BpArray *array, int64_t size,
+                                    uint64_t (*GetEntry)(int64_t i,
+                                                         const void *aux),
+                                    const void *aux);
+static int BuildStep1PackEntries(BpArray *array,
+                                 uint64_t (*GetEntry)(int64_t i,
+                                                      const void *aux),
+                                 const void *aux);
+
 // -----------------------------------------------------------------------------
 
 int BpArrayInit(BpArray *array, int64_t size) {
@@ -106,6 +115,74 @@ int BpArrayInit(BpArray *array, int64_t size) {
     return kNoError;
 }
 
+int BpArrayBuild(BpArray *array, int64_t size,
+                 uint64_t (*GetEntry)(int64_t i, const void *aux),
+                 const void *aux) {
+    memset(array, 0, sizeof(*array));
+    array->meta.num_entries = size;
+    int error = BpDictInit(&array->dict);
+    if (error != 0) {
+        fprintf(stderr,
+                "BpArrayBuild: failed to initialize BP dictionary, code %d\n",
+                error);
+        return error;
+    }
+
+    error = BuildStep0CollectEntries(array, size, GetEntry, aux);
+    if (error != 0) {
+        BpArrayDestroy(array);
+        return error;
+    }
+
+    error = BuildStep1PackEntries(array, GetEntry, aux);
+    if (error != 0) {
+        BpArrayDestroy(array);
+        return error;
+    }
+
+    return kNoError;
+}
+
+int BpArrayInitFromDict(BpArray *array, const BpArrayMeta *meta,
+                        const int32_t *decomp_dict, int32_t num_unique) {
+    memset(array, 0, sizeof(*array));
+    int bits_per_entry = meta->bits_per_entry;
+    if (meta->num_entries < 0 || bits_per_entry < 1 ||
+        bits_per_entry > kMaxBitsPerEntry || num_unique < 1 ||
+        num_unique > ((int64_t)1 << bits_per_entry) || decomp_dict[0] != 0 ||
+        meta->stream_length !=
+            GetStreamLength(meta->num_entries, bits_per_entry)) {
+        return kIllegalArgumentError;
+    }
+
+    int error = BpDictInit(&array->dict);
+    if (error != 0) return error;
+
+    // Entry 0 is mapped to 0 by BpDictInit. The remaining entries are mapped
+    // in order so that each entry keeps its encoding.
+    for (int32_t i = 1; i < num_unique; ++i) {
+        int32_t key = decomp_dict[i];
+        if (key < 0 || BpDictGet(&array->dict, key) >= 0) {
+            BpArrayDestroy(array);
+            return kIllegalArgumentError;
+        }
+        error = BpDictSet(&array->dict, key);
+        if (error != 0) {
+            BpArrayDestroy(array);
+            return error;
+        }
+    }
+
+    array->stream = (uint8_t *)calloc(meta->stream_length, sizeof(uint8_t));
+    if (array->stream == NULL) {
+        BpArrayDestroy(array);
+        return kMallocFailureError;
+    }
+    array->meta = *meta;
+
+    return kNoError;
+}
+
 void BpArrayDestroy(BpArray *array) {
     free(array->stream);
     BpDictDestroy(&array->dict);
@@ -275,3 +352,151 @@ static int ExpandHelper(BpArray *array, int new_bits_per_entry) {
     array->meta.stream_length = new_stream_length;
     return kNoError;
 }
+
+// Per-thread set of unique entries seen during the first build step, stored as
+// an entry-indexed array of flags.
+typedef struct {
+    uint8_t *seen;
+    int64_t size;
+} BpArrayEntrySet;
+
+static bool EntrySetAdd(BpArrayEntrySet *set, uint64_t entry) {
+    if ((int64_t)entry >= set->size) {
+        int64_t new_size = set->size == 0 ? 64 : set->size;
+        while (new_size <= (int64_t)entry) new_size *= 2;
+        uint8_t *new_seen = (uint8_t *)realloc(set->seen, new_size);
+        if (new_seen == NULL) return false;
+
+        memset(new_seen + set->size, 0, new_size - set->size);
+        set->seen = new_seen;
+        set->size = new_size;
+    }
+    set->seen[entry] = 1;
+
+    return true;
+}
+
+static int GetNumThreads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else   // _OPENMP not defined
+    return 1;
+#endif  // _OPENMP
+}
+
+static int GetThreadId(void) {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else   // _OPENMP not defined, thread 0 is the only available thread.
+    return 0;
+#endif  // _OPENMP
+}
+
+// Collects all unique entries of the array in parallel, inserts them into the
+// dictionary in ascending order, and allocates a zero-initialized stream with
+// just enough bits per entry to store their encodings.
+static int BuildStep0CollectEntries(BpArray *array, int64_t size,
+                                    uint64_t (*GetEntry)(int64_t i,
+                                                         const void *aux),
+                                    const void *aux) {
+    int num_threads = GetNumThreads();
+    BpArrayEntrySet *sets =
+        (BpArrayEntrySet *)calloc(num_threads, sizeof(BpArrayEntrySet));
+    if (sets == NULL) return kMallocFailureError;
+
+    ConcurrentBool success;
+    ConcurrentBoolInit(&success, true);
+    PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_STATIC
+    for (int64_t i = 0; i < size; ++i) {
+        uint64_t entry = GetEntry(i, aux);
+        bool added =
+            entry <= INT32_MAX && EntrySetAdd(&sets[GetThreadId()], entry);
+        if (!added) ConcurrentBoolStore(&success, false);
+    }
+
+    // Merge the per-thread sets into the dictionary. Entry 0 is always mapped
+    // to 0 by BpDictInit.
+    int error = kNoError;
+    if (!ConcurrentBoolLoad(&success)) {
+        fprintf(stderr,
+                "BpArrayBuild: entry too large or failed to realloc entry "
+                "set\n");
+        error = kRuntimeError;
+    }
+    int64_t max_size = 0;
+    for (int t = 0; t < num_threads; ++t) {
+        if (sets[t].size > max_size) max_size = sets[t].size;
+    }
+    for (int64_t entry = 1; entry < max_size && error == kNoError; ++entry) {
+        for (int t = 0; t < num_threads; ++t) {
+            if (entry >= sets[t].size || !sets[t].seen[entry]) continue;
+            error = BpDictSet(&array->dict, (int32_t)entry);
+            break;
+        }
+    }
+    for (int t = 0; t < num_threads; ++t) {
+        free(sets[t].seen);
+    }
+    free(sets);
+    if (error != kNoError) return error;
+
+    int bits_per_entry = kDefaultBitsPerEntry;
+    while (((int64_t)1 << bits_per_entry) < array->dict.num_unique) {
+        ++bits_per_entry;
+    }
+    if (bits_per_entry > kMaxBitsPerEntry) return kIntegerOverflowError;
+
+    array->meta.bits_per_entry = (int8_t)bits_per_entry;
+    array->meta.stream_length = GetStreamLength(size, bits_per_entry);
+    array->stream =
+        (uint8_t *)calloc(array->meta.stream_length, sizeof(uint8_t));
+    if (array->stream == NULL) return kMallocFailureError;
+
+    return kNoError;
+}
+
+// Encodes and packs the entries of group GROUP, which consists of 64 entries
+// and therefore occupies exactly bits_per_entry 64-bit words of the stream.
+static void PackGroup(BpArray *array, int64_t group,
+                      uint64_t (*GetEntry)(int64_t i, const void *aux),
+                      const void *aux) {
+    static const int kBitsPerWord = kBitsPerByte * sizeof(uint64_t);
+    int bits_per_entry = array->meta.bits_per_entry;
+    int64_t begin = group * kBitsPerWord;
+    int64_t end = begin + kBitsPerWord;
+    if (end > array->meta.num_entries) end = array->meta.num_entries;
+    uint8_t *dest =
+        array->stream + group * bits_per_entry * (int64_t)sizeof(uint64_t);
+
+    uint64_t word = 0;
+    int filled = 0;
+    for (int64_t i = begin; i < end; ++i) {
+        int32_t key = (int32_t)GetEntry(i, aux);
+        uint64_t compressed = (uint64_t)BpDictGet(&array->dict, key);
+        word |= compressed << filled;
+        filled += bits_per_entry;
+        if (filled >= kBitsPerWord) {
+            memcpy(dest, &word, sizeof(word));
+            dest += sizeof(word);
+            filled -= kBitsPerWord;
+
+            // Carry the bits of the current entry that did not fit.
+            word = filled > 0 ? compressed >> (bits_per_entry - filled) : 0;
+        }
+    }
+    if (filled > 0) memcpy(dest, &word, sizeof(word));
+}
+
+static int BuildStep1PackEntries(BpArray *array,
+                                 uint64_t (*GetEntry)(int64_t i,
+                                                      const void *aux),
+                                 const void *aux) {
+    static const int kBitsPerWord = kBitsPerByte * sizeof(uint64_t);
+    int64_t num_groups = RoundUpDivide(array->meta.num_entries, kBitsPerWord);
+    PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_STATIC
+    for (int64_t group = 0; group < num_groups; ++group) {
+        PackGroup(array, group, GetEntry, aux);
+    }
+
+    return kNoError;
+}
@@ -85,6 +85,50 @@ typedef struct BpArray {
  */
 int BpArrayInit(BpArray *array, int64_t size);
 
+/**
+ * @brief Initializes the given ARRAY to the given SIZE and sets entry I to
+ * GetEntry(I, AUX) for each I in [0, SIZE), using all available threads.
+ * @details Unlike BpArraySet, which may expand the bit stream and extend the
+ * dictionary on every call, the array is built in two phases. The set of
+ * unique entries is first collected in parallel, which fixes the dictionary
+ * and the number of bits per entry. Entries are then encoded and packed in
+ * parallel, with each thread writing groups of 64 entries that occupy
+ * disjoint 64-bit words of the stream. Unique entries are encoded in
+ * ascending order, so the result does not depend on the number of threads.
+ * @note Assumes ARRAY is uninitialized. May result in memory leak and other
+ * undefined behaviors otherwise. GetEntry must be thread-safe and must return
+ * the same entry when called more than once with the same index.
+ * @param array Array to initialize.
+ * @param size Size of the array in number of entries.
+ * @param GetEntry Function that returns the I-th entry of the array.
+ * @param aux Auxiliary parameter passed to GetEntry.
+ * @return 0 on success or
+ * @return non-zero error code otherwise.
+ */
+int BpArrayBuild(BpArray *array, int64_t size,
+                 uint64_t (*GetEntry)(int64_t i, const void *aux),
+                 const void *aux);
+
+/**
+ * @brief Initializes the given ARRAY to hold META.num_entries entries of
+ * META.bits_per_entry bits each, encoded using the decompression dictionary
+ * DECOMP_DICT of NUM_UNIQUE entries. The bit stream is zero-initialized so
+ * that it can be filled in directly, for example by decompressing a stream
+ * previously written from an array with the same metadata and dictionary.
+ * @note Assumes ARRAY is uninitialized. May result in memory leak and other
+ * undefined behaviors otherwise.
+ * @param array Array to initialize.
+ * @param meta Metadata of the array.
+ * @param decomp_dict Decompression dictionary, which maps encodings to
+ * entries. The first entry must be 0.
+ * @param num_unique Number of entries in DECOMP_DICT.
+ * @return 0 on success,
+ * @return kIllegalArgumentError if META or DECOMP_DICT is invalid, or
+ * @return non-zero error code otherwise.
+ */
+int BpArrayInitFromDict(BpArray *array, const BpArrayMeta *meta,
+                        const int32_t *decomp_dict, int32_t num_unique);
+
 /** @brief Destroys the given ARRAY. */
 void BpArrayDestroy(BpArray *array);
 
@@ -26,13 +26,27 @@
 
 #include "core/db/bpdb/bpdb_file.h"
 
-#include <stddef.h>  // NULL
-#include <stdio.h>   // fprintf, stderr, sprintf
-#include <stdlib.h>  // calloc, free
-#include <string.h>  // strlen, strcat
+#include <errno.h>      // errno, EINTR
+#include <fcntl.h>      // O_RDONLY
+#include <stdbool.h>    // bool, true, false
+#include <stddef.h>     // NULL
+#include <stdint.h>     // int32_t, int64_t, uint8_t, uint64_t
+#include <stdio.h>      // fprintf, stderr, sprintf, FILE
+#include <stdlib.h>     // calloc, malloc, free
+#include <string.h>     // memcpy, memset, strlen, strcat
+#include <sys/stat.h>   // fstat, struct stat
+#include <sys/types.h>  // ssize_t, off_t
+#include <unistd.h>     // pread
+#include <zlib.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // _OPENMP
+
+#include "core/concurrency.h"
 #include "core/constants.h"
 #include "core/db/bpdb/bparray.h"
+#include "core/db/bpdb/bprans.h"
 #include "core/misc.h"
 #include "core/types/gamesman_types.h"
 #include "libs/mgz/mgz.h"
@@ -43,10 +57,12 @@ static const bool kMgzLookupNeeded = true;
 
 static mgz_res_t FlushStep0MgzCompress(BpdbFileHeader *header,
                                        const BpArray *stream);
-static int FlushStep1WriteToFile(ReadOnlyString full_path,
-                                 const BpdbFileHeader *header,
+static int FlushStep1WriteToFile(FILE *db_file, const BpdbFileHeader *header,
                                  const int32_t *decomp_dict, mgz_res_t result);
 
+static int FlushV2(FILE *db_file, const BpArray *records, int scale_bits,
+                   int64_t size_limit, bool *written);
+
 // -----------------------------------------------------------------------------
 
 char *BpdbFileGetFullPath(ConstantReadOnlyString sandbox_path, Tier tier,
@@ -90,24 +106,60 @@ char *BpdbFileGetFullPathToFinishFlag(ConstantReadOnlyString sandbox_path) {
 }
 
 int BpdbFileFlush(ReadOnlyString full_path, const BpArray *records) {
-    int32_t num_unique_values = BpArrayGetNumUniqueValues(records);
+    // Write to a temp file first so that a partially written tier file never
+    // appears under the final name, then rename it.
+    char *tmp_full_path = (char *)malloc(strlen(full_path) + 5);
+    if (tmp_full_path == NULL) return kMallocFailureError;
+    sprintf(tmp_full_path, "%s.tmp", full_path);
 
+    int error = kFileSystemError;
+    FILE *db_file = GuardedFopen(tmp_full_path, "wb");
+    if (db_file != NULL) {
+        error = BpdbFileWrite(db_file, records);
+        if (error != kNoError) {
+            BailOutFclose(db_file, error);
+        } else if (GuardedFclose(db_file) != 0) {
+            error = kFileSystemError;
+        }
+    }
+    if (error == kNoError && GuardedRename(tmp_full_path, full_path) != 0) {
+        error = kFileSystemError;
+    }
+    free(tmp_full_path);
+
+    return error;
+}
+
+int BpdbFileWrite(FILE *db_file, const BpArray *records) {
+    // Compress stream using mgz.
+    int32_t num_unique_values = BpArrayGetNumUniqueValues(records);
     BpdbFileHeader header;
     header.decomp_dict_meta.size = num_unique_values * (int32_t)sizeof(int32_t);
     header.stream_meta = records->meta;
-
-    // Compress stream using mgz
     mgz_res_t result = FlushStep0MgzCompress(&header, records);
     if (result.out == NULL) {
         fprintf(stderr,
-                "BpdbLiteFlushSolvingTier: failed to compress records using "
-                "mgz.\n");
+                "BpdbFileWrite: failed to compress records using mgz.\n");
         return kMallocFailureError;
     }
 
-    // Write compressed data to file.
-    const int32_t *decomp_dict = BpArrayGetDecompDict(records);
-    return FlushStep1WriteToFile(full_path, &header, decomp_dict, result);
+    // Write a version 2 file instead if the rANS codec supports the records
+    // and produces a smaller file. Otherwise, write the mgz compressed stream.
+    int error = kNoError;
+    bool written = false;
+    int scale_bits = BpRansGetScaleBits(num_unique_values);
+    if (scale_bits > 0) {
+        int64_t v1_size = header.lookup_meta.size + result.size;
+        error = FlushV2(db_file, records, scale_bits, v1_size, &written);
+    }
+    if (!written && error == kNoError) {
+        const int32_t *decomp_dict = BpArrayGetDecompDict(records);
+        error = FlushStep1WriteToFile(db_file, &header, decomp_dict, result);
+    }
+    free(result.lookup);
+    free(result.out);
+
+    return error;
 }
 
 int64_t BpdbFileGetBlockSize(int bits_per_entry) {
@@ -146,34 +198,546 @@ static mgz_res_t FlushStep0MgzCompress(BpdbFileHeader *header,
     return result;
 }
 
-static int FlushStep1WriteToFile(ReadOnlyString full_path,
-                                 const BpdbFileHeader *header,
+static int FlushStep1WriteToFile(FILE *db_file, const BpdbFileHeader *header,
                                  const int32_t *decomp_dict, mgz_res_t result) {
-    // Write header to file.
-    FILE *db_file = GuardedFopen(full_path, "wb");
-    if (db_file == NULL) return kFileSystemError;
-
+    // Write header.
     int error = GuardedFwrite(header, sizeof(*header), 1, db_file);
-    if (error != 0) return BailOutFclose(db_file, error);
+    if (error != 0) return error;
 
     // Write decomp dict.
     error =
         GuardedFwrite(decomp_dict, 1, header->decomp_dict_meta.size, db_file);
-    if (error != 0) return BailOutFclose(db_file, error);
+    if (error != 0) return error;
 
     // Write mgz lookup table.
     error = GuardedFwrite(result.lookup, sizeof(int64_t), result.num_blocks,
                           db_file);
-    if (error != 0) return BailOutFclose(db_file, error);
-    free(result.lookup);
-    result.lookup = NULL;
+    if (error != 0) return error;
 
     // Write mgz compressed stream.
-    error = GuardedFwrite(result.out, 1, result.size, db_file);
-    if (error != 0) return BailOutFclose(db_file, error);
-    free(result.out);
-    result.out = NULL;
+    return GuardedFwrite(result.out, 1, result.size, db_file);
+}
+
+static int GetNumThreads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else   // _OPENMP not defined
+    return 1;
+#endif  // _OPENMP
+}
+
+static int GetThreadId(void) {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else   // _OPENMP not defined, thread 0 is the only available thread.
+    return 0;
+#endif  // _OPENMP
+}
+
+// Counts the occurrences of each dictionary index in each context of the
+// blocks of RECORDS of BLOCK_SIZE bytes in parallel and builds a rANS model
+// from the counts.
+static int FlushV2Step0BuildModel(const BpArray *records, int64_t block_size,
+                                  int scale_bits, BpRansModel *model) {
+    int32_t num_symbols = BpArrayGetNumUniqueValues(records);
+    int32_t num_contexts = BpRansGetNumContexts(num_symbols, scale_bits);
+    int64_t num_counts = (int64_t)num_symbols * num_contexts;
+    int num_threads = GetNumThreads();
+    int64_t *counts =
+        (int64_t *)calloc((int64_t)num_threads * num_counts, sizeof(int64_t));
+    if (counts == NULL) return kMallocFailureError;
+
+    int bits_per_entry = records->meta.bits_per_entry;
+    int64_t num_entries = records->meta.num_entries;
+    int64_t entries_per_block = block_size * kBitsPerByte / bits_per_entry;
+    int64_t num_blocks = RoundUpDivide(num_entries, entries_per_block);
+    PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_DYNAMIC(1)
+    for (int64_t i = 0; i < num_blocks; ++i) {
+        int64_t size = num_entries - i * entries_per_block;
+        if (size > entries_per_block) size = entries_per_block;
+        BpRansCountBlock(records->stream + i * block_size, size,
+                         bits_per_entry, num_symbols, num_contexts,
+                         counts + (int64_t)GetThreadId() * num_counts);
+    }
+    for (int t = 1; t < num_threads; ++t) {
+        for (int64_t j = 0; j < num_counts; ++j) {
+            counts[j] += counts[(int64_t)t * num_counts + j];
+        }
+    }
+
+    int error = BpRansModelInit(model, counts, num_symbols, num_contexts,
+                                scale_bits);
+    free(counts);
+
+    return error;
+}
+
+// Encoded blocks of a version 2 file.
+typedef struct {
+    uint8_t **data;
+    int64_t *sizes;
+    int64_t num_blocks;
+} EncodedBlocks;
+
+static void EncodedBlocksDestroy(EncodedBlocks *blocks) {
+    if (blocks->data != NULL) {
+        for (int64_t i = 0; i < blocks->num_blocks; ++i) {
+            free(blocks->data[i]);
+        }
+    }
+    free(blocks->data);
+    free(blocks->sizes);
+    memset(blocks, 0, sizeof(*blocks));
+}
+
+// Encodes each block of RECORDS of BLOCK_SIZE bytes in parallel.
+static int FlushV2Step1EncodeBlocks(const BpArray *records,
+                                    const BpRansModel *model,
+                                    int64_t block_size,
+                                    EncodedBlocks *blocks) {
+    int bits_per_entry = records->meta.bits_per_entry;
+    int64_t num_entries = records->meta.num_entries;
+    int64_t entries_per_block = block_size * kBitsPerByte / bits_per_entry;
+    blocks->num_blocks = RoundUpDivide(num_entries, entries_per_block);
+    blocks->data = (uint8_t **)calloc(blocks->num_blocks, sizeof(uint8_t *));
+    blocks->sizes = (int64_t *)calloc(blocks->num_blocks, sizeof(int64_t));
+    if (blocks->num_blocks > 0 &&
+        (blocks->data == NULL || blocks->sizes == NULL)) {
+        EncodedBlocksDestroy(blocks);
+        return kMallocFailureError;
+    }
+
+    ConcurrentBool success;
+    ConcurrentBoolInit(&success, true);
+    PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_DYNAMIC(1)
+    for (int64_t i = 0; i < blocks->num_blocks; ++i) {
+        int64_t first_entry = i * entries_per_block;
+        int64_t size = num_entries - first_entry;
+        if (size > entries_per_block) size = entries_per_block;
+        uint8_t *out = (uint8_t *)malloc(BpRansGetEncodeBound(size));
+        if (out == NULL) {
+            ConcurrentBoolStore(&success, false);
+            continue;
+        }
+        blocks->sizes[i] =
+            BpRansEncode(model, records->stream + i * block_size, size,
+                         bits_per_entry, out);
+        blocks->data[i] = out;
+    }
+    if (!ConcurrentBoolLoad(&success)) {
+        EncodedBlocksDestroy(blocks);
+        return kMallocFailureError;
+    }
+
+    return kNoError;
+}
+
+static int FlushV2Step2WriteToFile(FILE *db_file,
+                                   const BpdbFileV2Prefix *prefix,
+                                   const BpdbFileHeader *header,
+                                   const int32_t *decomp_dict,
+                                   const BpRansModel *model,
+                                   const EncodedBlocks *blocks) {
+    int64_t *lookup =
+        (int64_t *)malloc((blocks->num_blocks + 1) * sizeof(int64_t));
+    if (lookup == NULL) return kMallocFailureError;
+
+    int64_t offset = 0;
+    for (int64_t i = 0; i < blocks->num_blocks; ++i) {
+        lookup[i] = offset;
+        offset += blocks->sizes[i];
+    }
+
+    int error = GuardedFwrite(prefix, sizeof(*prefix), 1, db_file);
+    if (error != 0) goto _bailout;
+    error = GuardedFwrite(header, sizeof(*header), 1, db_file);
+    if (error != 0) goto _bailout;
+    error =
+        GuardedFwrite(decomp_dict, 1, header->decomp_dict_meta.size, db_file);
+    if (error != 0) goto _bailout;
+    error = GuardedFwrite(model->freqs, sizeof(uint32_t),
+                          (int64_t)model->num_symbols * model->num_contexts,
+                          db_file);
+    if (error != 0) goto _bailout;
+    error = GuardedFwrite(lookup, sizeof(int64_t), blocks->num_blocks, db_file);
+    if (error != 0) goto _bailout;
+    for (int64_t i = 0; i < blocks->num_blocks; ++i) {
+        error = GuardedFwrite(blocks->data[i], 1, blocks->sizes[i], db_file);
+        if (error != 0) goto _bailout;
+    }
+
+_bailout:
+    free(lookup);
+    return error;
+}
+
+// Writes RECORDS to DB_FILE as a version 2 file if the file would be smaller
+// than SIZE_LIMIT bytes, not counting the header and the decompression
+// dictionary shared by both versions. Sets WRITTEN to whether the file was
+// written.
+static int FlushV2(FILE *db_file, const BpArray *records, int scale_bits,
+                   int64_t size_limit, bool *written) {
+    *written = false;
+    int64_t block_size = BpdbFileGetBlockSize(records->meta.bits_per_entry);
+    BpRansModel model;
+    int error =
+        FlushV2Step0BuildModel(records, block_size, scale_bits, &model);
+    if (error != kNoError) return error;
+
+    EncodedBlocks blocks = {0};
+    error = FlushV2Step1EncodeBlocks(records, &model, block_size, &blocks);
+    if (error != kNoError) {
+        BpRansModelDestroy(&model);
+        return error;
+    }
+
+    BpdbFileV2Prefix prefix = {
+        .magic = kBpdbFileV2Magic,
+        .scale_bits = scale_bits,
+        .num_contexts = model.num_contexts,
+    };
+    BpdbFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.decomp_dict_meta.size =
+        BpArrayGetNumUniqueValues(records) * (int32_t)sizeof(int32_t);
+    header.lookup_meta.block_size = block_size;
+    header.lookup_meta.size = blocks.num_blocks * (int64_t)sizeof(int64_t);
+    header.stream_meta = records->meta;
+
+    int64_t size = (int64_t)sizeof(prefix) + header.lookup_meta.size +
+                   (int64_t)model.num_symbols * model.num_contexts *
+                       (int64_t)sizeof(uint32_t);
+    for (int64_t i = 0; i < blocks.num_blocks; ++i) {
+        size += blocks.sizes[i];
+    }
+    if (size < size_limit) {
+        const int32_t *decomp_dict = BpArrayGetDecompDict(records);
+        error = FlushV2Step2WriteToFile(db_file, &prefix, &header,
+                                        decomp_dict, &model, &blocks);
+        *written = (error == kNoError);
+    }
+    EncodedBlocksDestroy(&blocks);
+    BpRansModelDestroy(&model);
+
+    return error;
+}
+
+// -----------------------------------------------------------------------------
+
+// Bpdb file opened for loading.
+typedef struct {
+    int fd;
+    int64_t base;       // Offset of the tier data in the file.
+    int64_t file_size;  // Size of the tier data in bytes.
+    BpdbFileHeader header;
+    int64_t header_offset;  // Offset of the header in the file.
+    int32_t scale_bits;     // rANS scale bits, or 0 for version 1.
+    int32_t num_contexts;   // Number of rANS contexts.
+    int64_t num_blocks;
+    int64_t *offsets;  // File offsets of the blocks, num_blocks + 1 entries.
+} BpdbFileReader;
+
+// Reads exactly SIZE bytes at OFFSET of FD into BUF without moving the file
+// offset, so that the same descriptor can be shared by multiple threads.
+static bool PreadFull(int fd, void *buf, int64_t size, int64_t offset) {
+    while (size > 0) {
+        ssize_t n = pread(fd, buf, (size_t)size, (off_t)offset);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        buf = GenericPointerAdd(buf, n);
+        size -= n;
+        offset += n;
+    }
+
+    return true;
+}
+
+// Reads SIZE bytes at OFFSET of the tier data described by READER into BUF.
+static bool ReaderRead(const BpdbFileReader *reader, void *buf, int64_t size,
+                       int64_t offset) {
+    if (offset < 0 || size > reader->file_size - offset) return false;
+    return PreadFull(reader->fd, buf, size, reader->base + offset);
+}
+
+static int64_t GetEntriesPerBlock(const BpdbFileHeader *header) {
+    return header->lookup_meta.block_size * kBitsPerByte /
+           header->stream_meta.bits_per_entry;
+}
+
+// Returns the expected number of blocks in the file described by READER.
+static int64_t GetNumBlocks(const BpdbFileReader *reader) {
+    const BpdbFileHeader *header = &reader->header;
+    if (reader->scale_bits > 0) {
+        return RoundUpDivide(header->stream_meta.num_entries,
+                             GetEntriesPerBlock(header));
+    }
+
+    return RoundUpDivide(header->stream_meta.stream_length,
+                         header->lookup_meta.block_size);
+}
+
+static int LoadStep0ReadHeader(BpdbFileReader *reader) {
+    // Version 2 files begin with a prefix. Version 1 files begin directly
+    // with the header, whose first field never matches the magic number.
+    BpdbFileV2Prefix prefix;
+    if (!ReaderRead(reader, &prefix, sizeof(prefix), 0)) {
+        return kFileSystemError;
+    }
+    if (prefix.magic == kBpdbFileV2Magic) {
+        reader->header_offset = sizeof(prefix);
+        reader->scale_bits = prefix.scale_bits;
+        reader->num_contexts = prefix.num_contexts;
+    }
+    if (!ReaderRead(reader, &reader->header, sizeof(reader->header),
+                   reader->header_offset)) {
+        return kFileSystemError;
+    }
+
+    const BpdbFileHeader *header = &reader->header;
+    int bits_per_entry = header->stream_meta.bits_per_entry;
+    if (bits_per_entry < 1 || header->decomp_dict_meta.size <= 0 ||
+        header->decomp_dict_meta.size % sizeof(int32_t) != 0 ||
+        header->lookup_meta.block_size !=
+            BpdbFileGetBlockSize(bits_per_entry)) {
+        return kRuntimeError;
+    }
+    int32_t num_symbols =
+        header->decomp_dict_meta.size / (int32_t)sizeof(int32_t);
+    if (reader->scale_bits > 0 &&
+        (reader->num_contexts < 1 || reader->num_contexts > num_symbols)) {
+        return kRuntimeError;
+    }
+    reader->num_blocks = GetNumBlocks(reader);
+    if (header->lookup_meta.size !=
+        reader->num_blocks * (int64_t)sizeof(int64_t)) {
+        return kRuntimeError;
+    }
+
+    return kNoError;
+}
+
+static int LoadStep1InitArray(const BpdbFileReader *reader, BpArray *records) {
+    const BpdbFileHeader *header = &reader->header;
+    int32_t *decomp_dict = (int32_t *)malloc(header->decomp_dict_meta.size);
+    if (decomp_dict == NULL) return kMallocFailureError;
+
+    int error = kFileSystemError;
+    if (ReaderRead(reader, decomp_dict, header->decomp_dict_meta.size,
+                  reader->header_offset + (int64_t)sizeof(*header))) {
+        int32_t num_unique =
+            header->decomp_dict_meta.size / (int32_t)sizeof(int32_t);
+        error = BpArrayInitFromDict(records, &header->stream_meta, decomp_dict,
+                                    num_unique);
+        if (error == kIllegalArgumentError) error = kRuntimeError;
+    }
+    free(decomp_dict);
+
+    return error;
+}
+
+// Offset of the frequency table of a version 2 file, which immediately
+// follows the decompression dictionary.
+static int64_t GetFreqTableOffset(const BpdbFileReader *reader) {
+    return reader->header_offset + (int64_t)sizeof(reader->header) +
+           reader->header.decomp_dict_meta.size;
+}
+
+// Size of the frequency table of a version 2 file, or 0 for version 1.
+static int64_t GetFreqTableSize(const BpdbFileReader *reader) {
+    if (reader->scale_bits <= 0) return 0;
+
+    return (int64_t)reader->header.decomp_dict_meta.size *
+           reader->num_contexts;
+}
+
+// Reads the lookup table of the file and converts it into absolute file
+// offsets of the blocks. The last block extends to the end of the file.
+static int LoadStep2ReadLookupTable(BpdbFileReader *reader) {
+    reader->offsets =
+        (int64_t *)malloc((reader->num_blocks + 1) * sizeof(int64_t));
+    if (reader->offsets == NULL) return kMallocFailureError;
+
+    int64_t lookup_begin =
+        GetFreqTableOffset(reader) + GetFreqTableSize(reader);
+    int64_t stream_begin = lookup_begin + reader->header.lookup_meta.size;
+    if (!ReaderRead(reader, reader->offsets,
+                   reader->header.lookup_meta.size, lookup_begin)) {
+        return kFileSystemError;
+    }
+    for (int64_t i = 0; i < reader->num_blocks; ++i) {
+        reader->offsets[i] += stream_begin;
+    }
+    reader->offsets[reader->num_blocks] = reader->file_size;
+    for (int64_t i = 0; i < reader->num_blocks; ++i) {
+        if (reader->offsets[i] < stream_begin ||
+            reader->offsets[i + 1] < reader->offsets[i]) {
+            return kRuntimeError;
+        }
+    }
+
+    return kNoError;
+}
+
+// Builds the rANS decoding table of a version 2 file.
+static int LoadStep3CreateDecoder(const BpdbFileReader *reader,
+                                  BpRansDecoder **decoder) {
+    int64_t freq_table_size = GetFreqTableSize(reader);
+    uint32_t *freqs = (uint32_t *)malloc(freq_table_size);
+    if (freqs == NULL) return kMallocFailureError;
+    if (!ReaderRead(reader, freqs, freq_table_size,
+                   GetFreqTableOffset(reader))) {
+        free(freqs);
+        return kFileSystemError;
+    }
+
+    BpRansModel model;
+    int32_t num_symbols =
+        reader->header.decomp_dict_meta.size / (int32_t)sizeof(int32_t);
+    int error = BpRansModelInitFromFreqs(&model, freqs, num_symbols,
+                                         reader->num_contexts,
+                                         reader->scale_bits);
+    free(freqs);
+    if (error != kNoError) return kRuntimeError;
+
+    int64_t size;
+    *decoder = BpRansDecoderCreate(&model, &size);
+    BpRansModelDestroy(&model);
+
+    return *decoder == NULL ? kMallocFailureError : kNoError;
+}
+
+// Inflates the gzip member SRC of SRC_SIZE bytes into exactly DEST_SIZE bytes
+// of DEST.
+static bool LoadInflate(const void *src, int64_t src_size, void *dest,
+                        int64_t dest_size) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // 16 + MAX_WBITS: decode the gzip wrapper written by gzwrite.
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) return false;
+
+    stream.next_in = (Bytef *)src;
+    stream.avail_in = (uInt)src_size;
+    stream.next_out = (Bytef *)dest;
+    stream.avail_out = (uInt)dest_size;
+    int error = inflate(&stream, Z_FINISH);
+    bool full = (stream.avail_out == 0);
+    inflateEnd(&stream);
+
+    return error == Z_STREAM_END && full;
+}
+
+// Decompresses block I of the file into the bit stream of RECORDS. SRC must
+// have space for the compressed block.
+static bool LoadDecompressBlock(const BpdbFileReader *reader,
+                                const BpRansDecoder *decoder, int64_t i,
+                                void *src, BpArray *records) {
+    int64_t src_size = reader->offsets[i + 1] - reader->offsets[i];
+    if (!ReaderRead(reader, src, src_size, reader->offsets[i])) return false;
+
+    const BpdbFileHeader *header = &reader->header;
+    int64_t block_size = header->lookup_meta.block_size;
+    uint8_t *dest = records->stream + i * block_size;
+    if (decoder != NULL) {
+        // Each block holds a whole number of entries. The last block holds the
+        // remaining entries.
+        int64_t entries_per_block = GetEntriesPerBlock(header);
+        int64_t num_entries =
+            header->stream_meta.num_entries - i * entries_per_block;
+        if (num_entries > entries_per_block) num_entries = entries_per_block;
+        return BpRansDecode(decoder, (const uint8_t *)src, src_size,
+                            num_entries, header->stream_meta.bits_per_entry,
+                            dest);
+    }
+
+    // The last block may be shorter than the block size.
+    int64_t dest_size = header->stream_meta.stream_length - i * block_size;
+    if (dest_size > block_size) dest_size = block_size;
+    return LoadInflate(src, src_size, dest, dest_size);
+}
+
+// Decompresses all blocks of the file into the bit stream of RECORDS in
+// parallel. Each thread reads compressed blocks into its own buffer.
+static int LoadStep4DecompressBlocks(const BpdbFileReader *reader,
+                                     const BpRansDecoder *decoder,
+                                     BpArray *records) {
+    int64_t max_src_size = 0;
+    for (int64_t i = 0; i < reader->num_blocks; ++i) {
+        int64_t src_size = reader->offsets[i + 1] - reader->offsets[i];
+        if (src_size > max_src_size) max_src_size = src_size;
+    }
+    void *buffers = malloc(GetNumThreads() * max_src_size + 1);
+    if (buffers == NULL) return kMallocFailureError;
+
+    ConcurrentBool success;
+    ConcurrentBoolInit(&success, true);
+    PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_DYNAMIC(1)
+    for (int64_t i = 0; i < reader->num_blocks; ++i) {
+        if (!ConcurrentBoolLoad(&success)) continue;  // Fail fast.
+        void *src =
+            GenericPointerAdd(buffers, (int64_t)GetThreadId() * max_src_size);
+        if (!LoadDecompressBlock(reader, decoder, i, src, records)) {
+            ConcurrentBoolStore(&success, false);
+        }
+    }
+    free(buffers);
+
+    return ConcurrentBoolLoad(&success) ? kNoError : kRuntimeError;
+}
+
+static int LoadInternal(BpdbFileReader *reader, BpArray *records) {
+    int error = LoadStep0ReadHeader(reader);
+    if (error != kNoError) return error;
+
+    error = LoadStep1InitArray(reader, records);
+    if (error != kNoError) return error;
+
+    BpRansDecoder *decoder = NULL;
+    error = LoadStep2ReadLookupTable(reader);
+    if (error == kNoError && reader->scale_bits > 0) {
+        error = LoadStep3CreateDecoder(reader, &decoder);
+    }
+    if (error == kNoError) {
+        error = LoadStep4DecompressBlocks(reader, decoder, records);
+    }
+    free(decoder);
+    if (error != kNoError) BpArrayDestroy(records);
+
+    return error;
+}
+
+int BpdbFileLoad(ReadOnlyString full_path, BpArray *records) {
+    memset(records, 0, sizeof(*records));
+    BpdbFileReader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.fd = GuardedOpen(full_path, O_RDONLY);
+    if (reader.fd == -1) return kFileSystemError;
+
+    int error = kFileSystemError;
+    struct stat st;
+    if (fstat(reader.fd, &st) == 0) {
+        reader.file_size = (int64_t)st.st_size;
+        error = LoadInternal(&reader, records);
+    }
+    if (error == kRuntimeError) {
+        fprintf(stderr, "BpdbFileLoad: %s is corrupt\n", full_path);
+    }
+    free(reader.offsets);
+    GuardedClose(reader.fd);
+
+    return error;
+}
+
+int BpdbFileLoadRange(int fd, int64_t offset, int64_t size, BpArray *records) {
+    memset(records, 0, sizeof(*records));
+    BpdbFileReader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.fd = fd;
+    reader.base = offset;
+    reader.file_size = size;
+    int error = LoadInternal(&reader, records);
+    free(reader.offsets);
 
-    // Close the file.
-    return GuardedFclose(db_file);
+    return error;
 }
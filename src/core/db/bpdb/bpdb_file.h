@@ -28,6 +28,7 @@
 #define GAMESMANONE_CORE_DB_BPDB_BPDB_FILE_H_
 
 #include <stdint.h>  // int64_t, int32_t
+#include <stdio.h>   // FILE
 
 #include "core/db/bpdb/bparray.h"
 #include "core/types/gamesman_types.h"
@@ -59,6 +60,35 @@ typedef struct BpdbFileHeader {
     BpArrayMeta stream_meta;
 } BpdbFileHeader;
 
+enum {
+    /**
+     * Value of BpdbFileV2Prefix::magic, which is "BPD2" read as a
+     * little-endian integer and negated. The value is negative so that it
+     * never matches the first field of a version 1 file, which begins directly
+     * with a BpdbFileHeader whose first field is the nonnegative size of the
+     * decompression dictionary.
+     */
+    kBpdbFileV2Magic = -0x32445042,
+};
+
+/**
+ * @brief Prefix of version 2 bpdb files.
+ * @details A version 1 file is laid out as
+ * [header][decomp_dict][mgz_lookup_table][mgz_blocks], where each block of
+ * the bit stream is compressed using deflate. A version 2 file is laid out as
+ * [prefix][header][decomp_dict][freq_table][lookup_table][rans_blocks]. The
+ * frequency table contains one uint32_t normalized frequency for each entry
+ * of the decompression dictionary in each of the num_contexts contexts, and
+ * each block of the bit stream is encoded separately using the static order-1
+ * rANS model defined by the table. The lookup table has the same format in
+ * both versions, so a probe still decodes a single block to read a record.
+ */
+typedef struct BpdbFileV2Prefix {
+    int32_t magic;        /**< Always kBpdbFileV2Magic. */
+    int32_t scale_bits;   /**< Scale bits of the rANS model. */
+    int32_t num_contexts; /**< Number of contexts of the rANS model. */
+} BpdbFileV2Prefix;
+
 /**
  * @brief Returns a malloc'ed full path to the bpdb file for the given \p tier
  * given \p sandbox_path for bpdb and an optional function which converts
@@ -88,6 +118,9 @@ char *BpdbFileGetFullPathToFinishFlag(ConstantReadOnlyString sandbox_path);
 
 /**
  * @brief Flushes the RECORDS to a bpdb file under FULL_PATH.
+ * @details Compresses RECORDS using both mgz and the rANS codec and writes a
+ * version 2 file if the rANS codec supports the number of unique records in
+ * RECORDS and produces a smaller file, or a version 1 file otherwise.
  *
  * @param full_path Full path to the bpdb file to create.
  * @param records Solver records encoded as a BpArray.
@@ -96,6 +129,41 @@ char *BpdbFileGetFullPathToFinishFlag(ConstantReadOnlyString sandbox_path);
  */
 int BpdbFileFlush(ReadOnlyString full_path, const BpArray *records);
 
+/**
+ * @brief Writes RECORDS in the bpdb file format to DB_FILE at its current
+ * position. Used by BpdbFileFlush and to pack tiers into a DbArchive.
+ *
+ * @param db_file Stream opened for writing.
+ * @param records Solver records encoded as a BpArray.
+ * @return 0 on success, or
+ * @return non-zero error code on failure.
+ */
+int BpdbFileWrite(FILE *db_file, const BpArray *records);
+
+/**
+ * @brief Loads the bpdb file under FULL_PATH into RECORDS.
+ * @details Reads the lookup table of the file and decompresses all blocks of
+ * the bit stream in parallel, each directly into its place in the bit stream
+ * of RECORDS. Both version 1 (mgz) and version 2 (rANS) files are supported.
+ * @note Assumes RECORDS is uninitialized. On success, RECORDS must be destroyed
+ * using BpArrayDestroy.
+ *
+ * @param full_path Full path to the bpdb file.
+ * @param records (Output parameter) Array to load the records into.
+ * @return 0 on success,
+ * @return kFileSystemError if the file cannot be opened or read,
+ * @return kMallocFailureError on malloc failure, or
+ * @return kRuntimeError if the file is corrupt.
+ */
+int BpdbFileLoad(ReadOnlyString full_path, BpArray *records);
+
+/**
+ * @brief Same as BpdbFileLoad, but loads the bpdb file stored in the SIZE
+ * bytes at OFFSET of the file open as FD, e.g., a tier packed in a segment of
+ * a DbArchive. FD is only accessed using pread and is not closed.
+ */
+int BpdbFileLoadRange(int fd, int64_t offset, int64_t size, BpArray *records);
+
 /**
  * @brief Returns the proper MGZ block size (in bytes) to use given the number
  * of bits used to store each entry in the BpArray.
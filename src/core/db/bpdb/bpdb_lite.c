@@ -30,18 +30,25 @@
 
 #include "core/db/bpdb/bpdb_lite.h"
 
-#include <assert.h>  // assert
-#include <stddef.h>  // NULL
-#include <stdint.h>  // int64_t, uint64_t, int32_t
-#include <stdio.h>   // fprintf, stderr, FILE
-#include <stdlib.h>  // malloc, free, realloc
-#include <string.h>  // strlen
-
-#include "core/concurrency.h"
+#include <assert.h>    // assert
+#include <inttypes.h>  // PRId64
+#include <stdbool.h>   // bool
+#include <stddef.h>    // NULL
+#include <stdint.h>    // int8_t, int16_t, uint16_t, int64_t, intptr_t
+#include <stdio.h>     // fprintf, stderr, FILE, sprintf
+#include <stdlib.h>    // malloc, free, realloc
+#include <string.h>    // memset, strlen, strcat
+
 #include "core/constants.h"
 #include "core/db/bpdb/bparray.h"
 #include "core/db/bpdb/bpdb_file.h"
 #include "core/db/bpdb/bpdb_probe.h"
+#include "core/db/db_archive.h"
+#include "core/db/db_block_cache.h"
+#include "core/db/db_file_pool.h"
+#include "core/db/db_probe_batch.h"
+#include "core/db/db_shard.h"
+#include "core/db/db_tier_summary.h"
 #include "core/misc.h"
 #include "core/types/gamesman_types.h"
 
@@ -60,6 +67,8 @@ static void BpdbLiteFinalize(void);
 static int BpdbLiteCreateSolvingTier(Tier tier, int64_t size);
 static int BpdbLiteFlushSolvingTier(void *aux);
 static int BpdbLiteFreeSolvingTier(void);
+static int BpdbLiteWriteTier(Tier tier, int64_t size, const int8_t *values,
+                             const int16_t *remotenesses);
 
 static int BpdbLiteSetGameSolved(void);
 static int BpdbLiteSetValue(Position position, Value value);
@@ -67,11 +76,23 @@ static int BpdbLiteSetRemoteness(Position position, int remoteness);
 static Value BpdbLiteGetValue(Position position);
 static int BpdbLiteGetRemoteness(Position position);
 
+static intptr_t BpdbLiteTierMemUsage(Tier tier, int64_t size);
+static int BpdbLiteLoadTier(Tier tier, int64_t size);
+static int BpdbLiteUnloadTier(Tier tier);
+static bool BpdbLiteIsTierLoaded(Tier tier);
+static Value BpdbLiteGetValueFromLoaded(Tier tier, Position position);
+static int BpdbLiteGetRemotenessFromLoaded(Tier tier, Position position);
+
 static Value BpdbLiteProbeValue(DbProbe *probe, TierPosition tier_position);
 static int BpdbLiteProbeRemoteness(DbProbe *probe, TierPosition tier_position);
+static int BpdbLiteProbeRecordsBatch(DbProbe *probe, int64_t size,
+                                     const TierPosition *tier_positions,
+                                     Value *values, int *remotenesses);
 
 static int BpdbLiteTierStatus(Tier tier);
 static int BpdbLiteGameStatus(void);
+static int BpdbLiteGetTierSummary(Tier tier, int64_t size,
+                                  DbTierSummary *summary);
 
 const Database kBpdbLite = {
     .name = "bpdb_lite",
@@ -84,6 +105,7 @@ const Database kBpdbLite = {
     .CreateSolvingTier = &BpdbLiteCreateSolvingTier,
     .FlushSolvingTier = &BpdbLiteFlushSolvingTier,
     .FreeSolvingTier = &BpdbLiteFreeSolvingTier,
+    .WriteTier = &BpdbLiteWriteTier,
 
     .SetGameSolved = &BpdbLiteSetGameSolved,
     .SetValue = &BpdbLiteSetValue,
@@ -91,22 +113,56 @@ const Database kBpdbLite = {
     .GetValue = &BpdbLiteGetValue,
     .GetRemoteness = &BpdbLiteGetRemoteness,
 
+    // Loading
+    .TierMemUsage = &BpdbLiteTierMemUsage,
+    .LoadTier = &BpdbLiteLoadTier,
+    .UnloadTier = &BpdbLiteUnloadTier,
+    .IsTierLoaded = &BpdbLiteIsTierLoaded,
+    .GetValueFromLoaded = &BpdbLiteGetValueFromLoaded,
+    .GetRemotenessFromLoaded = &BpdbLiteGetRemotenessFromLoaded,
+
     // Probing
     .ProbeInit = &BpdbProbeInit,        // Generic version
     .ProbeDestroy = &BpdbProbeDestroy,  // Generic version
     .ProbeValue = &BpdbLiteProbeValue,
     .ProbeRemoteness = &BpdbLiteProbeRemoteness,
+    .ProbeRecordsBatch = &BpdbLiteProbeRecordsBatch,
     .TierStatus = &BpdbLiteTierStatus,
     .GameStatus = &BpdbLiteGameStatus,
+    .GetTierSummary = &BpdbLiteGetTierSummary,
+};
+
+const BpdbLiteOptions kBpdbLiteOptionsInit = {
+    .archive = false,  // Write each tier to its own file.
+    .summary = false,  // No tier summaries.
 };
 
+// Format tag of tiers in the archive, which are stored as bpdb files.
+enum { kBpdbLiteArchiveFormat = 1 };
+
 static char current_game_name[kGameNameLengthMax + 1];
 static int current_variant;
 static GetTierNameFunc CurrentGetTierName;
-static char *sandbox_path;
+static DbShardMap shards;  // Directories that store the tier files.
+static DbArchiveSet archives;  // Packed tiers in each directory.
+static bool use_archive;       // Whether new tiers are written to archives.
+static bool write_summary;     // Whether new tier files are summarized.
+static int64_t cache_source;  // Source ID in the process-wide block cache.
 static Tier current_tier;
 static int64_t current_tier_size;
-static BpArray records;
+
+// Records of the solving tier, one per position. Records are stored in a plain
+// array so that solver threads may set them concurrently without locking, and
+// are packed into a BpArray in parallel when the tier is flushed.
+static uint16_t *records;
+
+// Maximum number of tiers that can be loaded at the same time.
+enum { kBpdbLiteNumLoadedTiersMax = 256 };
+
+// Loaded tiers, which are decompressed into BpArrays. An unused slot has a
+// NULL bit stream.
+static TierHashMapSC loaded_tier_to_index;
+static BpArray loaded_records[kBpdbLiteNumLoadedTiersMax];
 
 static uint64_t BuildRecord(Value value, int remoteness);
 static Value GetValueFromRecord(uint64_t record);
@@ -117,15 +173,24 @@ static int GetRemotenessFromRecord(uint64_t record);
 static int BpdbLiteInit(ReadOnlyString game_name, int variant,
                         ReadOnlyString path, GetTierNameFunc GetTierName,
                         void *aux) {
-    (void)aux;  // Unused.
-    assert(sandbox_path == NULL);
-
-    sandbox_path = (char *)malloc((strlen(path) + 1) * sizeof(char));
-    if (sandbox_path == NULL) {
-        fprintf(stderr, "BpdbLiteInit: failed to malloc path.\n");
-        return kMallocFailureError;
+    const BpdbLiteOptions *options = (const BpdbLiteOptions *)aux;
+    if (options == NULL) options = &kBpdbLiteOptionsInit;
+    use_archive = options->archive;
+    write_summary = options->summary;
+
+    assert(shards.paths == NULL);
+    int error = DbShardMapInit(&shards, path, NULL);
+    if (error != kNoError) {
+        fprintf(stderr, "BpdbLiteInit: failed to parse path.\n");
+        return error;
+    }
+    error = DbArchiveSetInit(&archives, &shards);
+    if (error != kNoError) {
+        fprintf(stderr, "BpdbLiteInit: failed to open tier archives.\n");
+        DbShardMapDestroy(&shards);
+        return error;
     }
-    strcpy(sandbox_path, path);
+    cache_source = DbBlockCacheNewSource();
 
     SafeStrncpy(current_game_name, game_name, kGameNameLengthMax + 1);
     current_game_name[kGameNameLengthMax] = '\0';
@@ -133,100 +198,240 @@ static int BpdbLiteInit(ReadOnlyString game_name, int variant,
     CurrentGetTierName = GetTierName;
     current_tier = kIllegalTier;
     current_tier_size = kIllegalSize;
+    TierHashMapSCInit(&loaded_tier_to_index, 0.5);
+    memset(&loaded_records, 0, sizeof(loaded_records));
 
     return kNoError;
 }
 
 static void BpdbLiteFinalize(void) {
-    free(sandbox_path);
-    sandbox_path = NULL;
-    BpArrayDestroy(&records);
+    DbArchiveSetDestroy(&archives);
+    DbShardMapDestroy(&shards);
+    free(records);
+    records = NULL;
+    TierHashMapSCDestroy(&loaded_tier_to_index);
+    for (int i = 0; i < kBpdbLiteNumLoadedTiersMax; ++i) {
+        if (loaded_records[i].stream != NULL) {
+            BpArrayDestroy(&loaded_records[i]);
+        }
+    }
 }
 
 static int BpdbLiteCreateSolvingTier(Tier tier, int64_t size) {
     current_tier = tier;
     current_tier_size = size;
 
-    BpArrayDestroy(&records);
-    int error = BpArrayInit(&records, current_tier_size);
-    if (error != 0) {
+    free(records);
+    records = (uint16_t *)calloc(current_tier_size, sizeof(uint16_t));
+    if (records == NULL) {
         fprintf(stderr,
-                "BpdbLiteCreateSolvingTier: failed to initialize records, code "
-                "%d\n",
-                error);
-        return error;
+                "BpdbLiteCreateSolvingTier: failed to calloc records\n");
+        return kMallocFailureError;
     }
 
     return kNoError;
 }
 
-static int BpdbLiteFlushSolvingTier(void *aux) {
-    (void)aux;  // Unused.
+// Appends PACKED to the archive as the data of TIER.
+static int ArchiveRecords(Tier tier, const BpArray *packed) {
+    char *data = NULL;
+    size_t size = 0;
+    FILE *stream = open_memstream(&data, &size);
+    if (stream == NULL) return kMallocFailureError;
+
+    int error = BpdbFileWrite(stream, packed);
+    if (fclose(stream) != 0 && error == kNoError) error = kMallocFailureError;
+    if (error == kNoError) {
+        error = DbArchiveSetAppend(&archives, &shards, tier,
+                                   kBpdbLiteArchiveFormat, data, (int64_t)size);
+    }
+    free(data);
+
+    return error;
+}
 
+// Writes PACKED to the tier file of TIER and removes TIER from the archives,
+// which would otherwise shadow the new file.
+static int FlushPackedRecords(Tier tier, const BpArray *packed) {
     char *full_path =
-        BpdbFileGetFullPath(sandbox_path, current_tier, CurrentGetTierName);
+        BpdbFileGetFullPath(DbShardMapGetPath(&shards, tier), tier,
+                            CurrentGetTierName);
     if (full_path == NULL) return kMallocFailureError;
 
-    int error = BpdbFileFlush(full_path, &records);
-    if (error != 0) fprintf(stderr, "BpdbLiteFlushSolvingTier: code %d", error);
+    int error = BpdbFileFlush(full_path, packed);
     free(full_path);
+    if (error == kNoError) error = DbArchiveSetRemove(&archives, tier);
+
+    return error;
+}
+
+// Returns the full path to the summary file of TIER, or NULL on malloc
+// failure. The user is responsible for freeing the pointer returned.
+static char *GetFullPathToSummary(Tier tier) {
+    char *full_path =
+        BpdbFileGetFullPath(DbShardMapGetPath(&shards, tier), tier,
+                            CurrentGetTierName);
+    if (full_path == NULL) return NULL;
+
+    char *ret = (char *)realloc(full_path, strlen(full_path) + 5);
+    if (ret == NULL) {
+        free(full_path);
+        return NULL;
+    }
+    strcat(ret, ".sum");
+
+    return ret;
+}
+
+// Removes the summary file of TIER if it exists.
+static int RemoveTierSummary(Tier tier) {
+    char *full_path = GetFullPathToSummary(tier);
+    if (full_path == NULL) return kMallocFailureError;
+
+    int error = kNoError;
+    if (FileExists(full_path) && GuardedRemove(full_path) != 0) {
+        error = kFileSystemError;
+    }
+    free(full_path);
+
+    return error;
+}
+
+typedef struct {
+    uint64_t (*GetRecordAt)(int64_t i, const void *aux);
+    const void *aux;
+} BpdbLiteRecordSource;
+
+static void GetSummaryRecordAt(int64_t i, const void *aux, Value *value,
+                               int *remoteness) {
+    const BpdbLiteRecordSource *source = (const BpdbLiteRecordSource *)aux;
+    uint64_t record = source->GetRecordAt(i, source->aux);
+    *value = GetValueFromRecord(record);
+    *remoteness = GetRemotenessFromRecord(record);
+}
+
+// Summarizes the records of TIER returned by GetRecordAt into the summary
+// file of TIER.
+static int WriteTierSummary(Tier tier, int64_t size,
+                            uint64_t (*GetRecordAt)(int64_t i,
+                                                    const void *aux),
+                            const void *aux) {
+    BpdbLiteRecordSource source = {.GetRecordAt = GetRecordAt, .aux = aux};
+    char *full_path = GetFullPathToSummary(tier);
+    DbTierSummary *summary = (DbTierSummary *)malloc(sizeof(DbTierSummary));
+    int error = kMallocFailureError;
+    if (full_path != NULL && summary != NULL) {
+        error =
+            DbTierSummaryBuild(summary, size, &GetSummaryRecordAt, &source);
+    }
+    if (error == kNoError) error = DbTierSummaryWrite(summary, full_path);
+    free(full_path);
+    free(summary);
+
+    return error;
+}
+
+// Packs the records of TIER returned by GetRecordAt into a BpArray using all
+// available threads and flushes it to the database file of TIER, or appends
+// it to the archive if archiving is enabled.
+static int FlushRecords(Tier tier, int64_t size,
+                        uint64_t (*GetRecordAt)(int64_t i, const void *aux),
+                        const void *aux) {
+    // The old summary must not outlive the old contents of the tier, even if
+    // the new summary cannot be written.
+    int error = RemoveTierSummary(tier);
+    if (error != kNoError) return error;
+
+    BpArray packed;
+    error = BpArrayBuild(&packed, size, GetRecordAt, aux);
+    if (error == kNoError) {
+        error = use_archive ? ArchiveRecords(tier, &packed)
+                            : FlushPackedRecords(tier, &packed);
+        BpArrayDestroy(&packed);
+    }
+    DbBlockCacheInvalidate(cache_source, tier);
+    DbFilePoolInvalidate(cache_source, tier);
+
+    // Summaries are optional. Readers fall back to the records without one.
+    if (error == kNoError && write_summary && !use_archive &&
+        WriteTierSummary(tier, size, GetRecordAt, aux) != kNoError) {
+        fprintf(stderr,
+                "FlushRecords: failed to write the summary of tier %" PRITier
+                "\n",
+                tier);
+    }
+
+    return error;
+}
+
+static uint64_t GetSolvingRecordAt(int64_t i, const void *aux) {
+    (void)aux;  // Unused.
+    return records[i];
+}
+
+static int BpdbLiteFlushSolvingTier(void *aux) {
+    (void)aux;  // Unused.
+
+    int error = FlushRecords(current_tier, current_tier_size,
+                             &GetSolvingRecordAt, NULL);
+    if (error != 0) fprintf(stderr, "BpdbLiteFlushSolvingTier: code %d", error);
 
     return error;
 }
 
 static int BpdbLiteFreeSolvingTier(void) {
-    BpArrayDestroy(&records);
+    free(records);
+    records = NULL;
     current_tier = kIllegalTier;
     current_tier_size = -kIllegalSize;
 
     return kNoError;
 }
 
-static uint64_t GetRecord(Position position) {
-    uint64_t record;
-    PRAGMA_OMP_CRITICAL(records) { record = BpArrayGet(&records, position); }
-
-    return record;
-}
+static uint64_t GetRecord(Position position) { return records[position]; }
 
 static int BpdbLiteSetGameSolved(void) {
-    char *flag_filename = BpdbFileGetFullPathToFinishFlag(sandbox_path);
+    char *flag_filename = BpdbFileGetFullPathToFinishFlag(
+        DbShardMapGetPrimaryPath(&shards));
     if (flag_filename == NULL) return kMallocFailureError;
 
-    FILE *flag_file = GuardedFopen(flag_filename, "w");
+    // Create the flag under a temp name and rename it so that the game
+    // appears solved atomically.
+    char *tmp_filename = (char *)malloc(strlen(flag_filename) + 5);
+    if (tmp_filename == NULL) {
+        free(flag_filename);
+        return kMallocFailureError;
+    }
+    sprintf(tmp_filename, "%s.tmp", flag_filename);
+
+    int error = kNoError;
+    FILE *flag_file = GuardedFopen(tmp_filename, "w");
+    if (flag_file == NULL) {
+        error = kFileSystemError;
+    } else if (GuardedFclose(flag_file) != 0 ||
+               GuardedRename(tmp_filename, flag_filename) != 0) {
+        error = kFileSystemError;
+    }
+    free(tmp_filename);
     free(flag_filename);
-    if (flag_file == NULL) return kFileSystemError;
-
-    int error = GuardedFclose(flag_file);
-    if (error != 0) return kFileSystemError;
 
-    return kNoError;
+    return error;
 }
 
 static int BpdbLiteSetValue(Position position, Value value) {
     uint64_t record = GetRecord(position);
     int remoteness = GetRemotenessFromRecord(record);
-    record = BuildRecord(value, remoteness);
+    records[position] = (uint16_t)BuildRecord(value, remoteness);
 
-    int error;
-    PRAGMA_OMP_CRITICAL(records) {
-        error = BpArraySet(&records, position, record);
-    }
-
-    return error;
+    return kNoError;
 }
 
 static int BpdbLiteSetRemoteness(Position position, int remoteness) {
     uint64_t record = GetRecord(position);
     Value value = GetValueFromRecord(record);
-    record = BuildRecord(value, remoteness);
+    records[position] = (uint16_t)BuildRecord(value, remoteness);
 
-    int error;
-    PRAGMA_OMP_CRITICAL(records) {
-        error = BpArraySet(&records, position, record);
-    }
-
-    return error;
+    return kNoError;
 }
 
 static Value BpdbLiteGetValue(Position position) {
@@ -239,29 +444,156 @@ static int BpdbLiteGetRemoteness(Position position) {
     return GetRemotenessFromRecord(record);
 }
 
+static intptr_t BpdbLiteTierMemUsage(Tier tier, int64_t size) {
+    (void)tier;
+
+    // Upper bound: records fit in 16 bits, which bounds both the number of
+    // bits per entry and the sizes of the dictionaries.
+    static const intptr_t kDictsSizeMax =
+        2 * ((intptr_t)UINT16_MAX + 1) * (intptr_t)sizeof(int32_t);
+
+    return (intptr_t)(size * (int64_t)sizeof(uint16_t) +
+                      (int64_t)sizeof(uint64_t)) +
+           kDictsSizeMax;
+}
+
+static int GetFirstUnusedLoadedIndex(void) {
+    int i;
+    for (i = 0; i < kBpdbLiteNumLoadedTiersMax; ++i) {
+        if (loaded_records[i].stream == NULL) break;
+    }
+
+    return i;
+}
+
+static int BpdbLiteLoadTier(Tier tier, int64_t size) {
+    // Find the first unused slot in the loaded records array.
+    int i = GetFirstUnusedLoadedIndex();
+    if (i == kBpdbLiteNumLoadedTiersMax) {
+        fprintf(stderr,
+                "BpdbLiteLoadTier: cannot load more than %d tiers at the same "
+                "time\n",
+                kBpdbLiteNumLoadedTiersMax);
+        return kRuntimeError;
+    }
+
+    // Archived tiers take precedence over tier files.
+    int error;
+    DbArchiveLocation location;
+    if (DbArchiveSetLocate(&archives, &shards, tier, &location)) {
+        error = BpdbFileLoadRange(location.fd, location.offset, location.size,
+                                  &loaded_records[i]);
+    } else {
+        char *full_path =
+            BpdbFileGetFullPath(DbShardMapGetPath(&shards, tier), tier,
+                                CurrentGetTierName);
+        if (full_path == NULL) return kMallocFailureError;
+
+        error = BpdbFileLoad(full_path, &loaded_records[i]);
+        free(full_path);
+    }
+    if (error != kNoError) return error;
+
+    if (loaded_records[i].meta.num_entries != size) {
+        fprintf(stderr,
+                "BpdbLiteLoadTier: tier %" PRITier " has %" PRId64
+                " positions in the database, expected %" PRId64 "\n",
+                tier, loaded_records[i].meta.num_entries, size);
+        BpArrayDestroy(&loaded_records[i]);
+        return kRuntimeError;
+    }
+
+    if (!TierHashMapSCSet(&loaded_tier_to_index, tier, i)) {
+        BpArrayDestroy(&loaded_records[i]);
+        return kMallocFailureError;
+    }
+
+    return kNoError;
+}
+
+static BpArray *GetLoadedRecords(Tier tier) {
+    int64_t index;
+    if (!TierHashMapSCGet(&loaded_tier_to_index, tier, &index)) return NULL;
+
+    assert(index >= 0 && index < kBpdbLiteNumLoadedTiersMax);
+    return &loaded_records[index];
+}
+
+static int BpdbLiteUnloadTier(Tier tier) {
+    BpArray *loaded = GetLoadedRecords(tier);
+    if (loaded == NULL) return kRuntimeError;
+
+    BpArrayDestroy(loaded);
+    TierHashMapSCRemove(&loaded_tier_to_index, tier);
+
+    return kNoError;
+}
+
+static bool BpdbLiteIsTierLoaded(Tier tier) {
+    return GetLoadedRecords(tier) != NULL;
+}
+
+static Value BpdbLiteGetValueFromLoaded(Tier tier, Position position) {
+    BpArray *loaded = GetLoadedRecords(tier);
+    if (loaded == NULL) return kErrorValue;
+
+    return GetValueFromRecord(BpArrayGet(loaded, position));
+}
+
+static int BpdbLiteGetRemotenessFromLoaded(Tier tier, Position position) {
+    BpArray *loaded = GetLoadedRecords(tier);
+    if (loaded == NULL) return kErrorRemoteness;
+
+    return GetRemotenessFromRecord(BpArrayGet(loaded, position));
+}
+
 static Value BpdbLiteProbeValue(DbProbe *probe, TierPosition tier_position) {
     uint64_t record =
-        BpdbProbeRecord(sandbox_path, probe, tier_position, CurrentGetTierName);
+        BpdbProbeRecord(&shards, &archives, cache_source, probe,
+                        tier_position, CurrentGetTierName);
     return GetValueFromRecord(record);
 }
 
 static int BpdbLiteProbeRemoteness(DbProbe *probe, TierPosition tier_position) {
     uint64_t record =
-        BpdbProbeRecord(sandbox_path, probe, tier_position, CurrentGetTierName);
+        BpdbProbeRecord(&shards, &archives, cache_source, probe,
+                        tier_position, CurrentGetTierName);
     return GetRemotenessFromRecord(record);
 }
 
+// Reads both the value and the remoteness from a single probed record.
+static int BpdbLiteProbeRecord(DbProbe *probe, TierPosition tier_position,
+                               Value *value, int *remoteness) {
+    uint64_t record =
+        BpdbProbeRecord(&shards, &archives, cache_source, probe,
+                        tier_position, CurrentGetTierName);
+    *value = GetValueFromRecord(record);
+    if (remoteness != NULL) *remoteness = GetRemotenessFromRecord(record);
+
+    return kNoError;
+}
+
+static int BpdbLiteProbeRecordsBatch(DbProbe *probe, int64_t size,
+                                     const TierPosition *tier_positions,
+                                     Value *values, int *remotenesses) {
+    return DbProbeBatchRun(probe, size, tier_positions, values, remotenesses,
+                           BpdbLiteProbeRecord);
+}
+
 static int BpdbLiteTierStatus(Tier tier) {
-    return BpdbFileGetTierStatus(sandbox_path, tier, CurrentGetTierName);
+    // Archived tiers are found in memory without touching the file system.
+    if (DbArchiveSetLocate(&archives, &shards, tier, NULL)) {
+        return kDbTierStatusSolved;
+    }
+    return BpdbFileGetTierStatus(DbShardMapGetPath(&shards, tier), tier,
+                                 CurrentGetTierName);
 }
 
 static int BpdbLiteGameStatus(void) {
-    static ConstantReadOnlyString kIndicatorFileName = ".finish";
-    char *indicator =
-        (char *)malloc(strlen(sandbox_path) + strlen(kIndicatorFileName) + 1);
+    char *indicator = BpdbFileGetFullPathToFinishFlag(
+        DbShardMapGetPrimaryPath(&shards));
     if (indicator == NULL) return kDbGameStatusCheckError;
 
-    sprintf(indicator, "%s%s", sandbox_path, kIndicatorFileName);
     bool solved = FileExists(indicator);
     free(indicator);
     if (solved) return kDbGameStatusSolved;
@@ -269,6 +601,44 @@ static int BpdbLiteGameStatus(void) {
     return kDbGameStatusIncomplete;
 }
 
+static int BpdbLiteGetTierSummary(Tier tier, int64_t size,
+                                  DbTierSummary *summary) {
+    char *full_path = GetFullPathToSummary(tier);
+    if (full_path == NULL) return kMallocFailureError;
+
+    int error = DbTierSummaryRead(summary, full_path, size);
+    free(full_path);
+
+    return error;
+}
+
+typedef struct {
+    const int8_t *values;
+    const int16_t *remotenesses;
+} BpdbLiteTierRecords;
+
+static uint64_t GetTierRecordAt(int64_t i, const void *aux) {
+    const BpdbLiteTierRecords *tier_records = (const BpdbLiteTierRecords *)aux;
+
+    return BuildRecord(tier_records->values[i],
+                       tier_records->remotenesses[i]);
+}
+
+static int BpdbLiteWriteTier(Tier tier, int64_t size, const int8_t *values,
+                             const int16_t *remotenesses) {
+    // Unknown remotenesses cannot be represented.
+    for (int64_t i = 0; i < size; ++i) {
+        if (remotenesses[i] < 0) return kIllegalArgumentError;
+    }
+
+    BpdbLiteTierRecords tier_records = {
+        .values = values,
+        .remotenesses = remotenesses,
+    };
+
+    return FlushRecords(tier, size, &GetTierRecordAt, &tier_records);
+}
+
 // -----------------------------------------------------------------------------
 
 static uint64_t BuildRecord(Value value, int remoteness) {
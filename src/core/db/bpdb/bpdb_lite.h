@@ -31,6 +31,8 @@
 #ifndef GAMESMANONE_CORE_DB_BPDB_BPDB_LITE_H_
 #define GAMESMANONE_CORE_DB_BPDB_BPDB_LITE_H_
 
+#include <stdbool.h>  // bool
+
 #include "core/types/gamesman_types.h"
 
 /**
@@ -39,4 +41,27 @@
  */
 extern const Database kBpdbLite;
 
+/**
+ * @brief BpdbLite options. Pass a pointer to an instance of this type to the
+ * initialization function (kBpdbLite::Init) to use custom settings, or pass
+ * \c NULL for default options.
+ */
+typedef struct BpdbLiteOptions {
+    /** Set this to true to append new tiers to the packed archive of each data
+     * directory (see db_archive.h) instead of writing one file per tier.
+     * Tiers in either place can always be loaded and probed. Default: false.
+     */
+    bool archive;
+
+    /** Set this to true to store the summary of each tier (see
+     * db_tier_summary.h) in a .bpdb.sum file next to the tier file when the
+     * tier is flushed. Ignored for archived tiers, which would otherwise need
+     * one summary file per tier again. Flushing a tier without a summary
+     * removes any existing summary of the tier. Default: false. */
+    bool summary;
+} BpdbLiteOptions;
+
+/** @brief Default options of kBpdbLite. */
+extern const BpdbLiteOptions kBpdbLiteOptionsInit;
+
 #endif  // GAMESMANONE_CORE_DB_BPDB_BPDB_LITE_H_
@@ -30,22 +30,47 @@
 
 #include "core/db/bpdb/bpdb_probe.h"
 
-#include <fcntl.h>   // O_RDONLY
-#include <stddef.h>  // NULL
-#include <stdint.h>  // int32_t, int64_t, uint64_t
-#include <stdio.h>   // fprintf, stderr, FILE, SEEK_SET
-#include <stdlib.h>  // malloc, free, realloc
-#include <string.h>  // memset
+#include <errno.h>     // errno, EINTR
+#include <fcntl.h>     // O_RDONLY
+#include <stdbool.h>   // bool, true, false
+#include <stddef.h>    // NULL
+#include <stdint.h>    // int32_t, int64_t, uint64_t
+#include <stdio.h>     // fprintf, stderr
+#include <stdlib.h>    // malloc, calloc, free, realloc
+#include <string.h>    // memset, memcpy
+#include <sys/stat.h>  // fstat, struct stat
+#include <unistd.h>    // pread
 #include <zlib.h>
 
 #include "core/constants.h"
 #include "core/db/bpdb/bpdb_file.h"
+#include "core/db/bpdb/bprans.h"
+#include "core/db/db_archive.h"
+#include "core/db/db_block_cache.h"
+#include "core/db/db_file_pool.h"
+#include "core/db/db_shard.h"
 #include "core/misc.h"
 #include "core/types/gamesman_types.h"
 
 static const int kBlocksPerBuffer = 2;
 static const int kHeaderSize = sizeof(BpdbFileHeader);
 
+// Index of the pseudo-block under which the rANS decoding table of a version 2
+// tier file is stored in the block cache.
+static const int64_t kDecoderBlockIndex = -1;
+
+// Metadata of the tier loaded into a probe, stored at the beginning of the
+// probe buffer and followed by the decompression dictionary and the bit stream
+// blocks.
+typedef struct {
+    BpdbFileHeader header;  // Copy of the tier file header.
+    int64_t header_offset;  // Offset of the header in the tier file.
+    int32_t scale_bits;     // rANS scale bits, or 0 for mgz (version 1).
+    int32_t num_contexts;   // Number of rANS contexts.
+} ProbeTierMeta;
+
+static const int kMetaSize = sizeof(ProbeTierMeta);
+
 // (kNumValues - 2) because undecided and draw have no remoteness definition.
 static const int kDefaultDecompDictSize =
     (kNumValues - 2) * kNumRemotenesses * sizeof(uint32_t);
@@ -53,8 +78,21 @@ static const int kDefaultBitsPerEntry = 8;
 
 static int GetBufferSize(int32_t decomp_dict_size, int bits_per_entry);
 
-static int ProbeRecordStep0ReloadHeader(ConstantReadOnlyString sandbox_path,
-                                        DbProbe *probe, Tier tier,
+static const DbPooledFile *ProbeAcquireFile(const DbShardMap *shards,
+                                            DbArchiveSet *archives,
+                                            int64_t cache_source, Tier tier,
+                                            GetTierNameFunc GetTierName);
+
+typedef struct PooledBpdbFile PooledBpdbFile;
+
+static bool PreadFull(int fd, void *buf, int64_t size, int64_t offset);
+static bool ProbeFileRead(const PooledBpdbFile *file, void *buf, int64_t size,
+                          int64_t offset);
+
+static int ProbeRecordStep0ReloadHeader(const DbShardMap *shards,
+                                        DbArchiveSet *archives,
+                                        int64_t cache_source, DbProbe *probe,
+                                        Tier tier,
                                         GetTierNameFunc GetTierName);
 const BpdbFileHeader *ProbeGetHeader(const DbProbe *probe);
 const int32_t *ProbeGetDecompDict(const DbProbe *probe);
@@ -66,20 +104,24 @@ static bool ExpandProbeBuffer(DbProbe *probe, int target_size);
 
 static bool ProbeRecordStep1CacheMiss(const DbProbe *probe, Position position);
 
-static int ProbeRecordStep2LoadBlocks(ConstantReadOnlyString sandbox_path,
-                                      DbProbe *probe, Position position,
+static int ProbeRecordStep2LoadBlocks(const DbShardMap *shards,
+                                      DbArchiveSet *archives,
+                                      int64_t cache_source, DbProbe *probe,
+                                      Position position,
                                       GetTierNameFunc GetTierName);
 static int64_t GetBitOffset(Position position, int bits_per_entry);
 static int64_t GetByteOffset(Position position, int bits_per_entry);
 static int64_t GetBlockOffset(Position position, int bits_per_entry,
                               int64_t block_size);
 static void *ProbeGetBitStream(const DbProbe *probe);
-static int64_t ProbeRecordStep2_0ReadCompressedOffset(const DbProbe *probe,
-                                                      Position position,
-                                                      const char *full_path);
-static int ProbeRecordStep2_1HandleFile(const DbProbe *probe,
-                                        const char *full_path,
-                                        int64_t compressed_offset);
+static void *ProbeRecordStep2_0LoadBlock(void *aux, int64_t *size);
+static bool ProbeRecordStep2_1GetCompressedRange(const DbProbe *probe,
+                                                 const PooledBpdbFile *file,
+                                                 int64_t block_offset,
+                                                 int64_t *begin, int64_t *end);
+static bool ProbeRecordStep2_2Inflate(const void *src, int64_t src_size,
+                                      void *dest, int64_t dest_size);
+static int64_t ProbeGetLookupTableOffset(const DbProbe *probe);
 
 static uint64_t ProbeRecordStep3LoadRecord(const DbProbe *probe,
                                            Position position);
@@ -105,12 +147,14 @@ int BpdbProbeDestroy(DbProbe *probe) {
     return kNoError;
 }
 
-uint64_t BpdbProbeRecord(ConstantReadOnlyString sandbox_path, DbProbe *probe,
+uint64_t BpdbProbeRecord(const DbShardMap *shards, DbArchiveSet *archives,
+                         int64_t cache_source, DbProbe *probe,
                          TierPosition tier_position,
                          GetTierNameFunc GetTierName) {
     if (probe->tier != tier_position.tier) {
-        int error = ProbeRecordStep0ReloadHeader(
-            sandbox_path, probe, tier_position.tier, GetTierName);
+        int error = ProbeRecordStep0ReloadHeader(shards, archives, cache_source,
+                                                 probe, tier_position.tier,
+                                                 GetTierName);
         if (error != 0) {
             printf(
                 "BpdbProbeRecord: failed to reload header and decompression "
@@ -120,8 +164,8 @@ uint64_t BpdbProbeRecord(ConstantReadOnlyString sandbox_path, DbProbe *probe,
         }
     }
     if (ProbeRecordStep1CacheMiss(probe, tier_position.position)) {
-        ProbeRecordStep2LoadBlocks(sandbox_path, probe, tier_position.position,
-                                   GetTierName);
+        ProbeRecordStep2LoadBlocks(shards, archives, cache_source, probe,
+                                   tier_position.position, GetTierName);
     }
     return ProbeRecordStep3LoadRecord(probe, tier_position.position);
 }
@@ -129,29 +173,145 @@ uint64_t BpdbProbeRecord(ConstantReadOnlyString sandbox_path, DbProbe *probe,
 // -----------------------------------------------------------------------------
 
 static int GetBufferSize(int32_t decomp_dict_size, int bits_per_entry) {
-    // Header format:
-    // [header][decomp_dict][bit_stream_block_0][bit_stream_block_1][...]
+    // Buffer format:
+    // [meta][decomp_dict][bit_stream_block_0][bit_stream_block_1][...]
     // plus 8 bytes of additional space for safe uint64_t masking.
     int64_t block_size = BpdbFileGetBlockSize(bits_per_entry);
-    return (int)(kHeaderSize + decomp_dict_size +
+    return (int)(kMetaSize + decomp_dict_size +
                  kBlocksPerBuffer * block_size + sizeof(uint64_t));
 }
 
-// Reloads tier bpdb file header and decomp dict into probe's cache.
-static int ProbeRecordStep0ReloadHeader(ConstantReadOnlyString sandbox_path,
-                                        DbProbe *probe, Tier tier,
-                                        GetTierNameFunc GetTierName) {
-    char *full_path = BpdbFileGetFullPath(sandbox_path, tier, GetTierName);
-    if (full_path == NULL) return kMallocFailureError;
+// Open tier file held in the file pool. Archived tiers occupy a range of a
+// segment file whose descriptor is owned by the archive.
+struct PooledBpdbFile {
+    int fd;
+    int64_t base;  // Offset of the tier data in the file.
+    int64_t size;  // Size of the tier data in bytes.
+    bool owned;    // Whether FD is closed with the pooled file.
+};
+
+typedef struct {
+    const DbShardMap *shards;
+    DbArchiveSet *archives;
+    Tier tier;
+    GetTierNameFunc GetTierName;
+} PooledFileOpenerArgs;
+
+// The location of the tier data is only resolved on a pool miss.
+static void *PooledFileOpen(void *aux) {
+    const PooledFileOpenerArgs *args = (const PooledFileOpenerArgs *)aux;
+    DbArchiveLocation location;
+    if (args->archives != NULL &&
+        DbArchiveSetLocate(args->archives, args->shards, args->tier,
+                           &location)) {
+        PooledBpdbFile *file =
+            (PooledBpdbFile *)malloc(sizeof(PooledBpdbFile));
+        if (file == NULL) return NULL;
+        file->fd = location.fd;
+        file->base = location.offset;
+        file->size = location.size;
+        file->owned = false;
+        return file;
+    }
 
-    FILE *db_file = GuardedFopen(full_path, "rb");
+    char *full_path =
+        BpdbFileGetFullPath(DbShardMapGetPath(args->shards, args->tier),
+                            args->tier, args->GetTierName);
+    if (full_path == NULL) return NULL;
+
+    int fd = GuardedOpen(full_path, O_RDONLY);
     free(full_path);
-    full_path = NULL;
-    if (db_file == NULL) return kFileSystemError;
+    if (fd == -1) return NULL;
+
+    struct stat st;
+    PooledBpdbFile *file = (PooledBpdbFile *)malloc(sizeof(PooledBpdbFile));
+    if (file == NULL || fstat(fd, &st) != 0) {
+        free(file);
+        GuardedClose(fd);
+        return NULL;
+    }
+    file->fd = fd;
+    file->base = 0;
+    file->size = (int64_t)st.st_size;
+    file->owned = true;
 
-    // Read header. Assumes probe->buffer has enough space to store the header.
-    int error = GuardedFread(probe->buffer, kHeaderSize, 1, db_file, false);
-    if (error != 0) return BailOutFclose(db_file, error);
+    return file;
+}
+
+static void PooledFileClose(void *handle) {
+    PooledBpdbFile *file = (PooledBpdbFile *)handle;
+    if (file->owned) GuardedClose(file->fd);
+    free(file);
+}
+
+static const DbPooledFile *ProbeAcquireFile(const DbShardMap *shards,
+                                            DbArchiveSet *archives,
+                                            int64_t cache_source, Tier tier,
+                                            GetTierNameFunc GetTierName) {
+    PooledFileOpenerArgs args = {
+        .shards = shards,
+        .archives = archives,
+        .tier = tier,
+        .GetTierName = GetTierName,
+    };
+    return DbFilePoolAcquire(cache_source, tier, PooledFileOpen,
+                             PooledFileClose, &args);
+}
+
+// Reads exactly SIZE bytes at OFFSET of FD into BUF without moving the file
+// offset, so that the same descriptor can be shared by multiple threads.
+static bool PreadFull(int fd, void *buf, int64_t size, int64_t offset) {
+    while (size > 0) {
+        ssize_t n = pread(fd, buf, (size_t)size, (off_t)offset);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        buf = GenericPointerAdd(buf, n);
+        size -= n;
+        offset += n;
+    }
+
+    return true;
+}
+
+// Reads SIZE bytes at OFFSET of the tier data in FILE into BUF.
+static bool ProbeFileRead(const PooledBpdbFile *file, void *buf, int64_t size,
+                          int64_t offset) {
+    if (offset < 0 || size > file->size - offset) return false;
+    return PreadFull(file->fd, buf, size, file->base + offset);
+}
+
+// Reloads tier bpdb file header and decomp dict into probe's cache.
+static int ProbeRecordStep0ReloadHeader(const DbShardMap *shards,
+                                        DbArchiveSet *archives,
+                                        int64_t cache_source, DbProbe *probe,
+                                        Tier tier,
+                                        GetTierNameFunc GetTierName) {
+    const DbPooledFile *pooled =
+        ProbeAcquireFile(shards, archives, cache_source, tier, GetTierName);
+    if (pooled == NULL) return kFileSystemError;
+    const PooledBpdbFile *file = (const PooledBpdbFile *)pooled->handle;
+
+    // Version 2 files begin with a prefix. Version 1 files begin directly
+    // with the header, whose first field never matches the magic number.
+    int ret = kFileSystemError;
+    BpdbFileV2Prefix prefix;
+    if (!ProbeFileRead(file, &prefix, sizeof(prefix), 0)) goto _bailout;
+
+    // Read header. Assumes probe->buffer has enough space to store the meta.
+    ProbeTierMeta *meta = (ProbeTierMeta *)probe->buffer;
+    meta->header_offset = 0;
+    meta->scale_bits = 0;
+    meta->num_contexts = 0;
+    if (prefix.magic == kBpdbFileV2Magic) {
+        meta->header_offset = sizeof(prefix);
+        meta->scale_bits = prefix.scale_bits;
+        meta->num_contexts = prefix.num_contexts;
+    }
+    if (!ProbeFileRead(file, &meta->header, kHeaderSize, meta->header_offset)) {
+        goto _bailout;
+    }
 
     // Make sure probe->buffer has enough space for the next read.
     int bits_per_entry = ProbeGetBitsPerEntry(probe);
@@ -161,27 +321,37 @@ static int ProbeRecordStep0ReloadHeader(ConstantReadOnlyString sandbox_path,
         fprintf(
             stderr,
             "ProbeRecordStep0ReloadHeader: failed to expand probe buffer\n");
-        return BailOutFclose(db_file, 1);
+        ret = kMallocFailureError;
+        goto _bailout;
     }
 
-    // Read decompression dictionary.
-    error = GuardedFread(GenericPointerAdd(probe->buffer, kHeaderSize),
-                         decomp_dict_size, 1, db_file, false);
-    if (error != 0) return BailOutFclose(db_file, error);
+    // Read decompression dictionary. The buffer may have been reallocated.
+    meta = (ProbeTierMeta *)probe->buffer;
+    if (!ProbeFileRead(file, GenericPointerAdd(probe->buffer, kMetaSize),
+                   decomp_dict_size, meta->header_offset + kHeaderSize)) {
+        goto _bailout;
+    }
 
     // Uninitialize probe->begin so that a cache miss is triggered.
     probe->begin = -1;
     probe->tier = tier;
+    ret = kNoError;
 
-    return GuardedFclose(db_file);
+_bailout:
+    DbFilePoolRelease(pooled);
+    return ret;
+}
+
+static const ProbeTierMeta *ProbeGetMeta(const DbProbe *probe) {
+    return (const ProbeTierMeta *)probe->buffer;
 }
 
 const BpdbFileHeader *ProbeGetHeader(const DbProbe *probe) {
-    return (const BpdbFileHeader *)probe->buffer;
+    return &ProbeGetMeta(probe)->header;
 }
 
 const int32_t *ProbeGetDecompDict(const DbProbe *probe) {
-    return (const int32_t *)GenericPointerAdd(probe->buffer, kHeaderSize);
+    return (const int32_t *)GenericPointerAdd(probe->buffer, kMetaSize);
 }
 
 int64_t ProbeGetBlockSize(const DbProbe *probe) {
@@ -238,33 +408,67 @@ static bool ProbeRecordStep1CacheMiss(const DbProbe *probe, Position position) {
     return false;
 }
 
-static int ProbeRecordStep2LoadBlocks(ConstantReadOnlyString sandbox_path,
-                                      DbProbe *probe, Position position,
+typedef struct {
+    const DbProbe *probe;
+    const PooledBpdbFile *file;
+    int64_t cache_source;
+    int64_t block_offset;
+} ProbeBlockLoaderArgs;
+
+static bool ProbeRecordStep2_3Decode(const ProbeBlockLoaderArgs *args,
+                                     const void *src, int64_t src_size,
+                                     void *dest);
+
+// Loads the blocks that contain POSITION into PROBE's buffer through the
+// process-wide block cache, so that blocks already decompressed by other
+// probes or threads are not decompressed again. Compressed blocks are read
+// with pread from the tier file held open in the file pool.
+static int ProbeRecordStep2LoadBlocks(const DbShardMap *shards,
+                                      DbArchiveSet *archives,
+                                      int64_t cache_source, DbProbe *probe,
+                                      Position position,
                                       GetTierNameFunc GetTierName) {
     int ret = kRuntimeError;
-    char *full_path =
-        BpdbFileGetFullPath(sandbox_path, probe->tier, GetTierName);
-    if (full_path == NULL) return kMallocFailureError;
+    const DbPooledFile *pooled = ProbeAcquireFile(
+        shards, archives, cache_source, probe->tier, GetTierName);
+    if (pooled == NULL) return kFileSystemError;
 
-    // Get offset into the compressed bit stream.
-    int64_t compressed_offset =
-        ProbeRecordStep2_0ReadCompressedOffset(probe, position, full_path);
-    if (compressed_offset == -1) goto _bailout;
-
-    ret = ProbeRecordStep2_1HandleFile(probe, full_path, compressed_offset);
-    if (ret != kNoError) goto _bailout;
-
-    // Set PROBE->begin
     int64_t block_size = ProbeGetBlockSize(probe);
     int bits_per_entry = ProbeGetBitsPerEntry(probe);
     int64_t block_offset = GetBlockOffset(position, bits_per_entry, block_size);
+    int64_t num_blocks =
+        ProbeGetLookupTableSize(probe) / (int64_t)sizeof(int64_t);
+    void *buffer_blocks = ProbeGetBitStream(probe);
+    for (int i = 0; i < kBlocksPerBuffer; ++i) {
+        if (block_offset + i >= num_blocks) break;
+        DbBlockCacheKey key = {
+            .source = cache_source,
+            .tier = probe->tier,
+            .block = block_offset + i,
+        };
+        ProbeBlockLoaderArgs args = {
+            .probe = probe,
+            .file = (const PooledBpdbFile *)pooled->handle,
+            .cache_source = cache_source,
+            .block_offset = block_offset + i,
+        };
+        const DbCachedBlock *block =
+            DbBlockCacheAcquire(&key, ProbeRecordStep2_0LoadBlock, &args);
+        if (block == NULL) goto _bailout;
+
+        memcpy(GenericPointerAdd(buffer_blocks, i * block_size), block->data,
+               block->size);
+        DbBlockCacheRelease(block);
+    }
+
+    // Set PROBE->begin
     probe->begin = block_offset * block_size;
 
     // Success.
     ret = kNoError;
 
 _bailout:
-    free(full_path);
+    DbFilePoolRelease(pooled);
     return ret;
 }
 
@@ -285,67 +489,172 @@ static int64_t GetBlockOffset(Position position, int bits_per_entry,
 
 static void *ProbeGetBitStream(const DbProbe *probe) {
     int32_t decomp_dict_size = ProbeGetDecompDictSize(probe);
-    return GenericPointerAdd(probe->buffer, kHeaderSize + decomp_dict_size);
+    return GenericPointerAdd(probe->buffer, kMetaSize + decomp_dict_size);
 }
 
-static int64_t ProbeRecordStep2_0ReadCompressedOffset(const DbProbe *probe,
-                                                      Position position,
-                                                      const char *full_path) {
-    FILE *db_file = GuardedFopen(full_path, "rb");
-    if (db_file == NULL) return kFileSystemError;
+static void *ProbeRecordStep2_0LoadBlock(void *aux, int64_t *size) {
+    const ProbeBlockLoaderArgs *args = (const ProbeBlockLoaderArgs *)aux;
+    int64_t begin, end;
+    if (!ProbeRecordStep2_1GetCompressedRange(args->probe, args->file,
+                                              args->block_offset, &begin,
+                                              &end)) {
+        return NULL;
+    }
+
+    void *compressed = malloc(end - begin);
+    if (compressed == NULL) return NULL;
+    if (!ProbeFileRead(args->file, compressed, end - begin, begin)) {
+        free(compressed);
+        return NULL;
+    }
 
-    int bits_per_entry = ProbeGetBitsPerEntry(probe);
-    int64_t block_size = ProbeGetBlockSize(probe);
-    int64_t block_offset = GetBlockOffset(position, bits_per_entry, block_size);
+    // The last block may be shorter than the block size.
+    int64_t block_size = ProbeGetBlockSize(args->probe);
+    void *block = calloc(block_size, 1);
+    bool success = false;
+    if (block != NULL) {
+        if (ProbeGetMeta(args->probe)->scale_bits > 0) {
+            success = ProbeRecordStep2_3Decode(args, compressed, end - begin,
+                                               block);
+        } else {
+            success = ProbeRecordStep2_2Inflate(compressed, end - begin, block,
+                                                block_size);
+        }
+    }
+    free(compressed);
+    if (!success) {
+        free(block);
+        return NULL;
+    }
+    *size = block_size;
 
-    // Seek to the entry in lookup that corresponds to block_offset.
-    int32_t decomp_dict_size = ProbeGetDecompDictSize(probe);
-    int64_t seek_length = kHeaderSize + decomp_dict_size +
-                          block_offset * (int64_t)sizeof(int64_t);
-    int error = GuardedFseek(db_file, seek_length, SEEK_SET);
-    if (error) return BailOutFclose(db_file, -1);
+    return block;
+}
 
-    // Read offset into the compressed bit stream.
-    int64_t compressed_offset;
-    error =
-        GuardedFread(&compressed_offset, sizeof(int64_t), 1, db_file, false);
-    if (error) return BailOutFclose(db_file, -1);
+// Offset of the frequency table of a version 2 tier file, which immediately
+// follows the decompression dictionary.
+static int64_t ProbeGetFreqTableOffset(const DbProbe *probe) {
+    return ProbeGetMeta(probe)->header_offset + kHeaderSize +
+           ProbeGetDecompDictSize(probe);
+}
 
-    // Finalize.
-    error = GuardedFclose(db_file);
-    if (error != 0) return kFileSystemError;
+// Size of the frequency table of a version 2 tier file, which contains one
+// uint32_t for each dictionary entry in each context, or 0 for version 1.
+static int64_t ProbeGetFreqTableSize(const DbProbe *probe) {
+    const ProbeTierMeta *meta = ProbeGetMeta(probe);
+    if (meta->scale_bits <= 0) return 0;
 
-    int32_t lookup_table_size = ProbeGetLookupTableSize(probe);
-    return compressed_offset + kHeaderSize + decomp_dict_size +
-           lookup_table_size;
+    return (int64_t)ProbeGetDecompDictSize(probe) * meta->num_contexts;
 }
 
-static int ProbeRecordStep2_1HandleFile(const DbProbe *probe,
-                                        const char *full_path,
-                                        int64_t compressed_offset) {
-    // Open db_file
-    int db_fd = GuardedOpen(full_path, O_RDONLY);
-    if (db_fd == -1) return BailOutClose(db_fd, -1);
+static int64_t ProbeGetLookupTableOffset(const DbProbe *probe) {
+    return ProbeGetFreqTableOffset(probe) + ProbeGetFreqTableSize(probe);
+}
 
-    // lseek() to the beginning of the first block that contains POSITION.
-    int error = GuardedLseek(db_fd, compressed_offset, SEEK_SET);
-    if (error != 0) return BailOutClose(db_fd, error);
+// Builds the rANS decoding table of the tier loaded into the probe.
+static void *ProbeLoadDecoder(void *aux, int64_t *size) {
+    const ProbeBlockLoaderArgs *args = (const ProbeBlockLoaderArgs *)aux;
+    const ProbeTierMeta *meta = ProbeGetMeta(args->probe);
+    int32_t num_symbols =
+        ProbeGetDecompDictSize(args->probe) / (int32_t)sizeof(int32_t);
+    int64_t freq_table_size = ProbeGetFreqTableSize(args->probe);
+    if (freq_table_size <= 0) return NULL;
+    uint32_t *freqs = (uint32_t *)malloc(freq_table_size);
+    if (freqs == NULL) return NULL;
+    if (!ProbeFileRead(args->file, freqs, freq_table_size,
+                   ProbeGetFreqTableOffset(args->probe))) {
+        free(freqs);
+        return NULL;
+    }
 
-    // Wrap db_fd in a gzFile container.
-    gzFile compressed_stream = GuardedGzdopen(db_fd, "rb");
-    if (compressed_stream == Z_NULL) return BailOutClose(db_fd, -1);
+    BpRansModel model;
+    int error = BpRansModelInitFromFreqs(&model, freqs, num_symbols,
+                                         meta->num_contexts, meta->scale_bits);
+    free(freqs);
+    if (error != kNoError) return NULL;
 
-    // Since the cursor is already at the beginning of the first block,
-    // we can start reading from there.
-    int64_t block_size = ProbeGetBlockSize(probe);
-    void *buffer_blocks = ProbeGetBitStream(probe);
-    error = GuardedGzread(compressed_stream, buffer_blocks,
-                          (unsigned int)(kBlocksPerBuffer * block_size), true);
-    if (error != 0) return BailOutGzclose(compressed_stream, error);
+    BpRansDecoder *decoder = BpRansDecoderCreate(&model, size);
+    BpRansModelDestroy(&model);
+
+    return decoder;
+}
+
+// Decodes the rANS-encoded block SRC of SRC_SIZE bytes into DEST. The decoding
+// table is shared by all probes and threads through the block cache.
+static bool ProbeRecordStep2_3Decode(const ProbeBlockLoaderArgs *args,
+                                     const void *src, int64_t src_size,
+                                     void *dest) {
+    const DbProbe *probe = args->probe;
+    DbBlockCacheKey key = {
+        .source = args->cache_source,
+        .tier = probe->tier,
+        .block = kDecoderBlockIndex,
+    };
+    const DbCachedBlock *decoder = DbBlockCacheAcquire(
+        &key, ProbeLoadDecoder, (void *)args);
+    if (decoder == NULL) return false;
+
+    // Each block holds a whole number of entries. The last block holds the
+    // remaining entries.
+    int bits_per_entry = ProbeGetBitsPerEntry(probe);
+    int64_t entries_per_block =
+        ProbeGetBlockSize(probe) * kBitsPerByte / bits_per_entry;
+    int64_t first_entry = args->block_offset * entries_per_block;
+    int64_t num_entries =
+        ProbeGetHeader(probe)->stream_meta.num_entries - first_entry;
+    if (num_entries > entries_per_block) num_entries = entries_per_block;
+    bool success = BpRansDecode((const BpRansDecoder *)decoder->data,
+                                (const uint8_t *)src, src_size, num_entries,
+                                bits_per_entry, (uint8_t *)dest);
+    DbBlockCacheRelease(decoder);
+
+    return success;
+}
+
+// Reads the range [BEGIN, END) of the compressed block BLOCK_OFFSET in the
+// tier file from the lookup table.
+static bool ProbeRecordStep2_1GetCompressedRange(const DbProbe *probe,
+                                                 const PooledBpdbFile *file,
+                                                 int64_t block_offset,
+                                                 int64_t *begin, int64_t *end) {
+    int32_t lookup_table_size = ProbeGetLookupTableSize(probe);
+    int64_t num_blocks = lookup_table_size / (int64_t)sizeof(int64_t);
+    int64_t lookup_begin = ProbeGetLookupTableOffset(probe);
+    int64_t stream_begin = lookup_begin + lookup_table_size;
+
+    // Read the offsets of this block and the next one into the compressed bit
+    // stream. The last block extends to the end of the file.
+    int64_t offsets[2] = {0, file->size - stream_begin};
+    int count = block_offset + 1 < num_blocks ? 2 : 1;
+    if (!ProbeFileRead(file, offsets, count * (int64_t)sizeof(int64_t),
+                   lookup_begin + block_offset * (int64_t)sizeof(int64_t))) {
+        return false;
+    }
+    if (offsets[1] < offsets[0]) return false;
+
+    *begin = stream_begin + offsets[0];
+    *end = stream_begin + offsets[1];
+    return true;
+}
 
-    // This will also close db_fd.
-    error = GuardedGzclose(compressed_stream);
-    return error;
+// Inflates the gzip member SRC of SRC_SIZE bytes into DEST, which has space
+// for DEST_SIZE bytes.
+static bool ProbeRecordStep2_2Inflate(const void *src, int64_t src_size,
+                                      void *dest, int64_t dest_size) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // 16 + MAX_WBITS: decode the gzip wrapper written by gzwrite.
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) return false;
+
+    stream.next_in = (Bytef *)src;
+    stream.avail_in = (uInt)src_size;
+    stream.next_out = (Bytef *)dest;
+    stream.avail_out = (uInt)dest_size;
+    int error = inflate(&stream, Z_FINISH);
+    bool full = (stream.avail_out == 0);
+    inflateEnd(&stream);
+
+    return error == Z_STREAM_END || full;
 }
 
 // Loads the record of POSITION, assuming the requested record is in PROBE's
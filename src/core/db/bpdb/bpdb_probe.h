@@ -31,8 +31,10 @@
 #ifndef GAMESMANONE_CORE_DB_BPDB_BPDB_PROBE_H_
 #define GAMESMANONE_CORE_DB_BPDB_BPDB_PROBE_H_
 
-#include <stdint.h>  // uint64_t
+#include <stdint.h>  // int64_t, uint64_t
 
+#include "core/db/db_archive.h"
+#include "core/db/db_shard.h"
 #include "core/types/gamesman_types.h"
 
 /**
@@ -54,14 +56,19 @@ int BpdbProbeDestroy(DbProbe *probe);
  * @brief Probes the record for TIER_POSITION using the given PROBE and returns
  * it.
  *
- * @param sandbox_path Path to the sandbox directory provided to BPDB.
+ * @param shards Directories that store the tier files of BPDB.
+ * @param archives Archives of packed tiers in SHARDS, which take precedence
+ * over tier files, or NULL if only tier files are used.
+ * @param cache_source Source ID of the database in the process-wide block
+ * cache. See DbBlockCacheNewSource.
  * @param probe Initialized database probe to use.
  * @param tier_position Tier position to query.
  * @param GetTierName Function that converts a tier to its name. If set to
  * NULL, a fallback method will be used instead.
  * @return Record encoded as an unsigned integer.
  */
-uint64_t BpdbProbeRecord(ConstantReadOnlyString sandbox_path, DbProbe *probe,
+uint64_t BpdbProbeRecord(const DbShardMap *shards, DbArchiveSet *archives,
+                         int64_t cache_source, DbProbe *probe,
                          TierPosition tier_position,
                          GetTierNameFunc GetTierName);
 
@@ -0,0 +1,363 @@
+/**
+ * @file bprans.c
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Implementation of the static order-1 rANS codec for BpArray bit
+ * streams.
+ * @details The coder follows the byte-wise renormalizing rANS construction with
+ * a 32-bit state. Symbols are encoded in reverse order so that the decoder
+ * reads its input front to back.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/db/bpdb/bprans.h"
+
+#include <stdbool.h>  // bool, true, false
+#include <stddef.h>   // NULL
+#include <stdint.h>   // int32_t, int64_t, uint8_t, uint16_t, uint32_t, ...
+#include <stdlib.h>   // malloc, free
+#include <string.h>   // memcpy, memset
+
+#include "core/constants.h"
+#include "core/types/gamesman_types.h"
+
+// Lower bound of the normalized rANS state interval [kRansLowerBound,
+// kRansLowerBound << 8).
+static const uint32_t kRansLowerBound = (uint32_t)1 << 23;
+
+// Normalized frequencies are stored in at least 12 bits and at most 16 bits.
+// Having at least 4 slots per symbol keeps the precision loss caused by
+// rounding rare symbols up to a frequency of 1 small. The number of contexts
+// is limited so that the decoding table of all contexts has at most 2^15
+// slots.
+enum {
+    kMinScaleBits = 12,
+    kMaxScaleBits = 16,
+    kSlotsPerSymbolMin = 4,
+    kMaxNumContexts = 8,
+    kMaxDecoderSlotsBits = 15,
+};
+
+// With at most 16 scale bits and at least 4 slots per symbol, the frequency,
+// bias, and symbol of each slot all fit in 16 bits.
+typedef struct {
+    uint16_t freq;    // Normalized frequency of the symbol.
+    uint16_t symbol;  // Symbol that owns the slot.
+    uint16_t bias;    // Offset of the slot from the start of the symbol.
+} BpRansSlot;
+
+struct BpRansDecoder {
+    int32_t scale_bits;
+    int32_t num_contexts;
+    BpRansSlot slots[];  // 2^scale_bits slots per context.
+};
+
+static int ModelAlloc(BpRansModel *model, int32_t num_symbols,
+                      int32_t num_contexts, int scale_bits);
+static void ModelNormalize(uint32_t *freqs, const int64_t *counts,
+                           int32_t num_symbols, int scale_bits);
+static void ModelComputeStarts(BpRansModel *model);
+
+static uint32_t GetEntry(const uint8_t *stream, int64_t i, int bits_per_entry);
+static uint32_t GetContext(uint32_t prev, int32_t num_contexts);
+
+// -----------------------------------------------------------------------------
+
+int BpRansGetScaleBits(int32_t num_symbols) {
+    int scale_bits = kMinScaleBits;
+    while (((int64_t)1 << scale_bits) <
+           (int64_t)num_symbols * kSlotsPerSymbolMin) {
+        ++scale_bits;
+    }
+    if (scale_bits > kMaxScaleBits) return 0;
+
+    return scale_bits;
+}
+
+int32_t BpRansGetNumContexts(int32_t num_symbols, int scale_bits) {
+    int32_t num_contexts = kMaxNumContexts;
+    if (num_contexts > num_symbols) num_contexts = num_symbols;
+    if (scale_bits >= kMaxDecoderSlotsBits) return 1;
+    int32_t max_contexts = (int32_t)1 << (kMaxDecoderSlotsBits - scale_bits);
+    if (num_contexts > max_contexts) num_contexts = max_contexts;
+
+    return num_contexts > 0 ? num_contexts : 1;
+}
+
+void BpRansCountBlock(const uint8_t *stream, int64_t num_entries,
+                      int bits_per_entry, int32_t num_symbols,
+                      int32_t num_contexts, int64_t *counts) {
+    uint32_t context = 0;
+    for (int64_t i = 0; i < num_entries; ++i) {
+        uint32_t symbol = GetEntry(stream, i, bits_per_entry);
+        ++counts[(int64_t)context * num_symbols + symbol];
+        context = GetContext(symbol, num_contexts);
+    }
+}
+
+int BpRansModelInit(BpRansModel *model, const int64_t *counts,
+                    int32_t num_symbols, int32_t num_contexts,
+                    int scale_bits) {
+    int error = ModelAlloc(model, num_symbols, num_contexts, scale_bits);
+    if (error != kNoError) return error;
+
+    for (int32_t c = 0; c < num_contexts; ++c) {
+        int64_t offset = (int64_t)c * num_symbols;
+        ModelNormalize(model->freqs + offset, counts + offset, num_symbols,
+                       scale_bits);
+    }
+    ModelComputeStarts(model);
+
+    return kNoError;
+}
+
+int BpRansModelInitFromFreqs(BpRansModel *model, const uint32_t *freqs,
+                             int32_t num_symbols, int32_t num_contexts,
+                             int scale_bits) {
+    if (num_contexts <= 0 || num_symbols <= 0 || scale_bits <= 0 ||
+        scale_bits > kMaxScaleBits) {
+        return kIllegalArgumentError;
+    }
+    int error = ModelAlloc(model, num_symbols, num_contexts, scale_bits);
+    if (error != kNoError) return error;
+
+    // Every symbol must have a nonzero frequency for the model to be valid.
+    bool valid = true;
+    for (int32_t c = 0; c < num_contexts; ++c) {
+        int64_t sum = 0;
+        for (int32_t i = 0; i < num_symbols; ++i) {
+            int64_t j = (int64_t)c * num_symbols + i;
+            model->freqs[j] = freqs[j];
+            sum += freqs[j];
+            if (freqs[j] == 0) valid = false;
+        }
+        if (sum != ((int64_t)1 << scale_bits)) valid = false;
+    }
+    if (!valid) {
+        BpRansModelDestroy(model);
+        return kIllegalArgumentError;
+    }
+    ModelComputeStarts(model);
+
+    return kNoError;
+}
+
+void BpRansModelDestroy(BpRansModel *model) {
+    free(model->freqs);
+    free(model->starts);
+    memset(model, 0, sizeof(*model));
+}
+
+int64_t BpRansGetEncodeBound(int64_t num_entries) {
+    // With at most 16 scale bits, each symbol emits at most 2 bytes. The final
+    // state takes another 4 bytes.
+    return 2 * num_entries + (int64_t)sizeof(uint32_t);
+}
+
+int64_t BpRansEncode(const BpRansModel *model, const uint8_t *stream,
+                     int64_t num_entries, int bits_per_entry, uint8_t *out) {
+    int scale_bits = model->scale_bits;
+    int64_t bound = BpRansGetEncodeBound(num_entries);
+    uint8_t *ptr = out + bound;
+    uint32_t x = kRansLowerBound;
+
+    // Encode in reverse order so that the decoder runs forward. The context
+    // of each entry is determined by the entry before it.
+    for (int64_t i = num_entries - 1; i >= 0; --i) {
+        uint32_t symbol = GetEntry(stream, i, bits_per_entry);
+        uint32_t context =
+            i == 0 ? 0
+                   : GetContext(GetEntry(stream, i - 1, bits_per_entry),
+                                model->num_contexts);
+        int64_t j = (int64_t)context * model->num_symbols + symbol;
+        uint32_t freq = model->freqs[j];
+        uint32_t x_max = ((kRansLowerBound >> scale_bits) << 8) * freq;
+        while (x >= x_max) {
+            *--ptr = (uint8_t)(x & 0xff);
+            x >>= 8;
+        }
+        x = ((x / freq) << scale_bits) + (x % freq) + model->starts[j];
+    }
+
+    // Flush the final state in little-endian order.
+    ptr -= sizeof(uint32_t);
+    for (int i = 0; i < (int)sizeof(uint32_t); ++i) {
+        ptr[i] = (uint8_t)(x >> (i * kBitsPerByte));
+    }
+
+    int64_t size = (out + bound) - ptr;
+    memmove(out, ptr, size);
+
+    return size;
+}
+
+BpRansDecoder *BpRansDecoderCreate(const BpRansModel *model, int64_t *size) {
+    int64_t num_slots = (int64_t)model->num_contexts << model->scale_bits;
+    *size = (int64_t)sizeof(BpRansDecoder) + num_slots * sizeof(BpRansSlot);
+    BpRansDecoder *decoder = (BpRansDecoder *)malloc(*size);
+    if (decoder == NULL) return NULL;
+
+    decoder->scale_bits = model->scale_bits;
+    decoder->num_contexts = model->num_contexts;
+    for (int32_t c = 0; c < model->num_contexts; ++c) {
+        BpRansSlot *slots = decoder->slots + ((int64_t)c << model->scale_bits);
+        for (int32_t symbol = 0; symbol < model->num_symbols; ++symbol) {
+            int64_t j = (int64_t)c * model->num_symbols + symbol;
+            uint32_t start = model->starts[j];
+            for (uint32_t k = 0; k < model->freqs[j]; ++k) {
+                BpRansSlot *slot = &slots[start + k];
+                slot->freq = (uint16_t)model->freqs[j];
+                slot->symbol = (uint16_t)symbol;
+                slot->bias = (uint16_t)k;
+            }
+        }
+    }
+
+    return decoder;
+}
+
+bool BpRansDecode(const BpRansDecoder *decoder, const uint8_t *in,
+                  int64_t in_size, int64_t num_entries, int bits_per_entry,
+                  uint8_t *stream) {
+    static const int kBitsPerWord = kBitsPerByte * sizeof(uint64_t);
+    if (in_size < (int64_t)sizeof(uint32_t)) return false;
+
+    const uint8_t *end = in + in_size;
+    uint32_t x = 0;
+    for (int i = 0; i < (int)sizeof(uint32_t); ++i) {
+        x |= (uint32_t)in[i] << (i * kBitsPerByte);
+    }
+    in += sizeof(uint32_t);
+
+    int scale_bits = decoder->scale_bits;
+    int32_t num_contexts = decoder->num_contexts;
+    uint32_t slot_mask = ((uint32_t)1 << scale_bits) - 1;
+    const BpRansSlot *slots = decoder->slots;  // Context 0.
+    uint64_t word = 0;
+    int filled = 0;
+    for (int64_t i = 0; i < num_entries; ++i) {
+        const BpRansSlot *slot = &slots[x & slot_mask];
+        x = slot->freq * (x >> scale_bits) + slot->bias;
+        while (x < kRansLowerBound) {
+            if (in == end) return false;
+            x = (x << 8) | *in++;
+        }
+
+        // Pack the decoded symbol into the bit stream and switch to the
+        // context of the next entry.
+        uint64_t symbol = slot->symbol;
+        slots = decoder->slots +
+                ((int64_t)GetContext((uint32_t)symbol, num_contexts)
+                 << scale_bits);
+        word |= symbol << filled;
+        filled += bits_per_entry;
+        if (filled >= kBitsPerWord) {
+            memcpy(stream, &word, sizeof(word));
+            stream += sizeof(word);
+            filled -= kBitsPerWord;
+            word = filled > 0 ? symbol >> (bits_per_entry - filled) : 0;
+        }
+    }
+    if (filled > 0) memcpy(stream, &word, sizeof(word));
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+static int ModelAlloc(BpRansModel *model, int32_t num_symbols,
+                      int32_t num_contexts, int scale_bits) {
+    memset(model, 0, sizeof(*model));
+    int64_t num_freqs = (int64_t)num_symbols * num_contexts;
+    model->freqs = (uint32_t *)malloc(num_freqs * sizeof(uint32_t));
+    model->starts = (uint32_t *)malloc(num_freqs * sizeof(uint32_t));
+    if (model->freqs == NULL || model->starts == NULL) {
+        BpRansModelDestroy(model);
+        return kMallocFailureError;
+    }
+    model->num_symbols = num_symbols;
+    model->num_contexts = num_contexts;
+    model->scale_bits = scale_bits;
+
+    return kNoError;
+}
+
+// Normalizes the symbol COUNTS of a single context into FREQS.
+static void ModelNormalize(uint32_t *freqs, const int64_t *counts,
+                           int32_t num_symbols, int scale_bits) {
+    int64_t total = 0;
+    for (int32_t i = 0; i < num_symbols; ++i) {
+        total += counts[i];
+    }
+    if (total == 0) total = 1;
+
+    // Scale counts down to the target sum, rounding every symbol up to at
+    // least 1 so that all of them remain encodable.
+    int64_t target = (int64_t)1 << scale_bits;
+    int64_t sum = 0;
+    int32_t largest = 0;
+    for (int32_t i = 0; i < num_symbols; ++i) {
+        int64_t freq = (int64_t)((double)counts[i] * target / total);
+        if (freq < 1) freq = 1;
+        freqs[i] = (uint32_t)freq;
+        sum += freq;
+        if (counts[i] > counts[largest]) largest = i;
+    }
+
+    // Fix the sum. Rounding down can only leave slots unassigned, which are
+    // given to the most frequent symbol. Rounding up may overshoot, in which
+    // case frequencies greater than 1 are decremented in turn.
+    if (sum < target) freqs[largest] += (uint32_t)(target - sum);
+    while (sum > target) {
+        for (int32_t i = 0; i < num_symbols && sum > target; ++i) {
+            if (freqs[i] > 1) {
+                --freqs[i];
+                --sum;
+            }
+        }
+    }
+}
+
+static void ModelComputeStarts(BpRansModel *model) {
+    for (int32_t c = 0; c < model->num_contexts; ++c) {
+        uint32_t start = 0;
+        for (int32_t i = 0; i < model->num_symbols; ++i) {
+            int64_t j = (int64_t)c * model->num_symbols + i;
+            model->starts[j] = start;
+            start += model->freqs[j];
+        }
+    }
+}
+
+static uint32_t GetEntry(const uint8_t *stream, int64_t i, int bits_per_entry) {
+    int64_t bit_offset = i * bits_per_entry;
+    uint64_t segment;
+    memcpy(&segment, stream + bit_offset / kBitsPerByte, sizeof(segment));
+    segment >>= bit_offset % kBitsPerByte;
+
+    return (uint32_t)(segment & (((uint64_t)1 << bits_per_entry) - 1));
+}
+
+// Returns the context of the entry following an entry of value PREV.
+static uint32_t GetContext(uint32_t prev, int32_t num_contexts) {
+    uint32_t last = (uint32_t)num_contexts - 1;
+    return prev < last ? prev : last;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file bprans.h
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Static order-1 rANS codec for BpArray bit streams.
+ * @details Encodes the dictionary indices stored in a BpArray bit stream with a
+ * range asymmetric numeral system (rANS) coder using a small set of frequency
+ * tables selected by the previous entry, and decodes them back into the same
+ * bit-packed layout.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAMESMANONE_CORE_DB_BPDB_BPRANS_H_
+#define GAMESMANONE_CORE_DB_BPDB_BPRANS_H_
+
+#include <stdbool.h>  // bool
+#include <stdint.h>   // int32_t, int64_t, uint8_t, uint32_t
+
+/**
+ * @brief Static order-1 rANS model over the encoded entries of a BpArray.
+ * @details Entries of a BpArray are dictionary indices in the range
+ * [0, num_symbols). Each entry is coded using the frequency table of its
+ * context, which is the previous entry in the same block clamped to
+ * num_contexts - 1. The first entry of each block uses context 0. In every
+ * context, each symbol is assigned a nonzero normalized frequency, and the
+ * frequencies of all symbols sum to exactly 2^scale_bits.
+ */
+typedef struct BpRansModel {
+    /** Base-2 logarithm of the sum of all normalized frequencies. */
+    int scale_bits;
+
+    /** Number of symbols in the model. */
+    int32_t num_symbols;
+
+    /** Number of contexts in the model. */
+    int32_t num_contexts;
+
+    /**
+     * Normalized frequency of each symbol in each context, stored as
+     * num_contexts rows of num_symbols entries.
+     */
+    uint32_t *freqs;
+
+    /**
+     * Sum of the normalized frequencies of all preceding symbols in the same
+     * context, in the same layout as freqs.
+     */
+    uint32_t *starts;
+} BpRansModel;
+
+/**
+ * @brief Decoding table built from a BpRansModel. Allocated as a single block
+ * of memory and freed using the \c free function.
+ */
+typedef struct BpRansDecoder BpRansDecoder;
+
+/**
+ * @brief Returns the number of scale bits to use for a model of NUM_SYMBOLS
+ * symbols, or 0 if the codec does not support that many symbols, in which
+ * case the stream should be compressed using a different method.
+ */
+int BpRansGetScaleBits(int32_t num_symbols);
+
+/**
+ * @brief Returns the number of contexts to use for a model of NUM_SYMBOLS
+ * symbols with SCALE_BITS scale bits, which is limited so that the decoding
+ * table remains small.
+ */
+int32_t BpRansGetNumContexts(int32_t num_symbols, int scale_bits);
+
+/**
+ * @brief Adds the number of occurrences of each symbol in each context among
+ * the NUM_ENTRIES entries of the block STREAM, in which each entry occupies
+ * BITS_PER_ENTRY bits, to COUNTS, which is laid out in the same way as
+ * BpRansModel::freqs.
+ */
+void BpRansCountBlock(const uint8_t *stream, int64_t num_entries,
+                      int bits_per_entry, int32_t num_symbols,
+                      int32_t num_contexts, int64_t *counts);
+
+/**
+ * @brief Initializes MODEL of NUM_SYMBOLS symbols and NUM_CONTEXTS contexts
+ * by normalizing the symbol COUNTS of each context to sum to 2^SCALE_BITS.
+ * Every symbol is assigned a frequency of at least 1 regardless of its count.
+ * @return 0 on success, or
+ * @return non-zero error code on failure.
+ */
+int BpRansModelInit(BpRansModel *model, const int64_t *counts,
+                    int32_t num_symbols, int32_t num_contexts, int scale_bits);
+
+/**
+ * @brief Initializes MODEL of NUM_SYMBOLS symbols and NUM_CONTEXTS contexts
+ * using the normalized frequencies FREQS previously generated by
+ * BpRansModelInit.
+ * @return 0 on success, or
+ * @return non-zero error code on failure, including the case where the FREQS
+ * of any context do not sum to 2^SCALE_BITS.
+ */
+int BpRansModelInitFromFreqs(BpRansModel *model, const uint32_t *freqs,
+                             int32_t num_symbols, int32_t num_contexts,
+                             int scale_bits);
+
+/** @brief Destroys MODEL. */
+void BpRansModelDestroy(BpRansModel *model);
+
+/**
+ * @brief Returns the maximum size in bytes of the output of BpRansEncode for
+ * NUM_ENTRIES entries.
+ */
+int64_t BpRansGetEncodeBound(int64_t num_entries);
+
+/**
+ * @brief Encodes the first NUM_ENTRIES entries of the block STREAM, in which
+ * each entry occupies BITS_PER_ENTRY bits, into OUT using MODEL.
+ * @note STREAM must be readable for 8 bytes past the last entry, which is
+ * guaranteed for the bit stream of a BpArray.
+ * @param model Model containing every entry of STREAM as a symbol.
+ * @param stream Bit stream of the block to encode.
+ * @param num_entries Number of entries to encode.
+ * @param bits_per_entry Number of bits per entry in STREAM.
+ * @param out Output buffer of at least BpRansGetEncodeBound(num_entries)
+ * bytes.
+ * @return Number of bytes written to OUT.
+ */
+int64_t BpRansEncode(const BpRansModel *model, const uint8_t *stream,
+                     int64_t num_entries, int bits_per_entry, uint8_t *out);
+
+/**
+ * @brief Returns a decoding table for MODEL allocated as a single block of
+ * SIZE bytes, or NULL on malloc failure. The caller is responsible for
+ * freeing the table using the \c free function.
+ */
+BpRansDecoder *BpRansDecoderCreate(const BpRansModel *model, int64_t *size);
+
+/**
+ * @brief Decodes NUM_ENTRIES entries from IN of IN_SIZE bytes generated by
+ * BpRansEncode and packs them into STREAM using BITS_PER_ENTRY bits per
+ * entry, starting from bit 0 of STREAM.
+ * @note STREAM is written in whole 64-bit words and must have space for
+ * ceil(NUM_ENTRIES * BITS_PER_ENTRY / 64) words.
+ * @return true on success, or
+ * @return false if IN is corrupted.
+ */
+bool BpRansDecode(const BpRansDecoder *decoder, const uint8_t *in,
+                  int64_t in_size, int64_t num_entries, int bits_per_entry,
+                  uint8_t *stream);
+
+#endif  // GAMESMANONE_CORE_DB_BPDB_BPRANS_H_
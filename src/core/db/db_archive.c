@@ -0,0 +1,483 @@
+/**
+ * @file db_archive.c
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Implementation of the packed archive of solved tier files.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/db/db_archive.h"
+
+#include <errno.h>      // errno, EINTR, ENOENT
+#include <fcntl.h>      // open, O_RDONLY, O_WRONLY, O_CREAT
+#include <inttypes.h>   // PRId64
+#include <stdbool.h>    // bool, true, false
+#include <stddef.h>     // NULL
+#include <stdint.h>     // int32_t, int64_t, uint64_t
+#include <stdio.h>      // fprintf, stderr, perror, sprintf
+#include <stdlib.h>     // malloc, realloc, free
+#include <string.h>     // strlen, memcpy
+#include <sys/stat.h>   // fstat, struct stat
+#include <sys/types.h>  // ssize_t, off_t
+#include <unistd.h>     // pread, pwrite, ftruncate, fsync
+
+#include "core/concurrency.h"
+#include "core/db/db_shard.h"
+#include "core/misc.h"
+#include "core/types/gamesman_types.h"
+
+// Name of the index file in the archive directory.
+static ConstantReadOnlyString kIndexFileName = "archive.idx";
+
+// Format of the segment file names in the archive directory.
+static ConstantReadOnlyString kSegmentFileFormat = "archive.%d.seg";
+
+// Magic number at the beginning of the index file ("GMARCHV1").
+static const uint64_t kIndexMagic = UINT64_C(0x3156484352414d47);
+
+// Size of the header of the index file, which consists of the magic number.
+static const int64_t kIndexHeaderSize = sizeof(uint64_t);
+
+// Maximum length of a segment file name.
+enum { kSegmentFileNameLengthMax = 32 };
+
+// -----------------------------------------------------------------------------
+
+static char *GetFilePath(const DbArchive *archive, ReadOnlyString name) {
+    char *path = (char *)malloc(strlen(archive->path) + strlen(name) + 2);
+    if (path == NULL) return NULL;
+    sprintf(path, "%s/%s", archive->path, name);
+
+    return path;
+}
+
+static char *GetSegmentPath(const DbArchive *archive, int32_t segment) {
+    char name[kSegmentFileNameLengthMax];
+    sprintf(name, kSegmentFileFormat, segment);
+
+    return GetFilePath(archive, name);
+}
+
+static bool PreadFull(int fd, void *buf, int64_t size, int64_t offset) {
+    while (size > 0) {
+        ssize_t n = pread(fd, buf, (size_t)size, (off_t)offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        buf = GenericPointerAdd(buf, n);
+        size -= n;
+        offset += n;
+    }
+
+    return true;
+}
+
+static bool PwriteFull(int fd, const void *buf, int64_t size, int64_t offset) {
+    while (size > 0) {
+        ssize_t n = pwrite(fd, buf, (size_t)size, (off_t)offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        buf = GenericPointerAdd(buf, n);
+        size -= n;
+        offset += n;
+    }
+
+    return true;
+}
+
+// Records ENTRY in the in-memory index of ARCHIVE, superseding any earlier
+// entry of the same tier.
+static int ApplyEntry(DbArchive *archive, const DbArchiveEntry *entry) {
+    TierHashMapIterator it = TierHashMapGet(&archive->map, entry->tier);
+    if (TierHashMapIteratorIsValid(&it)) {
+        archive->entries[TierHashMapIteratorValue(&it)] = *entry;
+        return kNoError;
+    }
+
+    if (archive->num_entries == archive->capacity) {
+        int64_t new_capacity = archive->capacity ? archive->capacity * 2 : 64;
+        DbArchiveEntry *new_entries = (DbArchiveEntry *)realloc(
+            archive->entries, new_capacity * sizeof(DbArchiveEntry));
+        if (new_entries == NULL) return kMallocFailureError;
+        archive->entries = new_entries;
+        archive->capacity = new_capacity;
+    }
+    if (!TierHashMapSet(&archive->map, entry->tier, archive->num_entries)) {
+        return kMallocFailureError;
+    }
+    archive->entries[archive->num_entries++] = *entry;
+
+    return kNoError;
+}
+
+static bool EntryIsValid(const DbArchiveEntry *entry) {
+    if (entry->size < 0) return entry->size == -1;
+    return entry->segment >= 0 && entry->offset >= 0;
+}
+
+// Reads all complete entries of the index file of ARCHIVE. A missing index
+// is treated as an empty archive, and a torn entry at the end is ignored.
+static int LoadIndex(DbArchive *archive) {
+    char *path = GetFilePath(archive, kIndexFileName);
+    if (path == NULL) return kMallocFailureError;
+    int fd = open(path, O_RDONLY);
+    free(path);
+    if (fd < 0) return errno == ENOENT ? kNoError : kFileSystemError;
+
+    int ret = kFileSystemError;
+    DbArchiveEntry *entries = NULL;
+    struct stat st;
+    uint64_t magic;
+    if (fstat(fd, &st) != 0) goto _bailout;
+    int64_t file_size = (int64_t)st.st_size;
+    if (file_size < kIndexHeaderSize) {  // Torn header.
+        ret = kNoError;
+        goto _bailout;
+    }
+    if (!PreadFull(fd, &magic, sizeof(magic), 0) || magic != kIndexMagic) {
+        fprintf(stderr, "LoadIndex: %s/%s is not an archive index\n",
+                archive->path, kIndexFileName);
+        goto _bailout;
+    }
+
+    // Read all complete entries at once.
+    int64_t num_entries =
+        (file_size - kIndexHeaderSize) / (int64_t)sizeof(DbArchiveEntry);
+    entries = (DbArchiveEntry *)malloc(num_entries * sizeof(DbArchiveEntry));
+    if (num_entries > 0 && entries == NULL) {
+        ret = kMallocFailureError;
+        goto _bailout;
+    }
+    if (!PreadFull(fd, entries, num_entries * sizeof(DbArchiveEntry),
+                   kIndexHeaderSize)) {
+        goto _bailout;
+    }
+    for (int64_t i = 0; i < num_entries; ++i) {
+        if (!EntryIsValid(&entries[i])) {
+            fprintf(stderr, "LoadIndex: corrupted entry %" PRId64 " in %s\n",
+                    i, archive->path);
+            goto _bailout;
+        }
+        ret = ApplyEntry(archive, &entries[i]);
+        if (ret != kNoError) goto _bailout;
+        ret = kFileSystemError;
+        if (entries[i].segment >= archive->num_segments) {
+            archive->num_segments = entries[i].segment + 1;
+        }
+    }
+    archive->index_size =
+        kIndexHeaderSize + num_entries * (int64_t)sizeof(DbArchiveEntry);
+    ret = kNoError;
+
+_bailout:
+    free(entries);
+    GuardedClose(fd);
+    return ret;
+}
+
+static int ArchiveInit(DbArchive *archive, ReadOnlyString path) {
+    memset(archive, 0, sizeof(*archive));
+    archive->write_fd = -1;
+    archive->index_fd = -1;
+    TierHashMapInit(&archive->map, 0.5);
+    archive->path = (char *)malloc(strlen(path) + 1);
+    if (archive->path == NULL) return kMallocFailureError;
+    strcpy(archive->path, path);
+
+    int error = LoadIndex(archive);
+    if (error != kNoError) return error;
+    if (archive->num_segments == 0) return kNoError;
+
+    archive->segment_fds = (int *)malloc(archive->num_segments * sizeof(int));
+    if (archive->segment_fds == NULL) return kMallocFailureError;
+    for (int32_t i = 0; i < archive->num_segments; ++i) {
+        archive->segment_fds[i] = -1;
+    }
+
+    return kNoError;
+}
+
+static void ArchiveDestroy(DbArchive *archive) {
+    if (archive->write_fd >= 0) {
+        if (fsync(archive->write_fd) != 0) perror("fsync");
+        GuardedClose(archive->write_fd);
+    }
+    if (archive->index_fd >= 0) {
+        if (fsync(archive->index_fd) != 0) perror("fsync");
+        GuardedClose(archive->index_fd);
+    }
+    for (int32_t i = 0; archive->segment_fds && i < archive->num_segments;
+         ++i) {
+        if (archive->segment_fds[i] >= 0) GuardedClose(archive->segment_fds[i]);
+    }
+    free(archive->segment_fds);
+    free(archive->entries);
+    TierHashMapDestroy(&archive->map);
+    free(archive->path);
+    memset(archive, 0, sizeof(*archive));
+}
+
+// Returns the latest entry of TIER in ARCHIVE, or NULL if TIER is not
+// archived. Must be called inside the db_archive critical section.
+static const DbArchiveEntry *ArchiveFind(DbArchive *archive, Tier tier) {
+    TierHashMapIterator it = TierHashMapGet(&archive->map, tier);
+    if (!TierHashMapIteratorIsValid(&it)) return NULL;
+    const DbArchiveEntry *entry =
+        &archive->entries[TierHashMapIteratorValue(&it)];
+
+    return entry->size < 0 ? NULL : entry;
+}
+
+// Returns the read-only descriptor of SEGMENT, opening it if necessary. Must
+// be called inside the db_archive critical section.
+static int ArchiveGetSegmentFd(DbArchive *archive, int32_t segment) {
+    if (archive->segment_fds[segment] >= 0) {
+        return archive->segment_fds[segment];
+    }
+    char *path = GetSegmentPath(archive, segment);
+    if (path == NULL) return -1;
+    archive->segment_fds[segment] = GuardedOpen(path, O_RDONLY);
+    free(path);
+
+    return archive->segment_fds[segment];
+}
+
+static int ArchiveOpenSegmentForAppend(DbArchive *archive, int32_t segment) {
+    if (segment >= archive->num_segments) {
+        int *new_fds =
+            (int *)realloc(archive->segment_fds, (segment + 1) * sizeof(int));
+        if (new_fds == NULL) return kMallocFailureError;
+        archive->segment_fds = new_fds;
+        for (int32_t i = archive->num_segments; i <= segment; ++i) {
+            new_fds[i] = -1;
+        }
+        archive->num_segments = segment + 1;
+    }
+
+    char *path = GetSegmentPath(archive, segment);
+    if (path == NULL) return kMallocFailureError;
+    int fd = open(path, O_WRONLY | O_CREAT, 0644);
+    free(path);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror("ArchiveOpenSegmentForAppend");
+        if (fd >= 0) GuardedClose(fd);
+        return kFileSystemError;
+    }
+    if (archive->write_fd >= 0) GuardedClose(archive->write_fd);
+    archive->write_fd = fd;
+
+    // Bytes left behind by an interrupted append are simply skipped.
+    archive->write_offset = (int64_t)st.st_size;
+
+    return kNoError;
+}
+
+// Opens the index of ARCHIVE for appends, creating it if necessary and
+// discarding any torn entry at its end.
+static int ArchiveOpenIndexForAppend(DbArchive *archive) {
+    if (archive->index_fd >= 0) return kNoError;
+    if (MkdirRecursive(archive->path) != 0) return kFileSystemError;
+    char *path = GetFilePath(archive, kIndexFileName);
+    if (path == NULL) return kMallocFailureError;
+    int fd = open(path, O_WRONLY | O_CREAT, 0644);
+    free(path);
+    if (fd < 0) {
+        perror("ArchiveOpenIndexForAppend");
+        return kFileSystemError;
+    }
+
+    if (archive->index_size < kIndexHeaderSize) {
+        archive->index_size = kIndexHeaderSize;
+        if (!PwriteFull(fd, &kIndexMagic, sizeof(kIndexMagic), 0)) {
+            GuardedClose(fd);
+            return kFileSystemError;
+        }
+    }
+    if (ftruncate(fd, (off_t)archive->index_size) != 0) {
+        perror("ftruncate");
+        GuardedClose(fd);
+        return kFileSystemError;
+    }
+    archive->index_fd = fd;
+
+    return kNoError;
+}
+
+static int ArchiveAppendEntry(DbArchive *archive, const DbArchiveEntry *entry) {
+    int error = ArchiveOpenIndexForAppend(archive);
+    if (error != kNoError) return error;
+    if (!PwriteFull(archive->index_fd, entry, sizeof(*entry),
+                    archive->index_size)) {
+        perror("ArchiveAppendEntry");
+        return kFileSystemError;
+    }
+    archive->index_size += sizeof(*entry);
+
+    return ApplyEntry(archive, entry);
+}
+
+// Appends DATA to the last segment of ARCHIVE, starting a new segment if the
+// last one is full, flushes the segment to disk, and then appends its index
+// entry. Must be called inside the db_archive critical section.
+static int ArchiveAppend(DbArchive *archive, Tier tier, int32_t format,
+                         const void *data, int64_t size) {
+    int error = ArchiveOpenIndexForAppend(archive);
+    if (error != kNoError) return error;
+
+    int32_t segment = archive->num_segments - 1;
+    if (archive->write_fd < 0) {
+        if (segment < 0) segment = 0;
+        error = ArchiveOpenSegmentForAppend(archive, segment);
+        if (error != kNoError) return error;
+    }
+    if (archive->write_offset > 0 &&
+        archive->write_offset + size > kDbArchiveSegmentSizeMax) {
+        error = ArchiveOpenSegmentForAppend(archive, ++segment);
+        if (error != kNoError) return error;
+    }
+
+    if (!PwriteFull(archive->write_fd, data, size, archive->write_offset)) {
+        perror("ArchiveAppend");
+        return kFileSystemError;
+    }
+
+    // The data must reach the disk before the index entry that points to it,
+    // otherwise a crash could leave a complete entry pointing to garbage.
+    if (fsync(archive->write_fd) != 0) {
+        perror("fsync");
+        return kFileSystemError;
+    }
+    DbArchiveEntry entry = {
+        .tier = tier,
+        .offset = archive->write_offset,
+        .size = size,
+        .segment = segment,
+        .format = format,
+    };
+    archive->write_offset += size;
+
+    return ArchiveAppendEntry(archive, &entry);
+}
+
+// -----------------------------------------------------------------------------
+
+int DbArchiveSetInit(DbArchiveSet *set, const DbShardMap *shards) {
+    set->archives = (DbArchive *)calloc(shards->num_shards, sizeof(DbArchive));
+    set->num_archives = 0;
+    if (set->archives == NULL) return kMallocFailureError;
+
+    for (int i = 0; i < shards->num_shards; ++i) {
+        int error = ArchiveInit(&set->archives[i], shards->paths[i]);
+        ++set->num_archives;
+        if (error != kNoError) {
+            DbArchiveSetDestroy(set);
+            return error;
+        }
+    }
+
+    return kNoError;
+}
+
+void DbArchiveSetDestroy(DbArchiveSet *set) {
+    for (int i = 0; i < set->num_archives; ++i) {
+        ArchiveDestroy(&set->archives[i]);
+    }
+    free(set->archives);
+    set->archives = NULL;
+    set->num_archives = 0;
+}
+
+int64_t DbArchiveSetGetNumTiers(DbArchiveSet *set) {
+    int64_t ret = 0;
+    PRAGMA_OMP_CRITICAL(db_archive) {
+        for (int i = 0; i < set->num_archives; ++i) {
+            const DbArchive *archive = &set->archives[i];
+            for (int64_t j = 0; j < archive->num_entries; ++j) {
+                ret += (archive->entries[j].size >= 0);
+            }
+        }
+    }
+
+    return ret;
+}
+
+bool DbArchiveSetLocate(DbArchiveSet *set, const DbShardMap *shards,
+                        Tier tier, DbArchiveLocation *location) {
+    if (set->num_archives == 0) return false;
+    int first = DbShardMapGetIndex(shards, tier);
+    bool found = false;
+    PRAGMA_OMP_CRITICAL(db_archive) {
+        for (int i = 0; i < set->num_archives && !found; ++i) {
+            DbArchive *archive =
+                &set->archives[(first + i) % set->num_archives];
+            const DbArchiveEntry *entry = ArchiveFind(archive, tier);
+            if (entry == NULL) continue;
+            found = true;
+            if (location == NULL) break;
+            location->fd = ArchiveGetSegmentFd(archive, entry->segment);
+            location->offset = entry->offset;
+            location->size = entry->size;
+            location->format = entry->format;
+            found = (location->fd >= 0);
+        }
+    }
+
+    return found;
+}
+
+int DbArchiveSetAppend(DbArchiveSet *set, const DbShardMap *shards, Tier tier,
+                       int32_t format, const void *data, int64_t size) {
+    DbArchive *archive = &set->archives[DbShardMapGetIndex(shards, tier)];
+    int error;
+    PRAGMA_OMP_CRITICAL(db_archive) {
+        error = ArchiveAppend(archive, tier, format, data, size);
+    }
+    if (error != kNoError) return error;
+
+    // Remove stale copies left in other shards by a rebalance.
+    for (int i = 0; i < set->num_archives; ++i) {
+        if (&set->archives[i] == archive) continue;
+        PRAGMA_OMP_CRITICAL(db_archive) {
+            if (ArchiveFind(&set->archives[i], tier) != NULL) {
+                DbArchiveEntry entry = {.tier = tier, .size = -1};
+                error = ArchiveAppendEntry(&set->archives[i], &entry);
+            }
+        }
+        if (error != kNoError) return error;
+    }
+
+    return kNoError;
+}
+
+int DbArchiveSetRemove(DbArchiveSet *set, Tier tier) {
+    int error = kNoError;
+    for (int i = 0; i < set->num_archives; ++i) {
+        PRAGMA_OMP_CRITICAL(db_archive) {
+            if (ArchiveFind(&set->archives[i], tier) != NULL) {
+                DbArchiveEntry entry = {.tier = tier, .size = -1};
+                error = ArchiveAppendEntry(&set->archives[i], &entry);
+            }
+        }
+        if (error != kNoError) return error;
+    }
+
+    return kNoError;
+}
@@ -0,0 +1,155 @@
+/**
+ * @file db_archive.h
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Packed archive of solved tier files.
+ * @details Stores many small tier files in a few large segment files so that
+ * solving games with millions of tiers does not create millions of files. Each
+ * archive lives in a single shard directory and consists of an append-only
+ * index file "archive.idx" and segment files "archive.<k>.seg". Each index
+ * entry maps a tier to a byte range of a segment. A later entry of the same
+ * tier supersedes earlier ones, and a removal entry marks a tier as no longer
+ * archived, e.g., after it was rewritten as a loose file. Data is always
+ * written to the segment and flushed to disk with fsync before its index entry
+ * is written, so a crash during an append leaves at most a torn entry at the
+ * end of the index, which is ignored on load.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAMESMANONE_CORE_DB_DB_ARCHIVE_H_
+#define GAMESMANONE_CORE_DB_DB_ARCHIVE_H_
+
+#include <stdbool.h>  // bool
+#include <stdint.h>   // int32_t, int64_t
+
+#include "core/db/db_shard.h"
+#include "core/types/gamesman_types.h"
+
+enum {
+    /** Maximum size of a segment file in bytes. A tier whose data does not
+     * fit in the current segment starts a new one. */
+    kDbArchiveSegmentSizeMax = 1 << 30,
+};
+
+/** @brief Index entry of an archived tier, stored as is in the index file. */
+typedef struct DbArchiveEntry {
+    int64_t tier;    /**< Archived tier. */
+    int64_t offset;  /**< Offset of the data into the segment in bytes. */
+    int64_t size;    /**< Size of the data in bytes, or -1 if removed. */
+    int32_t segment; /**< Segment containing the data. */
+    int32_t format;  /**< Database-defined format tag of the data. */
+} DbArchiveEntry;
+
+/** @brief Location of the data of an archived tier. */
+typedef struct DbArchiveLocation {
+    int fd;         /**< Read-only descriptor of the segment, owned by the
+                     * archive. Must be read using pread. */
+    int64_t offset; /**< Offset of the data into the segment in bytes. */
+    int64_t size;   /**< Size of the data in bytes. */
+    int32_t format; /**< Database-defined format tag of the data. */
+} DbArchiveLocation;
+
+/** @brief Archive in a single shard directory. */
+typedef struct DbArchive {
+    char *path;       /**< Path to the directory containing the archive. */
+    TierHashMap map;  /**< Tier -> index into the entries array. */
+
+    DbArchiveEntry *entries; /**< Latest entry of each tier. */
+    int64_t num_entries; /**< Number of entries in use. */
+    int64_t capacity;    /**< Number of entries allocated. */
+
+    int *segment_fds;     /**< Read-only descriptors, -1 if not open. */
+    int32_t num_segments; /**< Number of segment files. */
+    int write_fd;         /**< Last segment opened for appends, or -1. */
+    int64_t write_offset; /**< Size of the last segment in bytes. */
+    int index_fd;         /**< Index opened for appends, or -1. */
+    int64_t index_size;   /**< Size of the valid part of the index. */
+} DbArchive;
+
+/** @brief Archives of all shards of a DbShardMap. */
+typedef struct DbArchiveSet {
+    int num_archives;    /**< Same as the number of shards. */
+    DbArchive *archives; /**< One archive per shard. */
+} DbArchiveSet;
+
+/**
+ * @brief Initializes SET with one archive per shard of SHARDS and loads the
+ * index of each archive that exists on disk. No file is created until the
+ * first append.
+ *
+ * @param set Archive set to initialize.
+ * @param shards Shard map of the database.
+ * @return kNoError on success,
+ * @return kFileSystemError if an existing index is corrupted or cannot be
+ * read, or
+ * @return kMallocFailureError on malloc failure.
+ */
+int DbArchiveSetInit(DbArchiveSet *set, const DbShardMap *shards);
+
+/**
+ * @brief Flushes and closes all files of SET and deallocates SET.
+ */
+void DbArchiveSetDestroy(DbArchiveSet *set);
+
+/**
+ * @brief Returns the total number of tiers archived in SET.
+ */
+int64_t DbArchiveSetGetNumTiers(DbArchiveSet *set);
+
+/**
+ * @brief Looks up TIER in the archives of SET, starting from the archive in
+ * the shard of TIER so that tiers moved by a rebalance are still found.
+ * Thread-safe.
+ *
+ * @param set Archive set.
+ * @param shards Shard map used to initialize SET.
+ * @param tier Tier to look up.
+ * @param location Set to the location of the data of TIER if found. May be
+ * NULL, in which case no segment file is opened.
+ * @return true if TIER is archived and its segment can be opened, or
+ * @return false otherwise.
+ */
+bool DbArchiveSetLocate(DbArchiveSet *set, const DbShardMap *shards,
+                        Tier tier, DbArchiveLocation *location);
+
+/**
+ * @brief Appends SIZE bytes of DATA as the data of TIER with the given FORMAT
+ * to the archive in the shard of TIER, superseding any data of TIER already
+ * archived. Thread-safe.
+ *
+ * @return kNoError on success,
+ * @return kFileSystemError on file system failure, or
+ * @return kMallocFailureError on malloc failure.
+ */
+int DbArchiveSetAppend(DbArchiveSet *set, const DbShardMap *shards, Tier tier,
+                       int32_t format, const void *data, int64_t size);
+
+/**
+ * @brief Removes TIER from all archives of SET. Used when TIER is rewritten
+ * outside of the archive. The space used by the old data is not reclaimed.
+ * Thread-safe.
+ *
+ * @return kNoError on success, or
+ * @return kFileSystemError on file system failure.
+ */
+int DbArchiveSetRemove(DbArchiveSet *set, Tier tier);
+
+#endif  // GAMESMANONE_CORE_DB_DB_ARCHIVE_H_
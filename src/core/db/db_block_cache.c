@@ -0,0 +1,395 @@
+/**
+ * @file db_block_cache.c
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Implementation of the process-wide cache of decompressed database
+ * blocks.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/db/db_block_cache.h"
+
+#include <stdbool.h>  // bool, true, false
+#include <stddef.h>   // NULL
+#include <stdint.h>   // int64_t, uint64_t
+#include <stdlib.h>   // calloc, free
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // _OPENMP
+
+#include "core/concurrency.h"
+#include "core/types/gamesman_types.h"
+
+// Each shard has its own lock, hash table, and LRU list so that threads
+// probing different blocks rarely contend.
+enum { kNumShards = 8, kNumBucketsPerShard = 256 };
+
+const int64_t kDbBlockCacheDefaultCapacity = 64LL << 20;  // 64 MiB.
+
+typedef struct Entry {
+    DbCachedBlock block;  // Must be the first member.
+    DbBlockCacheKey key;
+    int shard;
+
+    int64_t ref_count;  // Number of outstanding acquisitions.
+    bool ready;         // Load finished, possibly unsuccessfully.
+    bool failed;        // Load finished unsuccessfully.
+    bool detached;      // Removed from the cache, freed on the last release.
+
+#ifdef _OPENMP
+    // Held by the loading thread until the load finishes, so that other
+    // threads acquiring the same block can wait on it.
+    omp_lock_t load_lock;
+#endif  // _OPENMP
+
+    struct Entry *hash_next;  // Next entry in the same hash bucket.
+    struct Entry *lru_prev;   // Neighbor closer to the most recently used end.
+    struct Entry *lru_next;   // Neighbor closer to the least recently used end.
+} Entry;
+
+typedef struct Shard {
+#ifdef _OPENMP
+    omp_lock_t lock;
+#endif  // _OPENMP
+    Entry *buckets[kNumBucketsPerShard];
+    Entry *lru_head;  // Most recently used entry.
+    Entry *lru_tail;  // Least recently used entry.
+    int64_t bytes;
+    DbBlockCacheStats stats;
+} Shard;
+
+static Shard *shards;
+static int64_t cache_capacity;
+static int64_t shard_capacity;
+static int64_t next_source;
+
+// Bytes of all blocks in memory, including blocks that were removed from the
+// cache but are still acquired. Guarded by db_block_cache_budget.
+static int64_t total_bytes;
+
+// Bytes of all blocks that are currently acquired, which cannot be evicted.
+// Guarded by db_block_cache_budget.
+static int64_t acquired_bytes;
+
+// -----------------------------------------------------------------------------
+
+static void ShardLock(Shard *shard) {
+#ifdef _OPENMP
+    omp_set_lock(&shard->lock);
+#else   // _OPENMP not defined
+    (void)shard;
+#endif  // _OPENMP
+}
+
+static void ShardUnlock(Shard *shard) {
+#ifdef _OPENMP
+    omp_unset_lock(&shard->lock);
+#else   // _OPENMP not defined
+    (void)shard;
+#endif  // _OPENMP
+}
+
+static void BudgetAdd(int64_t *counter, int64_t delta) {
+    PRAGMA_OMP_CRITICAL(db_block_cache_budget) { *counter += delta; }
+}
+
+static int64_t BudgetLoad(const int64_t *counter) {
+    int64_t ret;
+    PRAGMA_OMP_CRITICAL(db_block_cache_budget) { ret = *counter; }
+
+    return ret;
+}
+
+static uint64_t HashKey(const DbBlockCacheKey *key) {
+    uint64_t h = (uint64_t)key->source * 0x9E3779B97F4A7C15ULL;
+    h ^= (uint64_t)key->tier + 0x632BE59BD9B4E019ULL + (h << 6) + (h >> 2);
+    h ^= (uint64_t)key->block + 0x8CB92BA72F3D8DD7ULL + (h << 6) + (h >> 2);
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+
+    return h;
+}
+
+static int GetShardIndex(uint64_t hash) { return (int)(hash % kNumShards); }
+
+static int GetBucketIndex(uint64_t hash) {
+    return (int)((hash / kNumShards) % kNumBucketsPerShard);
+}
+
+static bool KeyEqual(const DbBlockCacheKey *a, const DbBlockCacheKey *b) {
+    return a->source == b->source && a->tier == b->tier && a->block == b->block;
+}
+
+static void EntryFree(Entry *entry) {
+    BudgetAdd(&total_bytes, -entry->block.size);
+    free((void *)entry->block.data);
+#ifdef _OPENMP
+    omp_destroy_lock(&entry->load_lock);
+#endif  // _OPENMP
+    free(entry);
+}
+
+static void LruUnlink(Shard *shard, Entry *entry) {
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        shard->lru_head = entry->lru_next;
+    }
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        shard->lru_tail = entry->lru_prev;
+    }
+    entry->lru_prev = entry->lru_next = NULL;
+}
+
+static void LruPushFront(Shard *shard, Entry *entry) {
+    entry->lru_prev = NULL;
+    entry->lru_next = shard->lru_head;
+    if (shard->lru_head) shard->lru_head->lru_prev = entry;
+    shard->lru_head = entry;
+    if (shard->lru_tail == NULL) shard->lru_tail = entry;
+}
+
+// Removes ENTRY from the hash table and the LRU list of SHARD. The entry is
+// freed immediately if it is not acquired, or on its last release otherwise.
+// Assumes the lock of SHARD is held.
+static void ShardDetach(Shard *shard, Entry *entry) {
+    Entry **walker = &shard->buckets[GetBucketIndex(HashKey(&entry->key))];
+    while (*walker != entry) walker = &(*walker)->hash_next;
+    *walker = entry->hash_next;
+    LruUnlink(shard, entry);
+    shard->bytes -= entry->block.size;
+    entry->detached = true;
+    if (entry->ref_count == 0) EntryFree(entry);
+}
+
+// Evicts least recently used entries that are neither acquired nor loading
+// until both SHARD and the whole cache are within their budgets. Acquired
+// blocks are charged against the budget of the whole cache, so that blocks
+// kept by probes leave less room for the other blocks. Assumes the lock of
+// SHARD is held.
+static void ShardEvict(Shard *shard) {
+    Entry *walker = shard->lru_tail;
+    while ((shard->bytes > shard_capacity ||
+            BudgetLoad(&total_bytes) > cache_capacity) &&
+           walker != NULL) {
+        Entry *prev = walker->lru_prev;
+        if (walker->ref_count == 0 && walker->ready) {
+            ShardDetach(shard, walker);
+            ++shard->stats.evictions;
+        }
+        walker = prev;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+int DbBlockCacheInit(int64_t capacity) {
+    DbBlockCacheFinalize();
+    shards = (Shard *)calloc(kNumShards, sizeof(Shard));
+    if (shards == NULL) return kMallocFailureError;
+
+    for (int i = 0; i < kNumShards; ++i) {
+#ifdef _OPENMP
+        omp_init_lock(&shards[i].lock);
+#endif  // _OPENMP
+    }
+    cache_capacity = capacity;
+    shard_capacity = capacity / kNumShards;
+
+    return kNoError;
+}
+
+bool DbBlockCacheIsInitialized(void) { return shards != NULL; }
+
+void DbBlockCacheFinalize(void) {
+    if (shards == NULL) return;
+
+    for (int i = 0; i < kNumShards; ++i) {
+        Entry *walker = shards[i].lru_head;
+        while (walker != NULL) {
+            Entry *next = walker->lru_next;
+            EntryFree(walker);
+            walker = next;
+        }
+#ifdef _OPENMP
+        omp_destroy_lock(&shards[i].lock);
+#endif  // _OPENMP
+    }
+    free(shards);
+    shards = NULL;
+    cache_capacity = 0;
+    shard_capacity = 0;
+    total_bytes = 0;
+    acquired_bytes = 0;
+}
+
+int64_t DbBlockCacheNewSource(void) {
+    int64_t ret;
+    PRAGMA_OMP_CRITICAL(db_block_cache_new_source) { ret = next_source++; }
+
+    return ret;
+}
+
+const DbCachedBlock *DbBlockCacheAcquire(const DbBlockCacheKey *key,
+                                         DbBlockCacheLoader Load, void *aux) {
+    uint64_t hash = HashKey(key);
+    int shard_index = GetShardIndex(hash);
+    Shard *shard = &shards[shard_index];
+    int bucket = GetBucketIndex(hash);
+
+    ShardLock(shard);
+    Entry *entry = shard->buckets[bucket];
+    while (entry != NULL && !KeyEqual(&entry->key, key)) {
+        entry = entry->hash_next;
+    }
+
+    if (entry != NULL) {  // Hit, possibly on a block being loaded.
+        // Blocks being loaded are charged when the load finishes.
+        if (entry->ref_count++ == 0) {
+            BudgetAdd(&acquired_bytes, entry->block.size);
+        }
+        ++shard->stats.hits;
+        LruUnlink(shard, entry);
+        LruPushFront(shard, entry);
+        ShardUnlock(shard);
+#ifdef _OPENMP
+        // Wait for the loading thread to finish.
+        omp_set_lock(&entry->load_lock);
+        omp_unset_lock(&entry->load_lock);
+#endif  // _OPENMP
+        if (entry->failed) {
+            DbBlockCacheRelease(&entry->block);
+            return NULL;
+        }
+
+        return &entry->block;
+    }
+
+    // Miss. Insert a placeholder entry so that concurrent acquisitions of the
+    // same block wait for this thread instead of loading it again.
+    entry = (Entry *)calloc(1, sizeof(Entry));
+    if (entry == NULL) {
+        ShardUnlock(shard);
+        return NULL;
+    }
+    entry->key = *key;
+    entry->shard = shard_index;
+    entry->ref_count = 1;
+#ifdef _OPENMP
+    omp_init_lock(&entry->load_lock);
+    omp_set_lock(&entry->load_lock);
+#endif  // _OPENMP
+    entry->hash_next = shard->buckets[bucket];
+    shard->buckets[bucket] = entry;
+    LruPushFront(shard, entry);
+    ++shard->stats.misses;
+    ShardUnlock(shard);
+
+    int64_t size = 0;
+    void *data = Load(aux, &size);
+
+    ShardLock(shard);
+    entry->block.data = data;
+    entry->block.size = data ? size : 0;
+    entry->failed = (data == NULL);
+    entry->ready = true;
+    BudgetAdd(&total_bytes, entry->block.size);
+    BudgetAdd(&acquired_bytes, entry->block.size);
+    if (!entry->detached) {  // Not invalidated during the load.
+        if (entry->failed) {
+            ShardDetach(shard, entry);  // Allow future acquisitions to retry.
+        } else {
+            shard->bytes += size;
+            ShardEvict(shard);
+        }
+    }
+    ShardUnlock(shard);
+#ifdef _OPENMP
+    omp_unset_lock(&entry->load_lock);
+#endif  // _OPENMP
+
+    if (entry->failed) {
+        DbBlockCacheRelease(&entry->block);
+        return NULL;
+    }
+
+    return &entry->block;
+}
+
+void DbBlockCacheRelease(const DbCachedBlock *block) {
+    if (block == NULL) return;
+
+    Entry *entry = (Entry *)block;
+    Shard *shard = &shards[entry->shard];
+    ShardLock(shard);
+    if (--entry->ref_count == 0) {
+        BudgetAdd(&acquired_bytes, -entry->block.size);
+        if (entry->detached) {
+            EntryFree(entry);
+        } else {
+            ShardEvict(shard);
+        }
+    }
+    ShardUnlock(shard);
+}
+
+void DbBlockCacheInvalidate(int64_t source, Tier tier) {
+    if (shards == NULL) return;
+
+    for (int i = 0; i < kNumShards; ++i) {
+        Shard *shard = &shards[i];
+        ShardLock(shard);
+        Entry *walker = shard->lru_head;
+        while (walker != NULL) {
+            Entry *next = walker->lru_next;
+            if (walker->key.source == source && walker->key.tier == tier) {
+                ShardDetach(shard, walker);
+            }
+            walker = next;
+        }
+        ShardUnlock(shard);
+    }
+}
+
+bool DbBlockCacheOverBudget(int64_t size) {
+    return BudgetLoad(&acquired_bytes) + size > cache_capacity;
+}
+
+DbBlockCacheStats DbBlockCacheGetStats(void) {
+    DbBlockCacheStats ret = {0};
+    if (shards == NULL) return ret;
+
+    for (int i = 0; i < kNumShards; ++i) {
+        ShardLock(&shards[i]);
+        ret.hits += shards[i].stats.hits;
+        ret.misses += shards[i].stats.misses;
+        ret.evictions += shards[i].stats.evictions;
+        ret.bytes += shards[i].bytes;
+        ShardUnlock(&shards[i]);
+    }
+    ret.acquired = BudgetLoad(&acquired_bytes);
+
+    return ret;
+}
@@ -0,0 +1,160 @@
+/**
+ * @file db_block_cache.h
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Process-wide cache of decompressed database blocks shared by all
+ * probes and threads.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAMESMANONE_CORE_DB_DB_BLOCK_CACHE_H_
+#define GAMESMANONE_CORE_DB_DB_BLOCK_CACHE_H_
+
+#include <stdbool.h>  // bool
+#include <stdint.h>   // int64_t
+
+#include "core/types/gamesman_types.h"
+
+/**
+ * @brief Key to a block in the block cache.
+ *
+ * @details The meaning of the block index is defined by the database that
+ * owns the source. For example, arraydb uses the index of the XZ block in the
+ * tier file, whereas bpdb uses the index of the mgz block in the compressed
+ * bit stream.
+ */
+typedef struct DbBlockCacheKey {
+    /** ID of the database instance that owns the block. See
+     * DbBlockCacheNewSource. */
+    int64_t source;
+
+    /** Tier to which the block belongs. */
+    Tier tier;
+
+    /** Index of the block within the tier. */
+    int64_t block;
+} DbBlockCacheKey;
+
+/**
+ * @brief Decompressed block held in the block cache. All fields are read-only.
+ * A block stays valid until it is released with DbBlockCacheRelease.
+ */
+typedef struct DbCachedBlock {
+    const void *data; /**< Decompressed content of the block. */
+    int64_t size;     /**< Size of data in bytes. */
+} DbCachedBlock;
+
+/**
+ * @brief Loads a block on a cache miss.
+ *
+ * @param aux Auxiliary parameter passed to DbBlockCacheAcquire.
+ * @param size Output parameter for the size of the block in bytes.
+ * @return Block content allocated with malloc, which is then owned by the
+ * cache, or NULL on failure.
+ */
+typedef void *(*DbBlockCacheLoader)(void *aux, int64_t *size);
+
+/** @brief Block cache counters. */
+typedef struct DbBlockCacheStats {
+    int64_t hits;      /**< Number of acquisitions of cached blocks. */
+    int64_t misses;    /**< Number of blocks loaded. */
+    int64_t evictions; /**< Number of blocks evicted to stay within budget. */
+    int64_t bytes;     /**< Number of bytes currently cached. */
+    int64_t acquired;  /**< Number of bytes in blocks currently acquired. */
+} DbBlockCacheStats;
+
+/** @brief Default capacity of the block cache in bytes. */
+extern const int64_t kDbBlockCacheDefaultCapacity;
+
+/**
+ * @brief Initializes the block cache with a global budget of CAPACITY bytes,
+ * discarding all cached blocks if it was already initialized. The budget is
+ * split evenly among the shards of the cache. Blocks that are currently
+ * acquired are never evicted, but they are charged against the budget, so that
+ * other blocks are evicted to make room for them. Callers that keep several
+ * blocks acquired should check DbBlockCacheOverBudget before acquiring more.
+ *
+ * @note Must not be called while any block is acquired.
+ *
+ * @param capacity Budget of the cache in bytes.
+ * @return kNoError on success, or
+ * @return kMallocFailureError on malloc failure.
+ */
+int DbBlockCacheInit(int64_t capacity);
+
+/** @brief Returns true if the block cache has been initialized. */
+bool DbBlockCacheIsInitialized(void);
+
+/**
+ * @brief Frees all cached blocks and deinitializes the block cache.
+ *
+ * @note Must not be called while any block is acquired.
+ */
+void DbBlockCacheFinalize(void);
+
+/**
+ * @brief Returns a new source ID that is distinct from all previously returned
+ * IDs. A database should obtain a new source ID each time it is initialized so
+ * that blocks of different data paths never collide.
+ */
+int64_t DbBlockCacheNewSource(void);
+
+/**
+ * @brief Returns the block of KEY from the cache, calling LOAD with AUX to
+ * load it on a miss. This function is thread-safe. Concurrent misses on the
+ * same block load the block only once; the other threads wait for the load to
+ * finish and share its result.
+ *
+ * @param key Key to the block.
+ * @param Load Function that loads the block on a miss.
+ * @param aux Auxiliary parameter passed to LOAD.
+ * @return The cached block, which must be released with DbBlockCacheRelease;
+ * @return NULL if the block failed to load.
+ */
+const DbCachedBlock *DbBlockCacheAcquire(const DbBlockCacheKey *key,
+                                         DbBlockCacheLoader Load, void *aux);
+
+/**
+ * @brief Releases BLOCK previously returned by DbBlockCacheAcquire. Does
+ * nothing if BLOCK is NULL. This function is thread-safe.
+ */
+void DbBlockCacheRelease(const DbCachedBlock *block);
+
+/**
+ * @brief Removes all cached blocks of TIER in SOURCE. Must be called whenever
+ * a tier file is rewritten. Blocks that are currently acquired remain valid
+ * until released. This function is thread-safe.
+ */
+void DbBlockCacheInvalidate(int64_t source, Tier tier);
+
+/**
+ * @brief Returns true if acquiring another block of SIZE bytes would make the
+ * blocks that are currently acquired exceed the budget of the cache. Callers
+ * that keep several blocks acquired, such as probes, should then release all
+ * blocks that they do not need before acquiring the new one. This function is
+ * thread-safe.
+ */
+bool DbBlockCacheOverBudget(int64_t size);
+
+/** @brief Returns the counters of the block cache. */
+DbBlockCacheStats DbBlockCacheGetStats(void);
+
+#endif  // GAMESMANONE_CORE_DB_DB_BLOCK_CACHE_H_
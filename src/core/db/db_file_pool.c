@@ -0,0 +1,223 @@
+/**
+ * @file db_file_pool.c
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Implementation of the process-wide pool of open tier files.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/db/db_file_pool.h"
+
+#include <stdbool.h>  // bool, true, false
+#include <stddef.h>   // NULL
+#include <stdint.h>   // int64_t
+#include <stdlib.h>   // calloc, realloc, free
+
+#include "core/concurrency.h"
+#include "core/types/gamesman_types.h"
+
+const int kDbFilePoolDefaultCapacity = 64;
+
+typedef struct Entry {
+    DbPooledFile file;  // Must be the first member.
+    int64_t source;
+    Tier tier;
+    DbFilePoolCloser Close;
+    int64_t ref_count;  // Number of outstanding acquisitions.
+    int64_t last_used;  // Value of the pool clock at the most recent access.
+    bool detached;      // Removed from the pool, closed on the last release.
+} Entry;
+
+// The pool holds few files and files are opened rarely compared to blocks
+// being read from them, so a single lock and linear scans suffice.
+static Entry **entries;
+static int num_entries;
+static int entries_capacity;
+static int pool_capacity;
+static int64_t pool_clock;
+// Incremented on every invalidation so that files opened outside the lock are
+// not pooled if they may be stale.
+static int64_t pool_epoch;
+
+// -----------------------------------------------------------------------------
+
+static void EntryClose(Entry *entry) {
+    entry->Close(entry->file.handle);
+    free(entry);
+}
+
+static int FindEntry(int64_t source, Tier tier) {
+    for (int i = 0; i < num_entries; ++i) {
+        if (entries[i]->source == source && entries[i]->tier == tier) return i;
+    }
+
+    return -1;
+}
+
+// Removes the I-th entry from the pool, closing it immediately if it is not
+// acquired. Assumes the pool lock is held.
+static void DetachEntry(int i) {
+    Entry *entry = entries[i];
+    entries[i] = entries[--num_entries];
+    entry->detached = true;
+    if (entry->ref_count == 0) EntryClose(entry);
+}
+
+// Closes least recently used idle files until at most pool_capacity idle files
+// remain open. Assumes the pool lock is held.
+static void EvictIdle(void) {
+    int num_idle = 0;
+    for (int i = 0; i < num_entries; ++i) {
+        if (entries[i]->ref_count == 0) ++num_idle;
+    }
+    while (num_idle > pool_capacity) {
+        int victim = -1;
+        for (int i = 0; i < num_entries; ++i) {
+            if (entries[i]->ref_count > 0) continue;
+            if (victim < 0 ||
+                entries[i]->last_used < entries[victim]->last_used) {
+                victim = i;
+            }
+        }
+        DetachEntry(victim);
+        --num_idle;
+    }
+}
+
+static bool ExpandEntries(void) {
+    if (num_entries < entries_capacity) return true;
+
+    int new_capacity = entries_capacity * 2 + 1;
+    Entry **new_entries =
+        (Entry **)realloc(entries, new_capacity * sizeof(Entry *));
+    if (new_entries == NULL) return false;
+    entries = new_entries;
+    entries_capacity = new_capacity;
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+int DbFilePoolInit(int capacity) {
+    DbFilePoolFinalize();
+    entries_capacity = capacity > 0 ? capacity : 1;
+    entries = (Entry **)calloc(entries_capacity, sizeof(Entry *));
+    if (entries == NULL) {
+        entries_capacity = 0;
+        return kMallocFailureError;
+    }
+    pool_capacity = capacity;
+
+    return kNoError;
+}
+
+bool DbFilePoolIsInitialized(void) { return entries != NULL; }
+
+void DbFilePoolFinalize(void) {
+    for (int i = 0; i < num_entries; ++i) {
+        EntryClose(entries[i]);
+    }
+    free(entries);
+    entries = NULL;
+    num_entries = entries_capacity = pool_capacity = 0;
+}
+
+// Takes a reference to ENTRY. Assumes the pool lock is held.
+static void EntryAcquire(Entry *entry) {
+    ++entry->ref_count;
+    entry->last_used = ++pool_clock;
+    EvictIdle();
+}
+
+const DbPooledFile *DbFilePoolAcquire(int64_t source, Tier tier,
+                                      DbFilePoolOpener Open,
+                                      DbFilePoolCloser Close, void *aux) {
+    Entry *ret = NULL;
+    int64_t epoch;
+    PRAGMA_OMP_CRITICAL(db_file_pool) {
+        int i = FindEntry(source, tier);
+        if (i >= 0) EntryAcquire(ret = entries[i]);
+        epoch = pool_epoch;
+    }
+    if (ret != NULL) return (const DbPooledFile *)ret;
+
+    // Open the file outside the lock so that threads opening different files
+    // do not wait for each other. Concurrent misses on the same file may open
+    // it more than once, in which case all but the first handle are discarded.
+    void *handle = Open(aux);
+    if (handle == NULL) return NULL;
+
+    Entry *entry = (Entry *)calloc(1, sizeof(Entry));
+    if (entry == NULL) {
+        Close(handle);
+        return NULL;
+    }
+    entry->file.handle = handle;
+    entry->source = source;
+    entry->tier = tier;
+    entry->Close = Close;
+
+    bool duplicate = false;
+    PRAGMA_OMP_CRITICAL(db_file_pool) {
+        int i = FindEntry(source, tier);
+        if (i >= 0) {
+            EntryAcquire(ret = entries[i]);
+            duplicate = true;
+        } else if (epoch != pool_epoch || !ExpandEntries()) {
+            // The file may have been rewritten since it was opened, or there
+            // is no room in the pool. Hand out a private entry that is closed
+            // on its release.
+            entry->detached = true;
+            entry->ref_count = 1;
+            ret = entry;
+        } else {
+            entries[num_entries++] = entry;
+            EntryAcquire(ret = entry);
+        }
+    }
+    if (duplicate) EntryClose(entry);
+
+    return (const DbPooledFile *)ret;
+}
+
+void DbFilePoolRelease(const DbPooledFile *file) {
+    if (file == NULL) return;
+
+    Entry *entry = (Entry *)file;
+    PRAGMA_OMP_CRITICAL(db_file_pool) {
+        if (--entry->ref_count == 0) {
+            if (entry->detached) {
+                EntryClose(entry);
+            } else {
+                EvictIdle();
+            }
+        }
+    }
+}
+
+void DbFilePoolInvalidate(int64_t source, Tier tier) {
+    PRAGMA_OMP_CRITICAL(db_file_pool) {
+        int i = FindEntry(source, tier);
+        if (i >= 0) DetachEntry(i);
+        ++pool_epoch;
+    }
+}
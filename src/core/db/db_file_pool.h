@@ -0,0 +1,115 @@
+/**
+ * @file db_file_pool.h
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Process-wide pool of open tier files shared by all probes and threads.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAMESMANONE_CORE_DB_DB_FILE_POOL_H_
+#define GAMESMANONE_CORE_DB_DB_FILE_POOL_H_
+
+#include <stdbool.h>  // bool
+#include <stdint.h>   // int64_t
+
+#include "core/types/gamesman_types.h"
+
+/**
+ * @brief Open tier file held in the file pool. The meaning of the handle is
+ * defined by the database that opened it. For example, arraydb stores an
+ * XzraFile with its parsed block index, whereas bpdb stores a file descriptor.
+ * Since the same handle may be used by multiple threads at once, it should
+ * only be read from using position-independent functions such as \c pread.
+ */
+typedef struct DbPooledFile {
+    void *handle; /**< Database-defined handle to the open file. Read-only. */
+} DbPooledFile;
+
+/**
+ * @brief Opens a tier file on a pool miss.
+ *
+ * @param aux Auxiliary parameter passed to DbFilePoolAcquire.
+ * @return Handle to the opened file, or NULL if the file cannot be opened.
+ */
+typedef void *(*DbFilePoolOpener)(void *aux);
+
+/** @brief Closes a handle previously returned by a DbFilePoolOpener. */
+typedef void (*DbFilePoolCloser)(void *handle);
+
+/** @brief Default maximum number of idle files kept open by the pool. */
+extern const int kDbFilePoolDefaultCapacity;
+
+/**
+ * @brief Initializes the file pool, which keeps at most CAPACITY files open
+ * that are not currently acquired. Closes all pooled files if the pool was
+ * already initialized.
+ *
+ * @note Must not be called while any file is acquired.
+ *
+ * @param capacity Maximum number of idle open files.
+ * @return kNoError on success, or
+ * @return kMallocFailureError on malloc failure.
+ */
+int DbFilePoolInit(int capacity);
+
+/** @brief Returns true if the file pool has been initialized. */
+bool DbFilePoolIsInitialized(void);
+
+/**
+ * @brief Closes all pooled files and deinitializes the file pool.
+ *
+ * @note Must not be called while any file is acquired.
+ */
+void DbFilePoolFinalize(void);
+
+/**
+ * @brief Returns the open file of TIER in SOURCE from the pool, calling OPEN
+ * with AUX to open it on a miss. Files are opened without holding the pool
+ * lock, so OPEN may be called concurrently for different files and, on
+ * concurrent misses, for the same file. Files are evicted and closed using
+ * CLOSE in least-recently-used order. This function is thread-safe.
+ *
+ * @param source Source ID of the database. See DbBlockCacheNewSource.
+ * @param tier Tier of the file.
+ * @param Open Function that opens the file on a miss.
+ * @param Close Function that closes the file once it is evicted.
+ * @param aux Auxiliary parameter passed to OPEN.
+ * @return The pooled file, which must be released with DbFilePoolRelease;
+ * @return NULL if the file cannot be opened.
+ */
+const DbPooledFile *DbFilePoolAcquire(int64_t source, Tier tier,
+                                      DbFilePoolOpener Open,
+                                      DbFilePoolCloser Close, void *aux);
+
+/**
+ * @brief Releases FILE previously returned by DbFilePoolAcquire. Does nothing
+ * if FILE is NULL. This function is thread-safe.
+ */
+void DbFilePoolRelease(const DbPooledFile *file);
+
+/**
+ * @brief Removes the file of TIER in SOURCE from the pool. Must be called
+ * whenever a tier file is rewritten. Files that are currently acquired are
+ * closed on their last release. This function is thread-safe.
+ */
+void DbFilePoolInvalidate(int64_t source, Tier tier);
+
+#endif  // GAMESMANONE_CORE_DB_DB_FILE_POOL_H_
@@ -34,13 +34,27 @@
 #include <string.h>   // strlen
 
 #include "core/constants.h"
+#include "core/db/db_block_cache.h"
+#include "core/db/db_file_pool.h"
+#include "core/db/db_probe_batch.h"
+#include "core/db/db_shard.h"
 #include "core/misc.h"
 #include "core/types/gamesman_types.h"
 
 static const Database *current_db;
 static const Database *ref_db;
 
+// Data directories of the current database, used for rebalancing.
+static DbShardMap current_shards;
+static GetTierNameFunc CurrentGetTierName;
+
+static int InitSharedCaches(void);
+static void FinalizeSharedCachesIfUnused(void);
 static bool BasicDbApiImplemented(const Database *db);
+static int DefaultProbeRecord(DbProbe *probe, TierPosition tier_position,
+                              Value *value, int *remoteness);
+static int DefaultRefProbeRecord(DbProbe *probe, TierPosition tier_position,
+                                 Value *value, int *remoteness);
 static bool IsValidDbName(ReadOnlyString name);
 static char *SetupDbPath(const Database *db, ReadOnlyString game_name,
                          int variant, ReadOnlyString data_path, bool read_only);
@@ -61,11 +75,21 @@ int DbManagerInitDb(const Database *db, bool read_only,
                 db->formal_name);
         return kNotImplementedError;
     }
+    int error = InitSharedCaches();
+    if (error != kNoError) return error;
     current_db = db;
 
     char *path =
         SetupDbPath(current_db, game_name, variant, data_path, read_only);
-    int error = current_db->Init(game_name, variant, path, GetTierName, aux);
+    if (path == NULL) {
+        current_db = NULL;
+        return kRuntimeError;
+    }
+    error = DbShardMapInit(&current_shards, path, NULL);
+    if (error == kNoError) {
+        CurrentGetTierName = GetTierName;
+        error = current_db->Init(game_name, variant, path, GetTierName, aux);
+    }
     free(path);
 
     return error;
@@ -84,10 +108,16 @@ int DbManagerInitRefDb(const Database *db, ReadOnlyString game_name,
                 db->formal_name);
         return kNotImplementedError;
     }
+    int error = InitSharedCaches();
+    if (error != kNoError) return error;
     ref_db = db;
 
     char *path = SetupDbPath(ref_db, game_name, variant, data_path, false);
-    int error = ref_db->Init(game_name, variant, path, GetTierName, aux);
+    if (path == NULL) {
+        ref_db = NULL;
+        return kRuntimeError;
+    }
+    error = ref_db->Init(game_name, variant, path, GetTierName, aux);
     free(path);
 
     return error;
@@ -96,11 +126,14 @@ int DbManagerInitRefDb(const Database *db, ReadOnlyString game_name,
 void DbManagerFinalizeDb(void) {
     if (current_db) current_db->Finalize();
     current_db = NULL;
+    DbShardMapDestroy(&current_shards);
+    FinalizeSharedCachesIfUnused();
 }
 
 void DbManagerFinalizeRefDb(void) {
     if (ref_db) ref_db->Finalize();
     ref_db = NULL;
+    FinalizeSharedCachesIfUnused();
 }
 
 int DbManagerCreateSolvingTier(Tier tier, int64_t size) {
@@ -113,6 +146,23 @@ int DbManagerFlushSolvingTier(void *aux) {
 
 int DbManagerFreeSolvingTier(void) { return current_db->FreeSolvingTier(); }
 
+int DbManagerConvertTier(Tier tier, int64_t size) {
+    if (current_db->ConvertTier == NULL) return kNoError;
+
+    return current_db->ConvertTier(tier, size);
+}
+
+bool DbManagerSupportsConcurrentTierWrites(void) {
+    return current_db->WriteTier != NULL;
+}
+
+int DbManagerWriteTier(Tier tier, int64_t size, const int8_t *values,
+                       const int16_t *remotenesses) {
+    if (current_db->WriteTier == NULL) return kNotImplementedError;
+
+    return current_db->WriteTier(tier, size, values, remotenesses);
+}
+
 int DbManagerSetGameSolved(void) { return current_db->SetGameSolved(); }
 
 int DbManagerSetValue(Position position, Value value) {
@@ -123,6 +173,12 @@ int DbManagerSetRemoteness(Position position, int remoteness) {
     return current_db->SetRemoteness(position, remoteness);
 }
 
+int DbManagerReserveRemoteness(int remoteness) {
+    if (current_db->ReserveRemoteness == NULL) return kNoError;
+
+    return current_db->ReserveRemoteness(remoteness);
+}
+
 Value DbManagerGetValue(Position position) {
     return current_db->GetValue(position);
 }
@@ -152,6 +208,14 @@ intptr_t DbManagerTierMemUsage(Tier tier, int64_t size) {
     return current_db->TierMemUsage(tier, size);
 }
 
+intptr_t DbManagerLoadedTierMemUsage(Tier tier, int64_t size) {
+    if (current_db->LoadedTierMemUsage == NULL) {
+        return current_db->TierMemUsage(tier, size);
+    }
+
+    return current_db->LoadedTierMemUsage(tier, size);
+}
+
 int DbManagerLoadTier(Tier tier, int64_t size) {
     return current_db->LoadTier(tier, size);
 }
@@ -168,6 +232,19 @@ int DbManagerGetRemotenessFromLoaded(Tier tier, Position position) {
     return current_db->GetRemotenessFromLoaded(tier, position);
 }
 
+int DbManagerGetLoadedTierHandle(Tier tier, DbTierHandle *handle) {
+    handle->tier = tier;
+    handle->records = NULL;
+    handle->record_size = 0;
+    handle->value_shift = 0;
+    handle->remoteness_mask = 0;
+    handle->GetValue = current_db->GetValueFromLoaded;
+    handle->GetRemoteness = current_db->GetRemotenessFromLoaded;
+    if (current_db->GetLoadedTierHandle == NULL) return kNoError;
+
+    return current_db->GetLoadedTierHandle(tier, handle);
+}
+
 int DbManagerProbeInit(DbProbe *probe) { return current_db->ProbeInit(probe); }
 
 int DbManagerProbeDestroy(DbProbe *probe) {
@@ -182,10 +259,40 @@ int DbManagerProbeRemoteness(DbProbe *probe, TierPosition tier_position) {
     return current_db->ProbeRemoteness(probe, tier_position);
 }
 
+int DbManagerProbeRecordsBatch(DbProbe *probe, int64_t size,
+                               const TierPosition *tier_positions,
+                               Value *values, int *remotenesses) {
+    if (current_db->ProbeRecordsBatch != NULL) {
+        return current_db->ProbeRecordsBatch(probe, size, tier_positions,
+                                             values, remotenesses);
+    }
+
+    return DbProbeBatchRun(probe, size, tier_positions, values, remotenesses,
+                           DefaultProbeRecord);
+}
+
+int DbManagerProbeValuesBatch(DbProbe *probe, int64_t size,
+                              const TierPosition *tier_positions,
+                              Value *values) {
+    return DbManagerProbeRecordsBatch(probe, size, tier_positions, values,
+                                      NULL);
+}
+
 int DbManagerTierStatus(Tier tier) { return current_db->TierStatus(tier); }
 
 int DbManagerGameStatus(void) { return current_db->GameStatus(); }
 
+int DbManagerGetTierSummary(Tier tier, int64_t size, DbTierSummary *summary) {
+    if (current_db->GetTierSummary == NULL) return kNotImplementedError;
+
+    return current_db->GetTierSummary(tier, size, summary);
+}
+
+int DbManagerRebalanceTier(Tier tier, int64_t *num_moved) {
+    return DbShardMapMoveTier(&current_shards, tier, CurrentGetTierName,
+                              num_moved);
+}
+
 int DbManagerRefProbeInit(DbProbe *probe) { return ref_db->ProbeInit(probe); }
 
 int DbManagerRefProbeDestroy(DbProbe *probe) {
@@ -197,9 +304,40 @@ Value DbManagerRefProbeValue(DbProbe *probe, TierPosition tier_position) {
 int DbManagerRefProbeRemoteness(DbProbe *probe, TierPosition tier_position) {
     return ref_db->ProbeRemoteness(probe, tier_position);
 }
+int DbManagerRefProbeRecordsBatch(DbProbe *probe, int64_t size,
+                                  const TierPosition *tier_positions,
+                                  Value *values, int *remotenesses) {
+    if (ref_db->ProbeRecordsBatch != NULL) {
+        return ref_db->ProbeRecordsBatch(probe, size, tier_positions, values,
+                                         remotenesses);
+    }
+
+    return DbProbeBatchRun(probe, size, tier_positions, values, remotenesses,
+                           DefaultRefProbeRecord);
+}
 
 // -----------------------------------------------------------------------------
 
+// The block cache and the file pool are shared by the current and the
+// reference databases and live as long as either of them is initialized.
+static int InitSharedCaches(void) {
+    if (!DbBlockCacheIsInitialized()) {
+        int error = DbBlockCacheInit(kDbBlockCacheDefaultCapacity);
+        if (error != kNoError) return error;
+    }
+    if (!DbFilePoolIsInitialized()) {
+        return DbFilePoolInit(kDbFilePoolDefaultCapacity);
+    }
+
+    return kNoError;
+}
+
+static void FinalizeSharedCachesIfUnused(void) {
+    if (current_db != NULL || ref_db != NULL) return;
+    DbBlockCacheFinalize();
+    DbFilePoolFinalize();
+}
+
 static bool BasicDbApiImplemented(const Database *db) {
     if (!IsValidDbName(db->formal_name)) {
         fprintf(stderr,
@@ -218,6 +356,29 @@ static bool BasicDbApiImplemented(const Database *db) {
     return true;
 }
 
+// Probes a single record using the single-position probing functions of DB.
+static int ProbeRecordUsing(const Database *db, DbProbe *probe,
+                            TierPosition tier_position, Value *value,
+                            int *remoteness) {
+    *value = db->ProbeValue(probe, tier_position);
+    if (*value == kErrorValue) return kRuntimeError;
+    if (remoteness == NULL) return kNoError;
+
+    *remoteness = db->ProbeRemoteness(probe, tier_position);
+    return *remoteness < 0 ? kRuntimeError : kNoError;
+}
+
+static int DefaultProbeRecord(DbProbe *probe, TierPosition tier_position,
+                              Value *value, int *remoteness) {
+    return ProbeRecordUsing(current_db, probe, tier_position, value,
+                            remoteness);
+}
+
+static int DefaultRefProbeRecord(DbProbe *probe, TierPosition tier_position,
+                                 Value *value, int *remoteness) {
+    return ProbeRecordUsing(ref_db, probe, tier_position, value, remoteness);
+}
+
 static bool IsValidDbName(ReadOnlyString name) {
     bool terminates = false;
     for (int i = 0; i < kDbFormalNameLengthMax + 1; ++i) {
@@ -234,36 +395,49 @@ static bool IsValidDbName(ReadOnlyString name) {
 static char *SetupDbPath(const Database *db, ReadOnlyString game_name,
                          int variant, ReadOnlyString data_path,
                          bool read_only) {
-    // path = "<data_path>/<game_name>/<variant>/<db_name>/"
+    // path = "<data_path>/<game_name>/<variant>/<db_name>/" for each data path
+    // listed in DATA_PATH, joined in the same format as DATA_PATH.
     if (data_path == NULL) data_path = "data";
-    char *path = NULL;
+    char *subdir = NULL;
 
-    int path_length = (int)strlen(data_path) + 1;  // +1 for '/'.
-    path_length += (int)strlen(game_name) + 1;
-    path_length += kInt32Base10StringLengthMax + 1;
-    path_length += (int)strlen(db->name) + 1;
-    path = (char *)calloc((path_length + 1), sizeof(char));
-    if (path == NULL) {
+    int subdir_length = (int)strlen(game_name) + 1;  // +1 for '/'.
+    subdir_length += kInt32Base10StringLengthMax + 1;
+    subdir_length += (int)strlen(db->name) + 1;
+    subdir = (char *)calloc((subdir_length + 1), sizeof(char));
+    if (subdir == NULL) {
         fprintf(stderr, "SetupDbPath: failed to calloc path.\n");
         return NULL;
     }
 
-    int actual_length = snprintf(path, path_length, "%s/%s/%d/%s/", data_path,
+    int actual_length = snprintf(subdir, subdir_length, "%s/%d/%s/",
                                  game_name, variant, db->name);
-    if (actual_length >= path_length) {
+    if (actual_length >= subdir_length) {
         fprintf(stderr,
                 "SetupDbPath: (BUG) not enough space was allocated for path. "
                 "Please check the implementation of this function.\n");
-        free(path);
+        free(subdir);
         return NULL;
     }
 
-    if (!read_only && MkdirRecursive(path) != 0) {
-        fprintf(stderr,
-                "SetupDbPath: failed to create path in the file system.\n");
-        free(path);
-        return NULL;
+    DbShardMap shards;
+    int error = DbShardMapInit(&shards, data_path, subdir);
+    free(subdir);
+    if (error != kNoError) return NULL;
+
+    for (int i = 0; !read_only && i < shards.num_shards; ++i) {
+        if (MkdirRecursive(shards.paths[i]) != 0) {
+            fprintf(stderr,
+                    "SetupDbPath: failed to create path %s in the file "
+                    "system.\n",
+                    shards.paths[i]);
+            DbShardMapDestroy(&shards);
+            return NULL;
+        }
     }
 
+    char *path = DbShardMapToString(&shards);
+    DbShardMapDestroy(&shards);
+    if (path == NULL) fprintf(stderr, "SetupDbPath: failed to malloc path.\n");
+
     return path;
 }
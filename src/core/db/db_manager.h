@@ -29,7 +29,7 @@
 
 #include <stdbool.h>  // bool
 #include <stddef.h>   // size_t
-#include <stdint.h>   // int64_t, intptr_t
+#include <stdint.h>   // int8_t, int16_t, int64_t, intptr_t
 
 #include "core/types/gamesman_types.h"
 
@@ -48,7 +48,9 @@
  * @param game_name Internal name of the game.
  * @param variant Index of the game variant as an integer.
  * @param data_path Absolute or relative path to the data directory if non-NULL.
- * The default path "data" will be used if set to NULL.
+ * The default path "data" will be used if set to NULL. Multiple data
+ * directories may be listed as described in db_shard.h, in which case the
+ * files of each tier are placed in one of them by a stable hash of the tier.
  * @param GetTierName Function that converts a tier to its name. If set to
  * NULL, a fallback method will be used instead.
  * @param aux Auxiliary parameter.
@@ -104,6 +106,44 @@ int DbManagerFlushSolvingTier(void *aux);
  */
 int DbManagerFreeSolvingTier(void);
 
+/**
+ * @brief Rewrites the stored DB of the solved TIER of SIZE positions in the
+ * storage format selected when the current database was initialized, e.g.,
+ * converts an XZ-compressed arraydb tier into LZ4 format. Does nothing if TIER
+ * is already stored in that format or if the current database supports only
+ * one storage format.
+ *
+ * @param tier Solved tier to convert.
+ * @param size Size of TIER in number of positions.
+ * @return kNoError on success, or
+ * @return non-zero error code otherwise.
+ */
+int DbManagerConvertTier(Tier tier, int64_t size);
+
+/**
+ * @brief Returns whether the current database can write whole tiers with
+ * DbManagerWriteTier, which may be called concurrently for distinct tiers.
+ */
+bool DbManagerSupportsConcurrentTierWrites(void);
+
+/**
+ * @brief Writes TIER of SIZE positions with the given VALUES and REMOTENESSES
+ * to the current database without going through the solving tier. Safe to
+ * call concurrently for distinct tiers.
+ *
+ * @param tier Tier to write.
+ * @param size Size of TIER in number of positions.
+ * @param values Array of SIZE position values.
+ * @param remotenesses Array of SIZE non-negative position remotenesses.
+ * @return kNoError on success,
+ * @return kNotImplementedError if the current database does not support
+ * concurrent tier writes,
+ * @return kIllegalArgumentError if any remoteness is negative, or
+ * @return non-zero error code otherwise.
+ */
+int DbManagerWriteTier(Tier tier, int64_t size, const int8_t *values,
+                       const int16_t *remotenesses);
+
 /**
  * @brief Sets the current game as solved.
  *
@@ -132,6 +172,18 @@ int DbManagerSetValue(Position position, Value value);
  */
 int DbManagerSetRemoteness(Position position, int remoteness);
 
+/**
+ * @brief Prepares the solving tier for storing remotenesses up to REMOTENESS.
+ * Must be called outside of parallel regions before remotenesses that may
+ * exceed all previously reserved remotenesses are set from multiple threads.
+ *
+ * @note Assumes the solving tier has been created. Results in undefined
+ * behavior if not.
+ *
+ * @return int 0 on success, non-zero otherwise.
+ */
+int DbManagerReserveRemoteness(int remoteness);
+
 /**
  * @brief Returns the value of POSITION in the solving tier.
  *
@@ -211,6 +263,19 @@ int DbManagerCheckpointRemove(Tier tier);
  */
 intptr_t DbManagerTierMemUsage(Tier tier, int64_t size);
 
+/**
+ * @brief Returns the amount of memory in bytes actually used by the loaded
+ * \p tier of \p size positions, which is usually smaller than the estimate
+ * returned by \c DbManagerTierMemUsage. Callers that reserve memory using
+ * \c DbManagerTierMemUsage before loading a tier may return the difference
+ * after loading it, and should call this function before unloading it.
+ *
+ * @param tier A loaded tier.
+ * @param size Size of \p tier in number of positions.
+ * @return Memory usage of the loaded \p tier.
+ */
+intptr_t DbManagerLoadedTierMemUsage(Tier tier, int64_t size);
+
 /**
  * @brief Loads the given \p tier of \p size positions into memory.
  * @param tier Tier to be loaded.
@@ -261,6 +326,20 @@ Value DbManagerGetValueFromLoaded(Tier tier, Position position);
  */
 int DbManagerGetRemotenessFromLoaded(Tier tier, Position position);
 
+/**
+ * @brief Initializes \p handle for reading the loaded \p tier without
+ * looking up \p tier on every access. The handle remains valid until \p tier
+ * is unloaded. Records of \p tier should be read using the accessors in
+ * core/types/database/db_tier_handle.h.
+ *
+ * @param tier A loaded tier.
+ * @param handle Handle to initialize.
+ *
+ * @return \c kNoError on success, or
+ * @return non-zero error code otherwise.
+ */
+int DbManagerGetLoadedTierHandle(Tier tier, DbTierHandle *handle);
+
 // ----------------------------- Probing Interface -----------------------------
 
 /**
@@ -301,6 +380,40 @@ Value DbManagerProbeValue(DbProbe *probe, TierPosition tier_position);
  */
 int DbManagerProbeRemoteness(DbProbe *probe, TierPosition tier_position);
 
+/**
+ * @brief Reads the values and remotenesses of the SIZE tier positions in
+ * TIER_POSITIONS in the current database from disk using the given initialized
+ * PROBE, and stores them in VALUES and REMOTENESSES in the same order as
+ * TIER_POSITIONS.
+ * @details The tier positions are grouped by tier and storage block, and each
+ * block is loaded at most once per call. This is much faster than probing the
+ * tier positions one at a time if they are spread across multiple tiers or in
+ * no particular order.
+ *
+ * @note Results in undefined behavior if PROBE has not been initialized.
+ *
+ * @param probe Initialized database probe.
+ * @param size Number of tier positions to read.
+ * @param tier_positions Array of SIZE tier positions to read.
+ * @param values (Output parameter) Array of SIZE values.
+ * @param remotenesses (Output parameter) Array of SIZE remotenesses, or NULL
+ * if only the values are needed.
+ * @return kNoError on success, or
+ * @return non-zero error code otherwise, in which case the results of the tier
+ * positions that failed are set to kErrorValue and kErrorRemoteness.
+ */
+int DbManagerProbeRecordsBatch(DbProbe *probe, int64_t size,
+                               const TierPosition *tier_positions,
+                               Value *values, int *remotenesses);
+
+/**
+ * @brief Same as DbManagerProbeRecordsBatch but only reads the values of the
+ * SIZE tier positions in TIER_POSITIONS into VALUES.
+ */
+int DbManagerProbeValuesBatch(DbProbe *probe, int64_t size,
+                              const TierPosition *tier_positions,
+                              Value *values);
+
 /**
  * @brief Returns the status of TIER.
  *
@@ -323,11 +436,44 @@ int DbManagerTierStatus(Tier tier);
  */
 int DbManagerGameStatus(void);
 
+/**
+ * @brief Reads the summary of the solved TIER of SIZE positions stored by the
+ * current database into SUMMARY. See db_tier_summary.h.
+ *
+ * @param tier Tier whose summary is read.
+ * @param size Size of TIER in number of positions.
+ * @param summary (Output parameter) Summary of TIER.
+ * @return kNoError on success,
+ * @return kNotImplementedError if the current database does not store tier
+ * summaries, or
+ * @return non-zero error code if no valid summary is stored for TIER.
+ */
+int DbManagerGetTierSummary(Tier tier, int64_t size, DbTierSummary *summary);
+
+/**
+ * @brief Moves all files of TIER in the current database that are stored in
+ * a data directory other than the one TIER is assigned to into the assigned
+ * directory. Used to rebalance existing tiers after data directories have
+ * been added or reweighted. Does nothing if there is only one data directory.
+ *
+ * @note Not thread-safe. Must not be called while TIER is being solved,
+ * loaded, or probed.
+ *
+ * @param tier Tier whose files are to be moved.
+ * @param num_moved Number of files moved is added to this counter.
+ * @return kNoError on success, or
+ * @return non-zero error code on failure.
+ */
+int DbManagerRebalanceTier(Tier tier, int64_t *num_moved);
+
 // --------------------- (EXPERIMENTAL) Testing Interface ---------------------
 
 int DbManagerRefProbeInit(DbProbe *probe);
 int DbManagerRefProbeDestroy(DbProbe *probe);
 Value DbManagerRefProbeValue(DbProbe *probe, TierPosition tier_position);
 int DbManagerRefProbeRemoteness(DbProbe *probe, TierPosition tier_position);
+int DbManagerRefProbeRecordsBatch(DbProbe *probe, int64_t size,
+                                  const TierPosition *tier_positions,
+                                  Value *values, int *remotenesses);
 
 #endif  // GAMESMANONE_CORE_DB_DB_MANAGER_H_
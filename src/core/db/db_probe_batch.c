@@ -0,0 +1,126 @@
+/**
+ * @file db_probe_batch.c
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Implementation of the generic driver for batched database probes.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/db/db_probe_batch.h"
+
+#include <stdbool.h>  // bool, true, false
+#include <stddef.h>   // NULL
+#include <stdint.h>   // int64_t
+#include <stdlib.h>   // malloc, free, qsort
+
+#include "core/constants.h"
+#include "core/types/gamesman_types.h"
+
+typedef struct {
+    TierPosition tier_position;
+    int64_t index;  // Index of the tier position in the input batch.
+} BatchEntry;
+
+static bool IsSorted(int64_t size, const TierPosition *tier_positions);
+static int CompareBatchEntries(const void *a, const void *b);
+static int ProbeOne(DbProbe *probe, TierPosition tier_position, Value *value,
+                    int *remoteness, DbProbeBatchRecordFunc ProbeRecord);
+
+// -----------------------------------------------------------------------------
+
+int DbProbeBatchRun(DbProbe *probe, int64_t size,
+                    const TierPosition *tier_positions, Value *values,
+                    int *remotenesses, DbProbeBatchRecordFunc ProbeRecord) {
+    int ret = kNoError;
+
+    // Sorting an already sorted batch is wasted work. If the batch is not
+    // sorted and the index array cannot be allocated, probe in input order,
+    // which is slower but still correct.
+    BatchEntry *entries = NULL;
+    if (!IsSorted(size, tier_positions)) {
+        entries = (BatchEntry *)malloc(size * sizeof(BatchEntry));
+    }
+    if (entries == NULL) {
+        for (int64_t i = 0; i < size; ++i) {
+            int *remoteness = remotenesses ? &remotenesses[i] : NULL;
+            int error = ProbeOne(probe, tier_positions[i], &values[i],
+                                 remoteness, ProbeRecord);
+            if (ret == kNoError) ret = error;
+        }
+        return ret;
+    }
+
+    for (int64_t i = 0; i < size; ++i) {
+        entries[i].tier_position = tier_positions[i];
+        entries[i].index = i;
+    }
+    qsort(entries, size, sizeof(BatchEntry), CompareBatchEntries);
+    for (int64_t i = 0; i < size; ++i) {
+        int64_t j = entries[i].index;
+        int *remoteness = remotenesses ? &remotenesses[j] : NULL;
+        int error = ProbeOne(probe, entries[i].tier_position, &values[j],
+                             remoteness, ProbeRecord);
+        if (ret == kNoError) ret = error;
+    }
+    free(entries);
+
+    return ret;
+}
+
+// -----------------------------------------------------------------------------
+
+static int CompareTierPositions(TierPosition a, TierPosition b) {
+    if (a.tier != b.tier) return a.tier < b.tier ? -1 : 1;
+    if (a.position != b.position) return a.position < b.position ? -1 : 1;
+    return 0;
+}
+
+static bool IsSorted(int64_t size, const TierPosition *tier_positions) {
+    for (int64_t i = 1; i < size; ++i) {
+        if (CompareTierPositions(tier_positions[i - 1], tier_positions[i]) >
+            0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int CompareBatchEntries(const void *a, const void *b) {
+    const BatchEntry *x = (const BatchEntry *)a;
+    const BatchEntry *y = (const BatchEntry *)b;
+    int ret = CompareTierPositions(x->tier_position, y->tier_position);
+    if (ret != 0) return ret;
+
+    // Break ties by input index so that the probing order is deterministic.
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+static int ProbeOne(DbProbe *probe, TierPosition tier_position, Value *value,
+                    int *remoteness, DbProbeBatchRecordFunc ProbeRecord) {
+    int error = ProbeRecord(probe, tier_position, value, remoteness);
+    if (error != kNoError) {
+        *value = kErrorValue;
+        if (remoteness != NULL) *remoteness = kErrorRemoteness;
+    }
+
+    return error;
+}
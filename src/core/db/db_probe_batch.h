@@ -0,0 +1,67 @@
+/**
+ * @file db_probe_batch.h
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Generic driver for batched database probes.
+ * @details Sorts a batch of tier positions by tier and position so that
+ * positions stored in the same block of a tier file are probed back to back,
+ * probes each of them once, and scatters the results back to the order of the
+ * input.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAMESMANONE_CORE_DB_DB_PROBE_BATCH_H_
+#define GAMESMANONE_CORE_DB_DB_PROBE_BATCH_H_
+
+#include <stdint.h>  // int64_t
+
+#include "core/types/gamesman_types.h"
+
+/**
+ * @brief Probes the value and, if REMOTENESS is not NULL, the remoteness of
+ * TIER_POSITION using PROBE.
+ *
+ * @return \c kNoError on success, or
+ * @return non-zero error code otherwise.
+ */
+typedef int (*DbProbeBatchRecordFunc)(DbProbe *probe,
+                                      TierPosition tier_position, Value *value,
+                                      int *remoteness);
+
+/**
+ * @brief Probes the values and, if REMOTENESSES is not NULL, the remotenesses
+ * of the SIZE tier positions in TIER_POSITIONS using PROBE and ProbeRecord,
+ * and stores the results in VALUES and REMOTENESSES in the same order as
+ * TIER_POSITIONS.
+ * @details The tier positions are probed in ascending order of tier and
+ * position, so that a probe that buffers the most recently used block of a
+ * tier file loads each block at most once per batch. Input that is already
+ * sorted is probed in place without allocating memory.
+ *
+ * @return \c kNoError on success, or
+ * @return the first non-zero error code returned by ProbeRecord. Results of
+ * the failed positions are set to \c kErrorValue and \c kErrorRemoteness.
+ */
+int DbProbeBatchRun(DbProbe *probe, int64_t size,
+                    const TierPosition *tier_positions, Value *values,
+                    int *remotenesses, DbProbeBatchRecordFunc ProbeRecord);
+
+#endif  // GAMESMANONE_CORE_DB_DB_PROBE_BATCH_H_
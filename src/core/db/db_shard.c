@@ -0,0 +1,466 @@
+/**
+ * @file db_shard.c
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Implementation of the placement of tier files across multiple data
+ * roots.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/db/db_shard.h"
+
+#include <dirent.h>     // DIR, opendir, readdir, closedir
+#include <errno.h>      // errno, EINTR, ENOENT, EXDEV
+#include <fcntl.h>      // open, O_RDONLY, O_WRONLY, O_CREAT, O_TRUNC
+#include <stdbool.h>    // bool, true, false
+#include <stddef.h>     // NULL, size_t
+#include <stdint.h>     // int64_t, uint64_t
+#include <stdio.h>      // fprintf, stderr, perror, rename
+#include <stdlib.h>     // calloc, malloc, realloc, free, qsort
+#include <string.h>     // strlen, strcpy, strcat, strcmp, strchr, strrchr
+#include <sys/types.h>  // ssize_t
+#include <unistd.h>     // read, write, fsync, close
+
+#include "core/concurrency.h"
+#include "core/misc.h"
+#include "core/types/gamesman_types.h"
+
+// Size of the buffer used to copy files across file systems.
+static const size_t kCopyBufferSize = 1 << 20;
+
+// Extension of the partially copied file while a file is being copied.
+static ConstantReadOnlyString kMoveExtension = ".move";
+
+// -----------------------------------------------------------------------------
+
+static uint64_t Mix64(uint64_t x) {
+    // Finalizer of splitmix64.
+    x ^= x >> 30;
+    x *= UINT64_C(0xbf58476d1ce4e5b9);
+    x ^= x >> 27;
+    x *= UINT64_C(0x94d049bb133111eb);
+    x ^= x >> 31;
+    return x;
+}
+
+static void StripTrailingSlashes(char *path) {
+    size_t length = strlen(path);
+    while (length > 1 && path[length - 1] == '/') path[--length] = '\0';
+}
+
+// Parses the weight that follows the last kDbShardWeightSeparator in ENTRY
+// and removes it from ENTRY. Returns the weight, 1 if ENTRY has no weight, or
+// -1 if the weight is out of range.
+static int ParseWeight(char *entry) {
+    char *separator = strrchr(entry, kDbShardWeightSeparator);
+    if (separator == NULL || separator[1] == '\0') return 1;
+
+    int64_t weight = 0;
+    for (const char *c = separator + 1; *c != '\0'; ++c) {
+        if (*c < '0' || *c > '9') return 1;  // Part of the path.
+        weight = weight * 10 + (*c - '0');
+        if (weight > kDbShardWeightMax) return -1;
+    }
+    if (weight < 1) return -1;
+    *separator = '\0';
+
+    return (int)weight;
+}
+
+// Appends ENTRY, which is modified in place, to MAP as a new shard.
+static int AddShard(DbShardMap *map, char *entry, ReadOnlyString subdir) {
+    int weight = ParseWeight(entry);
+    StripTrailingSlashes(entry);
+    if (weight < 0 || entry[0] == '\0') return kIllegalArgumentError;
+
+    size_t length = strlen(entry) + 1;
+    if (subdir != NULL) length += strlen(subdir) + 1;
+    char *path = (char *)malloc(length);
+    if (path == NULL) return kMallocFailureError;
+    strcpy(path, entry);
+    if (subdir != NULL) {
+        strcat(path, "/");
+        strcat(path, subdir);
+        StripTrailingSlashes(path);
+    }
+
+    int i = map->num_shards++;
+    map->paths[i] = path;
+    map->weights[i] = weight;
+
+    return kNoError;
+}
+
+int DbShardMapInit(DbShardMap *map, ReadOnlyString list,
+                   ReadOnlyString subdir) {
+    int max_shards = 1;
+    for (const char *c = list; *c != '\0'; ++c) {
+        max_shards += (*c == kDbShardListSeparator);
+    }
+
+    map->num_shards = 0;
+    map->paths = (char **)calloc(max_shards, sizeof(char *));
+    map->weights = (int *)calloc(max_shards, sizeof(int));
+    map->listings = NULL;
+    char *entries = (char *)malloc(strlen(list) + 1);
+    int error = kNoError;
+    if (map->paths == NULL || map->weights == NULL || entries == NULL) {
+        error = kMallocFailureError;
+        goto _bailout;
+    }
+
+    strcpy(entries, list);
+    char *entry = entries;
+    for (int i = 0; i < max_shards; ++i) {
+        char *end = strchr(entry, kDbShardListSeparator);
+        if (end != NULL) *end = '\0';
+        error = AddShard(map, entry, subdir);
+        if (error != kNoError) goto _bailout;
+        if (end != NULL) entry = end + 1;
+    }
+
+_bailout:
+    free(entries);
+    if (error == kIllegalArgumentError) {
+        fprintf(stderr, "DbShardMapInit: malformed data path list [%s]\n",
+                list);
+    }
+    if (error != kNoError) DbShardMapDestroy(map);
+
+    return error;
+}
+
+static void DestroyListing(DbShardListing *listing) {
+    for (int64_t i = 0; i < listing->size; ++i) {
+        free(listing->names[i]);
+    }
+    free(listing->names);
+    listing->names = NULL;
+    listing->size = 0;
+    listing->initialized = false;
+}
+
+void DbShardMapDestroy(DbShardMap *map) {
+    for (int i = 0; i < map->num_shards; ++i) {
+        free(map->paths[i]);
+        if (map->listings != NULL) DestroyListing(&map->listings[i]);
+    }
+    free(map->paths);
+    free(map->weights);
+    free(map->listings);
+    map->paths = NULL;
+    map->weights = NULL;
+    map->listings = NULL;
+    map->num_shards = 0;
+}
+
+char *DbShardMapToString(const DbShardMap *map) {
+    // Each weight takes at most 4 digits plus the separator.
+    size_t length = 0;
+    for (int i = 0; i < map->num_shards; ++i) {
+        length += strlen(map->paths[i]) + 6;
+    }
+    char *ret = (char *)calloc(length + 1, sizeof(char));
+    if (ret == NULL) return NULL;
+
+    int count = 0;
+    for (int i = 0; i < map->num_shards; ++i) {
+        if (i > 0) ret[count++] = kDbShardListSeparator;
+        count += sprintf(ret + count, "%s", map->paths[i]);
+        if (map->weights[i] != 1) {
+            count += sprintf(ret + count, "%c%d", kDbShardWeightSeparator,
+                             map->weights[i]);
+        }
+    }
+
+    return ret;
+}
+
+int DbShardMapGetIndex(const DbShardMap *map, Tier tier) {
+    if (map->num_shards == 1) return 0;
+
+    // Weighted rendezvous hashing: shard i owns weights[i] replicas and the
+    // tier goes to the shard of the replica with the highest score.
+    uint64_t key = Mix64((uint64_t)tier);
+    uint64_t best_score = 0;
+    int best = 0;
+    for (int i = 0; i < map->num_shards; ++i) {
+        for (int j = 0; j < map->weights[i]; ++j) {
+            uint64_t replica = ((uint64_t)i << 32) | (uint64_t)j;
+            uint64_t score = Mix64(key ^ Mix64(replica + 1));
+            if (score > best_score) {
+                best_score = score;
+                best = i;
+            }
+        }
+    }
+
+    return best;
+}
+
+ReadOnlyString DbShardMapGetPath(const DbShardMap *map, Tier tier) {
+    return map->paths[DbShardMapGetIndex(map, tier)];
+}
+
+ReadOnlyString DbShardMapGetPrimaryPath(const DbShardMap *map) {
+    return map->paths[0];
+}
+
+// -----------------------------------------------------------------------------
+
+static int CompareNames(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static int ListShard(DbShardListing *listing, ReadOnlyString path) {
+    listing->initialized = true;
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+        if (errno == ENOENT) return kNoError;  // No files in this shard.
+        perror("opendir");
+        return kFileSystemError;
+    }
+
+    int64_t capacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0) continue;
+        if (strcmp(entry->d_name, "..") == 0) continue;
+        if (listing->size == capacity) {
+            capacity = capacity == 0 ? 64 : capacity * 2;
+            char **names = (char **)realloc(listing->names,
+                                            capacity * sizeof(char *));
+            if (names == NULL) goto _bailout;
+            listing->names = names;
+        }
+        char *name = (char *)malloc(strlen(entry->d_name) + 1);
+        if (name == NULL) goto _bailout;
+        strcpy(name, entry->d_name);
+        listing->names[listing->size++] = name;
+    }
+    closedir(dir);
+    qsort(listing->names, listing->size, sizeof(char *), CompareNames);
+
+    return kNoError;
+
+_bailout:
+    closedir(dir);
+    DestroyListing(listing);
+    return kMallocFailureError;
+}
+
+// Returns the index of the first name in LISTING that is not less than NAME.
+static int64_t LowerBound(const DbShardListing *listing, ReadOnlyString name) {
+    int64_t lo = 0, hi = listing->size;
+    while (lo < hi) {
+        int64_t mid = lo + (hi - lo) / 2;
+        if (strcmp(listing->names[mid], name) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+static char *JoinPath(ReadOnlyString dir, ReadOnlyString name,
+                      ReadOnlyString extension) {
+    size_t length = strlen(dir) + strlen(name) + strlen(extension) + 2;
+    char *path = (char *)malloc(length);
+    if (path == NULL) return NULL;
+    sprintf(path, "%s/%s%s", dir, name, extension);
+
+    return path;
+}
+
+static bool WriteFull(int fd, const char *buf, ssize_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, buf, size);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        buf += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+// Copies SRC into a temporary file next to DST, syncs it to disk, and renames
+// it to DST.
+static int CopyFile(ReadOnlyString src, ReadOnlyString dst) {
+    char *tmp = (char *)malloc(strlen(dst) + strlen(kMoveExtension) + 1);
+    char *buf = (char *)malloc(kCopyBufferSize);
+    int in = -1, out = -1, error = kFileSystemError;
+    if (tmp == NULL || buf == NULL) {
+        error = kMallocFailureError;
+        goto _bailout;
+    }
+    sprintf(tmp, "%s%s", dst, kMoveExtension);
+
+    in = GuardedOpen(src, O_RDONLY);
+    if (in < 0) goto _bailout;
+    out = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        perror("open");
+        goto _bailout;
+    }
+
+    ssize_t n;
+    while ((n = read(in, buf, kCopyBufferSize)) != 0) {
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 || !WriteFull(out, buf, n)) {
+            perror("CopyFile");
+            goto _bailout;
+        }
+    }
+    if (fsync(out) != 0) {
+        perror("fsync");
+        goto _bailout;
+    }
+    int close_error = GuardedClose(out);
+    out = -1;
+    if (close_error != 0) goto _bailout;
+    if (GuardedRename(tmp, dst) != 0) goto _bailout;
+    error = kNoError;
+
+_bailout:
+    if (in >= 0) close(in);
+    if (out >= 0) close(out);
+    if (error != kNoError && tmp != NULL) remove(tmp);
+    free(tmp);
+    free(buf);
+
+    return error;
+}
+
+static int MoveFile(ReadOnlyString src, ReadOnlyString dst) {
+    if (FileExists(dst)) {
+        fprintf(stderr,
+                "DbShardMapMoveTier: %s also exists in the destination shard "
+                "%s, skipping\n",
+                src, dst);
+        return kFileSystemError;
+    }
+    if (rename(src, dst) == 0) return kNoError;
+    if (errno != EXDEV) {
+        perror("rename");
+        return kFileSystemError;
+    }
+
+    // SRC and DST are on different file systems.
+    int error = CopyFile(src, dst);
+    if (error != kNoError) return error;
+
+    return GuardedRemove(src) == 0 ? kNoError : kFileSystemError;
+}
+
+static int MoveTierFromShard(DbShardMap *map, int from, int to,
+                             ReadOnlyString name, int64_t *num_moved) {
+    DbShardListing *listing = &map->listings[from];
+    if (!listing->initialized) {
+        int error = ListShard(listing, map->paths[from]);
+        if (error != kNoError) return error;
+    }
+
+    size_t length = strlen(name);
+    int ret = kNoError;
+    bool target_created = false;
+    for (int64_t i = LowerBound(listing, name); i < listing->size; ++i) {
+        ReadOnlyString file = listing->names[i];
+        if (strncmp(file, name, length) != 0) break;
+        if (file[length] != '\0' && file[length] != '.') continue;
+
+        if (!target_created) {
+            if (MkdirRecursive(map->paths[to]) != 0) return kFileSystemError;
+            target_created = true;
+        }
+        char *src = JoinPath(map->paths[from], file, "");
+        char *dst = JoinPath(map->paths[to], file, "");
+        int error = kMallocFailureError;
+        if (src != NULL && dst != NULL) error = MoveFile(src, dst);
+        free(src);
+        free(dst);
+        if (error == kMallocFailureError) return error;
+        if (error != kNoError) {
+            ret = error;
+        } else {
+            ++(*num_moved);
+        }
+    }
+
+    return ret;
+}
+
+int DbShardMapMoveTier(DbShardMap *map, Tier tier, GetTierNameFunc GetTierName,
+                       int64_t *num_moved) {
+    if (map->num_shards == 1) return kNoError;
+    if (map->listings == NULL) {
+        map->listings =
+            (DbShardListing *)calloc(map->num_shards, sizeof(DbShardListing));
+        if (map->listings == NULL) return kMallocFailureError;
+    }
+
+    char name[kDbFileNameLengthMax + 1];
+    if (GetTierName != NULL) {
+        int error = GetTierName(tier, name);
+        if (error != kNoError) return error;
+    } else {
+        sprintf(name, "%" PRITier, tier);
+    }
+
+    int target = DbShardMapGetIndex(map, tier);
+    int ret = kNoError;
+    for (int i = 0; i < map->num_shards; ++i) {
+        if (i == target) continue;
+        int error = MoveTierFromShard(map, i, target, name, num_moved);
+        if (error == kMallocFailureError) return error;
+        if (error != kNoError) ret = error;
+    }
+
+    return ret;
+}
+
+int DbShardMapListingContains(DbShardMap *map, Tier tier,
+                              ReadOnlyString file_name, bool *exists) {
+    int index = DbShardMapGetIndex(map, tier);
+    int error = kNoError;
+    PRAGMA_OMP_CRITICAL(db_shard_listing) {
+        if (map->listings == NULL) {
+            map->listings = (DbShardListing *)calloc(map->num_shards,
+                                                     sizeof(DbShardListing));
+        }
+        if (map->listings == NULL) {
+            error = kMallocFailureError;
+        } else if (!map->listings[index].initialized) {
+            error = ListShard(&map->listings[index], map->paths[index]);
+            if (error != kNoError) DestroyListing(&map->listings[index]);
+        }
+    }
+    if (error != kNoError) return error;
+
+    // Listings are never modified once initialized.
+    const DbShardListing *listing = &map->listings[index];
+    int64_t i = LowerBound(listing, file_name);
+    *exists = i < listing->size && strcmp(listing->names[i], file_name) == 0;
+
+    return kNoError;
+}
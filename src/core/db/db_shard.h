@@ -0,0 +1,150 @@
+/**
+ * @file db_shard.h
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Placement of tier files across multiple data roots.
+ * @details A data path may list several roots separated by ':', each optionally
+ * followed by '@' and a positive integer weight, e.g.
+ * "/nvme0/data:/nvme1/data:/scratch/data@4". Each tier is assigned to one root
+ * by weighted rendezvous hashing of its tier ID, so the assignment does not
+ * depend on the order in which tiers are created, and appending a root or
+ * raising the weight of a root only moves tiers onto that root. Roots are
+ * identified by their position in the list, which allows the same list to be
+ * mounted at different paths on different nodes as long as the order is kept.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAMESMANONE_CORE_DB_DB_SHARD_H_
+#define GAMESMANONE_CORE_DB_DB_SHARD_H_
+
+#include <stdbool.h>  // bool
+#include <stdint.h>   // int64_t
+
+#include "core/types/gamesman_types.h"
+
+enum {
+    kDbShardListSeparator = ':',   /**< Separator between roots in a list. */
+    kDbShardWeightSeparator = '@', /**< Separator before the weight. */
+    kDbShardWeightMax = 1024,      /**< Maximum weight of a single root. */
+};
+
+/** @brief Sorted names of the files found in a shard directory. */
+typedef struct DbShardListing {
+    char **names;      /**< File names in ascending strcmp order. */
+    int64_t size;      /**< Number of file names. */
+    bool initialized;  /**< Whether the directory has been listed. */
+} DbShardListing;
+
+/**
+ * @brief Mapping from tiers to the directories in which their files are
+ * stored. A map with a single shard stores every tier in that shard.
+ */
+typedef struct DbShardMap {
+    int num_shards; /**< Number of shards, at least 1. */
+    char **paths;   /**< Path to the directory of each shard. */
+    int *weights;   /**< Weight of each shard, see kDbShardWeightMax. */
+
+    /** Directory listings used by DbShardMapMoveTier, built on demand. */
+    DbShardListing *listings;
+} DbShardMap;
+
+/**
+ * @brief Initializes MAP from the shard list LIST and appends "/" followed by
+ * SUBDIR to the path of each shard if SUBDIR is not NULL.
+ *
+ * @param map Map to initialize.
+ * @param list List of paths separated by kDbShardListSeparator, each
+ * optionally followed by kDbShardWeightSeparator and a weight in range
+ * [1, kDbShardWeightMax]. Weights default to 1.
+ * @param subdir Subdirectory to append to each path, or NULL.
+ * @return kNoError on success,
+ * @return kIllegalArgumentError if LIST is malformed, or
+ * @return kMallocFailureError on malloc failure.
+ */
+int DbShardMapInit(DbShardMap *map, ReadOnlyString list,
+                   ReadOnlyString subdir);
+
+/** @brief Destroys MAP. */
+void DbShardMapDestroy(DbShardMap *map);
+
+/**
+ * @brief Returns a newly allocated shard list describing MAP, which can be
+ * passed to DbShardMapInit to rebuild an identical map. The user is
+ * responsible for freeing the string returned. Returns NULL on malloc failure.
+ */
+char *DbShardMapToString(const DbShardMap *map);
+
+/** @brief Returns the index of the shard in MAP that stores TIER. */
+int DbShardMapGetIndex(const DbShardMap *map, Tier tier);
+
+/** @brief Returns the path to the directory in MAP that stores TIER. */
+ReadOnlyString DbShardMapGetPath(const DbShardMap *map, Tier tier);
+
+/**
+ * @brief Returns the path to the primary (first) directory in MAP, which
+ * stores files that do not belong to any tier, such as finish flags.
+ */
+ReadOnlyString DbShardMapGetPrimaryPath(const DbShardMap *map);
+
+/**
+ * @brief Moves all files of TIER that are not in the shard assigned to TIER
+ * into that shard. A file belongs to TIER if its name is the name of TIER, or
+ * begins with the name of TIER followed by a '.'. Files are renamed when
+ * possible and copied otherwise, in which case the source file is removed
+ * only after the copy has been synced to disk.
+ *
+ * @note Not thread-safe. Each shard directory is listed once on first use and
+ * files added to the directory afterwards are not considered.
+ *
+ * @param map Shard map.
+ * @param tier Tier whose files are to be moved.
+ * @param GetTierName Function that returns the file name of a tier, or NULL
+ * if tiers are named by their IDs.
+ * @param num_moved Number of files moved is added to this counter.
+ * @return kNoError on success,
+ * @return kMallocFailureError on malloc failure, or
+ * @return kFileSystemError if a file cannot be moved, including when a file
+ * of the same name already exists in the destination shard.
+ */
+int DbShardMapMoveTier(DbShardMap *map, Tier tier, GetTierNameFunc GetTierName,
+                       int64_t *num_moved);
+
+/**
+ * @brief Sets EXISTS to whether a file named FILE_NAME was present in the
+ * shard assigned to TIER when that shard was first listed. Each shard
+ * directory is read at most once, so checking many tiers costs a single
+ * directory scan per shard instead of one file system lookup per tier.
+ *
+ * @note Thread-safe. Files added to or removed from the directory after it was
+ * listed are not reflected. The listing is shared with DbShardMapMoveTier.
+ *
+ * @param map Shard map.
+ * @param tier Tier whose shard is searched.
+ * @param file_name Name of the file, without the directory.
+ * @param exists (Output parameter) Whether the file was found.
+ * @return kNoError on success,
+ * @return kMallocFailureError on malloc failure, or
+ * @return kFileSystemError if the shard directory cannot be listed.
+ */
+int DbShardMapListingContains(DbShardMap *map, Tier tier,
+                              ReadOnlyString file_name, bool *exists);
+
+#endif  // GAMESMANONE_CORE_DB_DB_SHARD_H_
@@ -0,0 +1,275 @@
+/**
+ * @file db_tier_summary.c
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Implementation of tier summaries.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/db/db_tier_summary.h"
+
+#include <stdbool.h>  // bool, true, false
+#include <stddef.h>   // NULL, size_t
+#include <stdint.h>   // int64_t, uint64_t
+#include <stdio.h>    // FILE, fopen, fread, fseek, ftell, sprintf
+#include <stdlib.h>   // malloc, free
+#include <string.h>   // strlen
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // _OPENMP
+
+#include "core/concurrency.h"
+#include "core/constants.h"
+#include "core/misc.h"
+#include "core/types/gamesman_types.h"
+
+// File layout, all fields are 64-bit integers:
+//   magic, tier size,
+//   for each value: count, example, max remoteness,
+//   for each value and each remoteness up to its max: count, example.
+static const uint64_t kMagic = 0x31304d5553544d47;  // "GMTSUM01"
+enum {
+    kHeaderWords = 2 + 3 * kNumValues,
+    kFileWordsMax = kHeaderWords + 2 * kNumValues * kNumRemotenesses,
+};
+
+void DbTierSummaryInit(DbTierSummary *summary, int64_t size) {
+    summary->size = size;
+    for (int v = 0; v < kNumValues; ++v) {
+        summary->value_counts[v] = 0;
+        summary->value_examples[v] = -1;
+        summary->max_remoteness[v] = -1;
+        for (int r = 0; r < kNumRemotenesses; ++r) {
+            summary->remoteness_counts[v][r] = 0;
+            summary->remoteness_examples[v][r] = -1;
+        }
+    }
+}
+
+static void Count(DbTierSummary *summary, Position position, Value value,
+                  int remoteness) {
+    if (value < 0 || value >= kNumValues) return;
+    if (summary->value_counts[value]++ == 0) {
+        summary->value_examples[value] = position;
+    }
+    if (remoteness < 0 || remoteness > kRemotenessMax) return;
+    if (summary->remoteness_counts[value][remoteness]++ == 0) {
+        summary->remoteness_examples[value][remoteness] = position;
+    }
+    if (remoteness > summary->max_remoteness[value]) {
+        summary->max_remoteness[value] = remoteness;
+    }
+}
+
+static Position MinExample(Position a, Position b) {
+    if (a < 0) return b;
+    if (b < 0) return a;
+    return a < b ? a : b;
+}
+
+static void Merge(DbTierSummary *dest, const DbTierSummary *part) {
+    for (int v = 0; v < kNumValues; ++v) {
+        dest->value_counts[v] += part->value_counts[v];
+        dest->value_examples[v] =
+            MinExample(dest->value_examples[v], part->value_examples[v]);
+        if (part->max_remoteness[v] > dest->max_remoteness[v]) {
+            dest->max_remoteness[v] = part->max_remoteness[v];
+        }
+        for (int r = 0; r <= part->max_remoteness[v]; ++r) {
+            dest->remoteness_counts[v][r] += part->remoteness_counts[v][r];
+            dest->remoteness_examples[v][r] =
+                MinExample(dest->remoteness_examples[v][r],
+                           part->remoteness_examples[v][r]);
+        }
+    }
+}
+
+static int GetNumThreads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else   // _OPENMP not defined
+    return 1;
+#endif  // _OPENMP
+}
+
+int DbTierSummaryBuild(DbTierSummary *summary, int64_t size,
+                       DbTierSummaryGetRecordFunc GetRecordAt,
+                       const void *aux) {
+    DbTierSummaryInit(summary, size);
+    int num_threads = GetNumThreads();
+    DbTierSummary *parts =
+        (DbTierSummary *)malloc(num_threads * sizeof(DbTierSummary));
+    if (parts == NULL) return kMallocFailureError;
+
+    // Each thread summarizes a contiguous range of positions.
+    PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_STATIC
+    for (int t = 0; t < num_threads; ++t) {
+        DbTierSummaryInit(&parts[t], size);
+        int64_t chunk = size / num_threads;
+        int64_t begin = chunk * t;
+        int64_t end = (t == num_threads - 1) ? size : begin + chunk;
+        for (int64_t i = begin; i < end; ++i) {
+            Value value;
+            int remoteness;
+            GetRecordAt(i, aux, &value, &remoteness);
+            Count(&parts[t], i, value, remoteness);
+        }
+    }
+    for (int t = 0; t < num_threads; ++t) {
+        Merge(summary, &parts[t]);
+    }
+    free(parts);
+
+    return kNoError;
+}
+
+// Serializes SUMMARY into WORDS and returns the number of words used.
+static int64_t Pack(const DbTierSummary *summary, int64_t *words) {
+    int64_t n = 0;
+    words[n++] = (int64_t)kMagic;
+    words[n++] = summary->size;
+    for (int v = 0; v < kNumValues; ++v) {
+        words[n++] = summary->value_counts[v];
+        words[n++] = summary->value_examples[v];
+        words[n++] = summary->max_remoteness[v];
+    }
+    for (int v = 0; v < kNumValues; ++v) {
+        for (int r = 0; r <= summary->max_remoteness[v]; ++r) {
+            words[n++] = summary->remoteness_counts[v][r];
+            words[n++] = summary->remoteness_examples[v][r];
+        }
+    }
+
+    return n;
+}
+
+int DbTierSummaryWrite(const DbTierSummary *summary, ReadOnlyString full_path) {
+    int64_t *words = (int64_t *)malloc(kFileWordsMax * sizeof(int64_t));
+    char *tmp_path = (char *)malloc(strlen(full_path) + 5);
+    if (words == NULL || tmp_path == NULL) {
+        free(words);
+        free(tmp_path);
+        return kMallocFailureError;
+    }
+    int64_t num_words = Pack(summary, words);
+    sprintf(tmp_path, "%s.tmp", full_path);
+
+    int error = kNoError;
+    FILE *file = GuardedFopen(tmp_path, "wb");
+    if (file == NULL) {
+        error = kFileSystemError;
+    } else {
+        if (GuardedFwrite(words, sizeof(int64_t), num_words, file) != 0) {
+            error = kFileSystemError;
+        }
+        if (GuardedFclose(file) != 0) error = kFileSystemError;
+        if (error == kNoError && GuardedRename(tmp_path, full_path) != 0) {
+            error = kFileSystemError;
+        }
+    }
+    free(words);
+    free(tmp_path);
+
+    return error;
+}
+
+// Reads the entire summary file at FULL_PATH into WORDS, which must have space
+// for kFileWordsMax words, and returns the number of words read, or -1 if the
+// file cannot be read or is too large to be a summary file.
+static int64_t ReadWords(ReadOnlyString full_path, int64_t *words) {
+    FILE *file = fopen(full_path, "rb");
+    if (file == NULL) return -1;
+
+    // One extra word detects files that are too large.
+    size_t n = fread(words, sizeof(int64_t), kFileWordsMax, file);
+    int64_t extra;
+    bool too_large = (n == kFileWordsMax &&
+                      fread(&extra, sizeof(extra), 1, file) == 1);
+    bool failed = ferror(file);
+    fclose(file);
+    if (failed || too_large) return -1;
+
+    return (int64_t)n;
+}
+
+// Deserializes the NUM_WORDS words of a summary file into SUMMARY. Returns
+// false if the words do not form a valid summary of a tier of SIZE positions.
+static bool Unpack(DbTierSummary *summary, const int64_t *words,
+                   int64_t num_words, int64_t size) {
+    if (num_words < kHeaderWords) return false;
+    if ((uint64_t)words[0] != kMagic || words[1] != size) return false;
+
+    DbTierSummaryInit(summary, size);
+    int64_t n = 2;
+    int64_t expected = kHeaderWords;
+    for (int v = 0; v < kNumValues; ++v) {
+        summary->value_counts[v] = words[n++];
+        summary->value_examples[v] = words[n++];
+        int64_t max_remoteness = words[n++];
+        if (max_remoteness < -1 || max_remoteness > kRemotenessMax) {
+            return false;
+        }
+        summary->max_remoteness[v] = (int)max_remoteness;
+        expected += 2 * (max_remoteness + 1);
+    }
+    if (num_words != expected) return false;
+
+    for (int v = 0; v < kNumValues; ++v) {
+        for (int r = 0; r <= summary->max_remoteness[v]; ++r) {
+            summary->remoteness_counts[v][r] = words[n++];
+            summary->remoteness_examples[v][r] = words[n++];
+        }
+    }
+
+    return true;
+}
+
+int DbTierSummaryRead(DbTierSummary *summary, ReadOnlyString full_path,
+                      int64_t size) {
+    int64_t *words = (int64_t *)malloc(kFileWordsMax * sizeof(int64_t));
+    if (words == NULL) return kMallocFailureError;
+
+    int error = kNoError;
+    int64_t num_words = ReadWords(full_path, words);
+    if (num_words < 0) {
+        error = kFileSystemError;
+    } else if (!Unpack(summary, words, num_words, size)) {
+        error = kRuntimeError;
+    }
+    free(words);
+
+    return error;
+}
+
+int DbTierSummaryGetMaxRemoteness(const DbTierSummary *summary,
+                                  const Value *values, int num_values) {
+    int ret = -1;
+    for (int i = 0; i < num_values; ++i) {
+        Value value = values[i];
+        if (value < 0 || value >= kNumValues) continue;
+        if (summary->max_remoteness[value] > ret) {
+            ret = summary->max_remoteness[value];
+        }
+    }
+
+    return ret;
+}
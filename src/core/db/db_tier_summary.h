@@ -0,0 +1,127 @@
+/**
+ * @file db_tier_summary.h
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Summary of the records of a solved tier.
+ * @details A tier summary holds the number of positions of each value and
+ * remoteness in a tier, the largest remoteness of each value, and the first
+ * position of each value and remoteness as an example. Databases may store the
+ * summary of each tier next to the tier's records when the tier is flushed, so
+ * that tools that only need these statistics, such as the remoteness bounds
+ * used by the tier workers, do not have to load and scan the records. On disk,
+ * only the counts and examples up to the largest remoteness of each value are
+ * stored.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAMESMANONE_CORE_DB_DB_TIER_SUMMARY_H_
+#define GAMESMANONE_CORE_DB_DB_TIER_SUMMARY_H_
+
+#include <stdint.h>  // int64_t
+
+#include "core/constants.h"
+#include "core/types/gamesman_types.h"
+
+/**
+ * @brief Summary of the records of a solved tier.
+ * @warning This structure is large. Do NOT store DbTierSummary objects on
+ * stack. Instead, store them in static memory or on the heap.
+ */
+typedef struct DbTierSummary {
+    int64_t size; /**< Number of positions in the tier. */
+
+    /** Number of positions of each value, indexed by Value. */
+    int64_t value_counts[kNumValues];
+
+    /** Smallest position of each value, or -1 if there is none. */
+    Position value_examples[kNumValues];
+
+    /** Largest remoteness of each value, or -1 if no position of that value
+     * has a known remoteness, e.g., in value-only tiers. */
+    int max_remoteness[kNumValues];
+
+    /** Number of positions of each value and remoteness. Entries beyond the
+     * largest remoteness of each value are 0. */
+    int64_t remoteness_counts[kNumValues][kNumRemotenesses];
+
+    /** Smallest position of each value and remoteness, or -1 if there is
+     * none. */
+    Position remoteness_examples[kNumValues][kNumRemotenesses];
+} DbTierSummary;
+
+/**
+ * @brief Function that returns the value and remoteness of the I-th position
+ * of a tier. Remotenesses outside [0, kRemotenessMax], such as
+ * kUnknownRemoteness, are counted towards the value only.
+ */
+typedef void (*DbTierSummaryGetRecordFunc)(int64_t i, const void *aux,
+                                           Value *value, int *remoteness);
+
+/** @brief Initializes SUMMARY as the summary of an empty tier of SIZE
+ * positions. */
+void DbTierSummaryInit(DbTierSummary *summary, int64_t size);
+
+/**
+ * @brief Initializes SUMMARY as the summary of a tier of SIZE positions
+ * whose records are returned by GetRecordAt, using all available threads.
+ *
+ * @param summary Summary to build.
+ * @param size Number of positions in the tier.
+ * @param GetRecordAt Function that returns the record of each position.
+ * @param aux Auxiliary parameter passed to GetRecordAt.
+ * @return kNoError on success, or
+ * @return kMallocFailureError on malloc failure.
+ */
+int DbTierSummaryBuild(DbTierSummary *summary, int64_t size,
+                       DbTierSummaryGetRecordFunc GetRecordAt,
+                       const void *aux);
+
+/**
+ * @brief Writes SUMMARY to a temporary file and renames it to FULL_PATH, so
+ * that a summary file is either complete or absent.
+ *
+ * @return kNoError on success,
+ * @return kMallocFailureError on malloc failure, or
+ * @return kFileSystemError if the file cannot be written.
+ */
+int DbTierSummaryWrite(const DbTierSummary *summary, ReadOnlyString full_path);
+
+/**
+ * @brief Reads the summary file at FULL_PATH of a tier of SIZE positions into
+ * SUMMARY.
+ *
+ * @return kNoError on success,
+ * @return kMallocFailureError on malloc failure,
+ * @return kFileSystemError if the file does not exist or cannot be read, or
+ * @return kRuntimeError if the file is corrupted or does not summarize a tier
+ * of SIZE positions.
+ */
+int DbTierSummaryRead(DbTierSummary *summary, ReadOnlyString full_path,
+                      int64_t size);
+
+/**
+ * @brief Returns the largest remoteness of all positions in SUMMARY whose
+ * value is one of the NUM_VALUES values in VALUES, or -1 if there is none.
+ */
+int DbTierSummaryGetMaxRemoteness(const DbTierSummary *summary,
+                                  const Value *values, int num_values);
+
+#endif  // GAMESMANONE_CORE_DB_DB_TIER_SUMMARY_H_
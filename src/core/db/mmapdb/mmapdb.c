@@ -0,0 +1,666 @@
+/**
+ * @file mmapdb.c
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Implementation of the memory-mapped serving database.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/db/mmapdb/mmapdb.h"
+
+#include <assert.h>     // assert
+#include <fcntl.h>      // open, O_RDONLY
+#include <stdbool.h>    // bool, true, false
+#include <stddef.h>     // NULL, size_t
+#include <stdint.h>     // intptr_t, uint8_t, uint64_t, int64_t
+#include <stdio.h>      // fprintf, stderr
+#include <stdlib.h>     // malloc, calloc, free
+#include <string.h>     // strcpy, strcat, memcpy, memset
+#include <sys/mman.h>   // mmap, munmap, madvise
+#include <sys/stat.h>   // fstat, struct stat
+#include <unistd.h>     // close
+
+#include "core/constants.h"
+#include "core/db/arraydb/record.h"
+#include "core/db/arraydb/record_array.h"
+#include "core/db/db_block_cache.h"
+#include "core/db/db_file_pool.h"
+#include "core/db/db_shard.h"
+#include "core/misc.h"
+#include "core/types/gamesman_types.h"
+
+// DB API
+
+static int MmapDbInit(ReadOnlyString game_name, int variant,
+                      ReadOnlyString path, GetTierNameFunc GetTierName,
+                      void *aux);
+static void MmapDbFinalize(void);
+
+static int MmapDbCreateSolvingTier(Tier tier, int64_t size);
+static int MmapDbFlushSolvingTier(void *aux);
+static int MmapDbFreeSolvingTier(void);
+
+static int MmapDbSetGameSolved(void);
+static int MmapDbSetValue(Position position, Value value);
+static int MmapDbSetRemoteness(Position position, int remoteness);
+static int MmapDbReserveRemoteness(int remoteness);
+static Value MmapDbGetValue(Position position);
+static int MmapDbGetRemoteness(Position position);
+
+static intptr_t MmapDbTierMemUsage(Tier tier, int64_t size);
+static int MmapDbLoadTier(Tier tier, int64_t size);
+static int MmapDbUnloadTier(Tier tier);
+static bool MmapDbIsTierLoaded(Tier tier);
+static Value MmapDbGetValueFromLoaded(Tier tier, Position position);
+static int MmapDbGetRemotenessFromLoaded(Tier tier, Position position);
+
+static int MmapDbProbeInit(DbProbe *probe);
+static int MmapDbProbeDestroy(DbProbe *probe);
+static Value MmapDbProbeValue(DbProbe *probe, TierPosition tier_position);
+static int MmapDbProbeRemoteness(DbProbe *probe, TierPosition tier_position);
+static int MmapDbTierStatus(Tier tier);
+static int MmapDbGameStatus(void);
+
+const Database kMmapDb = {
+    .name = "mmapdb",
+    .formal_name = "Memory-Mapped Database",
+
+    .Init = MmapDbInit,
+    .Finalize = MmapDbFinalize,
+
+    // Solving
+    .CreateSolvingTier = MmapDbCreateSolvingTier,
+    .FlushSolvingTier = MmapDbFlushSolvingTier,
+    .FreeSolvingTier = MmapDbFreeSolvingTier,
+
+    .SetGameSolved = MmapDbSetGameSolved,
+    .SetValue = MmapDbSetValue,
+    .SetRemoteness = MmapDbSetRemoteness,
+    .ReserveRemoteness = MmapDbReserveRemoteness,
+    .GetValue = MmapDbGetValue,
+    .GetRemoteness = MmapDbGetRemoteness,
+
+    // Loading
+    .TierMemUsage = MmapDbTierMemUsage,
+    .LoadTier = MmapDbLoadTier,
+    .UnloadTier = MmapDbUnloadTier,
+    .IsTierLoaded = MmapDbIsTierLoaded,
+    .GetValueFromLoaded = MmapDbGetValueFromLoaded,
+    .GetRemotenessFromLoaded = MmapDbGetRemotenessFromLoaded,
+
+    // Probing
+    .ProbeInit = MmapDbProbeInit,
+    .ProbeDestroy = MmapDbProbeDestroy,
+    .ProbeValue = MmapDbProbeValue,
+    .ProbeRemoteness = MmapDbProbeRemoteness,
+    .TierStatus = MmapDbTierStatus,
+    .GameStatus = MmapDbGameStatus,
+};
+
+// Types
+
+// Tier file mapped into memory for reading. Never modified after opening, so
+// the same file may be read by multiple threads at once.
+typedef struct {
+    const uint8_t *data;  // Read-only mapping of the entire file.
+    int64_t size;         // Size of the file in bytes.
+    int format;           // RecordArrayFormat of the file.
+} MdbFile;
+
+// Mapped file acquired from the process-wide file pool and kept by a probe.
+typedef struct {
+    Tier tier;                  // Tier of the file, or kIllegalTier if unused.
+    const DbPooledFile *file;   // Pooled MdbFile.
+    int64_t last_used;  // Value of the probe clock at the most recent access.
+} MdbProbeFile;
+
+typedef struct {
+    // Least-recently-used set of mapped files.
+    MdbProbeFile *files;
+    int num_files;
+    int64_t clock;
+} MdbProbeInternal;
+
+// Constants
+
+enum { kMmapDbNumLoadedTiersMax = 256 };
+const MmapDbOptions kMmapDbOptionsInit = {
+    .value_only = false,     // Store remotenesses.
+    .probe_cache_files = 8,  // 8 mapped files per probe.
+};
+static ConstantReadOnlyString kFileExtension = ".mdb";
+
+// Global options
+
+static bool value_only;  // Format of new solving tiers.
+static int probe_cache_files;
+
+// Global state variables
+
+static DbShardMap shards;  // Directories that store the tier files.
+static GetTierNameFunc CurrentGetTierName;
+static int64_t pool_source;  // Source ID in the process-wide file pool.
+static Tier current_tier;
+static RecordArray solving_records;
+static TierHashMapSC loaded_tier_to_index;
+static const DbPooledFile *loaded_files[kMmapDbNumLoadedTiersMax];
+
+static int MmapDbInit(ReadOnlyString game_name, int variant,
+                      ReadOnlyString path, GetTierNameFunc GetTierName,
+                      void *aux) {
+    (void)game_name;  // Unused.
+    (void)variant;    // Unused.
+    const MmapDbOptions *options = (const MmapDbOptions *)aux;
+    if (options == NULL) options = &kMmapDbOptionsInit;
+    value_only = options->value_only;
+    probe_cache_files = options->probe_cache_files;
+    if (probe_cache_files < 1) probe_cache_files = 1;
+
+    pool_source = DbBlockCacheNewSource();
+
+    assert(shards.paths == NULL);
+    int error = DbShardMapInit(&shards, path, NULL);
+    if (error != kNoError) {
+        fprintf(stderr, "MmapDbInit: failed to parse path.\n");
+        return error;
+    }
+
+    CurrentGetTierName = GetTierName;
+    current_tier = kIllegalTier;
+    memset(&solving_records, 0, sizeof(solving_records));
+    TierHashMapSCInit(&loaded_tier_to_index, 0.5);
+    memset(loaded_files, 0, sizeof(loaded_files));
+
+    return kNoError;
+}
+
+static void MmapDbFinalize(void) {
+    for (int i = 0; i < kMmapDbNumLoadedTiersMax; ++i) {
+        DbFilePoolRelease(loaded_files[i]);
+        loaded_files[i] = NULL;
+    }
+    TierHashMapSCDestroy(&loaded_tier_to_index);
+    RecordArrayDestroy(&solving_records);
+    current_tier = kIllegalTier;
+    DbShardMapDestroy(&shards);
+}
+
+static int MmapDbCreateSolvingTier(Tier tier, int64_t size) {
+    if (current_tier != kIllegalTier) {
+        fprintf(stderr,
+                "MmapDbCreateSolvingTier: failed to create solving tier due "
+                "to an existing solving tier\n");
+        return kRuntimeError;
+    }
+
+    int format =
+        value_only ? kRecordArrayFormatValueOnly : kRecordArrayFormatNarrow;
+    int error = RecordArrayInitFormat(&solving_records, size, format);
+    if (error != kNoError) return error;
+
+    current_tier = tier;
+    return kNoError;
+}
+
+/**
+ * @brief Returns the full path to the DB file for the given tier with the
+ * given EXTENSION appended. The user is responsible for freeing the pointer
+ * returned by this function. Returns NULL on failure.
+ */
+static char *GetFullPathWithExtension(Tier tier, ReadOnlyString extension) {
+    // Full path: "<path>/<file_name>.mdb<ext>", +2 for '/' and '\0'.
+    ReadOnlyString sandbox_path = DbShardMapGetPath(&shards, tier);
+    char *full_path = (char *)calloc(
+        (strlen(sandbox_path) + kDbFileNameLengthMax + strlen(kFileExtension) +
+         strlen(extension) + 2),
+        sizeof(char));
+    if (full_path == NULL) {
+        fprintf(stderr,
+                "GetFullPathWithExtension: failed to calloc full_path.\n");
+        return NULL;
+    }
+
+    int count = sprintf(full_path, "%s/", sandbox_path);
+    if (CurrentGetTierName != NULL) {
+        CurrentGetTierName(tier, full_path + count);
+    } else {
+        sprintf(full_path + count, "%" PRITier, tier);
+    }
+    strcat(full_path, kFileExtension);
+    strcat(full_path, extension);
+
+    return full_path;
+}
+
+static char *GetFullPathToFile(Tier tier) {
+    return GetFullPathWithExtension(tier, "");
+}
+
+static char *GetFullPathToTempFile(Tier tier) {
+    return GetFullPathWithExtension(tier, ".tmp");
+}
+
+static char *GetFullPathToFinishFlag(void) {
+    // Full path: "<path>/.finish", +2 for '/' and '\0'.
+    static const char finish_flag_name[] = ".finish";
+    ReadOnlyString sandbox_path = DbShardMapGetPrimaryPath(&shards);
+    char *full_path = (char *)calloc(
+        (strlen(sandbox_path) + sizeof(finish_flag_name) + 2), sizeof(char));
+    if (full_path == NULL) {
+        fprintf(stderr,
+                "GetFullPathToFinishFlag: failed to calloc full_path.\n");
+        return NULL;
+    }
+
+    sprintf(full_path, "%s/%s", sandbox_path, finish_flag_name);
+    return full_path;
+}
+
+// Writes the raw bytes of RECORDS into the file at FULL_PATH.
+static int WriteRecords(ReadOnlyString full_path, const RecordArray *records) {
+    FILE *file = GuardedFopen(full_path, "wb");
+    if (file == NULL) return kFileSystemError;
+
+    int error = GuardedFwrite(RecordArrayGetReadOnlyData(records), 1,
+                              (size_t)RecordArrayGetRawSize(records), file);
+    if (error != 0) {
+        GuardedFclose(file);
+        return kFileSystemError;
+    }
+
+    error = GuardedFclose(file);
+    if (error != 0) return kFileSystemError;
+
+    return kNoError;
+}
+
+static int MmapDbFlushSolvingTier(void *aux) {
+    (void)aux;  // Unused.
+    int error = kNoError;
+    char *full_path = GetFullPathToFile(current_tier);
+    char *tmp_full_path = GetFullPathToTempFile(current_tier);
+    if (full_path == NULL || tmp_full_path == NULL) {
+        error = kMallocFailureError;
+        goto _bailout;
+    }
+
+    // Write to a temp file first so that a tier file is never partially
+    // written, then rename it into the desired tier DB name.
+    error = WriteRecords(tmp_full_path, &solving_records);
+    if (error != kNoError) goto _bailout;
+    if (GuardedRename(tmp_full_path, full_path) != 0) {
+        error = kFileSystemError;
+        goto _bailout;
+    }
+
+    // Probes and loaded tiers keep mapping the old file until released.
+    DbFilePoolInvalidate(pool_source, current_tier);
+
+_bailout:
+    free(full_path);
+    free(tmp_full_path);
+
+    return error;
+}
+
+static int MmapDbFreeSolvingTier(void) {
+    RecordArrayDestroy(&solving_records);
+    current_tier = kIllegalTier;
+
+    return kNoError;
+}
+
+static int MmapDbSetGameSolved(void) {
+    char *flag_filename = GetFullPathToFinishFlag();
+    if (flag_filename == NULL) return kMallocFailureError;
+
+    FILE *flag_file = GuardedFopen(flag_filename, "w");
+    free(flag_filename);
+    if (flag_file == NULL) return kFileSystemError;
+
+    int error = GuardedFclose(flag_file);
+    if (error != 0) return kFileSystemError;
+
+    return kNoError;
+}
+
+static int MmapDbSetValue(Position position, Value value) {
+    RecordArraySetValue(&solving_records, position, value);
+
+    return kNoError;
+}
+
+static int MmapDbSetRemoteness(Position position, int remoteness) {
+    return RecordArraySetRemoteness(&solving_records, position, remoteness);
+}
+
+static int MmapDbReserveRemoteness(int remoteness) {
+    return RecordArrayReserveRemoteness(&solving_records, remoteness);
+}
+
+static Value MmapDbGetValue(Position position) {
+    return RecordArrayGetValue(&solving_records, position);
+}
+
+static int MmapDbGetRemoteness(Position position) {
+    return RecordArrayGetRemoteness(&solving_records, position);
+}
+
+static intptr_t MmapDbTierMemUsage(Tier tier, int64_t size) {
+    (void)tier;
+    if (value_only) {
+        return (intptr_t)RecordArrayGetFormatRawSize(
+            kRecordArrayFormatValueOnly, size);
+    }
+
+    // Upper bound: the tier may have been stored with 16-bit records.
+    return (intptr_t)RecordArrayGetFormatRawSize(kRecordArrayFormatWide, size);
+}
+
+// Maps the DB file of TIER into memory. Returns NULL if the file does not
+// exist or cannot be mapped.
+static MdbFile *MdbFileOpen(Tier tier) {
+    char *full_path = GetFullPathToFile(tier);
+    if (full_path == NULL) return NULL;
+
+    // Not using GuardedOpen as missing tiers are reported by the caller.
+    int fd = open(full_path, O_RDONLY);
+    free(full_path);
+    if (fd < 0) return NULL;
+
+    MdbFile *file = NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) goto _bailout;
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) goto _bailout;
+
+    // Probes touch a few records at random; reading ahead only wastes memory.
+    madvise(data, (size_t)st.st_size, MADV_RANDOM);
+    int format = RecordArrayGetFormatFromPrefix(data, (size_t)st.st_size);
+    file = (MdbFile *)malloc(sizeof(MdbFile));
+    if (format < 0 || file == NULL) {
+        munmap(data, (size_t)st.st_size);
+        free(file);
+        file = NULL;
+        goto _bailout;
+    }
+    file->data = (const uint8_t *)data;
+    file->size = (int64_t)st.st_size;
+    file->format = format;
+
+_bailout:
+    GuardedClose(fd);
+    return file;
+}
+
+static void MdbFileClose(MdbFile *file) {
+    if (file == NULL) return;
+    munmap((void *)file->data, (size_t)file->size);
+    free(file);
+}
+
+// Reads the chunk of FILE that holds the record of POSITION into CHUNK directly
+// from the mapping. See RecordArrayGetChunkOffset for details. Returns false
+// if POSITION is out of the bounds of FILE.
+static bool MdbFileGetChunk(const MdbFile *file, Position position,
+                            uint64_t *chunk) {
+    int64_t offset = RecordArrayGetChunkOffset(file->format, position);
+    int size = RecordArrayGetChunkSize(file->format);
+    if (position < 0 || offset + size > file->size) return false;
+
+    const uint8_t *src = file->data + offset;
+    switch (file->format) {
+        case kRecordArrayFormatNarrow:
+            *chunk = *src;
+            break;
+
+        case kRecordArrayFormatValueOnly: {
+            uint64_t word;
+            memcpy(&word, src, sizeof(word));
+            *chunk = word;
+            break;
+        }
+
+        default: {
+            Record rec;
+            memcpy(&rec, src, sizeof(rec));
+            *chunk = rec;
+            break;
+        }
+    }
+
+    return true;
+}
+
+static void *PooledFileOpen(void *aux) {
+    return MdbFileOpen(*(const Tier *)aux);
+}
+
+static void PooledFileClose(void *handle) { MdbFileClose((MdbFile *)handle); }
+
+static const DbPooledFile *AcquireFile(Tier tier) {
+    return DbFilePoolAcquire(pool_source, tier, PooledFileOpen,
+                             PooledFileClose, &tier);
+}
+
+static const MdbFile *GetMdbFile(const DbPooledFile *file) {
+    return (const MdbFile *)file->handle;
+}
+
+static int GetFirstUnusedLoadedIndex(void) {
+    int i;
+    for (i = 0; i < kMmapDbNumLoadedTiersMax; ++i) {
+        if (loaded_files[i] == NULL) break;
+    }
+
+    return i;
+}
+
+static int MmapDbLoadTier(Tier tier, int64_t size) {
+    // Loaded tiers are mapped, not copied. Holding on to the pooled file keeps
+    // the mapping alive until the tier is unloaded.
+    int i = GetFirstUnusedLoadedIndex();
+    if (i == kMmapDbNumLoadedTiersMax) {
+        fprintf(stderr,
+                "MmapDbLoadTier: cannot load more than %d tiers at the same "
+                "time\n",
+                kMmapDbNumLoadedTiersMax);
+        return kRuntimeError;
+    }
+
+    const DbPooledFile *file = AcquireFile(tier);
+    if (file == NULL) return kFileSystemError;
+    const MdbFile *mdb_file = GetMdbFile(file);
+    if (mdb_file->size <
+        RecordArrayGetFormatRawSize(mdb_file->format, size)) {
+        fprintf(stderr,
+                "MmapDbLoadTier: file of tier %" PRITier " is truncated\n",
+                tier);
+        DbFilePoolRelease(file);
+        return kRuntimeError;
+    }
+
+    if (!TierHashMapSCSet(&loaded_tier_to_index, tier, i)) {
+        DbFilePoolRelease(file);
+        return kMallocFailureError;
+    }
+    loaded_files[i] = file;
+
+    return kNoError;
+}
+
+static int GetLoadedTierIndex(Tier tier) {
+    int64_t index;
+    if (!TierHashMapSCGet(&loaded_tier_to_index, tier, &index)) return -1;
+
+    assert(index >= 0 && index < kMmapDbNumLoadedTiersMax);
+    return (int)index;
+}
+
+static int MmapDbUnloadTier(Tier tier) {
+    int index = GetLoadedTierIndex(tier);
+    if (index < 0) return kRuntimeError;
+
+    DbFilePoolRelease(loaded_files[index]);
+    loaded_files[index] = NULL;
+    TierHashMapSCRemove(&loaded_tier_to_index, tier);
+
+    return kNoError;
+}
+
+static bool MmapDbIsTierLoaded(Tier tier) {
+    return GetLoadedTierIndex(tier) >= 0;
+}
+
+static Value MmapDbGetValueFromLoaded(Tier tier, Position position) {
+    int index = GetLoadedTierIndex(tier);
+    if (index < 0) return kErrorValue;
+
+    const MdbFile *file = GetMdbFile(loaded_files[index]);
+    uint64_t chunk;
+    if (!MdbFileGetChunk(file, position, &chunk)) return kErrorValue;
+
+    return RecordArrayGetValueFromChunk(file->format, chunk, position);
+}
+
+static int MmapDbGetRemotenessFromLoaded(Tier tier, Position position) {
+    int index = GetLoadedTierIndex(tier);
+    if (index < 0) return -1;
+
+    const MdbFile *file = GetMdbFile(loaded_files[index]);
+    uint64_t chunk;
+    if (!MdbFileGetChunk(file, position, &chunk)) return -1;
+
+    return RecordArrayGetRemotenessFromChunk(file->format, chunk, position);
+}
+
+static int MmapDbProbeInit(DbProbe *probe) {
+    MdbProbeInternal *probe_internal =
+        (MdbProbeInternal *)calloc(1, sizeof(MdbProbeInternal));
+    if (probe_internal == NULL) return kMallocFailureError;
+
+    probe_internal->files =
+        (MdbProbeFile *)calloc(probe_cache_files, sizeof(MdbProbeFile));
+    if (probe_internal->files == NULL) {
+        free(probe_internal);
+        return kMallocFailureError;
+    }
+    probe_internal->num_files = probe_cache_files;
+    for (int i = 0; i < probe_internal->num_files; ++i) {
+        probe_internal->files[i].tier = kIllegalTier;
+    }
+
+    probe->buffer = probe_internal;
+    probe->tier = kIllegalTier;
+    // probe->begin and probe->size are unused.
+
+    return kNoError;
+}
+
+static int MmapDbProbeDestroy(DbProbe *probe) {
+    MdbProbeInternal *probe_internal = (MdbProbeInternal *)probe->buffer;
+    for (int i = 0; i < probe_internal->num_files; ++i) {
+        DbFilePoolRelease(probe_internal->files[i].file);
+    }
+    free(probe_internal->files);
+    free(probe->buffer);
+    memset(probe, 0, sizeof(*probe));
+
+    return kNoError;
+}
+
+// Returns the mapped file of TIER, acquiring it from the process-wide file pool
+// into the least recently used entry if the probe does not keep it. Returns
+// NULL on failure.
+static const MdbFile *ProbeGetFile(DbProbe *probe, Tier tier) {
+    MdbProbeInternal *probe_internal = (MdbProbeInternal *)probe->buffer;
+    MdbProbeFile *victim = &probe_internal->files[0];
+    for (int i = 0; i < probe_internal->num_files; ++i) {
+        MdbProbeFile *entry = &probe_internal->files[i];
+        if (entry->tier == tier) {
+            entry->last_used = ++probe_internal->clock;
+            return GetMdbFile(entry->file);
+        }
+        if (entry->last_used < victim->last_used) victim = entry;
+    }
+
+    DbFilePoolRelease(victim->file);
+    victim->tier = kIllegalTier;
+    victim->file = AcquireFile(tier);
+    if (victim->file == NULL) return NULL;
+
+    victim->tier = tier;
+    victim->last_used = ++probe_internal->clock;
+    probe->tier = tier;
+
+    return GetMdbFile(victim->file);
+}
+
+static Value MmapDbProbeValue(DbProbe *probe, TierPosition tier_position) {
+    const MdbFile *file = ProbeGetFile(probe, tier_position.tier);
+    uint64_t chunk;
+    if (file == NULL ||
+        !MdbFileGetChunk(file, tier_position.position, &chunk)) {
+        fprintf(stderr,
+                "MmapDbProbeValue: failed to read tier %" PRITier "\n",
+                tier_position.tier);
+        return kErrorValue;
+    }
+
+    return RecordArrayGetValueFromChunk(file->format, chunk,
+                                        tier_position.position);
+}
+
+static int MmapDbProbeRemoteness(DbProbe *probe, TierPosition tier_position) {
+    const MdbFile *file = ProbeGetFile(probe, tier_position.tier);
+    uint64_t chunk;
+    if (file == NULL ||
+        !MdbFileGetChunk(file, tier_position.position, &chunk)) {
+        fprintf(stderr,
+                "MmapDbProbeRemoteness: failed to read tier %" PRITier "\n",
+                tier_position.tier);
+        return kErrorRemoteness;
+    }
+
+    return RecordArrayGetRemotenessFromChunk(file->format, chunk,
+                                             tier_position.position);
+}
+
+static int MmapDbTierStatus(Tier tier) {
+    char *full_path = GetFullPathToFile(tier);
+    if (full_path == NULL) return kDbTierStatusCheckError;
+
+    bool exists = FileExists(full_path);
+    free(full_path);
+
+    return exists ? kDbTierStatusSolved : kDbTierStatusMissing;
+}
+
+static int MmapDbGameStatus(void) {
+    char *full_path = GetFullPathToFinishFlag();
+    if (full_path == NULL) return kDbGameStatusCheckError;
+
+    bool exists = FileExists(full_path);
+    free(full_path);
+
+    return exists ? kDbGameStatusSolved : kDbGameStatusIncomplete;
+}
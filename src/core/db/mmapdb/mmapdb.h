@@ -0,0 +1,70 @@
+/**
+ * @file mmapdb.h
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Serving database which stores each tier as an uncompressed record
+ * file and probes it through memory mapping.
+ * @details Each tier is stored as the raw bytes of a RecordArray in any of its
+ * formats (16-bit, 8-bit, or 3-bit value-only records), so that the record of
+ * any position is at a fixed offset in the file. Probes map the file into
+ * memory and read records directly from the mapping without decompressing or
+ * copying any block, relying on the page cache to keep hot positions in memory.
+ * The database trades disk space for query latency and is meant to be created
+ * from a solved game by converting its existing database.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAMESMANONE_CORE_DB_MMAPDB_MMAPDB_H_
+#define GAMESMANONE_CORE_DB_MMAPDB_MMAPDB_H_
+
+#include "core/types/gamesman_types.h"
+
+/**
+ * @brief Memory-mapped database which stores each tier as an uncompressed
+ * record array and serves probes directly from the page cache.
+ */
+extern const Database kMmapDb;
+
+/**
+ * @brief MmapDb options. Pass a pointer to an instance of this type to the
+ * initialization function (kMmapDb::Init) to use custom settings, or pass
+ * \c NULL for default options.
+ */
+typedef struct MmapDbOptions {
+    /** Set this to 1 to create tiers in value-only format, which stores 3 bits
+     * per position and discards remotenesses. Default: 0. */
+    int value_only;
+
+    /** Number of mapped tier files kept by each probe. Files are acquired
+     * from the process-wide file pool (see db_file_pool.h) and the probe keeps
+     * the most recently used ones so that alternating between a parent tier
+     * and its child tiers does not go back to the pool on every switch. Values
+     * smaller than 1 are treated as 1. Default: 8. */
+    int probe_cache_files;
+} MmapDbOptions;
+
+/**
+ * @brief Default \c MmapDbOptions for convenient initialization of
+ * MmapDbOptions instances.
+ */
+extern const MmapDbOptions kMmapDbOptionsInit;
+
+#endif  // GAMESMANONE_CORE_DB_MMAPDB_MMAPDB_H_
@@ -34,6 +34,7 @@
 #include <string.h>  // strcpy, memset
 
 #include "core/constants.h"
+#include "core/db/db_shard.h"
 #include "core/misc.h"
 #include "core/types/gamesman_types.h"
 
@@ -120,7 +121,7 @@ static const int kBufferSize = (1 << 17) * sizeof(NaiveDbEntry);
 static char current_game_name[kGameNameLengthMax + 1];
 static int current_variant;
 static GetTierNameFunc CurrentGetTierName;
-static char *sandbox_path;
+static DbShardMap shards;  // Directories that store the tier files.
 static Tier current_tier;
 static int64_t current_tier_size;
 static NaiveDbEntry *records;
@@ -134,6 +135,7 @@ static NaiveDbEntry *loaded_records[kNaiveDbNumLoadedTiersMax];
  */
 static char *GetFullPathToFile(Tier tier, GetTierNameFunc GetTierName) {
     // Full path: "<path>/<file_name>", +2 for '/' and '\0'.
+    ReadOnlyString sandbox_path = DbShardMapGetPath(&shards, tier);
     char *full_path = (char *)calloc(
         (strlen(sandbox_path) + kDbFileNameLengthMax + 2), sizeof(char));
     if (full_path == NULL) {
@@ -154,6 +156,7 @@ static char *GetFullPathToFile(Tier tier, GetTierNameFunc GetTierName) {
 static char *GetFullPathToFinishFlag(void) {
     // Full path: "<path>/.finish", +2 for '/' and '\0'.
     ConstantReadOnlyString kFinishFlagFilename = ".finish";
+    ReadOnlyString sandbox_path = DbShardMapGetPrimaryPath(&shards);
     char *full_path = (char *)calloc(
         (strlen(sandbox_path) + strlen(kFinishFlagFilename) + 2), sizeof(char));
     if (full_path == NULL) {
@@ -204,14 +207,12 @@ static int NaiveDbInit(ReadOnlyString game_name, int variant,
                        ReadOnlyString path, GetTierNameFunc GetTierName,
                        void *aux) {
     (void)aux;  // Unused.
-    assert(sandbox_path == NULL);
-
-    sandbox_path = (char *)malloc((strlen(path) + 1) * sizeof(char));
-    if (sandbox_path == NULL) {
-        fprintf(stderr, "NaiveDbInit: failed to malloc path.\n");
-        return kMallocFailureError;
+    assert(shards.paths == NULL);
+    int error = DbShardMapInit(&shards, path, NULL);
+    if (error != kNoError) {
+        fprintf(stderr, "NaiveDbInit: failed to parse path.\n");
+        return error;
     }
-    strcpy(sandbox_path, path);
 
     SafeStrncpy(current_game_name, game_name, kGameNameLengthMax + 1);
     current_game_name[kGameNameLengthMax] = '\0';
@@ -227,8 +228,7 @@ static int NaiveDbInit(ReadOnlyString game_name, int variant,
 }
 
 static void NaiveDbFinalize(void) {
-    free(sandbox_path);
-    sandbox_path = NULL;
+    DbShardMapDestroy(&shards);
     free(records);
     records = NULL;
     TierHashMapSCDestroy(&loaded_tier_to_index);
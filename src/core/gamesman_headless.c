@@ -28,12 +28,14 @@
 
 #include <stdbool.h>  // bool
 #include <stdint.h>   // intptr_t,
-#include <stdlib.h>   // atoi
+#include <stdlib.h>   // atoi, strtod
+#include <string.h>   // strrchr
 #ifdef USE_MPI
 #include <mpi.h>
 #endif  // USE_MPI
 
 #include "core/headless/hanalyze.h"
+#include "core/headless/hconvert.h"
 #include "core/headless/hparser.h"
 #include "core/headless/hquery.h"
 #include "core/headless/hsolve.h"
@@ -42,13 +44,32 @@
 #include "core/types/gamesman_types.h"
 
 /**
- * @brief Convert the input memory limit string \p str, which is in GiB, into
- * an integer memory limit, which is in bytes.
+ * @brief Convert the input memory limit string \p str, which is in GiB and
+ * may be fractional, into an integer memory limit, which is in bytes.
  */
 static intptr_t ParseMemLimit(ReadOnlyString str) {
     if (str == NULL || *str == '\0') return 0;
 
-    return (intptr_t)atoi(str) << 30;
+    return (intptr_t)(strtod(str, NULL) * (1 << 30));
+}
+
+/**
+ * @brief Splits the input out-of-core option string \p str of the form
+ * PATH[@BUDGET] in place into the directory, which is returned, and the
+ * resident budget in GiB, which is converted into bytes and stored in
+ * \p budget. The budget defaults to 1 GiB if not specified.
+ */
+static char *ParseOutOfCore(char *str, intptr_t *budget) {
+    *budget = (intptr_t)1 << 30;
+    if (str == NULL || *str == '\0') return NULL;
+
+    char *at = strrchr(str, '@');
+    if (at != NULL) {
+        *at = '\0';
+        *budget = ParseMemLimit(at + 1);
+    }
+
+    return str;
 }
 
 int GamesmanHeadlessMain(int argc, char **argv) {
@@ -71,20 +92,32 @@ int GamesmanHeadlessMain(int argc, char **argv) {
     HeadlessArguments arguments = HeadlessParseArguments(argc, argv);
     char *game = arguments.game;
     char *data_path = arguments.data_path;
-    intptr_t memlimit = ParseMemLimit(arguments.memlimit);
     bool force = arguments.force;
     char *position = arguments.position;
     int verbose = HeadlessGetVerbosity(arguments.verbose, arguments.quiet);
     int variant_id =
         arguments.variant_id != NULL ? atoi(arguments.variant_id) : -1;
 
+    HeadlessSolveOptions solve_options = kHeadlessSolveOptionsInit;
+    solve_options.force = force;
+    solve_options.verbose = verbose;
+    solve_options.memlimit = ParseMemLimit(arguments.memlimit);
+    solve_options.sort_frontiers = arguments.sort_frontiers;
+    solve_options.frontier_spill = ParseMemLimit(arguments.spill);
+    solve_options.lazy_children = arguments.lazy_children;
+    solve_options.value_only = arguments.value_only;
+    solve_options.lz4 = arguments.lz4;
+    solve_options.out_of_core_dir = ParseOutOfCore(
+        arguments.out_of_core, &solve_options.out_of_core_budget);
+    solve_options.compressed_children = arguments.compressed;
+    solve_options.numa = arguments.numa;
+
     int error = HeadlessRedirectOutput(arguments.output);
     if (error != 0) return error;
 
     switch (arguments.action) {
         case kHeadlessSolve:
-            error = HeadlessSolve(game, variant_id, data_path, force, verbose,
-                                  memlimit);
+            error = HeadlessSolve(game, variant_id, data_path, &solve_options);
             break;
         case kHeadlessAnalyze:
             error =
@@ -99,6 +132,17 @@ int GamesmanHeadlessMain(int argc, char **argv) {
         case kHeadlessGetRandom:
             error = HeadlessGetRandom(game, variant_id);
             break;
+        case kHeadlessExport:
+            error = HeadlessExport(game, variant_id, data_path, force, verbose,
+                                   arguments.value_only);
+            break;
+        case kHeadlessCompact:
+            error = HeadlessCompact(game, variant_id, data_path, force,
+                                    verbose, arguments.archive);
+            break;
+        case kHeadlessRebalance:
+            error = HeadlessRebalance(game, variant_id, data_path, verbose);
+            break;
         default:
             fprintf(stderr, "GamesmanHeadlessMain: unknown action\n");
             error = kNotReachedError;
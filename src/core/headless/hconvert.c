@@ -0,0 +1,126 @@
+/**
+ * @file hconvert.c
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Implementation of database conversion functionality of headless mode.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/headless/hconvert.h"
+
+#include <assert.h>   // assert
+#include <stdbool.h>  // bool
+#include <stddef.h>   // NULL
+#include <stdio.h>    // fprintf, stderr
+
+#include "core/db/bpdb/bpdb_lite.h"
+#include "core/db/mmapdb/mmapdb.h"
+#include "core/game_manager.h"
+#include "core/headless/hutils.h"
+#include "core/solvers/tier_solver/tier_solver.h"
+#include "core/types/gamesman_types.h"
+
+// -----------------------------------------------------------------------------
+
+// Initializes the solver for the given game and makes sure that the game uses
+// the tier solver, which is required by database conversion.
+static int InitTierSolver(ReadOnlyString game_name, int variant_id,
+                          ReadOnlyString data_path, ReadOnlyString caller) {
+    int error = HeadlessInitSolver(game_name, variant_id, data_path);
+    if (error != 0) return error;
+
+    const Game *game = GameManagerGetCurrentGame();
+    assert(game != NULL);
+    if (game->solver != &kTierSolver) {
+        fprintf(stderr,
+                "%s: database conversion is only supported for games using "
+                "the tier solver\n",
+                caller);
+        return kNotImplementedError;
+    }
+
+    return kNoError;
+}
+
+int HeadlessExport(ReadOnlyString game_name, int variant_id,
+                   ReadOnlyString data_path, bool force, int verbose,
+                   bool value_only) {
+    int error =
+        InitTierSolver(game_name, variant_id, data_path, "HeadlessExport");
+    if (error != 0) return error;
+
+    MmapDbOptions db_options = kMmapDbOptionsInit;
+    db_options.value_only = value_only;
+    TierSolverConvertOptions options = {
+        .verbose = verbose,
+        .force = force,
+        .db = &kMmapDb,
+        .db_options = &db_options,
+        .value_only = value_only,
+    };
+    error = TierSolverConvert(&options);
+    if (error != 0) {
+        fprintf(stderr, "HeadlessExport: export failed with code %d\n",
+                error);
+    }
+
+    return error;
+}
+
+int HeadlessCompact(ReadOnlyString game_name, int variant_id,
+                    ReadOnlyString data_path, bool force, int verbose,
+                    bool archive) {
+    int error =
+        InitTierSolver(game_name, variant_id, data_path, "HeadlessCompact");
+    if (error != 0) return error;
+
+    BpdbLiteOptions db_options = kBpdbLiteOptionsInit;
+    db_options.archive = archive;
+    db_options.summary = true;
+    TierSolverConvertOptions options = {
+        .verbose = verbose,
+        .force = force,
+        .db = &kBpdbLite,
+        .db_options = &db_options,
+    };
+    error = TierSolverConvert(&options);
+    if (error != 0) {
+        fprintf(stderr, "HeadlessCompact: compaction failed with code %d\n",
+                error);
+    }
+
+    return error;
+}
+
+int HeadlessRebalance(ReadOnlyString game_name, int variant_id,
+                      ReadOnlyString data_path, int verbose) {
+    int error =
+        InitTierSolver(game_name, variant_id, data_path, "HeadlessRebalance");
+    if (error != 0) return error;
+
+    error = TierSolverRebalance(verbose);
+    if (error != 0) {
+        fprintf(stderr, "HeadlessRebalance: rebalancing failed with code %d\n",
+                error);
+    }
+
+    return error;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file hconvert.h
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Database conversion functionality of headless mode.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAMESMANONE_CORE_HEADLESS_HCONVERT_H_
+#define GAMESMANONE_CORE_HEADLESS_HCONVERT_H_
+
+#include <stdbool.h>  // bool
+
+#include "core/types/gamesman_types.h"
+
+/**
+ * @brief Converts the solved variant VARIANT_ID of game GAME_NAME into the
+ * memory-mapped serving database (mmapdb), which stores tiers uncompressed and
+ * takes precedence over the solver's database for queries once complete.
+ *
+ * @param game_name Name of the game internal to GAMESMAN.
+ * @param variant_id Variant index of the game. The default variant will be
+ * converted instead if set to a negative value.
+ * @param data_path Path to the `data` directory. The default data path will be
+ * used if set to NULL.
+ * @param force If true, tiers that have already been converted will be
+ * converted again.
+ * @param verbose May take values 0, 1, or 2. If set to 0, no output will be
+ * produced to stdout. Set to 1 for default output level. Set to 2 for more
+ * detailed output.
+ * @param value_only Whether to store values only, 3 bits per position.
+ * @return 0 on success, non-zero error code otherwise.
+ */
+int HeadlessExport(ReadOnlyString game_name, int variant_id,
+                   ReadOnlyString data_path, bool force, int verbose,
+                   bool value_only);
+
+/**
+ * @brief Compacts the solved variant VARIANT_ID of game GAME_NAME into the
+ * bit-perfect database (bpdb) by converting multiple tiers in parallel. Every
+ * record is read back and compared against the solver's database after its
+ * tier is written, and the game is marked as solved in bpdb only if all tiers
+ * match.
+ *
+ * @param game_name Name of the game internal to GAMESMAN.
+ * @param variant_id Variant index of the game. The default variant will be
+ * compacted instead if set to a negative value.
+ * @param data_path Path to the `data` directory. The default data path will be
+ * used if set to NULL.
+ * @param force If true, tiers that have already been compacted will be
+ * compacted again.
+ * @param verbose May take values 0, 1, or 2. If set to 0, no output will be
+ * produced to stdout. Set to 1 for default output level. Set to 2 for more
+ * detailed output.
+ * @param archive Whether to pack the compacted tiers into a few large archive
+ * files in each data directory instead of writing one file per tier.
+ * @return 0 on success, non-zero error code otherwise.
+ */
+int HeadlessCompact(ReadOnlyString game_name, int variant_id,
+                    ReadOnlyString data_path, bool force, int verbose,
+                    bool archive);
+
+/**
+ * @brief Moves the tier files of the solved variant VARIANT_ID of game
+ * GAME_NAME into the data directories assigned to them under DATA_PATH. Run
+ * this after adding data directories to DATA_PATH or changing their weights so
+ * that existing tiers can be found again.
+ *
+ * @param game_name Name of the game internal to GAMESMAN.
+ * @param variant_id Variant index of the game. The default variant will be
+ * rebalanced instead if set to a negative value.
+ * @param data_path List of data directories. See db_shard.h for the format.
+ * The default data path will be used if set to NULL.
+ * @param verbose May take values 0, 1, or 2. If set to 0, no output will be
+ * produced to stdout. Set to 1 for default output level. Set to 2 for more
+ * detailed output.
+ * @return 0 on success, non-zero error code otherwise.
+ */
+int HeadlessRebalance(ReadOnlyString game_name, int variant_id,
+                      ReadOnlyString data_path, int verbose);
+
+#endif  // GAMESMANONE_CORE_HEADLESS_HCONVERT_H_
@@ -75,6 +75,11 @@ int HeadlessJsonAddValue(json_object *dest, Value value) {
 }
 
 int HeadlessJsonAddRemoteness(json_object *dest, int remoteness) {
+    // Remotenesses not stored in the database are reported as null.
+    if (remoteness == kUnknownRemoteness) {
+        return json_object_object_add(dest, "remoteness", NULL);
+    }
+
     json_object *remoteness_obj = json_object_new_int(remoteness);
     if (remoteness_obj == NULL) return kMallocFailureError;
 
@@ -39,22 +39,53 @@
 
 static HeadlessArguments arguments;
 static ConstantReadOnlyString HeadlessCommands[] = {
-    "solve", "analyze", "query", "getstart", "getrandom",
+    "solve",     "analyze", "query",   "getstart",
+    "getrandom", "export",  "compact", "rebalance",
 };
 
 static const struct option kLongOptions[] = {
+    {
+        .name = "archive",
+        .has_arg = no_argument,
+        .flag = NULL,
+        .val = 'A',
+    },
+    {
+        .name = "compressed-children",
+        .has_arg = no_argument,
+        .flag = NULL,
+        .val = 'C',
+    },
     {
         .name = "data-path",
         .has_arg = required_argument,
         .flag = NULL,
         .val = 'd',
     },
+    {
+        .name = "lz4",
+        .has_arg = no_argument,
+        .flag = NULL,
+        .val = 'Z',
+    },
+    {
+        .name = "lazy-children",
+        .has_arg = no_argument,
+        .flag = NULL,
+        .val = 'L',
+    },
     {
         .name = "memory",
         .has_arg = required_argument,
         .flag = NULL,
         .val = 'M',
     },
+    {
+        .name = "frontier-spill",
+        .has_arg = required_argument,
+        .flag = NULL,
+        .val = 'F',
+    },
     {
         .name = "force",
         .has_arg = no_argument,
@@ -67,6 +98,18 @@ static const struct option kLongOptions[] = {
         .flag = NULL,
         .val = '?',
     },
+    {
+        .name = "numa",
+        .has_arg = no_argument,
+        .flag = NULL,
+        .val = 'N',
+    },
+    {
+        .name = "out-of-core",
+        .has_arg = required_argument,
+        .flag = NULL,
+        .val = 'O',
+    },
     {
         .name = "output",
         .has_arg = required_argument,
@@ -79,6 +122,12 @@ static const struct option kLongOptions[] = {
         .flag = NULL,
         .val = 'q',
     },
+    {
+        .name = "sort-frontiers",
+        .has_arg = no_argument,
+        .flag = NULL,
+        .val = 'S',
+    },
     {
         .name = "usage",
         .has_arg = no_argument,
@@ -91,6 +140,12 @@ static const struct option kLongOptions[] = {
         .flag = NULL,
         .val = 'v',
     },
+    {
+        .name = "value-only",
+        .has_arg = no_argument,
+        .flag = NULL,
+        .val = 'W',
+    },
     {
         .name = "version",
         .has_arg = no_argument,
@@ -115,12 +170,27 @@ static void ParserError(const char *format, ...);
 
 static const char kDoc[] =
     "\nList of options:\n\n"
-    "\t-d, --data-path=PATH\tSpecify data path (default=\"data\")\n"
+    "\t-A, --archive\t\tPack compacted tiers into a few large archive files\n"
+    "\t-C, --compressed-children\tKeep loaded child tiers compressed in "
+    "memory (tier games)\n"
+    "\t-d, --data-path=PATH\tSpecify data path (default=\"data\"), or "
+    "PATH[@WEIGHT]:PATH[@WEIGHT]... to spread tiers across directories\n"
     "\t-M, --memory=LIMIT\tSpecify heap memory limit in GiB (default=90%)"
     "\t-o, --output=PATH\tSpecify output file (default=stdout)\n"
+    "\t-O, --out-of-core=PATH[@BUDGET]\tBack tiers larger than BUDGET GiB "
+    "(default=1) by memory-mapped files in PATH (tier games)\n"
     "\t-f, --force\t\tForce re-solve/re-analyze\n"
+    "\t-F, --frontier-spill=LIMIT\tSpill frontiers to disk beyond LIMIT GiB\n"
+    "\t-L, --lazy-children\tIndex child tiers instead of loading them into "
+    "frontiers (tier games)\n"
+    "\t-N, --numa\t\tFirst-touch solver arrays in parallel to spread them "
+    "across NUMA nodes\n"
     "\t-q, --quiet\t\tProduce no output\n"
+    "\t-S, --sort-frontiers\tSort frontiers before propagation (tier games)\n"
     "\t-v, --verbose\t\tProduce verbose output\n"
+    "\t-W, --value-only\tSolve for values only (tier games)\n"
+    "\t-Z, --lz4\t\tStore tiers as LZ4 blocks for fast probing, converting "
+    "tiers of unfinished solves (tier games)\n"
     "\t-?, --help\t\tGive this help list\n"
     "\t--usage\t\t\tGive a short usage message\n"
     "\t-V, --version\t\tPrint program version\n"
@@ -130,6 +200,13 @@ static const char kDoc[] =
     "    solve\tgamesman solve <game> [<variant>]\n"
     "    analyze\tgamesman analyze <game> [<variant>]\n"
     "\n"
+    "convert a solved game for serving\n"
+    "    export\tgamesman export <game> [<variant>]\n"
+    "    compact\tgamesman compact <game> [<variant>]\n"
+    "\n"
+    "move tier files after changing the data directories in --data-path\n"
+    "    rebalance\tgamesman rebalance <game> [<variant>]\n"
+    "\n"
     "query game information\n"
     "    query\tgamesman query <game> <variant> <position>\n"
     "    getstart\tgamesman getstart <game> [<variant>]\n"
@@ -144,8 +221,8 @@ HeadlessArguments HeadlessParseArguments(int argc, char **argv) {
         /* getopt_long stores the option index here. */
         int option_index = 0;
         // NOLINTBEGIN(concurrency-mt-unsafe)
-        key =
-            getopt_long(argc, argv, "dM:f?o:qvV", kLongOptions, &option_index);
+        key = getopt_long(argc, argv, "ACd:M:fF:LN?o:O:qSvVWZ", kLongOptions,
+                          &option_index);
         // NOLINTEND(concurrency-mt-unsafe)
         /* Detect the end of the options. */
         if (key == -1) break;
@@ -179,6 +256,18 @@ static void ParseOption(int key, int option_index) {
             printf("\n");
             break;
 
+        case 'A':
+            arguments.archive = 1;
+            break;
+
+        case 'C':
+            arguments.compressed = 1;
+            break;
+
+        case 'N':
+            arguments.numa = 1;
+            break;
+
         case 'd':
             arguments.data_path = optarg;
             break;
@@ -191,6 +280,10 @@ static void ParseOption(int key, int option_index) {
             arguments.force = 1;
             break;
 
+        case 'F':
+            arguments.spill = optarg;
+            break;
+
         case 'h':
             PrintUsage();
             exit(0);  // NOLINT(concurrency-mt-unsafe)
@@ -199,10 +292,30 @@ static void ParseOption(int key, int option_index) {
             arguments.output = optarg;
             break;
 
+        case 'O':
+            arguments.out_of_core = optarg;
+            break;
+
+        case 'L':
+            arguments.lazy_children = 1;
+            break;
+
+        case 'W':
+            arguments.value_only = 1;
+            break;
+
+        case 'Z':
+            arguments.lz4 = 1;
+            break;
+
         case 'q':
             arguments.quiet = 1;
             break;
 
+        case 'S':
+            arguments.sort_frontiers = 1;
+            break;
+
         case 'v':
             arguments.verbose = 1;
             break;
@@ -259,6 +372,9 @@ static void ValidateArguments(int arg_num) {
         case kHeadlessAnalyze:
         case kHeadlessGetStart:
         case kHeadlessGetRandom:
+        case kHeadlessExport:
+        case kHeadlessCompact:
+        case kHeadlessRebalance:
             min_args = 2;
             max_args = 3;
             break;
@@ -36,10 +36,18 @@
  * getstart <game> [<variant_id>]        // get starting position.
  * getrandom <game> [<variant_id>]       // get a random position.
  *
+ * export <game> [<variant_id>]   // convert solved game into mmapdb.
+ * compact <game> [<variant_id>]  // convert solved game into bpdb.
+ *
+ * rebalance <game> [<variant_id>]  // move tier files across data paths.
+ *
  * Options:
- * --data-path=<path>
+ * -A, --archive  // only effective when compacting
+ * -C, --compressed-children  // only effective when solving
+ * --data-path=<path>[@<weight>][:<path>[@<weight>]...]
  * --memory=<limit>  // in GiB
  * -o, --output=<path>
+ * -O, --out-of-core=<path>[@<budget>]  // in GiB, only effective when solving
  * -f, --force    // only effective when solving/analyzing
  * -q, --quiet    // only effective when solving/analyzing
  * -v, --verbose  // only effective when solving/analyzing
@@ -56,22 +64,34 @@ enum HeadlessAction {
     kHeadlessQuery,              /**< Query position. */
     kHeadlessGetStart,           /**< Get start position. */
     kHeadlessGetRandom,          /**< Get random position. */
+    kHeadlessExport,             /**< Convert into serving database. */
+    kHeadlessCompact,            /**< Convert into bit-perfect database. */
+    kHeadlessRebalance,          /**< Move tier files across data paths. */
     kNumHeadlessActions,         /**< Number of all valid actions. */
 };
 
 /** @brief Collection of all arguments used for command line parsing. */
 typedef struct HeadlessArguments {
-    char *command;    /**< User command. See Headless Commands for details. */
-    char *game;       /**< Game name. */
-    char *variant_id; /**< Variant index. */
-    char *position;   /**< Position to query. */
-    char *data_path;  /**< Path to the "data" directory, NULL for default. */
-    char *memlimit;   /**< Heap memory limit, NULL for default (90%). */
-    char *output;     /**< Path to output file, defaults to stdout if NULL. */
-    int action;       /**< Action to take. */
-    int force;        /**< Whether to force solve/analyze. */
-    int verbose;      /**< Whether to print additional output. */
-    int quiet;        /**< Whether to give no output. */
+    char *command;      /**< User command. See Headless Commands for details. */
+    char *game;         /**< Game name. */
+    char *variant_id;   /**< Variant index. */
+    char *position;     /**< Position to query. */
+    char *data_path;    /**< Path to the "data" directory, NULL for default. */
+    char *memlimit;     /**< Heap memory limit, NULL for default (90%). */
+    char *output;       /**< Path to output file, defaults to stdout if NULL. */
+    char *spill;        /**< Frontier spill limit, NULL to never spill. */
+    char *out_of_core;  /**< Out-of-core directory and budget, or NULL. */
+    int action;         /**< Action to take. */
+    int force;          /**< Whether to force solve/analyze. */
+    int verbose;        /**< Whether to print additional output. */
+    int quiet;          /**< Whether to give no output. */
+    int sort_frontiers; /**< Whether to sort frontiers in tier solver. */
+    int lazy_children;  /**< Whether to index child tiers in tier solver. */
+    int value_only;     /**< Whether to solve for values only. */
+    int lz4;            /**< Whether to store tiers in LZ4 blocks. */
+    int archive;        /**< Whether to pack compacted tiers into archives. */
+    int compressed;     /**< Whether to keep loaded child tiers compressed. */
+    int numa;           /**< Whether to first-touch solver arrays. */
 } HeadlessArguments;
 
 HeadlessArguments HeadlessParseArguments(int argc, char **argv);
@@ -33,6 +33,7 @@
 #include <stdbool.h>             // bool
 #include <stdint.h>              // int64_t
 #include <stdio.h>               // printf
+#include <stdlib.h>              // malloc, free
 
 #include "core/constants.h"
 #include "core/game_manager.h"
@@ -57,9 +58,12 @@ static int GetRandomTier(const Game *game);
 
 static int JsonPrintPositionResponse(const Game *game, Position position);
 static json_object *JsonCreateBasicPositionObject(const Game *game,
-                                                  Position position);
+                                                  Position position,
+                                                  Value value, int remoteness);
 static json_object *JsonCreateChildPositionObject(const Game *game,
-                                                  Position parent, Move move);
+                                                  Position parent, Move move,
+                                                  Position child, Value value,
+                                                  int remoteness);
 static json_object *JsonCreateParentPositionObject(
     const Game *game, Position position, json_object *moves_array_obj,
     json_object *partmoves_array_obj);
@@ -71,14 +75,16 @@ static MoveArray GetMovesFromTierPosition(const Game *game,
 static PartmoveArray GetPartmovesFromTierPosition(const Game *game,
                                                   TierPosition tier_position);
 static json_object *JsonCreateBasicTierPositionObject(
-    const Game *game, TierPosition tier_position);
-static json_object *JsonCreateChildTierPositionObject(const Game *game,
-                                                      TierPosition parent,
-                                                      Move move);
+    const Game *game, TierPosition tier_position, Value value, int remoteness);
+static json_object *JsonCreateChildTierPositionObject(
+    const Game *game, TierPosition parent, Move move, TierPosition child,
+    Value value, int remoteness);
 static json_object *JsonCreateParentTierPositionObject(
     const Game *game, TierPosition tier_position, json_object *moves_array_obj,
     json_object *partmoves_array_obj);
 static json_object *JsonCreatePartmoveEdgeObject(const Partmove *pm);
+static int ProbeChildren(const TierPosition *children, int64_t size,
+                         Value **values, int **remotenesses);
 
 static void JsonPrintStartResponse(ReadOnlyString start,
                                    ReadOnlyString autogui_start);
@@ -362,6 +368,9 @@ static int JsonPrintPositionResponse(const Game *game, Position position) {
     PartmoveArray partmoves = GetPartmovesFromPosition(game, position);
     json_object *moves_array_obj = NULL, *child_obj = NULL, *parent_obj = NULL;
     json_object *partmoves_array_obj = NULL, *partmove_edge_obj = NULL;
+    TierPosition *children = NULL;
+    Value *values = NULL;
+    int *remotenesses = NULL;
     if (moves.size < 0 || partmoves.size < 0) {
         fprintf(stderr, "out of memory");
         ret = kMallocFailureError;
@@ -370,16 +379,29 @@ static int JsonPrintPositionResponse(const Game *game, Position position) {
 
     moves_array_obj = json_object_new_array_ext((int)moves.size);
     partmoves_array_obj = json_object_new_array_ext((int)partmoves.size);
-    if (moves_array_obj == NULL || partmoves_array_obj == NULL) {
+    children = (TierPosition *)malloc(moves.size * sizeof(TierPosition));
+    if (moves_array_obj == NULL || partmoves_array_obj == NULL ||
+        (moves.size > 0 && children == NULL)) {
         fprintf(stderr, "out of memory");
         ret = kMallocFailureError;
         goto _bailout;
     }
 
+    // Probe all child positions in one batch.
+    for (int64_t i = 0; i < moves.size; ++i) {
+        children[i].tier = kDefaultTier;
+        children[i].position =
+            game->uwapi->regular->DoMove(position, moves.array[i]);
+    }
+    ret = ProbeChildren(children, moves.size, &values, &remotenesses);
+    if (ret != kNoError) goto _bailout;
+
     // Add moves and corresponding child positions.
     for (int64_t i = 0; i < moves.size; ++i) {
         Move move = moves.array[i];
-        child_obj = JsonCreateChildPositionObject(game, position, move);
+        child_obj = JsonCreateChildPositionObject(game, position, move,
+                                                  children[i].position,
+                                                  values[i], remotenesses[i]);
         if (child_obj == NULL) {
             fprintf(stderr, "out of memory");
             ret = kMallocFailureError;
@@ -414,6 +436,9 @@ static int JsonPrintPositionResponse(const Game *game, Position position) {
 _bailout:
     MoveArrayDestroy(&moves);
     PartmoveArrayDestroy(&partmoves);
+    free(children);
+    free(values);
+    free(remotenesses);
     json_object_put(moves_array_obj);
     json_object_put(child_obj);
     json_object_put(parent_obj);
@@ -423,7 +448,8 @@ _bailout:
 }
 
 static json_object *JsonCreateBasicPositionObject(const Game *game,
-                                                  Position position) {
+                                                  Position position,
+                                                  Value value, int remoteness) {
     json_object *ret = json_object_new_object();
     if (ret == NULL) goto _bailout;
 
@@ -439,9 +465,6 @@ static json_object *JsonCreateBasicPositionObject(const Game *game,
     int error = HeadlessJsonAddPosition(ret, formal_position.str);
     error |= HeadlessJsonAddAutoGuiPosition(ret, autogui_position.str);
 
-    TierPosition tier_position = {.tier = kDefaultTier, .position = position};
-    Value value = SolverManagerGetValue(tier_position);
-    int remoteness = SolverManagerGetRemoteness(tier_position);
     error |= HeadlessJsonAddValue(ret, value);
     error |= HeadlessJsonAddRemoteness(ret, remoteness);
     if (error) {
@@ -456,9 +479,11 @@ _bailout:
 }
 
 static json_object *JsonCreateChildPositionObject(const Game *game,
-                                                  Position parent, Move move) {
-    Position child = game->uwapi->regular->DoMove(parent, move);
-    json_object *ret = JsonCreateBasicPositionObject(game, child);
+                                                  Position parent, Move move,
+                                                  Position child, Value value,
+                                                  int remoteness) {
+    json_object *ret =
+        JsonCreateBasicPositionObject(game, child, value, remoteness);
     if (ret == NULL) return NULL;
 
     CString formal_move = game->uwapi->regular->MoveToFormalMove(parent, move);
@@ -487,7 +512,10 @@ static json_object *JsonCreateParentPositionObject(
     const Game *game, Position position, json_object *moves_array_obj,
     json_object *partmoves_array_obj) {
     //
-    json_object *ret = JsonCreateBasicPositionObject(game, position);
+    TierPosition tier_position = {.tier = kDefaultTier, .position = position};
+    json_object *ret = JsonCreateBasicPositionObject(
+        game, position, SolverManagerGetValue(tier_position),
+        SolverManagerGetRemoteness(tier_position));
     if (ret == NULL) return NULL;
 
     int error = HeadlessJsonAddMovesArray(ret, moves_array_obj);
@@ -507,6 +535,9 @@ static int JsonPrintTierPositionResponse(const Game *game,
     PartmoveArray partmoves = GetPartmovesFromTierPosition(game, tier_position);
     json_object *moves_array_obj = NULL, *child_obj = NULL, *parent_obj = NULL;
     json_object *partmoves_array_obj = NULL, *partmove_edge_obj = NULL;
+    TierPosition *children = NULL;
+    Value *values = NULL;
+    int *remotenesses = NULL;
     if (moves.size < 0 || partmoves.size < 0) {
         fprintf(stderr, "out of memory");
         ret = kMallocFailureError;
@@ -515,17 +546,27 @@ static int JsonPrintTierPositionResponse(const Game *game,
 
     moves_array_obj = json_object_new_array_ext((int)moves.size);
     partmoves_array_obj = json_object_new_array_ext((int)partmoves.size);
-    if (moves_array_obj == NULL || partmoves_array_obj == NULL) {
+    children = (TierPosition *)malloc(moves.size * sizeof(TierPosition));
+    if (moves_array_obj == NULL || partmoves_array_obj == NULL ||
+        (moves.size > 0 && children == NULL)) {
         fprintf(stderr, "out of memory");
         ret = kMallocFailureError;
         goto _bailout;
     }
 
+    // Probe all child tier positions in one batch.
+    for (int64_t i = 0; i < moves.size; ++i) {
+        children[i] = game->uwapi->tier->DoMove(tier_position, moves.array[i]);
+    }
+    ret = ProbeChildren(children, moves.size, &values, &remotenesses);
+    if (ret != kNoError) goto _bailout;
+
     // Add moves and corresponding child tier positions.
     for (int64_t i = 0; i < moves.size; ++i) {
         Move move = moves.array[i];
-        child_obj =
-            JsonCreateChildTierPositionObject(game, tier_position, move);
+        child_obj = JsonCreateChildTierPositionObject(
+            game, tier_position, move, children[i], values[i],
+            remotenesses[i]);
         if (child_obj == NULL) {
             fprintf(stderr, "out of memory");
             ret = kMallocFailureError;
@@ -560,6 +601,9 @@ static int JsonPrintTierPositionResponse(const Game *game,
 _bailout:
     MoveArrayDestroy(&moves);
     PartmoveArrayDestroy(&partmoves);
+    free(children);
+    free(values);
+    free(remotenesses);
     json_object_put(moves_array_obj);
     json_object_put(child_obj);
     json_object_put(parent_obj);
@@ -602,7 +646,7 @@ static PartmoveArray GetPartmovesFromTierPosition(const Game *game,
 }
 
 static json_object *JsonCreateBasicTierPositionObject(
-    const Game *game, TierPosition tier_position) {
+    const Game *game, TierPosition tier_position, Value value, int remoteness) {
     //
     json_object *ret = json_object_new_object();
     if (ret == NULL) goto _bailout;
@@ -619,8 +663,6 @@ static json_object *JsonCreateBasicTierPositionObject(
     int error = HeadlessJsonAddPosition(ret, formal_position.str);
     error |= HeadlessJsonAddAutoGuiPosition(ret, autogui_position.str);
 
-    Value value = SolverManagerGetValue(tier_position);
-    int remoteness = SolverManagerGetRemoteness(tier_position);
     error |= HeadlessJsonAddValue(ret, value);
     error |= HeadlessJsonAddRemoteness(ret, remoteness);
     if (error) {
@@ -634,11 +676,12 @@ _bailout:
     return ret;
 }
 
-static json_object *JsonCreateChildTierPositionObject(const Game *game,
-                                                      TierPosition parent,
-                                                      Move move) {
-    TierPosition child = game->uwapi->tier->DoMove(parent, move);
-    json_object *ret = JsonCreateBasicTierPositionObject(game, child);
+static json_object *JsonCreateChildTierPositionObject(
+    const Game *game, TierPosition parent, Move move, TierPosition child,
+    Value value, int remoteness) {
+    //
+    json_object *ret =
+        JsonCreateBasicTierPositionObject(game, child, value, remoteness);
     if (ret == NULL) return NULL;
 
     CString formal_move = game->uwapi->tier->MoveToFormalMove(parent, move);
@@ -666,7 +709,9 @@ static json_object *JsonCreateParentTierPositionObject(
     const Game *game, TierPosition tier_position, json_object *moves_array_obj,
     json_object *partmoves_array_obj) {
     //
-    json_object *ret = JsonCreateBasicTierPositionObject(game, tier_position);
+    json_object *ret = JsonCreateBasicTierPositionObject(
+        game, tier_position, SolverManagerGetValue(tier_position),
+        SolverManagerGetRemoteness(tier_position));
     if (ret == NULL) return NULL;
 
     int error = HeadlessJsonAddMovesArray(ret, moves_array_obj);
@@ -702,6 +747,29 @@ static json_object *JsonCreatePartmoveEdgeObject(const Partmove *pm) {
     return ret;
 }
 
+// Probes the values and remotenesses of the SIZE CHILDREN in one batch into
+// malloc'ed arrays VALUES and REMOTENESSES.
+static int ProbeChildren(const TierPosition *children, int64_t size,
+                         Value **values, int **remotenesses) {
+    if (size == 0) return kNoError;
+
+    *values = (Value *)malloc(size * sizeof(Value));
+    *remotenesses = (int *)malloc(size * sizeof(int));
+    if (*values == NULL || *remotenesses == NULL) {
+        fprintf(stderr, "out of memory");
+        return kMallocFailureError;
+    }
+
+    // Children that fail to be probed are reported with error values, as
+    // they were when probed one at a time. Only running out of memory leaves
+    // the results undefined.
+    int error =
+        SolverManagerGetRecordsBatch(size, children, *values, *remotenesses);
+    if (error == kMallocFailureError) return error;
+
+    return kNoError;
+}
+
 static void JsonPrintStartResponse(ReadOnlyString formal_start,
                                    ReadOnlyString autogui_start) {
     JsonPrintSinglePosition(formal_start, autogui_start);
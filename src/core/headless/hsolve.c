@@ -35,13 +35,29 @@
 
 #include "core/game_manager.h"
 #include "core/headless/hutils.h"
+#include "core/large_alloc.h"
 #include "core/misc.h"
 #include "core/solvers/regular_solver/regular_solver.h"
 #include "core/solvers/solver_manager.h"
 #include "core/solvers/tier_solver/tier_solver.h"
 #include "core/types/gamesman_types.h"
 
-static void *GenerateSolveOptions(bool force, int verbose, intptr_t memlimit) {
+const HeadlessSolveOptions kHeadlessSolveOptionsInit = {
+    .force = false,
+    .verbose = 1,
+    .memlimit = 0,
+    .sort_frontiers = false,
+    .frontier_spill = 0,
+    .lazy_children = false,
+    .value_only = false,
+    .lz4 = false,
+    .out_of_core_dir = NULL,
+    .out_of_core_budget = (intptr_t)1 << 30,
+    .compressed_children = false,
+    .numa = false,
+};
+
+static void *GenerateSolveOptions(const HeadlessSolveOptions *hoptions) {
     const Game *game = GameManagerGetCurrentGame();
     assert(game != NULL);
 
@@ -49,15 +65,23 @@ static void *GenerateSolveOptions(bool force, int verbose, intptr_t memlimit) {
         RegularSolverSolveOptions *options =
             (RegularSolverSolveOptions *)SafeMalloc(
                 sizeof(RegularSolverSolveOptions));
-        options->force = force;
-        options->verbose = verbose;
+        options->force = hoptions->force;
+        options->verbose = hoptions->verbose;
         return (void *)options;
     } else if (game->solver == &kTierSolver) {
         TierSolverSolveOptions *options = (TierSolverSolveOptions *)SafeMalloc(
             sizeof(TierSolverSolveOptions));
-        options->force = force;
-        options->verbose = verbose;
-        options->memlimit = memlimit;
+        options->force = hoptions->force;
+        options->verbose = hoptions->verbose;
+        options->memlimit = hoptions->memlimit;
+        options->sort_frontiers = hoptions->sort_frontiers;
+        options->frontier_spill_threshold = hoptions->frontier_spill;
+        options->lazy_children = hoptions->lazy_children;
+        options->value_only = hoptions->value_only;
+        options->lz4 = hoptions->lz4;
+        options->out_of_core_dir = hoptions->out_of_core_dir;
+        options->out_of_core_budget = hoptions->out_of_core_budget;
+        options->compressed_children = hoptions->compressed_children;
         return (void *)options;
     }  // Append new solvers to the end.
 
@@ -66,14 +90,16 @@ static void *GenerateSolveOptions(bool force, int verbose, intptr_t memlimit) {
 }
 
 int HeadlessSolve(ReadOnlyString game_name, int variant_id,
-                  ReadOnlyString data_path, bool force, int verbose,
-                  intptr_t memlimit) {
+                  ReadOnlyString data_path,
+                  const HeadlessSolveOptions *options) {
+    if (options == NULL) options = &kHeadlessSolveOptionsInit;
+    LargeAllocSetNumaFirstTouch(options->numa);
     int error = HeadlessInitSolver(game_name, variant_id, data_path);
     if (error != 0) return error;
 
-    void *options = GenerateSolveOptions(force, verbose, memlimit);
-    error = SolverManagerSolve(options);
-    free(options);
+    void *solver_options = GenerateSolveOptions(options);
+    error = SolverManagerSolve(solver_options);
+    free(solver_options);
     if (error != 0) {
         fprintf(stderr, "HeadlessSolve: solve failed with code %d\n", error);
     }
@@ -32,6 +32,74 @@
 
 #include "core/types/gamesman_types.h"
 
+/** @brief Options of the headless solve command. */
+typedef struct HeadlessSolveOptions {
+    /** If set to true, the given game variant will be solved regardless of
+     * the current database status. Otherwise, the solving process is skipped
+     * if the game variant has already been correctly solved. */
+    bool force;
+
+    /** May take values 0, 1, or 2. If set to 0, no output will be produced
+     * unless an error occurrs. If set to 1, the solver will print out the
+     * default messages. If set to 2, additional information will be printed.
+     */
+    int verbose;
+
+    /** Approximate heap memory limit in bytes, or 0 for default. */
+    intptr_t memlimit;
+
+    /** Whether to sort frontiers before propagating them during backward
+     * induction. Ignored by solvers other than the tier solver. */
+    bool sort_frontiers;
+
+    /** Approximate frontier memory limit in bytes beyond which frontiers are
+     * spilled to temporary files during backward induction, or 0 to never
+     * spill. Ignored by solvers other than the tier solver. */
+    intptr_t frontier_spill;
+
+    /** Whether to enumerate the positions of child tiers through remoteness
+     * indices instead of loading them into frontiers during backward
+     * induction. Ignored by solvers other than the tier solver. */
+    bool lazy_children;
+
+    /** Whether to solve for values only, storing a compact value-only
+     * database without remotenesses. Ignored by solvers other than the tier
+     * solver. */
+    bool value_only;
+
+    /** Whether to store solved tiers as LZ4 blocks with an offset index for
+     * fast random probing, converting tiers solved by an earlier run of an
+     * unfinished game into the same format. Ignored by solvers other than the
+     * tier solver. */
+    bool lz4;
+
+    /** Directory on fast local storage in which tiers and solver arrays larger
+     * than \c out_of_core_budget bytes are backed by memory-mapped files, or
+     * NULL to keep them in memory. Ignored by solvers other than the tier
+     * solver. */
+    ReadOnlyString out_of_core_dir;
+
+    /** Resident memory budget in bytes of each file-backed array. Ignored if
+     * \c out_of_core_dir is NULL. */
+    intptr_t out_of_core_budget;
+
+    /** Whether to keep loaded child tiers compressed in memory during value
+     * iteration and iterative solving. Ignored by solvers other than the tier
+     * solver. */
+    bool compressed_children;
+
+    /** Whether to first-touch large solver arrays in parallel with the same
+     * static schedule as the solver loops, which spreads their pages across
+     * the NUMA nodes of all worker threads. See \c LargeFirstTouch. */
+    bool numa;
+} HeadlessSolveOptions;
+
+/**
+ * @brief Default \c HeadlessSolveOptions for convenient initialization of
+ * HeadlessSolveOptions instances.
+ */
+extern const HeadlessSolveOptions kHeadlessSolveOptionsInit;
+
 /**
  * @brief Solves the game of name GAME_NAME and variant index VARIANT_ID and
  * stores the database at the given DATA_PATH.
@@ -41,17 +109,11 @@
  * variant will be solved.
  * @param data_path Path to the "data" directory. The default path will be used
  * if set to NULL.
- * @param force If set to true, the given game variant will be solved regardless
- * of the current database status. Otherwise, the solving process is skipped if
- * the game variant has already been correctly solved.
- * @param verbose May take values 0, 1, or 2. If set to 0, no output will be
- * produced unless an error occurrs. If set to 1, the solver will print out the
- * default messages. If set to 2, additional information will be printed.
- * @param memlimit Approximate heap memory limit in bytes.
+ * @param options Solve options, or NULL for default options.
  * @return 0 on success, non-zero error code otherwise.
  */
 int HeadlessSolve(ReadOnlyString game_name, int variant_id,
-                  ReadOnlyString data_path, bool force, int verbose,
-                  intptr_t memlimit);
+                  ReadOnlyString data_path,
+                  const HeadlessSolveOptions *options);
 
 #endif  // GAMESMANONE_CORE_HEADLESS_HSOLVE_H_
@@ -5,7 +5,7 @@
 #include <stddef.h>   // NULL
 #include <stdint.h>   // int64_t
 #include <stdio.h>    // fprintf, stderr
-#include <stdlib.h>   // exit, EXIT_FAILURE
+#include <stdlib.h>   // exit, EXIT_FAILURE, free
 #include <string.h>   // strcmp
 
 #include "core/constants.h"
@@ -58,8 +58,13 @@ static void PrintPrediction(void) {
     }
 
     int remoteness = SolverManagerGetRemoteness(current);
-    printf("Player %d (%s) %s %s in %d.", turn + 1, controller, prediction,
-           value_string, remoteness);
+    if (remoteness == kUnknownRemoteness) {
+        printf("Player %d (%s) %s %s.", turn + 1, controller, prediction,
+               value_string);
+    } else {
+        printf("Player %d (%s) %s %s in %d.", turn + 1, controller, prediction,
+               value_string, remoteness);
+    }
 }
 
 static void PrintCurrentPosition(const Game *game) {
@@ -142,10 +147,12 @@ static void PrintMovesOfValue(const Game *game, MoveArray *moves,
         if (childValue == SolverManagerGetValue(child)) {
             game->gameplay_api->common->MoveToString(moves->array[i],
                                                      move_string);
+            int remoteness = SolverManagerGetRemoteness(child);
             if (childValue == kDraw) {
                 printf("\t\t\t%-16s\tDraw\n", move_string);
+            } else if (remoteness == kUnknownRemoteness) {
+                printf("\t\t\t%-16s\t?\n", move_string);
             } else {
-                int remoteness = SolverManagerGetRemoteness(child);
                 printf("\t\t\t%-16s\t%d\n", move_string, remoteness);
             }
         }
@@ -199,26 +206,43 @@ static bool LoadMoveValues(const MoveArray *moves) {
     MoveValueCacheCleanup();
     Int64HashMapInit(&move_values, 0.5);
     Int64HashMapInit(&move_remotenesses, 0.5);
-    for (int64_t i = 0; i < moves->size; ++i) {
-        TierPosition current = InteractiveMatchGetCurrentPosition();
-        TierPosition child = InteractiveMatchDoMove(current, moves->array[i]);
-        Value value = SolverManagerGetValue(child);
-        if (!Int64HashMapSet(&move_values, moves->array[i], value)) {
+
+    // Probe all children in one batch.
+    int64_t size = moves->size;
+    if (size == 0) return true;
+    TierPosition *children =
+        (TierPosition *)SafeMalloc(size * sizeof(TierPosition));
+    Value *values = (Value *)SafeMalloc(size * sizeof(Value));
+    int *remotenesses = (int *)SafeMalloc(size * sizeof(int));
+    TierPosition current = InteractiveMatchGetCurrentPosition();
+    for (int64_t i = 0; i < size; ++i) {
+        children[i] = InteractiveMatchDoMove(current, moves->array[i]);
+    }
+    int error =
+        SolverManagerGetRecordsBatch(size, children, values, remotenesses);
+    bool success = (error != kMallocFailureError);
+    for (int64_t i = 0; success && i < size; ++i) {
+        if (!Int64HashMapSet(&move_values, moves->array[i], values[i])) {
             fprintf(stderr,
                     "LoadMoveValues: failed to create new map entry for move "
                     "value\n");
-            return false;
+            success = false;
+            break;
         }
-        int remoteness = SolverManagerGetRemoteness(child);
-        if (!Int64HashMapSet(&move_remotenesses, moves->array[i], remoteness)) {
+        if (!Int64HashMapSet(&move_remotenesses, moves->array[i],
+                             remotenesses[i])) {
             fprintf(stderr,
                     "LoadMoveValues: failed to create new map entry for move "
                     "remoteness\n");
-            return false;
+            success = false;
+            break;
         }
     }
+    free(children);
+    free(values);
+    free(remotenesses);
 
-    return true;
+    return success;
 }
 
 /**
@@ -259,19 +283,21 @@ static bool PrintSortedMoveValues(const Game *game) {
 
 static bool IsBestChild(Value parent_value, int parent_remoteness,
                         Value child_value, int child_remoteness) {
+    // Any child of the matching value is considered best if remotenesses are
+    // not available.
+    bool closer = parent_remoteness == kUnknownRemoteness ||
+                  child_remoteness == parent_remoteness - 1;
     switch (parent_value) {
         case kLose:
             assert(child_value == kWin);
-            return (child_remoteness == parent_remoteness - 1);
+            return closer;
 
         case kWin:
-            return (child_value == kLose &&
-                    child_remoteness == parent_remoteness - 1);
+            return (child_value == kLose && closer);
 
         case kTie:
             assert(child_value != kLose);
-            return (child_value == kTie &&
-                    child_remoteness == parent_remoteness - 1);
+            return (child_value == kTie && closer);
 
         case kDraw:
             assert(child_value != kLose);
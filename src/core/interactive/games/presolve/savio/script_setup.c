@@ -21,7 +21,7 @@ static const SavioPartition *partition;
 static const Game *game;
 static int variant_id;
 
-enum { NUM_ITEMS = 8 };
+enum { NUM_ITEMS = 9 };
 // Note that the size of each string here must be longer than the maximum
 // length that an item can grow into.
 static char items[NUM_ITEMS][256];
@@ -46,6 +46,7 @@ static int PromptForNumTasksPerNode(ReadOnlyString key);
 static int PromptForNumCpuPerTask(ReadOnlyString key);
 static int PromptForTogglingOmpThreadBinding(ReadOnlyString key);
 static int PromptForTimeLimit(ReadOnlyString key);
+static int PromptForTogglingNuma(ReadOnlyString key);
 
 static int IntMin2(int x, int y);
 static void ReplaceSpecialCharacters(char *str);
@@ -82,6 +83,7 @@ static void RestoreDefaultSettings(void) {
     }
     settings.ntasks_per_node = kSavioDefaultNumTasksPerNode;
     sprintf(settings.time_limit, "%s", kSavioDefaultTimeLimit);
+    settings.numa = false;
 }
 
 static void UpdateItems(void) {
@@ -97,6 +99,8 @@ static void UpdateItems(void) {
     sprintf(items[6], "Bind OpenMP threads to: [%s]",
             OmpThreadBindingDesc(settings.bind_omp_threads_to_cores));
     sprintf(items[7], "Time limit: [%s]", settings.time_limit);
+    sprintf(items[8], "NUMA first-touch mode: [%s]",
+            settings.numa ? "on" : "off");
 
     for (int i = 0; i < NUM_ITEMS; ++i) {
         items_p[i] = (ReadOnlyString)&items[i];
@@ -125,6 +129,7 @@ static void InitHooks(void) {
     hooks[5] = &PromptForNumCpuPerTask;
     hooks[6] = &PromptForTogglingOmpThreadBinding;
     hooks[7] = &PromptForTimeLimit;
+    hooks[8] = &PromptForTogglingNuma;
 }
 
 static int ConfirmSettings(ReadOnlyString key) {
@@ -338,6 +343,22 @@ static int PromptForTimeLimit(ReadOnlyString key) {
     return 0;
 }
 
+static int PromptForTogglingNuma(ReadOnlyString key) {
+    (void)key;  // Unused
+    printf(
+        "Turning NUMA first-touch mode %s.\n"
+        "In this mode, the solver arrays are first touched in parallel so that "
+        "their pages are spread across the memory of all sockets, and OpenMP "
+        "threads are pinned to cores with OMP_PLACES=cores and "
+        "OMP_PROC_BIND=spread.\n"
+        "This may reduce remote memory accesses on multi-socket nodes, and "
+        "needs to be benchmarked.\n",
+        settings.numa ? "off" : "on");
+    settings.numa = !settings.numa;
+
+    return 0;
+}
+
 static int IntMin2(int x, int y) { return x < y ? x : y; }
 
 static void ReplaceSpecialCharacters(char *str) {
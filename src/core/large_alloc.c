@@ -0,0 +1,271 @@
+/**
+ * @file large_alloc.c
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Implementation of the allocator for large, solver-sized buffers.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/large_alloc.h"
+
+#include <inttypes.h>  // PRId64
+#include <stdbool.h>   // bool, true, false
+#include <stddef.h>    // size_t, NULL
+#include <stdint.h>    // int64_t, uintptr_t
+#include <stdio.h>     // printf, perror, sprintf
+#include <stdlib.h>    // calloc, free, malloc, mkstemp
+#include <string.h>    // strlen
+#include <sys/mman.h>  // mmap, munmap, madvise
+#include <unistd.h>    // close, ftruncate, unlink
+
+#include "core/concurrency.h"
+#include "core/types/gamesman_types.h"
+
+// Default huge page size on x86-64. Buffers smaller than this are allocated on
+// the heap as they gain nothing from being mapped separately.
+static const size_t kHugePageSize = (size_t)1 << 21;  // 2 MiB.
+
+static ConstantReadOnlyString kModeNames[kNumLargeAllocModes] = {
+    "heap (calloc)",
+    "explicit huge pages (hugetlbfs)",
+    "transparent huge pages (madvise)",
+    "base pages (mmap)",
+    "file-backed pages (mmap)",
+};
+
+// Cleared after the first failed attempt so that later allocations skip the
+// modes that are not available on this system.
+static ConcurrentBool hugetlb_available = true;
+static ConcurrentBool thp_available = true;
+
+// Smallest page size. Buffers that fall back to base pages need one write at
+// this stride to fault in every page.
+static const size_t kBasePageSize = (size_t)1 << 12;  // 4 KiB.
+
+// Whether LargeFirstTouch touches buffers. Set once before solving.
+static bool numa_first_touch = false;
+
+static int64_t num_allocs[kNumLargeAllocModes];
+static int64_t num_bytes[kNumLargeAllocModes];
+
+static size_t GetMappingSize(size_t size) {
+    return (size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+}
+
+static void RecordAlloc(LargeAllocMode mode, size_t size) {
+    PRAGMA_OMP_CRITICAL(large_alloc_stats) {
+        ++num_allocs[mode];
+        num_bytes[mode] += (int64_t)size;
+    }
+}
+
+static void *MapAnonymous(size_t length, int extra_flags) {
+    void *ret = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    return ret == MAP_FAILED ? NULL : ret;
+}
+
+static void *TryHugetlb(size_t length) {
+#ifdef MAP_HUGETLB
+    if (!ConcurrentBoolLoad(&hugetlb_available)) return NULL;
+    void *ret = MapAnonymous(length, MAP_HUGETLB);
+    if (ret == NULL) ConcurrentBoolStore(&hugetlb_available, false);
+    return ret;
+#else   // MAP_HUGETLB not defined.
+    (void)length;
+    return NULL;
+#endif  // MAP_HUGETLB
+}
+
+static bool TryAdviseHugePages(void *addr, size_t length) {
+#ifdef MADV_HUGEPAGE
+    if (!ConcurrentBoolLoad(&thp_available)) return false;
+    if (madvise(addr, length, MADV_HUGEPAGE) == 0) return true;
+    ConcurrentBoolStore(&thp_available, false);
+#else   // MADV_HUGEPAGE not defined.
+    (void)addr;
+    (void)length;
+#endif  // MADV_HUGEPAGE
+    return false;
+}
+
+void *LargeCalloc(size_t size) {
+    if (size < kHugePageSize) {
+        void *ret = calloc(size, 1);
+        if (ret != NULL) RecordAlloc(kLargeAllocHeap, size);
+        return ret;
+    }
+
+    size_t length = GetMappingSize(size);
+    void *ret = TryHugetlb(length);
+    if (ret != NULL) {
+        RecordAlloc(kLargeAllocHugetlb, size);
+        return ret;
+    }
+
+    ret = MapAnonymous(length, 0);
+    if (ret == NULL) return NULL;
+    if (TryAdviseHugePages(ret, length)) {
+        RecordAlloc(kLargeAllocThp, size);
+    } else {
+        RecordAlloc(kLargeAllocBasePages, size);
+    }
+
+    return ret;
+}
+
+// Creates an unlinked temporary file of LENGTH bytes in DIR and returns its
+// file descriptor, or -1 on failure.
+static int CreateUnlinkedFile(const char *dir, size_t length) {
+    static const char kTemplate[] = "/gamesman.XXXXXX";
+    char *path = (char *)malloc(strlen(dir) + sizeof(kTemplate));
+    if (path == NULL) return -1;
+
+    sprintf(path, "%s%s", dir, kTemplate);
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        free(path);
+        return -1;
+    }
+
+    // The file is removed as soon as it is unmapped or the process exits.
+    unlink(path);
+    free(path);
+    if (ftruncate(fd, (off_t)length) != 0) {
+        perror("ftruncate");
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+void *LargeCallocFileBacked(size_t size, const char *dir) {
+    if (dir == NULL) return LargeCalloc(size);
+    if (size < kHugePageSize) return LargeCalloc(size);
+
+    // The file is extended without writing to it, so it reads as all zeros
+    // and takes no space until the pages are written back.
+    size_t length = GetMappingSize(size);
+    int fd = CreateUnlinkedFile(dir, length);
+    if (fd < 0) return NULL;
+
+    void *ret =
+        mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping keeps the file open.
+    if (ret == MAP_FAILED) {
+        perror("mmap");
+        return NULL;
+    }
+    RecordAlloc(kLargeAllocFile, size);
+
+    return ret;
+}
+
+static int GetAdvice(LargeAccessPattern pattern) {
+    switch (pattern) {
+        case kLargeAccessNormal:
+            return MADV_NORMAL;
+        case kLargeAccessSequential:
+            return MADV_SEQUENTIAL;
+        case kLargeAccessRandom:
+            return MADV_RANDOM;
+        case kLargeAccessDone:
+#if defined(MADV_PAGEOUT)
+            return MADV_PAGEOUT;
+#elif defined(MADV_COLD)
+            return MADV_COLD;
+#else   // Neither MADV_PAGEOUT nor MADV_COLD is defined.
+            return -1;
+#endif  // MADV_PAGEOUT
+    }
+
+    return -1;
+}
+
+void LargeAdvise(void *ptr, size_t size, LargeAccessPattern pattern) {
+    if (ptr == NULL || size < kHugePageSize) return;
+
+    // Hints are best effort, so failures are ignored.
+    int advice = GetAdvice(pattern);
+    if (advice >= 0) madvise(ptr, GetMappingSize(size), advice);
+}
+
+void LargeAllocSetNumaFirstTouch(bool enabled) {
+    numa_first_touch = enabled;
+}
+
+bool LargeAllocNumaFirstTouch(void) { return numa_first_touch; }
+
+void LargeFirstTouch(void *ptr, size_t size) {
+    // Heap buffers are small and have already been zeroed by calloc.
+    if (!numa_first_touch || ptr == NULL || size < kHugePageSize) return;
+
+    // Work is split on huge page boundaries so that each huge page is faulted
+    // in by exactly one thread. The buffer may start in the middle of a huge
+    // page if it is backed by THP, so the boundaries are taken relative to the
+    // huge page that contains its first byte.
+    uintptr_t begin = (uintptr_t)ptr;
+    uintptr_t end = begin + size;
+    uintptr_t first = begin & ~(uintptr_t)(kHugePageSize - 1);
+    int64_t num_huge_pages =
+        (int64_t)((end - first + kHugePageSize - 1) / kHugePageSize);
+
+    // Mapped pages already read as zeros, so writing a single zero byte to
+    // each page is enough to fault it in without clearing it once more. The
+    // first write to a huge page faults in all of it and the remaining writes
+    // only hit memory that is already mapped. They are still needed for
+    // buffers that fell back to base pages.
+    PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_STATIC
+    for (int64_t i = 0; i < num_huge_pages; ++i) {
+        uintptr_t lo = first + (uintptr_t)i * kHugePageSize;
+        uintptr_t hi = lo + kHugePageSize;
+        if (lo < begin) lo = begin;
+        if (hi > end) hi = end;
+        for (uintptr_t addr = lo; addr < hi; addr += kBasePageSize) {
+            *(volatile char *)addr = 0;
+        }
+    }
+}
+
+void LargeFree(void *ptr, size_t size) {
+    if (ptr == NULL) return;
+    if (size < kHugePageSize) {
+        free(ptr);
+        return;
+    }
+
+    // All mappings are made in multiples of the huge page size regardless of
+    // the backing mode, so the length can be recovered from the size alone.
+    munmap(ptr, GetMappingSize(size));
+}
+
+void LargeAllocPrintStats(void) {
+    printf("Large buffer allocations:\n");
+    PRAGMA_OMP_CRITICAL(large_alloc_stats) {
+        for (int i = 0; i < kNumLargeAllocModes; ++i) {
+            if (num_allocs[i] == 0) continue;
+            printf("  %s: %" PRId64 " allocation(s), %" PRId64 " bytes\n",
+                   kModeNames[i], num_allocs[i], num_bytes[i]);
+        }
+    }
+}
@@ -0,0 +1,152 @@
+/**
+ * @file large_alloc.h
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Allocator for large, solver-sized buffers backed by huge pages when
+ * available.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAMESMANONE_CORE_LARGE_ALLOC_H_
+#define GAMESMANONE_CORE_LARGE_ALLOC_H_
+
+#include <stdbool.h>  // bool
+#include <stddef.h>   // size_t
+
+/**
+ * @brief Backing modes of buffers allocated by \c LargeCalloc.
+ */
+typedef enum {
+    kLargeAllocHeap,      /**< Small buffer, allocated with calloc. */
+    kLargeAllocHugetlb,   /**< Explicit huge pages from hugetlbfs. */
+    kLargeAllocThp,       /**< Anonymous mmap with MADV_HUGEPAGE. */
+    kLargeAllocBasePages, /**< Anonymous mmap with base (4 KiB) pages. */
+    kLargeAllocFile,      /**< Shared mmap of an unlinked temporary file. */
+    kNumLargeAllocModes,
+} LargeAllocMode;
+
+/**
+ * @brief Expected access patterns of large buffers, see \c LargeAdvise.
+ */
+typedef enum {
+    kLargeAccessNormal,     /**< No particular pattern. */
+    kLargeAccessSequential, /**< Accessed in increasing address order. */
+    kLargeAccessRandom,     /**< Accessed at random; do not read ahead. */
+    /** Not accessed again soon; the pages may be written back and evicted. */
+    kLargeAccessDone,
+} LargeAccessPattern;
+
+/**
+ * @brief Allocates a zero-initialized buffer of \p size bytes, using huge pages
+ * if possible.
+ *
+ * @details Buffers of at least 2 MiB are mapped with mmap. Explicit huge pages
+ * (MAP_HUGETLB) are tried first, then an anonymous mapping advised with
+ * MADV_HUGEPAGE, and finally an ordinary anonymous mapping if transparent huge
+ * pages are disabled. Smaller buffers are allocated with calloc. Physical
+ * pages are not touched by this function, so the first-touch NUMA placement is
+ * decided by the threads that first write to the buffer.
+ *
+ * @param size Size of the buffer in bytes.
+ * @return Pointer to the new buffer, which must be deallocated using
+ * \c LargeFree with the same \p size, or
+ * @return NULL on failure.
+ */
+void *LargeCalloc(size_t size);
+
+/**
+ * @brief Allocates a zero-initialized buffer of \p size bytes backed by a
+ * temporary file in the directory \p dir instead of memory, so that buffers
+ * larger than the physical memory can be used at the speed of the underlying
+ * storage. Falls back to \c LargeCalloc if \p dir is NULL.
+ *
+ * @details The file is created with mkstemp, unlinked immediately so that it
+ * is removed even if the process crashes, extended to the buffer size without
+ * writing any data, and mapped with MAP_SHARED. The kernel reads the pages in
+ * on demand and writes dirty pages back as memory runs short. Use
+ * \c LargeAdvise to describe the access pattern of each pass over the buffer.
+ * Buffers smaller than the huge page size are allocated on the heap.
+ *
+ * @param size Size of the buffer in bytes.
+ * @param dir Directory on fast local storage in which to create the file.
+ * @return Pointer to the new buffer, which must be deallocated using
+ * \c LargeFree with the same \p size, or
+ * @return NULL on failure.
+ */
+void *LargeCallocFileBacked(size_t size, const char *dir);
+
+/**
+ * @brief Advises the kernel that the buffer \p ptr of \p size bytes previously
+ * allocated by \c LargeCalloc or \c LargeCallocFileBacked will be accessed
+ * following \p pattern. Does nothing for buffers on the heap or if the hint is
+ * not supported.
+ *
+ * @note The hints only affect performance. In particular,
+ * \c kLargeAccessDone never discards data, but it may push the pages of an
+ * anonymous buffer to swap.
+ */
+void LargeAdvise(void *ptr, size_t size, LargeAccessPattern pattern);
+
+/**
+ * @brief Enables or disables the NUMA first-touch mode, which is disabled by
+ * default. See \c LargeFirstTouch.
+ */
+void LargeAllocSetNumaFirstTouch(bool enabled);
+
+/**
+ * @brief Returns whether the NUMA first-touch mode is enabled.
+ */
+bool LargeAllocNumaFirstTouch(void);
+
+/**
+ * @brief Touches every page of the anonymous buffer \p ptr of \p size bytes
+ * previously allocated by \c LargeCalloc in parallel using a static schedule
+ * if the NUMA first-touch mode is enabled. Does nothing otherwise.
+ *
+ * @details Under the default first-touch policy of the kernel, each page is
+ * placed on the NUMA node of the thread that touches it first. Touching the
+ * buffer with the same static schedule as the solver loops that work on it
+ * spreads its pages across the nodes of all worker threads instead of placing
+ * them on the node of the allocating thread. This only helps if the OpenMP
+ * threads are bound to cores, e.g., with OMP_PLACES=cores and
+ * OMP_PROC_BIND=spread.
+ *
+ * The buffer is divided among threads in whole 2 MiB huge pages, since a huge
+ * page is placed on a single node as a whole. Placement is therefore only as
+ * fine as one huge page: near each thread boundary, up to about one huge page
+ * of the buffer may end up on the node of the neighboring thread.
+ */
+void LargeFirstTouch(void *ptr, size_t size);
+
+/**
+ * @brief Deallocates the buffer \p ptr of \p size bytes previously allocated
+ * using \c LargeCalloc or \c LargeCallocFileBacked. Does nothing if \p ptr is
+ * NULL.
+ */
+void LargeFree(void *ptr, size_t size);
+
+/**
+ * @brief Prints the number of allocations and bytes allocated in each backing
+ * mode to stdout.
+ */
+void LargeAllocPrintStats(void);
+
+#endif  // GAMESMANONE_CORE_LARGE_ALLOC_H_
@@ -40,7 +40,7 @@
 #include <string.h>     // strcspn, strlen, strncpy
 #include <sys/stat.h>   // mkdir, struct stat
 #include <sys/types.h>  // mode_t
-#include <time.h>       // clock_t, CLOCKS_PER_SEC
+#include <time.h>       // clock_t, CLOCKS_PER_SEC, clock_gettime
 #include <unistd.h>     // close, _exit
 #include <zlib.h>  // gzFile, gzopen, gzdopen, gzread, gzwrite, Z_NULL, Z_OK
 #ifdef USE_MPI
@@ -133,6 +133,12 @@ void *GenericPointerAdd(const void *p, int64_t offset) {
 
 double ClockToSeconds(clock_t n) { return (double)n / CLOCKS_PER_SEC; }
 
+double GetWallTime(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
 char *GetTimeStampString(void) {
     time_t rawtime = time(NULL);
     static char time_str[26];  // 26 bytes as requested by ctime_r.
@@ -119,6 +119,14 @@ void *GenericPointerAdd(const void *p, int64_t offset);
 /** @brief Return the number of seconds corresponding to N clock ticks. */
 double ClockToSeconds(clock_t n);
 
+/**
+ * @brief Returns the current wall-clock time in seconds relative to an
+ * arbitrary fixed point in the past. Unlike clock(), the result does not
+ * scale with the number of running threads, which makes it suitable for timing
+ * parallel code sections.
+ */
+double GetWallTime(void);
+
 /** @brief Return the current system time stamp as a c-string. */
 char *GetTimeStampString(void);
 
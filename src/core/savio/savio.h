@@ -42,6 +42,7 @@ typedef struct SavioJobSettings {
     int ntasks_per_node;
     char time_limit[kSavioTimeLimitLengthMax + 1];
     bool bind_omp_threads_to_cores;
+    bool numa;
 } SavioJobSettings;
 
 extern const SavioPartition kSavioPartitions[kNumSavioPartitions];
@@ -28,9 +28,10 @@ static int PrintExclusive(FILE *file);
 static int Print512GbSavio4Request(FILE *file);
 static int PrintModuleLoad(FILE *file, bool use_savio4);
 static int PrintExportOmpNumThreads(FILE *file, int num_threads);
+static int PrintExportOmpPlacesAndProcBind(FILE *file);
 static int PrintSolveCommand(FILE *file, int num_processes,
                              int cpus_per_proccess, ReadOnlyString game_name,
-                             int variant_id);
+                             int variant_id, bool numa);
 
 // -----------------------------------------------------------------------------
 
@@ -63,8 +64,10 @@ int SavioScriptGeneratorWrite(const SavioJobSettings *settings) {
     }
     PrintModuleLoad(file, use_savio4);
     PrintExportOmpNumThreads(file, omp_num_threads);
+    if (settings->numa) PrintExportOmpPlacesAndProcBind(file);
     PrintSolveCommand(file, num_proccesses, cpus_per_process,
-                      settings->game_name, settings->game_variant_id);
+                      settings->game_name, settings->game_variant_id,
+                      settings->numa);
 
     int error = GuardedFclose(file);
     if (error) return kFileSystemError;
@@ -171,10 +174,21 @@ static int PrintExportOmpNumThreads(FILE *file, int num_threads) {
     return fprintf(file, "export OMP_NUM_THREADS=%d\n", num_threads);
 }
 
+// Pins each OpenMP thread to its own core and spreads the threads across the
+// sockets so that the first-touch initialization of the solver arrays in NUMA
+// mode places their pages evenly on all NUMA nodes, and the threads that
+// touched a page stay on the node that owns it.
+static int PrintExportOmpPlacesAndProcBind(FILE *file) {
+    return fprintf(file,
+                   "export OMP_PLACES=cores\n"
+                   "export OMP_PROC_BIND=spread\n");
+}
+
 static int PrintSolveCommand(FILE *file, int num_processes,
                              int cpus_per_proccess, ReadOnlyString game_name,
-                             int variant_id) {
+                             int variant_id, bool numa) {
     return fprintf(
-        file, "srun -n %d -c %d --cpu_bind=cores bin/gamesman solve %s %d\n",
-        num_processes, cpus_per_proccess, game_name, variant_id);
+        file, "srun -n %d -c %d --cpu_bind=cores bin/gamesman solve %s %d%s\n",
+        num_processes, cpus_per_proccess, game_name, variant_id,
+        numa ? " --numa" : "");
 }
@@ -65,6 +65,9 @@ static const SolverConfig *RegularSolverGetCurrentConfig(void);
 static int RegularSolverSetOption(int option, int selection);
 static Value RegularSolverGetValue(TierPosition tier_position);
 static int RegularSolverGetRemoteness(TierPosition tier_position);
+static int RegularSolverGetRecordsBatch(int64_t size,
+                                        const TierPosition *tier_positions,
+                                        Value *values, int *remotenesses);
 
 /** @brief Regular Solver definition. */
 const Solver kRegularSolver = {
@@ -86,6 +89,7 @@ const Solver kRegularSolver = {
 
     .GetValue = &RegularSolverGetValue,
     .GetRemoteness = &RegularSolverGetRemoteness,
+    .GetRecordsBatch = &RegularSolverGetRecordsBatch,
 };
 
 static ConstantReadOnlyString kChoices[] = {"On", "Off"};
@@ -415,6 +419,33 @@ static int RegularSolverGetRemoteness(TierPosition tier_position) {
     return ret;
 }
 
+static int RegularSolverGetRecordsBatch(int64_t size,
+                                        const TierPosition *tier_positions,
+                                        Value *values, int *remotenesses) {
+    if (size <= 0) return kNoError;
+    TierPosition *canonicals =
+        (TierPosition *)malloc(size * sizeof(TierPosition));
+    if (canonicals == NULL) return kMallocFailureError;
+
+    for (int64_t i = 0; i < size; ++i) {
+        canonicals[i].tier = kDefaultTier;
+        canonicals[i].position =
+            current_api.GetCanonicalPosition(tier_positions[i]);
+    }
+    DbProbe probe;
+    int error = DbManagerProbeInit(&probe);
+    if (error != kNoError) {
+        free(canonicals);
+        return error;
+    }
+    error = DbManagerProbeRecordsBatch(&probe, size, canonicals, values,
+                                       remotenesses);
+    DbManagerProbeDestroy(&probe);
+    free(canonicals);
+
+    return error;
+}
+
 // -----------------------------------------------------------------------------
 
 static bool RequiredApiFunctionsImplemented(const RegularSolverApi *api) {
@@ -36,6 +36,7 @@
 
 #include <assert.h>  // assert
 #include <stddef.h>  // NULL
+#include <stdint.h>  // int64_t
 #include <stdio.h>   // printf
 
 #include "core/game_manager.h"
@@ -97,3 +98,20 @@ Value SolverManagerGetValue(TierPosition tier_position) {
 int SolverManagerGetRemoteness(TierPosition tier_position) {
     return current_solver->GetRemoteness(tier_position);
 }
+
+int SolverManagerGetRecordsBatch(int64_t size,
+                                 const TierPosition *tier_positions,
+                                 Value *values, int *remotenesses) {
+    if (current_solver->GetRecordsBatch != NULL) {
+        return current_solver->GetRecordsBatch(size, tier_positions, values,
+                                               remotenesses);
+    }
+
+    for (int64_t i = 0; i < size; ++i) {
+        values[i] = current_solver->GetValue(tier_positions[i]);
+        if (remotenesses == NULL) continue;
+        remotenesses[i] = current_solver->GetRemoteness(tier_positions[i]);
+    }
+
+    return kNoError;
+}
@@ -121,4 +121,26 @@ Value SolverManagerGetValue(TierPosition tier_position);
  */
 int SolverManagerGetRemoteness(TierPosition tier_position);
 
+/**
+ * @brief Probes the values and, if REMOTENESSES is not NULL, the remotenesses
+ * of the SIZE tier positions in TIER_POSITIONS, and stores them in VALUES and
+ * REMOTENESSES in the same order as TIER_POSITIONS. Probing a batch of tier
+ * positions at once, such as all children of a position, is faster than
+ * probing them one at a time as the database may group them by storage block.
+ *
+ * @note Assumes the solver manager is initialized with the SolverManagerInit
+ * function. Results in undefined behavior if called before the solver manager
+ * module is initialized.
+ *
+ * @param size Number of tier positions to probe.
+ * @param tier_positions Array of SIZE tier positions to probe.
+ * @param values (Output parameter) Array of SIZE values.
+ * @param remotenesses (Output parameter) Array of SIZE remotenesses, or NULL if
+ * only the values are needed.
+ * @return 0 on success, non-zero error code otherwise.
+ */
+int SolverManagerGetRecordsBatch(int64_t size,
+                                 const TierPosition *tier_positions,
+                                 Value *values, int *remotenesses);
+
 #endif  // GAMESMANONE_CORE_SOLVERS_SOLVER_MANAGER_H_
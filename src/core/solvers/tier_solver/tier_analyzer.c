@@ -33,6 +33,7 @@
 
 #include "core/analysis/analysis.h"
 #include "core/analysis/stat_manager.h"
+#include "core/constants.h"
 #include "core/concurrency.h"
 #include "core/data_structures/bitstream.h"
 #include "core/db/db_manager.h"
@@ -476,6 +477,8 @@ static bool Step5Analyze(Analysis *dest) {
             Value value = DbManagerGetValueFromLoaded(this_tier, canonical);
             int remoteness =
                 DbManagerGetRemotenessFromLoaded(this_tier, canonical);
+            // Value-only tiers are counted as if all remotenesses were 0.
+            if (remoteness == kUnknownRemoteness) remoteness = 0;
             bool is_canonical = (tier_position.position == canonical);
             int error = AnalysisCount(&parts[tid], tier_position, value,
                                       remoteness, is_canonical);
@@ -0,0 +1,301 @@
+/**
+ * @file tier_converter.c
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Implementation of the tier converter.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/solvers/tier_solver/tier_converter.h"
+
+#include <stdbool.h>  // bool, true, false
+#include <stdint.h>   // int8_t, int16_t, int64_t
+#include <stdio.h>    // fprintf, stderr
+#include <stdlib.h>   // calloc, malloc, free
+
+#include "core/concurrency.h"
+#include "core/constants.h"
+#include "core/db/db_manager.h"
+#include "core/types/gamesman_types.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // _OPENMP
+
+// Number of positions read from the reference database before they are
+// written into the current database. Remotenesses are reserved in the current
+// database once per slice so that compact formats are only widened if needed.
+static const int64_t kSliceSize = 1 << 20;
+
+// Records of a slice read from the reference database.
+typedef struct {
+    int8_t *values;
+    int16_t *remotenesses;
+} ConverterSlice;
+
+static int GetNumThreads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else   // _OPENMP not defined
+    return 1;
+#endif  // _OPENMP
+}
+
+static int GetThreadId(void) {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else   // _OPENMP not defined, thread 0 is the only available thread.
+    return 0;
+#endif  // _OPENMP
+}
+
+static void DestroyProbes(DbProbe *probes, int num_probes) {
+    for (int i = 0; i < num_probes; ++i) {
+        if (probes[i].buffer != NULL) DbManagerRefProbeDestroy(&probes[i]);
+    }
+    free(probes);
+}
+
+static DbProbe *InitProbes(int num_probes) {
+    DbProbe *probes = (DbProbe *)calloc(num_probes, sizeof(DbProbe));
+    if (probes == NULL) return NULL;
+
+    for (int i = 0; i < num_probes; ++i) {
+        if (DbManagerRefProbeInit(&probes[i]) != kNoError) {
+            DestroyProbes(probes, i);
+            return NULL;
+        }
+    }
+
+    return probes;
+}
+
+// Reads positions [BEGIN, BEGIN + SIZE) of TIER from the reference database
+// into SLICE and sets MAX_REMOTENESS to the largest remoteness read. Unknown
+// remotenesses are only accepted if VALUE_ONLY is true. Returns kNoError on
+// success, kIllegalArgumentError if an unknown remoteness is read while
+// VALUE_ONLY is false, or kRuntimeError if a record could not be read.
+static int ReadSlice(ConverterSlice *slice, DbProbe *probes, Tier tier,
+                     int64_t begin, int64_t size, bool value_only,
+                     int *max_remoteness) {
+    ConcurrentBool success, known;
+    ConcurrentBoolInit(&success, true);
+    ConcurrentBoolInit(&known, true);
+    int max = 0;
+    PRAGMA_OMP_PARALLEL_FOR_REDUCTION_MAX(max)
+    for (int64_t i = 0; i < size; ++i) {
+        if (!ConcurrentBoolLoad(&success)) continue;  // Fail fast.
+        DbProbe *probe = &probes[GetThreadId()];
+        TierPosition tier_position = {.tier = tier, .position = begin + i};
+        Value value = DbManagerRefProbeValue(probe, tier_position);
+        int remoteness = DbManagerRefProbeRemoteness(probe, tier_position);
+        if (value == kErrorValue || remoteness == kErrorRemoteness) {
+            ConcurrentBoolStore(&success, false);
+            continue;
+        } else if (remoteness == kUnknownRemoteness && !value_only) {
+            ConcurrentBoolStore(&known, false);
+            ConcurrentBoolStore(&success, false);
+            continue;
+        }
+        slice->values[i] = (int8_t)value;
+        slice->remotenesses[i] = (int16_t)remoteness;
+        if (remoteness > max) max = remoteness;
+    }
+    *max_remoteness = max;
+
+    if (!ConcurrentBoolLoad(&known)) return kIllegalArgumentError;
+    return ConcurrentBoolLoad(&success) ? kNoError : kRuntimeError;
+}
+
+// Writes SLICE into positions [BEGIN, BEGIN + SIZE) of the solving tier of the
+// current database.
+static int WriteSlice(const ConverterSlice *slice, int64_t begin,
+                      int64_t size) {
+    ConcurrentBool success;
+    ConcurrentBoolInit(&success, true);
+    PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_STATIC
+    for (int64_t i = 0; i < size; ++i) {
+        Position position = begin + i;
+        DbManagerSetValue(position, slice->values[i]);
+
+        // Unknown remotenesses are only read for value-only targets, which do
+        // not store remotenesses.
+        if (slice->remotenesses[i] < 0) continue;
+        if (DbManagerSetRemoteness(position, slice->remotenesses[i]) !=
+            kNoError) {
+            ConcurrentBoolStore(&success, false);
+        }
+    }
+
+    return ConcurrentBoolLoad(&success) ? kNoError : kRuntimeError;
+}
+
+static int CopyRecords(Tier tier, int64_t size, bool value_only,
+                       DbProbe *probes) {
+    int64_t slice_size = size < kSliceSize ? size : kSliceSize;
+    ConverterSlice slice = {
+        .values = (int8_t *)calloc(slice_size, sizeof(int8_t)),
+        .remotenesses = (int16_t *)calloc(slice_size, sizeof(int16_t)),
+    };
+    int error = kNoError;
+    if (slice.values == NULL || slice.remotenesses == NULL) {
+        error = kMallocFailureError;
+        goto _bailout;
+    }
+
+    for (int64_t begin = 0; begin < size; begin += slice_size) {
+        int64_t this_size = size - begin;
+        if (this_size > slice_size) this_size = slice_size;
+        int max_remoteness;
+        error = ReadSlice(&slice, probes, tier, begin, this_size, value_only,
+                          &max_remoteness);
+        if (error == kIllegalArgumentError) {
+            fprintf(stderr,
+                    "TierConverterConvert: tier %" PRITier
+                    " was solved without remotenesses and can only be "
+                    "converted into a value-only database\n",
+                    tier);
+            goto _bailout;
+        } else if (error != kNoError) {
+            fprintf(stderr,
+                    "TierConverterConvert: failed to read tier %" PRITier
+                    " from the reference database\n",
+                    tier);
+            goto _bailout;
+        }
+
+        error = DbManagerReserveRemoteness(max_remoteness);
+        if (error != kNoError) goto _bailout;
+        error = WriteSlice(&slice, begin, this_size);
+        if (error != kNoError) goto _bailout;
+    }
+
+_bailout:
+    free(slice.values);
+    free(slice.remotenesses);
+
+    return error;
+}
+
+int TierConverterConvert(Tier tier, int64_t size, bool value_only) {
+    int num_threads = GetNumThreads();
+    DbProbe *probes = InitProbes(num_threads);
+    if (probes == NULL) return kMallocFailureError;
+
+    int error = DbManagerCreateSolvingTier(tier, size);
+    if (error != kNoError) {
+        DestroyProbes(probes, num_threads);
+        return error;
+    }
+
+    error = CopyRecords(tier, size, value_only, probes);
+    DestroyProbes(probes, num_threads);
+    if (error == kNoError) error = DbManagerFlushSolvingTier(NULL);
+    DbManagerFreeSolvingTier();
+
+    return error;
+}
+
+// Reads all records of TIER from the reference database into VALUES and
+// REMOTENESSES using the calling thread only.
+static int ReadTier(Tier tier, int64_t size, int8_t *values,
+                    int16_t *remotenesses) {
+    DbProbe probe;
+    int error = DbManagerRefProbeInit(&probe);
+    if (error != kNoError) return error;
+
+    for (int64_t i = 0; i < size; ++i) {
+        TierPosition tier_position = {.tier = tier, .position = i};
+        Value value = DbManagerRefProbeValue(&probe, tier_position);
+        int remoteness = DbManagerRefProbeRemoteness(&probe, tier_position);
+        if (value == kErrorValue || remoteness == kErrorRemoteness) {
+            fprintf(stderr,
+                    "TierConverterCompact: failed to read tier %" PRITier
+                    " from the reference database\n",
+                    tier);
+            error = kRuntimeError;
+            break;
+        } else if (remoteness == kUnknownRemoteness) {
+            fprintf(stderr,
+                    "TierConverterCompact: tier %" PRITier
+                    " was solved without remotenesses and cannot be "
+                    "compacted\n",
+                    tier);
+            error = kIllegalArgumentError;
+            break;
+        }
+        values[i] = (int8_t)value;
+        remotenesses[i] = (int16_t)remoteness;
+    }
+    DbManagerRefProbeDestroy(&probe);
+
+    return error;
+}
+
+// Compares the records of TIER in the current database against VALUES and
+// REMOTENESSES using the calling thread only.
+static int VerifyTier(Tier tier, int64_t size, const int8_t *values,
+                      const int16_t *remotenesses) {
+    DbProbe probe;
+    int error = DbManagerProbeInit(&probe);
+    if (error != kNoError) return error;
+
+    for (int64_t i = 0; i < size; ++i) {
+        TierPosition tier_position = {.tier = tier, .position = i};
+        if (DbManagerProbeValue(&probe, tier_position) != values[i] ||
+            DbManagerProbeRemoteness(&probe, tier_position) !=
+                remotenesses[i]) {
+            fprintf(stderr,
+                    "TierConverterCompact: position %" PRIPos
+                    " of tier %" PRITier
+                    " does not match the reference database\n",
+                    tier_position.position, tier);
+            error = kRuntimeError;
+            break;
+        }
+    }
+    DbManagerProbeDestroy(&probe);
+
+    return error;
+}
+
+int TierConverterCompact(Tier tier, int64_t size) {
+    // An empty tier has no records to read or verify, but its file must still
+    // be written. Skip the allocations, as malloc(0) may return NULL.
+    if (size == 0) return DbManagerWriteTier(tier, 0, NULL, NULL);
+
+    int8_t *values = (int8_t *)malloc(size * sizeof(int8_t));
+    int16_t *remotenesses = (int16_t *)malloc(size * sizeof(int16_t));
+    int error = kMallocFailureError;
+    if (values != NULL && remotenesses != NULL) {
+        error = ReadTier(tier, size, values, remotenesses);
+    }
+    if (error == kNoError) {
+        error = DbManagerWriteTier(tier, size, values, remotenesses);
+    }
+    if (error == kNoError) {
+        error = VerifyTier(tier, size, values, remotenesses);
+    }
+    free(values);
+    free(remotenesses);
+
+    return error;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file tier_converter.h
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Tier converter which copies solved tiers from one database into
+ * another.
+ * @details The converter reads every record of a tier from the reference
+ * database through per-thread probes and writes it into the solving tier of the
+ * current database, which is then flushed in the format of the current
+ * database. Since only probing is required of the source, any database can be
+ * converted into any database that implements the solving interface.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAMESMANONE_CORE_SOLVERS_TIER_SOLVER_TIER_CONVERTER_H_
+#define GAMESMANONE_CORE_SOLVERS_TIER_SOLVER_TIER_CONVERTER_H_
+
+#include <stdbool.h>  // bool
+#include <stdint.h>   // int64_t
+
+#include "core/types/gamesman_types.h"
+
+/**
+ * @brief Copies the records of \p tier from the reference database into the
+ * current database and flushes the tier to disk, using all available threads.
+ *
+ * @note Assumes that the reference database has been initialized using
+ * DbManagerInitRefDb and contains the solved \p tier, and that the current
+ * database has been initialized in read-write mode.
+ *
+ * @param tier Tier to convert.
+ * @param size Size of \p tier in number of positions.
+ * @param value_only Whether the current database stores values only. If
+ * false, \p tier must have been solved with remotenesses.
+ * @return kNoError on success,
+ * @return kIllegalArgumentError if \p value_only is false but \p tier was
+ * solved without remotenesses, or
+ * @return non-zero error code on any other failure.
+ */
+int TierConverterConvert(Tier tier, int64_t size, bool value_only);
+
+/**
+ * @brief Compacts \p tier from the reference database into the current
+ * database using DbManagerWriteTier and verifies that every record read back
+ * from the new tier file matches the reference database, using the calling
+ * thread only.
+ *
+ * @note Assumes that the reference database has been initialized using
+ * DbManagerInitRefDb and contains the solved \p tier, and that the current
+ * database has been initialized in read-write mode and supports concurrent
+ * tier writes. Since no state is shared between calls, this function may be
+ * called concurrently from multiple threads on distinct tiers.
+ *
+ * @param tier Tier to compact.
+ * @param size Size of \p tier in number of positions.
+ * @return kNoError on success,
+ * @return kIllegalArgumentError if \p tier was solved without remotenesses,
+ * or
+ * @return non-zero error code on any other failure, including a record
+ * mismatch.
+ */
+int TierConverterCompact(Tier tier, int64_t size);
+
+#endif  // GAMESMANONE_CORE_SOLVERS_TIER_SOLVER_TIER_CONVERTER_H_
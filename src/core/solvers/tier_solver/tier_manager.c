@@ -41,14 +41,17 @@
 #include <stddef.h>    // NULL
 #include <stdint.h>    // int64_t
 #include <stdio.h>     // printf, fprintf, stderr
-#include <stdlib.h>    // malloc, free
+#include <stdlib.h>    // malloc, free, qsort
 #include <time.h>      // time_t, time, difftime
 
 #include "core/analysis/analysis.h"
+#include "core/concurrency.h"
 #include "core/db/db_manager.h"
+#include "core/large_alloc.h"
 #include "core/misc.h"
 #include "core/solvers/tier_solver/reverse_tier_graph.h"
 #include "core/solvers/tier_solver/tier_analyzer.h"
+#include "core/solvers/tier_solver/tier_converter.h"
 #include "core/solvers/tier_solver/tier_solver.h"
 #include "core/solvers/tier_solver/tier_worker.h"
 #include "core/types/gamesman_types.h"
@@ -130,7 +133,7 @@ static int EnqueuePrimitiveTiers(void);
 static void CreateTierGraphPrintError(int error);
 
 #ifndef USE_MPI
-static int SolveTierGraph(bool force, int verbose);
+static int SolveTierGraph(const TierSolverSolveOptions *options);
 #else   // USE_MPI
 static int SolveTierGraphMpi(bool force, int verbose);
 static void SolveTierGraphMpiTerminateWorkers(void);
@@ -163,13 +166,23 @@ static void PrintAnalyzed(Tier tier, const Analysis *analysis, int verbose);
 static void AnalyzeUpdateTierGraph(Tier analyzed_tier);
 static void PrintAnalyzerResult(void);
 
+static int ConvertTierGraph(const TierSolverConvertOptions *options);
+static void ConvertTiers(bool force, bool value_only, int verbose);
+static int CompactTiers(bool force, int verbose);
+static void PrintConverted(Tier tier, int64_t tier_size, int error,
+                           int verbose);
+static void PrintConverterResult(double time_elapsed);
+
+static int RebalanceTierGraph(int verbose);
+
 static int TestTierGraph(long seed, int64_t test_size);
 static void PrintTierGraphAnalysis(void);
 static void PrintTestResult(double time_elapsed);
 
 // -----------------------------------------------------------------------------
 
-int TierManagerSolve(const TierSolverApi *api, bool force, int verbose) {
+int TierManagerSolve(const TierSolverApi *api,
+                     const TierSolverSolveOptions *options) {
     time_t begin = time(NULL);
     api_internal = api;
     int error = InitGlobalVariables(kTierSolving);
@@ -181,14 +194,14 @@ int TierManagerSolve(const TierSolverApi *api, bool force, int verbose) {
     }
 
 #ifndef USE_MPI  // If not using MPI
-    int ret = SolveTierGraph(force, verbose);
+    int ret = SolveTierGraph(options);
 #else   // Using MPI
-    int ret = SolveTierGraphMpi(force, verbose);
+    int ret = SolveTierGraphMpi(options->force, options->verbose);
 #endif  // USE_MPI
     DestroyGlobalVariables();
 
     time_t end = time(NULL);
-    if (verbose > 0) {
+    if (options->verbose > 0) {
         printf("Time Elapsed: %d seconds\n", (int)difftime(end, begin));
     }
 
@@ -211,6 +224,39 @@ int TierManagerAnalyze(const TierSolverApi *api, bool force, int verbose) {
     return ret;
 }
 
+int TierManagerConvert(const TierSolverApi *api,
+                       const TierSolverConvertOptions *options) {
+    api_internal = api;
+    int error = InitGlobalVariables(kTierSolving);
+    if (error != 0) {
+        fprintf(stderr,
+                "TierManagerConvert: initialization failed with code %d.\n",
+                error);
+        return error;
+    }
+
+    int ret = ConvertTierGraph(options);
+    DestroyGlobalVariables();
+
+    return ret;
+}
+
+int TierManagerRebalance(const TierSolverApi *api, int verbose) {
+    api_internal = api;
+    int error = InitGlobalVariables(kTierSolving);
+    if (error != 0) {
+        fprintf(stderr,
+                "TierManagerRebalance: initialization failed with code %d.\n",
+                error);
+        return error;
+    }
+
+    int ret = RebalanceTierGraph(verbose);
+    DestroyGlobalVariables();
+
+    return ret;
+}
+
 int TierManagerTest(const TierSolverApi *api, long seed, int64_t test_size) {
     api_internal = api;
     int error = InitGlobalVariables(kTierSolving);
@@ -521,14 +567,20 @@ static void CreateTierGraphPrintError(int error) {
 
 #ifndef USE_MPI
 
-static int SolveTierGraph(bool force, int verbose) {
-    TierWorkerSolveOptions options = {
+static int SolveTierGraph(const TierSolverSolveOptions *options) {
+    TierWorkerSolveOptions worker_options = {
         .compare = false,
-        .force = force,
-        .verbose = verbose,
+        .force = options->force,
+        .verbose = options->verbose,
+        .sort_frontiers = options->sort_frontiers,
+        .frontier_spill_threshold = options->frontier_spill_threshold,
+        .lazy_children = options->lazy_children,
+        .value_only = options->value_only,
+        .out_of_core_dir = options->out_of_core_dir,
+        .out_of_core_budget = options->out_of_core_budget,
     };
     double time_elapsed = 0.0;
-    if (verbose > 0) {
+    if (options->verbose > 0) {
         printf("Begin solving all %" PRId64 " tiers (%" PRId64
                " canonical) of total size %" PRId64 " (positions)\n",
                total_tiers, total_canonical_tiers, total_size);
@@ -541,7 +593,12 @@ static int SolveTierGraph(bool force, int verbose) {
             bool solved;
             TierType type = api_internal->GetTierType(tier);
             int error = TierWorkerSolve(GetMethodForTierType(type), tier,
-                                        &options, &solved);
+                                        &worker_options, &solved);
+            if (error == 0 && !solved && options->lz4) {
+                // The tier was solved before. Convert it into LZ4 format.
+                error = DbManagerConvertTier(tier,
+                                             api_internal->GetTierSize(tier));
+            }
             if (error == 0) {
                 // Solve succeeded.
                 SolveUpdateTierGraph(tier);
@@ -553,12 +610,13 @@ static int SolveTierGraph(bool force, int verbose) {
             }
             time_t end = time(NULL);
             time_elapsed += difftime(end, begin);
-            SolveTierGraphPrintTime(tier, time_elapsed, solved, verbose);
+            SolveTierGraphPrintTime(tier, time_elapsed, solved,
+                                    options->verbose);
         } else {
             ++skipped_tiers;
         }
     }
-    if (verbose > 0) PrintSolverResult(time_elapsed);
+    if (options->verbose > 0) PrintSolverResult(time_elapsed);
     if (failed_tiers == 0) {
         int error = DbManagerSetGameSolved();
         if (error != kNoError) {
@@ -769,6 +827,7 @@ static void PrintSolverResult(double time_elapsed) {
         "\nTotal tiers scanned: %" PRId64 "\n",
         (int)time_elapsed, processed_tiers, skipped_tiers, failed_tiers,
         processed_tiers + skipped_tiers + failed_tiers);
+    LargeAllocPrintStats();
     printf("\n");
 }
 
@@ -916,6 +975,165 @@ static void PrintAnalyzerResult(void) {
     AnalysisPrintEverything(stdout, &game_analysis);
 }
 
+static int ConvertTierGraph(const TierSolverConvertOptions *options) {
+    if (options->verbose > 0) {
+        printf("Begin converting all %" PRId64
+               " canonical tiers of total size %" PRId64 " (positions)\n",
+               total_canonical_tiers, total_size);
+    }
+
+    // Tiers are independent of each other once solved, so the order in which
+    // they are converted does not matter. Databases that build each tier in
+    // private memory allow multiple tiers to be written at the same time.
+    time_t begin = time(NULL);
+    if (DbManagerSupportsConcurrentTierWrites()) {
+        int error = CompactTiers(options->force, options->verbose);
+        if (error != kNoError) return error;
+    } else {
+        ConvertTiers(options->force, options->value_only, options->verbose);
+    }
+    if (options->verbose > 0) {
+        PrintConverterResult(difftime(time(NULL), begin));
+    }
+    if (failed_tiers > 0) return kRuntimeError;
+
+    // Mark the game as solved only after all of its tiers have been converted.
+    int error = DbManagerSetGameSolved();
+    if (error != kNoError) {
+        fprintf(stderr,
+                "ConvertTierGraph: DB manager failed to set current game as "
+                "solved (code %d)\n",
+                error);
+    }
+
+    return error;
+}
+
+static bool ConvertTierNeeded(Tier tier, bool force) {
+    if (!IsCanonicalTier(tier)) return false;
+    return force || DbManagerTierStatus(tier) != kDbTierStatusSolved;
+}
+
+static void ConvertTiers(bool force, bool value_only, int verbose) {
+    TierHashMapIterator it = TierHashMapBegin(&tier_graph);
+    Tier tier;
+    int64_t value;
+    while (TierHashMapIteratorNext(&it, &tier, &value)) {
+        if (!ConvertTierNeeded(tier, force)) {
+            ++skipped_tiers;
+            continue;
+        }
+
+        int64_t tier_size = api_internal->GetTierSize(tier);
+        int error = TierConverterConvert(tier, tier_size, value_only);
+        PrintConverted(tier, tier_size, error, verbose);
+    }
+}
+
+typedef struct {
+    Tier tier;
+    int64_t size;
+} SizedTier;
+
+static int SizedTierCompareSizeDesc(const void *a, const void *b) {
+    int64_t size_a = ((const SizedTier *)a)->size;
+    int64_t size_b = ((const SizedTier *)b)->size;
+
+    return (size_a < size_b) - (size_a > size_b);
+}
+
+static int CompactTiers(bool force, int verbose) {
+    SizedTier *tiers =
+        (SizedTier *)malloc(total_canonical_tiers * sizeof(SizedTier));
+    if (tiers == NULL) return kMallocFailureError;
+
+    int64_t num_tiers = 0;
+    TierHashMapIterator it = TierHashMapBegin(&tier_graph);
+    Tier tier;
+    int64_t value;
+    while (TierHashMapIteratorNext(&it, &tier, &value)) {
+        if (!ConvertTierNeeded(tier, force)) {
+            ++skipped_tiers;
+            continue;
+        }
+        tiers[num_tiers].tier = tier;
+        tiers[num_tiers++].size = api_internal->GetTierSize(tier);
+    }
+
+    // Each thread compacts one tier at a time. Starting with the largest tiers
+    // keeps the threads busy until the end.
+    qsort(tiers, num_tiers, sizeof(SizedTier), &SizedTierCompareSizeDesc);
+    PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_DYNAMIC(1)
+    for (int64_t i = 0; i < num_tiers; ++i) {
+        int error = TierConverterCompact(tiers[i].tier, tiers[i].size);
+        PRAGMA_OMP_CRITICAL(tier_manager_compact_tiers) {
+            PrintConverted(tiers[i].tier, tiers[i].size, error, verbose);
+        }
+    }
+    free(tiers);
+
+    return kNoError;
+}
+
+// Updates the converter counters and prints the result of converting TIER.
+static void PrintConverted(Tier tier, int64_t tier_size, int error,
+                           int verbose) {
+    if (error != kNoError) {
+        printf("Failed to convert tier %" PRITier ", code %d\n", tier, error);
+        ++failed_tiers;
+        return;
+    }
+
+    ++processed_tiers;
+    processed_size += tier_size;
+    if (verbose > 1) {
+        char tier_name[kDbFileNameLengthMax + 1];
+        api_internal->GetTierName(tier, tier_name);
+        printf("%s: Finished converting tier [%s] (#%" PRITier
+               ") of size %" PRId64 "\n",
+               GetTimeStampString(), tier_name, tier, tier_size);
+    }
+}
+
+static void PrintConverterResult(double time_elapsed) {
+    printf(
+        "Finished converting all tiers in %d second(s).\n"
+        "Number of canonical tiers converted: %" PRId64
+        "\nTotal positions converted: %" PRId64
+        "\nNumber of tiers skipped: %" PRId64
+        "\nNumber of tiers failed: %" PRId64 "\n\n",
+        (int)time_elapsed, processed_tiers, processed_size, skipped_tiers,
+        failed_tiers);
+}
+
+static int RebalanceTierGraph(int verbose) {
+    time_t begin = time(NULL);
+    int64_t num_moved = 0;
+    int ret = kNoError;
+    TierHashMapIterator it = TierHashMapBegin(&tier_graph);
+    Tier tier;
+    int64_t value;
+    while (TierHashMapIteratorNext(&it, &tier, &value)) {
+        if (!IsCanonicalTier(tier)) continue;
+        int error = DbManagerRebalanceTier(tier, &num_moved);
+        if (error != kNoError) {
+            fprintf(stderr,
+                    "RebalanceTierGraph: failed to move files of tier %" PRITier
+                    " (code %d)\n",
+                    tier, error);
+            ret = error;
+        }
+    }
+    if (verbose > 0) {
+        printf("Moved %" PRId64 " file(s) of %" PRId64
+               " canonical tiers in %d second(s).\n",
+               num_moved, total_canonical_tiers,
+               (int)difftime(time(NULL), begin));
+    }
+
+    return ret;
+}
+
 static int TestTierGraph(long seed, int64_t test_size) {
     double time_elapsed = 0.0;
     printf("Begin random sanity testing of all %" PRId64 " tiers (%" PRId64
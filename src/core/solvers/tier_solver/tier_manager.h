@@ -45,14 +45,16 @@
  * @brief Creates and solves the tier graph.
  *
  * @param api Tier solver API functions implemented by the current Game.
- * @param force If set to true, the solver will solve each tier regardless of
- * the current database status. Otherwise, the solving stage is skipped if Tier
- * Manager believes that the given tier has been correctly solved already.
- * @param verbose Set to 0 for quiet (only error messages will be printed,) 1
- * for default, and 2 for verbose.
+ * @param options Solver options. If \c options->force is set to true, the
+ * solver will solve each tier regardless of the current database status.
+ * Otherwise, the solving stage is skipped if Tier Manager believes that the
+ * given tier has been correctly solved already. Set \c options->verbose to 0
+ * for quiet (only error messages will be printed,) 1 for default, and 2 for
+ * verbose.
  * @return 0 on success, non-zero error code otherwise.
  */
-int TierManagerSolve(const TierSolverApi *api, bool force, int verbose);
+int TierManagerSolve(const TierSolverApi *api,
+                     const TierSolverSolveOptions *options);
 
 /**
  * @brief Creates and analyzes the tier graph.
@@ -68,6 +70,39 @@ int TierManagerSolve(const TierSolverApi *api, bool force, int verbose);
  */
 int TierManagerAnalyze(const TierSolverApi *api, bool force, int verbose);
 
+/**
+ * @brief Converts all canonical tiers of the game from the reference database
+ * into the current database, and marks the game as solved in the current
+ * database if all tiers are converted successfully.
+ *
+ * @note Assumes that the reference database has been initialized using
+ * DbManagerInitRefDb and contains the solved game, and that the current
+ * database has been initialized in read-write mode.
+ *
+ * @param api Tier solver API functions implemented by the current Game.
+ * @param options Converter options. If \c options->force is set to true,
+ * tiers that already exist in the current database are converted again.
+ * Otherwise, they are skipped. If \c options->db is kBpdbLite, multiple tiers
+ * are compacted concurrently and every record is verified after compaction.
+ * @return 0 on success, non-zero error code otherwise.
+ */
+int TierManagerConvert(const TierSolverApi *api,
+                       const TierSolverConvertOptions *options);
+
+/**
+ * @brief Moves the files of every canonical tier of the current game in the
+ * current database into the data directory assigned to the tier.
+ *
+ * @note Assumes that the current database has been initialized using
+ * DbManagerInitDb.
+ *
+ * @param api Tier solver API functions implemented by the current Game.
+ * @param verbose Level of details to output.
+ * @return kNoError on success, or
+ * @return non-zero error code if any file failed to move.
+ */
+int TierManagerRebalance(const TierSolverApi *api, int verbose);
+
 /**
  * @brief Tests the given tier solver API implementation using the given SEED
  * for random number generation.
@@ -33,8 +33,8 @@
 #include <stddef.h>  // NULL
 #include <stdint.h>  // int64_t, intptr_t
 #include <stdio.h>   // fprintf, stderr
-#include <stdlib.h>  // strtoll
-#include <string.h>  // memset, memcpy, strncmp
+#include <stdlib.h>  // strtoll, malloc, free
+#include <string.h>  // memset, memcpy, strncmp, strlen, strcpy
 #ifdef USE_MPI
 #include <mpi.h>
 #endif  // USE_MPI
@@ -43,6 +43,7 @@
 #include "core/db/arraydb/arraydb.h"
 #include "core/db/bpdb/bpdb_lite.h"
 #include "core/db/db_manager.h"
+#include "core/db/mmapdb/mmapdb.h"
 #include "core/db/naivedb/naivedb.h"
 #include "core/misc.h"
 #include "core/solvers/tier_solver/tier_manager.h"
@@ -65,6 +66,9 @@ static const SolverConfig *TierSolverGetCurrentConfig(void);
 static int TierSolverSetOption(int option, int selection);
 static Value TierSolverGetValue(TierPosition tier_position);
 static int TierSolverGetRemoteness(TierPosition tier_position);
+static int TierSolverGetRecordsBatch(int64_t size,
+                                     const TierPosition *tier_positions,
+                                     Value *values, int *remotenesses);
 
 /** @brief Tier Solver definition. */
 const Solver kTierSolver = {
@@ -86,6 +90,7 @@ const Solver kTierSolver = {
 
     .GetValue = &TierSolverGetValue,
     .GetRemoteness = &TierSolverGetRemoteness,
+    .GetRecordsBatch = &TierSolverGetRecordsBatch,
 };
 
 // Size of each uncompressed XZ block for ArrayDb compression. Smaller block
@@ -132,14 +137,27 @@ static SolverOption current_options[NUM_OPTIONS_MAX];
 static int current_selections[NUM_OPTIONS_MAX];
 #undef NUM_OPTIONS_MAX
 
-// Whether the current game was solved and stored with an older database
-// version. Solving, including force re-solving, are disabled to prevent
-// damage to the old database.
+// Whether the current game was solved and stored in a read-only database, which
+// is either an older database version or a serving format converted from the
+// solver's database. Solving, including force re-solving, are disabled to
+// prevent damage to the read-only database.
 static bool read_only_db;
 
 // Solver status: 0 if not solved, 1 if solved.
 static int solver_status;
 
+// Game name, variant, and data path of the current database, used to
+// reinitialize the database with different options before solving.
+static ReadOnlyString current_game_name;
+static int current_variant;
+static char *current_data_path;
+
+// Probe reused by TierSolverGetValue and TierSolverGetRemoteness so that the
+// blocks it caches are shared across queries. Must be destroyed before the
+// database is finalized or modified.
+static DbProbe query_probe;
+static bool query_probe_initialized;
+
 // Helper Functions
 
 static bool RequiredApiFunctionsImplemented(const TierSolverApi *api);
@@ -155,6 +173,11 @@ static bool SetCurrentApi(const TierSolverApi *api);
 
 static int SetDb(ReadOnlyString game_name, int variant,
                  ReadOnlyString data_path);
+static int DiscoverDb(void);
+static const Database *FindSolvedDb(const Database *exclude);
+static int SetSolvingDbOptions(const TierSolverSolveOptions *options);
+static DbProbe *GetQueryProbe(void);
+static void DestroyQueryProbe(void);
 
 static TierPosition GetCanonicalTierPosition(TierPosition tier_position);
 
@@ -204,7 +227,11 @@ _bailout:
 static int TierSolverFinalize(void) {
     read_only_db = false;
     solver_status = kTierSolverSolveStatusNotSolved;
+    DestroyQueryProbe();
     DbManagerFinalizeDb();
+    free(current_data_path);
+    current_data_path = NULL;
+    current_game_name = NULL;
     memset(&default_api, 0, sizeof(default_api));
     memset(&current_api, 0, sizeof(current_api));
     memset(&current_config, 0, sizeof(current_config));
@@ -282,18 +309,12 @@ static ReadOnlyString TierSolverExplainTestError(int error) {
 }
 
 static ConstantReadOnlyString kTierSolverSolveSkipReadOnlyMsg =
-    "TierSolverSolve: the current game was solved with a database of a "
-    "previous version that is no longer supported. The solver has "
-    "skipped the solving process to prevent damage to the existing "
-    "database. To re-solve the current game, remove the old database "
-    "or use a different data path and try again.";
-
-static ConstantReadOnlyString kTierSolverAnalyzeSkipReadOnlyMsg =
-    "TierSolverAnalyze: the current game was solved with a database of a "
-    "previous version that is no longer supported. The solver has skipped the "
-    "analysis because some functions are missing from the original database "
-    "implementation. To analyze the current game, remove the old database "
-    "or use a different data path to resolve the game and try again.";
+    "TierSolverSolve: the current game was solved and stored in a read-only "
+    "database, either of a previous version that is no longer supported or "
+    "converted for serving. The solver has skipped the solving process to "
+    "prevent damage to the existing database. To re-solve the current game, "
+    "remove the read-only database or use a different data path and try "
+    "again.";
 
 static ConstantReadOnlyString kTierSolverSolveSkipSolvedMsg =
     "TierSolverSolve: the current game variant has already been solved. Use -f "
@@ -309,6 +330,14 @@ static int TierSolverSolve(void *aux) {
         .force = false,
         .verbose = 1,
         .memlimit = 0,  // Use default memory limit.
+        .sort_frontiers = false,
+        .frontier_spill_threshold = 0,  // Never spill.
+        .lazy_children = false,
+        .value_only = false,
+        .lz4 = false,
+        .out_of_core_dir = NULL,  // Keep all arrays in memory.
+        .out_of_core_budget = 0,
+        .compressed_children = false,
     };
     const TierSolverSolveOptions *options = (TierSolverSolveOptions *)aux;
     if (options == NULL) options = &default_options;
@@ -316,9 +345,22 @@ static int TierSolverSolve(void *aux) {
         printf("%s\n", kTierSolverSolveSkipSolvedMsg);
         return kNoError;
     }
+#ifdef USE_MPI
+    // Worker nodes do not receive the solving options and would store
+    // remotenesses into the value-only database.
+    if (options->value_only && SafeMpiCommSize(MPI_COMM_WORLD) > 1) {
+        fprintf(stderr,
+                "TierSolverSolve: solving for values only is not supported "
+                "with more than one MPI process\n");
+        return kNotImplementedError;
+    }
+#endif  // USE_MPI
+    DestroyQueryProbe();  // Tiers may be rewritten.
+    int error = SetSolvingDbOptions(options);
+    if (error != kNoError) return error;
 #ifndef USE_MPI  // If not using MPI
     TierWorkerInit(&current_api, kArrayDbRecordsPerBlock, options->memlimit);
-    return TierManagerSolve(&current_api, options->force, options->verbose);
+    return TierManagerSolve(&current_api, options);
 #else   // Using MPI
     // Assumes MPI_Init or MPI_Init_thread has been called.
     int process_id, cluster_size;
@@ -329,11 +371,10 @@ static int TierSolverSolve(void *aux) {
     } else if (cluster_size == 1) {  // Only one node is allocated.
         TierWorkerInit(&current_api, kArrayDbRecordsPerBlock,
                        options->memlimit);
-        return TierManagerSolve(&current_api, options->force, options->verbose);
+        return TierManagerSolve(&current_api, options);
     } else {                    // cluster_size > 1
         if (process_id == 0) {  // This is the manager node.
-            return TierManagerSolve(&current_api, options->force,
-                                    options->verbose);
+            return TierManagerSolve(&current_api, options);
         } else {  // This is a worker node.
             TierWorkerInit(&current_api, kArrayDbRecordsPerBlock,
                            options->memlimit);
@@ -346,13 +387,6 @@ static int TierSolverSolve(void *aux) {
 }
 
 static int TierSolverAnalyze(void *aux) {
-    // Now allowing analysis on old databases now for simplicity.
-    // Need to work on old db implementation to support new analyzer API calls.
-    if (read_only_db) {
-        printf("%s\n", kTierSolverAnalyzeSkipReadOnlyMsg);
-        return kNoError;
-    }
-
     static const TierSolverAnalyzeOptions kDefaultAnalyzeOptions = {
         .force = false,
         .verbose = 1,
@@ -399,30 +433,32 @@ static int TierSolverSetOption(int option, int selection) {
 
 static Value TierSolverGetValue(TierPosition tier_position) {
     TierPosition canonical = GetCanonicalTierPosition(tier_position);
-    DbProbe probe;
-    int error = DbManagerProbeInit(&probe);
-    if (error != 0) {
-        NotReached(
-            "RegularSolverGetRemoteness: failed to initialize DbProbe, most "
-            "likely ran out of memory");
-    }
-    Value ret = DbManagerProbeValue(&probe, canonical);
-    DbManagerProbeDestroy(&probe);
-    return ret;
+
+    return DbManagerProbeValue(GetQueryProbe(), canonical);
 }
 
 static int TierSolverGetRemoteness(TierPosition tier_position) {
     TierPosition canonical = GetCanonicalTierPosition(tier_position);
-    DbProbe probe;
-    int error = DbManagerProbeInit(&probe);
-    if (error != 0) {
-        NotReached(
-            "RegularSolverGetRemoteness: failed to initialize DbProbe, most "
-            "likely ran out of memory");
-    }
-    int ret = DbManagerProbeRemoteness(&probe, canonical);
-    DbManagerProbeDestroy(&probe);
-    return ret;
+
+    return DbManagerProbeRemoteness(GetQueryProbe(), canonical);
+}
+
+static int TierSolverGetRecordsBatch(int64_t size,
+                                     const TierPosition *tier_positions,
+                                     Value *values, int *remotenesses) {
+    if (size <= 0) return kNoError;
+    TierPosition *canonicals =
+        (TierPosition *)malloc(size * sizeof(TierPosition));
+    if (canonicals == NULL) return kMallocFailureError;
+
+    for (int64_t i = 0; i < size; ++i) {
+        canonicals[i] = GetCanonicalTierPosition(tier_positions[i]);
+    }
+    int error = DbManagerProbeRecordsBatch(GetQueryProbe(), size, canonicals,
+                                           values, remotenesses);
+    free(canonicals);
+
+    return error;
 }
 
 // Helper functions
@@ -544,22 +580,47 @@ static bool SetCurrentApi(const TierSolverApi *api) {
 
 static int SetDb(ReadOnlyString game_name, int variant,
                  ReadOnlyString data_path) {
-    // Look for existing bpdb_lite database.
-    int error = DbManagerInitDb(&kBpdbLite, true, game_name, variant, data_path,
-                                current_api.GetTierName, NULL);
-    if (error != kNoError) return error;
-    int bpdb_status = DbManagerGameStatus();
-    if (bpdb_status == kDbGameStatusCheckError) return kRuntimeError;
-    if (bpdb_status == kDbGameStatusSolved) {
-        read_only_db = true;
-        solver_status = kTierSolverSolveStatusSolved;
-        return kNoError;
+    current_game_name = game_name;
+    current_variant = variant;
+    free(current_data_path);
+    current_data_path = NULL;
+    if (data_path != NULL) {
+        current_data_path = (char *)SafeMalloc(strlen(data_path) + 1);
+        strcpy(current_data_path, data_path);
+    }
+
+    return DiscoverDb();
+}
+
+// Read-only databases in the order in which they are looked for. Serving
+// formats come first as they are converted from a solved game for faster
+// probing.
+static const Database *const kReadOnlyDbs[] = {&kMmapDb, &kBpdbLite};
+enum { kNumReadOnlyDbs = sizeof(kReadOnlyDbs) / sizeof(kReadOnlyDbs[0]) };
+
+static int DiscoverDb(void) {
+    read_only_db = false;
+
+    // Look for an existing read-only database.
+    for (int i = 0; i < kNumReadOnlyDbs; ++i) {
+        int error = DbManagerInitDb(kReadOnlyDbs[i], true, current_game_name,
+                                    current_variant, current_data_path,
+                                    current_api.GetTierName, NULL);
+        if (error != kNoError) return error;
+        int status = DbManagerGameStatus();
+        if (status == kDbGameStatusCheckError) return kRuntimeError;
+        if (status == kDbGameStatusSolved) {
+            read_only_db = true;
+            solver_status = kTierSolverSolveStatusSolved;
+            return kNoError;
+        }
+        DbManagerFinalizeDb();
     }
-    DbManagerFinalizeDb();
 
     // Initialize a R/W array database.
-    error = DbManagerInitDb(&kArrayDb, false, game_name, variant, data_path,
-                            current_api.GetTierName, NULL);
+    int error = DbManagerInitDb(&kArrayDb, false, current_game_name,
+                                current_variant, current_data_path,
+                                current_api.GetTierName, NULL);
     if (error != kNoError) return error;
     int arraydb_status = DbManagerGameStatus();
     if (arraydb_status == kDbGameStatusCheckError) return kRuntimeError;
@@ -568,6 +629,130 @@ static int SetDb(ReadOnlyString game_name, int variant,
     return kNoError;
 }
 
+// Returns the first database other than EXCLUDE in which the current game is
+// solved, or NULL if there is none. Finalizes the current database.
+static const Database *FindSolvedDb(const Database *exclude) {
+    static const Database *const kSourceDbs[] = {&kArrayDb, &kBpdbLite,
+                                                 &kMmapDb};
+    enum { kNumSourceDbs = sizeof(kSourceDbs) / sizeof(kSourceDbs[0]) };
+    const Database *ret = NULL;
+    for (int i = 0; i < kNumSourceDbs && ret == NULL; ++i) {
+        if (kSourceDbs[i] == exclude) continue;
+        int error = DbManagerInitDb(kSourceDbs[i], true, current_game_name,
+                                    current_variant, current_data_path,
+                                    current_api.GetTierName, NULL);
+        if (error == kNoError &&
+            DbManagerGameStatus() == kDbGameStatusSolved) {
+            ret = kSourceDbs[i];
+        }
+        DbManagerFinalizeDb();
+    }
+
+    return ret;
+}
+
+int TierSolverConvert(const TierSolverConvertOptions *options) {
+    DestroyQueryProbe();
+    const Database *source = FindSolvedDb(options->db);
+    if (source == NULL) {
+        fprintf(stderr,
+                "TierSolverConvert: the current game has not been solved\n");
+        DiscoverDb();
+        return kRuntimeError;
+    }
+    if (options->verbose > 0) {
+        printf("Converting the current game from the %s into the %s\n",
+               source->formal_name, options->db->formal_name);
+    }
+
+    int error = DbManagerInitRefDb(source, current_game_name, current_variant,
+                                   current_data_path, current_api.GetTierName,
+                                   NULL);
+    if (error == kNoError) {
+        error = DbManagerInitDb(options->db, false, current_game_name,
+                                current_variant, current_data_path,
+                                current_api.GetTierName, options->db_options);
+    }
+    if (error == kNoError) {
+        error = TierManagerConvert(&current_api, options);
+    }
+    DbManagerFinalizeDb();
+    DbManagerFinalizeRefDb();
+
+    // Switch to the newly converted database if it is a serving database.
+    int discover_error = DiscoverDb();
+
+    return error != kNoError ? error : discover_error;
+}
+
+int TierSolverRebalance(int verbose) {
+    static const Database *const kShardedDbs[] = {&kArrayDb, &kBpdbLite,
+                                                  &kMmapDb};
+    static const int kNumShardedDbs =
+        sizeof(kShardedDbs) / sizeof(kShardedDbs[0]);
+
+    DestroyQueryProbe();
+    int ret = kNoError;
+    for (int i = 0; i < kNumShardedDbs; ++i) {
+        if (verbose > 0) {
+            printf("Rebalancing the %s\n", kShardedDbs[i]->formal_name);
+        }
+        int error = DbManagerInitDb(kShardedDbs[i], true, current_game_name,
+                                    current_variant, current_data_path,
+                                    current_api.GetTierName, NULL);
+        if (error == kNoError) {
+            error = TierManagerRebalance(&current_api, verbose);
+        }
+        if (error != kNoError) ret = error;
+    }
+    DbManagerFinalizeDb();
+
+    // Reopen the serving database from the new locations.
+    int discover_error = DiscoverDb();
+
+    return ret != kNoError ? ret : discover_error;
+}
+
+static int SetSolvingDbOptions(const TierSolverSolveOptions *options) {
+    ArrayDbOptions db_options = kArrayDbOptionsInit;
+    db_options.value_only = options->value_only;
+    db_options.lz4_compression = options->lz4;
+    db_options.status_scan = true;
+    db_options.summary = true;
+    if (options->out_of_core_dir != NULL) {
+        db_options.out_of_core_dir = options->out_of_core_dir;
+        db_options.out_of_core_budget = options->out_of_core_budget;
+    }
+    db_options.compressed_loading = options->compressed_children;
+    DestroyQueryProbe();
+    DbManagerFinalizeDb();
+    read_only_db = false;  // Replaced by a R/W array database.
+
+    return DbManagerInitDb(&kArrayDb, false, current_game_name,
+                           current_variant, current_data_path,
+                           current_api.GetTierName, &db_options);
+}
+
+static DbProbe *GetQueryProbe(void) {
+    if (!query_probe_initialized) {
+        int error = DbManagerProbeInit(&query_probe);
+        if (error != kNoError) {
+            NotReached(
+                "TierSolver: failed to initialize DbProbe, most likely ran out "
+                "of memory");
+        }
+        query_probe_initialized = true;
+    }
+
+    return &query_probe;
+}
+
+static void DestroyQueryProbe(void) {
+    if (!query_probe_initialized) return;
+    DbManagerProbeDestroy(&query_probe);
+    query_probe_initialized = false;
+}
+
 static TierPosition GetCanonicalTierPosition(TierPosition tier_position) {
     TierPosition canonical;
 
@@ -360,6 +360,69 @@ typedef struct TierSolverSolveOptions {
     int verbose;       /**< Level of details to output. */
     bool force;        /**< Whether to force (re)solve the game. */
     intptr_t memlimit; /**< Approximate heap memory limit in bytes. */
+
+    /**
+     * Whether to radix-sort each frontier bucket before propagating it to the
+     * parent positions during backward induction. Not supported by MPI worker
+     * nodes.
+     */
+    bool sort_frontiers;
+
+    /**
+     * Approximate total size in bytes of in-memory frontiers during backward
+     * induction beyond which frontiers are spilled to compressed temporary
+     * files, or 0 to never spill. Not supported by MPI worker nodes.
+     */
+    intptr_t frontier_spill_threshold;
+
+    /**
+     * Whether to enumerate the solved positions of child tiers during
+     * backward induction through per-tier remoteness indices, which store
+     * each position in 4 bytes, instead of loading them into frontiers. Not
+     * supported by MPI worker nodes.
+     */
+    bool lazy_children;
+
+    /**
+     * Whether to solve for values only. Remotenesses are not computed and the
+     * solved tiers are stored as bit-packed value-only record arrays. Only
+     * supported by the backward induction and iterative tier workers. Rejected
+     * when solving with more than one MPI process, since MPI worker nodes do
+     * not receive this option.
+     */
+    bool value_only;
+
+    /**
+     * Whether to store solved tiers as independently LZ4-compressed blocks
+     * with an offset index instead of XZ, which makes random probes much
+     * faster at the cost of disk space. Tiers solved by an earlier run of an
+     * unfinished game are converted into the same format. A solved game is
+     * still skipped unless \c force is set, in which case it is re-solved
+     * into the new format. Not supported by MPI worker nodes.
+     */
+    bool lz4;
+
+    /**
+     * Directory on fast local storage, such as an NVMe drive, in which record
+     * arrays and backward induction counter arrays larger than
+     * \c out_of_core_budget bytes are backed by memory-mapped temporary files,
+     * or NULL to keep them in memory. Not supported by MPI worker nodes.
+     */
+    const char *out_of_core_dir;
+
+    /**
+     * Resident memory budget in bytes of each file-backed array. Memory usage
+     * of file-backed tiers is estimated using this value when scheduling tiers.
+     * Ignored if \c out_of_core_dir is NULL.
+     */
+    int64_t out_of_core_budget;
+
+    /**
+     * Whether to keep child tiers loaded by the value iteration and iterative
+     * tier workers compressed in memory, which allows many more child tiers to
+     * be loaded at the same time at the cost of slower lookups.
+     */
+    bool compressed_children;
 } TierSolverSolveOptions;
 
 /** @brief Analyzer options of the Tier Solver. */
@@ -368,6 +431,59 @@ typedef struct TierSolverAnalyzeOptions {
     bool force;  /**< Whether to force (re)analyze the game. */
 } TierSolverAnalyzeOptions;
 
+/** @brief Options for converting a solved game into another database. */
+typedef struct TierSolverConvertOptions {
+    int verbose; /**< Level of details to output. */
+
+    /** Whether to convert tiers that already exist in the target database. */
+    bool force;
+
+    /** Target database, which must implement the solving interface. */
+    const Database *db;
+
+    /** Options passed to the initialization function of the target database,
+     * or NULL for default options. */
+    void *db_options;
+
+    /** Whether the target database stores values only, as configured in
+     * \c db_options. Tiers solved without remotenesses can only be converted
+     * into a value-only target. */
+    bool value_only;
+} TierSolverConvertOptions;
+
+/**
+ * @brief Converts the current game, which must have been solved, from its
+ * existing database into the database specified in \p options, using all
+ * available threads. The game is marked as solved in the target database once
+ * all tiers have been converted, and the solver then rediscovers its database
+ * so that a read-only serving database takes effect immediately.
+ *
+ * @note Assumes that the Tier Solver has been initialized for the current
+ * game using SolverManagerInit.
+ *
+ * @param options Conversion options.
+ * @return kNoError on success, or
+ * @return non-zero error code on failure.
+ */
+int TierSolverConvert(const TierSolverConvertOptions *options);
+
+/**
+ * @brief Moves the tier files of the current game in every database that
+ * stores files by tier into the data directory each tier is assigned to under
+ * the current data path. Used after data directories have been added to or
+ * reweighted in the data path. Does nothing if the data path lists a single
+ * directory.
+ *
+ * @note Assumes that the Tier Solver has been initialized for the current
+ * game using SolverManagerInit, and that no other process is accessing the
+ * databases of the current game.
+ *
+ * @param verbose Level of details to output.
+ * @return kNoError on success, or
+ * @return non-zero error code on failure.
+ */
+int TierSolverRebalance(int verbose);
+
 enum TierSolverSolveStatus {
     kTierSolverSolveStatusNotSolved, /**< Not fully solved. */
     kTierSolverSolveStatusSolved,    /**< Fully solved. */
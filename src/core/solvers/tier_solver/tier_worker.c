@@ -87,6 +87,12 @@ const TierWorkerSolveOptions kDefaultTierWorkerSolveOptions = {
     .compare = false,
     .force = false,
     .verbose = 1,
+    .sort_frontiers = false,
+    .frontier_spill_threshold = 0,
+    .lazy_children = false,
+    .value_only = false,
+    .out_of_core_dir = NULL,
+    .out_of_core_budget = 0,
 };
 
 int TierWorkerSolve(int method, Tier tier,
@@ -122,6 +122,12 @@ typedef struct TierWorkerSolveOptions {
     int verbose;
     bool force;
     bool compare;
+    bool sort_frontiers;
+    int64_t frontier_spill_threshold;
+    bool lazy_children;
+    bool value_only;
+    const char *out_of_core_dir;
+    int64_t out_of_core_budget;
 } TierWorkerSolveOptions;
 
 extern const TierWorkerSolveOptions kDefaultTierWorkerSolveOptions;
@@ -34,15 +34,18 @@
 #include <stdbool.h>  // bool, true, false
 #include <stddef.h>   // NULL
 #include <stdint.h>   // int64_t
-#include <stdio.h>    // fprintf, stderr
+#include <stdio.h>    // fprintf, printf, stderr
 #include <stdlib.h>   // calloc, malloc, free
 #include <string.h>   // memcpy
 
 #include "core/concurrency.h"
 #include "core/constants.h"
 #include "core/db/db_manager.h"
+#include "core/large_alloc.h"
+#include "core/misc.h"
 #include "core/solvers/tier_solver/tier_solver.h"
 #include "core/solvers/tier_solver/tier_worker/frontier.h"
+#include "core/solvers/tier_solver/tier_worker/remoteness_index.h"
 #include "core/solvers/tier_solver/tier_worker/reverse_graph.h"
 #include "core/types/gamesman_types.h"
 
@@ -66,6 +69,9 @@ static int64_t current_db_chunk_size;
 // A frontier array will be created for each possible remoteness.
 static const int kFrontierSize = kRemotenessMax + 1;
 
+// Number of positions probed from the database at once.
+enum { kProbeBatchSize = 1024 };
+
 static Tier this_tier;          // The tier being solved.
 static int64_t this_tier_size;  // Size of the tier being solved.
 // Array of child tiers with this_tier appended to the back.
@@ -76,12 +82,12 @@ static Frontier *win_frontiers;   // Winning frontiers for each thread.
 static Frontier *lose_frontiers;  // Losing frontiers for each thread.
 static Frontier *tie_frontiers;   // Tying frontiers for each thread.
 
-// Number of undecided child positions array (malloc'ed and owned by the
-// TierWorkerSolve function). Note that we are assuming the number of children
-// of ANY position is no more than 254. This allows us to use an unsigned 8-bit
-// integer to save memory. If this assumption no longer holds for any new
-// games in the future, the programmer should change this type to a wider
-// integer type such as int16_t.
+// Number of undecided child positions array (allocated by LargeCalloc and owned
+// by the TierWorkerSolve function). Note that we are assuming the number of
+// children of ANY position is no more than 254. This allows us to use an
+// unsigned 8-bit integer to save memory. If this assumption no longer holds
+// for any new games in the future, the programmer should change this type to a
+// wider integer type such as int16_t.
 typedef int16_t ChildPosCounterType;
 #ifdef _OPENMP
 typedef _Atomic ChildPosCounterType AtomicChildPosCounterType;
@@ -98,8 +104,51 @@ static bool use_reverse_graph = false;
 
 static int num_threads;  // Number of threads available.
 
+// Whether to sort each frontier bucket before pushing it up. See
+// FrontierSortRemoteness() for details.
+static bool sort_frontiers;
+
+// Total size in bytes of in-memory frontier buckets beyond which the largest
+// buckets are spilled to temporary files, or 0 to disable spilling.
+static int64_t frontier_spill_threshold;
+
+// Whether to enumerate the solved positions of child tiers through remoteness
+// indices instead of loading them into frontiers.
+static bool lazy_children;
+
+// Remoteness indices of the child tiers, one for each child tier excluding
+// this_tier, or NULL if lazy_children is not set. A child tier whose index has
+// NULL offsets was loaded into frontiers instead.
+static RemotenessIndex *child_indices;
+static int num_child_indices;
+
+// Whether to solve for values only. If set, remotenesses are neither probed
+// nor stored, and each frontier alternates between buckets 0 and 1 instead of
+// using one bucket per remoteness.
+static bool value_only;
+
+// Set if a child tier that was solved for values only is found while loading
+// child tiers for a full solve.
+static ConcurrentBool value_only_child_found;
+
+// Directory in which the number of undecided children array is backed by a
+// memory-mapped temporary file if it is larger than out_of_core_budget bytes,
+// or NULL to always keep it in memory.
+static const char *out_of_core_dir;
+static int64_t out_of_core_budget;
+
 // ------------------------------ Step0Initialize ------------------------------
 
+static Position GetMaxPosition(void) {
+    int64_t max_size = 1;
+    for (int64_t i = 0; i < child_tiers.size; ++i) {
+        int64_t size = current_api.GetTierSize(child_tiers.array[i]);
+        if (size > max_size) max_size = size;
+    }
+
+    return max_size - 1;
+}
+
 static bool Step0_1InitFrontiers(int dividers_size) {
 #ifdef _OPENMP
     num_threads = omp_get_max_threads();
@@ -113,17 +162,30 @@ static bool Step0_1InitFrontiers(int dividers_size) {
         return false;
     }
 
-    bool success = true;
+    // Positions are packed using just enough bytes to hold the largest
+    // position in this tier and all its child tiers. The spill threshold is
+    // split evenly among all frontiers.
+    Position max_position = GetMaxPosition();
+    int64_t threshold = frontier_spill_threshold / (3 * num_threads);
+    if (frontier_spill_threshold > 0 && threshold == 0) threshold = 1;
+
+    // In NUMA first-touch mode, thread i initializes frontier i with a static
+    // schedule over num_threads iterations so that the bucket and divider
+    // arrays are first touched on the NUMA node of the thread that uses them.
+    ConcurrentBool success;
+    ConcurrentBoolInit(&success, true);
+    PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_STATIC_IF(LargeAllocNumaFirstTouch())
     for (int i = 0; i < num_threads; ++i) {
-        success &=
-            FrontierInit(&win_frontiers[i], kFrontierSize, dividers_size);
-        success &=
-            FrontierInit(&lose_frontiers[i], kFrontierSize, dividers_size);
-        success &=
-            FrontierInit(&tie_frontiers[i], kFrontierSize, dividers_size);
+        bool ok = FrontierInit(&win_frontiers[i], kFrontierSize, dividers_size,
+                               max_position, threshold);
+        ok &= FrontierInit(&lose_frontiers[i], kFrontierSize, dividers_size,
+                           max_position, threshold);
+        ok &= FrontierInit(&tie_frontiers[i], kFrontierSize, dividers_size,
+                           max_position, threshold);
+        if (!ok) ConcurrentBoolStore(&success, false);
     }
 
-    return success;
+    return ConcurrentBoolLoad(&success);
 }
 
 static bool Step0_0SetupChildTiers(void) {
@@ -156,10 +218,17 @@ static PositionArray TierGetCanonicalParentPositionsFromReverseGraph(
 }
 
 static bool Step0Initialize(const TierSolverApi *api, int64_t db_chunk_size,
-                            Tier tier) {
+                            Tier tier, const TierWorkerSolveOptions *options) {
     // Copy solver API function pointers and set db chunk size.
     memcpy(&current_api, api, sizeof(current_api));
     current_db_chunk_size = db_chunk_size;
+    sort_frontiers = options->sort_frontiers;
+    frontier_spill_threshold = options->frontier_spill_threshold;
+    value_only = options->value_only;
+    lazy_children = options->lazy_children && !value_only;
+    ConcurrentBoolInit(&value_only_child_found, false);
+    out_of_core_dir = options->out_of_core_dir;
+    out_of_core_budget = options->out_of_core_budget;
 
     // Initialize child tier array.
     this_tier = tier;
@@ -197,8 +266,15 @@ static int GetThreadId(void) {
 
 static bool CheckAndLoadFrontier(int child_index, int64_t position, Value value,
                                  int remoteness, int tid) {
-    if (remoteness < 0) return false;  // Error probing remoteness.
     if (value == kUndecided || value == kDraw) return true;
+
+    // Remotenesses of this tier cannot be deduced from a child tier that was
+    // solved for values only.
+    if (remoteness == kUnknownRemoteness) {
+        ConcurrentBoolStore(&value_only_child_found, true);
+        return false;
+    }
+    if (remoteness < 0) return false;  // Error probing remoteness.
     Frontier *dest = NULL;
     switch (value) {
         case kUndecided:
@@ -223,28 +299,61 @@ static bool CheckAndLoadFrontier(int child_index, int64_t position, Value value,
     return FrontierAdd(dest, position, remoteness, child_index);
 }
 
+// Probes the SIZE positions of CHILD_TIER starting from BEGIN in one batch and
+// loads them into frontiers.
+static bool Step1_0LoadBatch(DbProbe *probe, int child_index, Tier child_tier,
+                             Position begin, int64_t size, int tid) {
+    TierPosition tier_positions[kProbeBatchSize];
+    Value values[kProbeBatchSize];
+    int remotenesses[kProbeBatchSize];
+    for (int64_t i = 0; i < size; ++i) {
+        tier_positions[i].tier = child_tier;
+        tier_positions[i].position = begin + i;
+    }
+
+    // Probing errors are reported as illegal values and remotenesses, which
+    // are then rejected by CheckAndLoadFrontier.
+    DbManagerProbeRecordsBatch(probe, size, tier_positions, values,
+                               value_only ? NULL : remotenesses);
+    bool success = true;
+    for (int64_t i = 0; i < size; ++i) {
+        int remoteness = value_only ? 0 : remotenesses[i];
+        if (!CheckAndLoadFrontier(child_index, begin + i, values[i],
+                                  remoteness, tid)) {
+            success = false;
+        }
+    }
+
+    return success;
+}
+
 static bool Step1_0LoadTierHelper(int child_index) {
     Tier child_tier = child_tiers.array[child_index];
 
-    // Scan child tier and load non-drawing positions into frontier.
+    // Scan child tier and load non-drawing positions into frontier. Each
+    // thread scans whole database chunks in batches of positions.
     int64_t child_tier_size = current_api.GetTierSize(child_tier);
+    int64_t num_chunks = RoundUpDivide(child_tier_size, current_db_chunk_size);
     ConcurrentBool success;
     ConcurrentBoolInit(&success, true);
 
     PRAGMA_OMP_PARALLEL {
         DbProbe probe;
         DbManagerProbeInit(&probe);
-        TierPosition child_tier_position = {.tier = child_tier};
         int tid = GetThreadId();
-        PRAGMA_OMP_FOR_SCHEDULE_DYNAMIC(current_db_chunk_size)
-        for (Position position = 0; position < child_tier_size; ++position) {
-            child_tier_position.position = position;
-            Value value = DbManagerProbeValue(&probe, child_tier_position);
-            int remoteness =
-                DbManagerProbeRemoteness(&probe, child_tier_position);
-            if (!CheckAndLoadFrontier(child_index, position, value, remoteness,
-                                      tid)) {
-                ConcurrentBoolStore(&success, false);
+        PRAGMA_OMP_FOR_SCHEDULE_DYNAMIC(1)
+        for (int64_t chunk = 0; chunk < num_chunks; ++chunk) {
+            Position chunk_begin = chunk * current_db_chunk_size;
+            Position chunk_end = chunk_begin + current_db_chunk_size;
+            if (chunk_end > child_tier_size) chunk_end = child_tier_size;
+            for (Position begin = chunk_begin; begin < chunk_end;
+                 begin += kProbeBatchSize) {
+                int64_t size = chunk_end - begin;
+                if (size > kProbeBatchSize) size = kProbeBatchSize;
+                if (!Step1_0LoadBatch(&probe, child_index, child_tier, begin,
+                                      size, tid)) {
+                    ConcurrentBoolStore(&success, false);
+                }
             }
         }
         DbManagerProbeDestroy(&probe);
@@ -253,16 +362,65 @@ static bool Step1_0LoadTierHelper(int child_index) {
     return ConcurrentBoolLoad(&success);
 }
 
+static bool Step1_1IndexTierHelper(int child_index) {
+    Tier child_tier = child_tiers.array[child_index];
+    int64_t child_tier_size = current_api.GetTierSize(child_tier);
+
+    // Fall back to loading the child tier into frontiers if the database does
+    // not have room for it.
+    if (DbManagerLoadTier(child_tier, child_tier_size) != kNoError) {
+        return Step1_0LoadTierHelper(child_index);
+    }
+
+    // The child tier is only needed while its index is being built. If the
+    // index cannot be built, fall back to loading the child tier into
+    // frontiers, which also reports child tiers solved for values only.
+    RemotenessIndex *index = &child_indices[child_index];
+    bool success = RemotenessIndexInit(index, child_tier, child_tier_size);
+    DbManagerUnloadTier(child_tier);
+    if (!success) return Step1_0LoadTierHelper(child_index);
+
+    return true;
+}
+
+static void DestroyChildIndices(void) {
+    for (int i = 0; i < num_child_indices; ++i) {
+        RemotenessIndexDestroy(&child_indices[i]);
+    }
+    free(child_indices);
+    child_indices = NULL;
+    num_child_indices = 0;
+}
+
 /**
- * @brief Load all non-drawing positions from all child tiers into frontier.
+ * @brief Load all non-drawing positions from all child tiers into frontier,
+ * or index all child tiers if lazy_children is set.
  */
 static bool Step1LoadChildren(void) {
+    int num_child_tiers = (int)child_tiers.size - 1;
+    if (lazy_children) {
+        child_indices = (RemotenessIndex *)calloc(num_child_tiers,
+                                                  sizeof(RemotenessIndex));
+        if (child_indices == NULL && num_child_tiers > 0) return false;
+        num_child_indices = num_child_tiers;
+    }
+
     // Child tiers must be processed sequentially, otherwise the frontier
     // dividers wouldn't work.
-    int num_child_tiers = (int)child_tiers.size - 1;
     for (int child_index = 0; child_index < num_child_tiers; ++child_index) {
-        // Load child tier from disk.
-        if (!Step1_0LoadTierHelper(child_index)) return false;
+        bool success = lazy_children ? Step1_1IndexTierHelper(child_index)
+                                     : Step1_0LoadTierHelper(child_index);
+        if (!success) {
+            if (ConcurrentBoolLoad(&value_only_child_found)) {
+                fprintf(stderr,
+                        "Step1LoadChildren: child tier %" PRITier
+                        " was solved for values only. Solve tier %" PRITier
+                        " for values only as well, or re-solve the game with "
+                        "-f\n",
+                        child_tiers.array[child_index], this_tier);
+            }
+            return false;
+        }
     }
 
     return true;
@@ -270,6 +428,20 @@ static bool Step1LoadChildren(void) {
 
 // -------------------------- Step2SetupSolverArrays --------------------------
 
+static size_t GetNumUndecidedChildrenRawSize(void) {
+    return (size_t)this_tier_size * sizeof(*num_undecided_children);
+}
+
+static void AdviseNumUndecidedChildren(LargeAccessPattern pattern) {
+    LargeAdvise(num_undecided_children, GetNumUndecidedChildrenRawSize(),
+                pattern);
+}
+
+static void FreeNumUndecidedChildren(void) {
+    LargeFree(num_undecided_children, GetNumUndecidedChildrenRawSize());
+    num_undecided_children = NULL;
+}
+
 /**
  * @brief Initializes database and number of undecided children array.
  */
@@ -278,20 +450,31 @@ static bool Step2SetupSolverArrays(void) {
                                            current_api.GetTierSize(this_tier));
     if (error != 0) return false;
 
-#ifdef _OPENMP
-    num_undecided_children = (AtomicChildPosCounterType *)malloc(
-        this_tier_size * sizeof(AtomicChildPosCounterType));
+    // The counters are hit at random by ProcessWinPosition and
+    // ProcessLosePosition, so the array is backed by huge pages if possible.
+    // Arrays over the out-of-core budget are backed by a file instead, which
+    // is already zero-filled and must not be touched all at once.
+    size_t raw_size = GetNumUndecidedChildrenRawSize();
+    bool file_backed =
+        out_of_core_dir != NULL && (int64_t)raw_size > out_of_core_budget;
+    num_undecided_children =
+        file_backed ? LargeCallocFileBacked(raw_size, out_of_core_dir)
+                    : LargeCalloc(raw_size);
     if (num_undecided_children == NULL) return false;
 
-    for (int64_t i = 0; i < this_tier_size; ++i) {
-        atomic_init(&num_undecided_children[i], 0);
+    // Step3ScanTier initializes the counters in a sequential pass.
+    if (file_backed) {
+        AdviseNumUndecidedChildren(kLargeAccessSequential);
+        return true;
     }
-#else   // _OPENMP not defined
-    num_undecided_children = (ChildPosCounterType *)calloc(
-        this_tier_size, sizeof(ChildPosCounterType));
-#endif  // _OPENMP
 
-    return (num_undecided_children != NULL);
+    // The counters are zero-filled. In NUMA first-touch mode, their pages are
+    // touched with the same static schedule as Step5MarkDrawPositions, which
+    // spreads them across the NUMA nodes of all worker threads instead of
+    // placing them on the master thread's node.
+    LargeFirstTouch(num_undecided_children, raw_size);
+
+    return true;
 }
 
 // ------------------------------- Step3ScanTier -------------------------------
@@ -358,9 +541,9 @@ static bool Step3ScanTier(void) {
             if (value != kUndecided) {  // If tier_position is primitive...
                 // Set its value immediately and push it into the frontier.
                 DbManagerSetValue(position, value);
-                DbManagerSetRemoteness(position, 0);
                 int this_tier_index = (int)child_tiers.size - 1;
-                if (!CheckAndLoadFrontier(this_tier_index, position, value, 0,
+                if (DbManagerSetRemoteness(position, 0) != kNoError ||
+                    !CheckAndLoadFrontier(this_tier_index, position, value, 0,
                                           tid)) {
                     ConcurrentBoolStore(&success, false);
                 }
@@ -394,8 +577,8 @@ static int64_t *MakeFrontierOffsets(const Frontier *frontiers, int remoteness) {
 
     frontier_offsets[0] = 0;
     for (int i = 1; i <= num_threads; ++i) {
-        frontier_offsets[i] =
-            frontier_offsets[i - 1] + frontiers[i - 1].buckets[remoteness].size;
+        frontier_offsets[i] = frontier_offsets[i - 1] +
+                              FrontierGetSize(&frontiers[i - 1], remoteness);
     }
 
     return frontier_offsets;
@@ -419,6 +602,78 @@ static void UpdateFrontierAndChildTierIds(int64_t i, const Frontier *frontiers,
     }
 }
 
+// Loads the positions of the given REMOTENESS that were spilled to disk back
+// into memory and sorts them if requested.
+static bool PrepareFrontiers(Frontier *frontiers, int remoteness) {
+    ConcurrentBool success;
+    ConcurrentBoolInit(&success, true);
+    PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_DYNAMIC(1)
+    for (int i = 0; i < num_threads; ++i) {
+        if (!FrontierLoadRemoteness(&frontiers[i], remoteness)) {
+            ConcurrentBoolStore(&success, false);
+        } else if (sort_frontiers) {
+            FrontierSortRemoteness(&frontiers[i], remoteness);
+        }
+    }
+
+    return ConcurrentBoolLoad(&success);
+}
+
+// Processes all positions of VALUE and REMOTENESS in the child tiers that were
+// indexed instead of loaded into frontiers.
+static bool PushIndexedChildren(
+    Value value, int remoteness,
+    bool (*ProcessPosition)(int remoteness, TierPosition tier_position)) {
+    //
+    ConcurrentBool success;
+    ConcurrentBoolInit(&success, true);
+    for (int i = 0; i < num_child_indices; ++i) {
+        const RemotenessIndex *index = &child_indices[i];
+        if (index->offsets == NULL) continue;  // Loaded into frontiers.
+
+        int64_t size = RemotenessIndexGetSize(index, value, remoteness);
+        if (size == 0) continue;
+
+        PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_DYNAMIC(16)
+        for (int64_t j = 0; j < size; ++j) {
+            TierPosition tier_position = {
+                .tier = index->tier,
+                .position =
+                    RemotenessIndexGetPosition(index, value, remoteness, j),
+            };
+            if (!ProcessPosition(remoteness, tier_position)) {
+                ConcurrentBoolStore(&success, false);
+            }
+        }
+    }
+
+    return ConcurrentBoolLoad(&success);
+}
+
+static bool FrontiersEmpty(const Frontier *frontiers, int remoteness) {
+    for (int i = 0; i < num_threads; ++i) {
+        if (FrontierGetSize(&frontiers[i], remoteness) > 0) return false;
+    }
+
+    return true;
+}
+
+// Returns whether any position of VALUE and REMOTENESS is waiting to be pushed
+// up, either in FRONTIERS or in the child tier indices.
+static bool HasPositionsToPush(const Frontier *frontiers, Value value,
+                               int remoteness) {
+    if (!FrontiersEmpty(frontiers, remoteness)) return true;
+    for (int i = 0; i < num_child_indices; ++i) {
+        const RemotenessIndex *index = &child_indices[i];
+        if (index->offsets == NULL) continue;  // Loaded into frontiers.
+        if (RemotenessIndexGetSize(index, value, remoteness) > 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 /**
  * @details The algorithm is as follows: first count the total number N of
  * positions that need to be processed and then run a parallel for loop that
@@ -438,11 +693,24 @@ static void UpdateFrontierAndChildTierIds(int64_t i, const Frontier *frontiers,
  * searching. This allows us to not start the search at index 0 for every
  * position. However, it also means that we are assuming an order of processing
  * within each tier. If the order is random, the hints will not work correctly.
+ *
+ * Child tiers that were indexed instead of loaded into frontiers (see
+ * lazy_children) are processed before the frontiers by enumerating the
+ * positions of the given VALUE and remoteness listed in their remoteness
+ * indices.
  */
 static bool PushFrontierHelper(
-    Frontier *frontiers, int remoteness,
+    Frontier *frontiers, Value value, int remoteness,
     bool (*ProcessPosition)(int remoteness, TierPosition tier_position)) {
     //
+    // Parents of the positions being pushed are assigned REMOTENESS + 1, which
+    // may not fit in the records of the solving tier yet.
+    if (HasPositionsToPush(frontiers, value, remoteness) &&
+        DbManagerReserveRemoteness(remoteness + 1) != kNoError) {
+        return false;
+    }
+    if (!PushIndexedChildren(value, remoteness, ProcessPosition)) return false;
+    if (!PrepareFrontiers(frontiers, remoteness)) return false;
     int64_t *frontier_offsets = MakeFrontierOffsets(frontiers, remoteness);
     if (!frontier_offsets) return false;
 
@@ -467,9 +735,14 @@ static bool PushFrontierHelper(
         }
     }
 
-    // Free current remoteness from all frontiers.
+    // Free current remoteness from all frontiers. In value-only mode, the
+    // bucket will be reused.
     for (int i = 0; i < num_threads; ++i) {
-        FrontierFreeRemoteness(&frontiers[i], remoteness);
+        if (value_only) {
+            FrontierResetRemoteness(&frontiers[i], remoteness);
+        } else {
+            FrontierFreeRemoteness(&frontiers[i], remoteness);
+        }
     }
     free(frontier_offsets);
     frontier_offsets = NULL;
@@ -477,6 +750,12 @@ static bool PushFrontierHelper(
     return ConcurrentBoolLoad(&success);
 }
 
+// Returns the frontier bucket into which the parents deduced from the
+// positions in bucket REMOTENESS are inserted.
+static int GetNextBucket(int remoteness) {
+    return value_only ? !remoteness : remoteness + 1;
+}
+
 // This function is called within a OpenMP parallel region.
 static bool ProcessLoseOrTiePosition(int remoteness, TierPosition tier_position,
                                      bool processing_lose) {
@@ -506,11 +785,13 @@ static bool ProcessLoseOrTiePosition(int remoteness, TierPosition tier_position,
 
         // All parents are win/tie in (remoteness + 1) positions.
         DbManagerSetValue(parents.array[i], value);
-        DbManagerSetRemoteness(parents.array[i], remoteness + 1);
         int this_tier_index = (int)child_tiers.size - 1;
-        bool success = FrontierAdd(frontier, parents.array[i], remoteness + 1,
-                                   this_tier_index);
-        if (!success) {  // OOM.
+        bool success =
+            DbManagerSetRemoteness(parents.array[i], remoteness + 1) ==
+                kNoError &&
+            FrontierAdd(frontier, parents.array[i], GetNextBucket(remoteness),
+                        this_tier_index);
+        if (!success) {  // Remoteness out of range or OOM.
             TierArrayDestroy(&parents);
             return false;
         }
@@ -582,11 +863,13 @@ static bool ProcessWinPosition(int remoteness, TierPosition tier_position) {
         // position, mark parent as lose in (childRmt + 1).
         if (child_remaining == 1) {
             DbManagerSetValue(parents.array[i], kLose);
-            DbManagerSetRemoteness(parents.array[i], remoteness + 1);
             int this_tier_index = (int)child_tiers.size - 1;
-            bool success = FrontierAdd(&lose_frontiers[tid], parents.array[i],
-                                       remoteness + 1, this_tier_index);
-            if (!success) {  // OOM.
+            bool success =
+                DbManagerSetRemoteness(parents.array[i], remoteness + 1) ==
+                    kNoError &&
+                FrontierAdd(&lose_frontiers[tid], parents.array[i],
+                            GetNextBucket(remoteness), this_tier_index);
+            if (!success) {  // Remoteness out of range or OOM.
                 PositionArrayDestroy(&parents);
                 return false;
             }
@@ -614,17 +897,57 @@ static void DestroyFrontiers(void) {
     tie_frontiers = NULL;
 }
 
+/**
+ * @brief Pushes frontier up without keeping track of remotenesses. Winning and
+ * losing positions are processed first until no new positions are discovered,
+ * followed by tying positions.
+ */
+static bool Step4_0PushFrontierUpValueOnly(void) {
+    int bucket = 0;
+    while (!FrontiersEmpty(lose_frontiers, bucket) ||
+           !FrontiersEmpty(win_frontiers, bucket)) {
+        if (!PushFrontierHelper(lose_frontiers, kLose, bucket,
+                                &ProcessLosePosition)) {
+            return false;
+        } else if (!PushFrontierHelper(win_frontiers, kWin, bucket,
+                                       &ProcessWinPosition)) {
+            return false;
+        }
+        bucket = GetNextBucket(bucket);
+    }
+
+    bucket = 0;
+    while (!FrontiersEmpty(tie_frontiers, bucket)) {
+        if (!PushFrontierHelper(tie_frontiers, kTie, bucket,
+                                &ProcessTiePosition)) {
+            return false;
+        }
+        bucket = GetNextBucket(bucket);
+    }
+
+    return true;
+}
+
 /**
  * @brief Pushes frontier up.
  */
 static bool Step4PushFrontierUp(void) {
+    AdviseNumUndecidedChildren(kLargeAccessRandom);
+    if (value_only) {
+        if (!Step4_0PushFrontierUpValueOnly()) return false;
+        DestroyFrontiers();
+        TierArrayDestroy(&child_tiers);
+        ReverseGraphDestroy(&reverse_graph);
+        return true;
+    }
+
     // Process winning and losing positions first.
     // Remotenesses must be processed sequentially.
     for (int remoteness = 0; remoteness < kFrontierSize; ++remoteness) {
-        if (!PushFrontierHelper(lose_frontiers, remoteness,
+        if (!PushFrontierHelper(lose_frontiers, kLose, remoteness,
                                 &ProcessLosePosition)) {
             return false;
-        } else if (!PushFrontierHelper(win_frontiers, remoteness,
+        } else if (!PushFrontierHelper(win_frontiers, kWin, remoteness,
                                        &ProcessWinPosition)) {
             return false;
         }
@@ -632,12 +955,13 @@ static bool Step4PushFrontierUp(void) {
 
     // Then move on to tying positions.
     for (int remoteness = 0; remoteness < kFrontierSize; ++remoteness) {
-        if (!PushFrontierHelper(tie_frontiers, remoteness,
+        if (!PushFrontierHelper(tie_frontiers, kTie, remoteness,
                                 &ProcessTiePosition)) {
             return false;
         }
     }
     DestroyFrontiers();
+    DestroyChildIndices();
     TierArrayDestroy(&child_tiers);
     ReverseGraphDestroy(&reverse_graph);
     return true;
@@ -655,7 +979,8 @@ static ChildPosCounterType GetNumUndecidedChildren(Position pos) {
 }
 
 static void Step5MarkDrawPositions(void) {
-    PRAGMA_OMP_PARALLEL_FOR
+    AdviseNumUndecidedChildren(kLargeAccessSequential);
+    PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_STATIC
     for (Position position = 0; position < this_tier_size; ++position) {
         if (GetNumUndecidedChildren(position) > 0) {
             // A position is drawing if it still has undecided children.
@@ -663,8 +988,7 @@ static void Step5MarkDrawPositions(void) {
             continue;
         }
     }
-    free(num_undecided_children);
-    num_undecided_children = NULL;
+    FreeNumUndecidedChildren();
 }
 
 // ------------------------------ Step6SaveValues ------------------------------
@@ -687,41 +1011,61 @@ static void Step6SaveValues(void) {
 
 // --------------------------------- CompareDb ---------------------------------
 
-static bool CompareDb(void) {
-    DbProbe probe, ref_probe;
-    if (DbManagerProbeInit(&probe)) return false;
-    if (DbManagerRefProbeInit(&ref_probe)) {
-        DbManagerProbeDestroy(&probe);
-        return false;
+// Compares the SIZE positions of the current tier starting from BEGIN between
+// the current and the reference databases in one batch.
+static bool CompareDbBatch(DbProbe *probe, DbProbe *ref_probe, Position begin,
+                           int64_t size) {
+    TierPosition tier_positions[kProbeBatchSize];
+    Value ref_values[kProbeBatchSize], actual_values[kProbeBatchSize];
+    int ref_remotenesses[kProbeBatchSize];
+    int actual_remotenesses[kProbeBatchSize];
+    for (int64_t i = 0; i < size; ++i) {
+        tier_positions[i].tier = this_tier;
+        tier_positions[i].position = begin + i;
     }
+    DbManagerRefProbeRecordsBatch(ref_probe, size, tier_positions, ref_values,
+                                  ref_remotenesses);
+    DbManagerProbeRecordsBatch(probe, size, tier_positions, actual_values,
+                               actual_remotenesses);
 
-    bool success = true;
-    for (Position p = 0; p < this_tier_size; ++p) {
-        TierPosition tp = {.tier = this_tier, .position = p};
-        Value ref_value = DbManagerRefProbeValue(&ref_probe, tp);
-        if (ref_value == kUndecided) continue;
+    for (int64_t i = 0; i < size; ++i) {
+        if (ref_values[i] == kUndecided) continue;
 
-        Value actual_value = DbManagerProbeValue(&probe, tp);
-        if (actual_value != ref_value) {
+        Position p = begin + i;
+        if (actual_values[i] != ref_values[i]) {
             printf("CompareDb: inconsistent value at tier %" PRITier
                    " position %" PRIPos "\n",
                    this_tier, p);
-            success = false;
-            goto _bailout;
+            return false;
         }
 
-        int actual_remoteness = DbManagerProbeRemoteness(&probe, tp);
-        int ref_remoteness = DbManagerRefProbeRemoteness(&ref_probe, tp);
-        if (actual_remoteness != ref_remoteness) {
+        if (actual_remotenesses[i] != ref_remotenesses[i]) {
             printf("CompareDb: inconsistent remoteness at tier %" PRITier
                    " position %" PRIPos "\n",
                    this_tier, p);
-            success = false;
-            goto _bailout;
+            return false;
         }
     }
 
-_bailout:
+    return true;
+}
+
+static bool CompareDb(void) {
+    DbProbe probe, ref_probe;
+    if (DbManagerProbeInit(&probe)) return false;
+    if (DbManagerRefProbeInit(&ref_probe)) {
+        DbManagerProbeDestroy(&probe);
+        return false;
+    }
+
+    bool success = true;
+    for (Position begin = 0; success && begin < this_tier_size;
+         begin += kProbeBatchSize) {
+        int64_t size = this_tier_size - begin;
+        if (size > kProbeBatchSize) size = kProbeBatchSize;
+        success = CompareDbBatch(&probe, &ref_probe, begin, size);
+    }
+
     DbManagerProbeDestroy(&probe);
     DbManagerRefProbeDestroy(&ref_probe);
     if (success) {
@@ -734,13 +1078,13 @@ _bailout:
 // ------------------------------- Step7Cleanup -------------------------------
 
 static void Step7Cleanup(void) {
+    FreeNumUndecidedChildren();
     this_tier = kIllegalTier;
     this_tier_size = kIllegalSize;
     TierArrayDestroy(&child_tiers);
     DbManagerFreeSolvingTier();
     DestroyFrontiers();
-    free(num_undecided_children);
-    num_undecided_children = NULL;
+    DestroyChildIndices();
     if (use_reverse_graph) {
         ReverseGraphDestroy(&reverse_graph);
         // Unset the local function pointer.
@@ -764,11 +1108,17 @@ int TierWorkerSolveBIInternal(const TierSolverApi *api, int64_t db_chunk_size,
     }
 
     /* Solver main algorithm. */
-    if (!Step0Initialize(api, db_chunk_size, tier)) goto _bailout;
+    if (!Step0Initialize(api, db_chunk_size, tier, options)) goto _bailout;
     if (!Step1LoadChildren()) goto _bailout;
     if (!Step2SetupSolverArrays()) goto _bailout;
     if (!Step3ScanTier()) goto _bailout;
+    double step4_begin = GetWallTime();
     if (!Step4PushFrontierUp()) goto _bailout;
+    if (options->verbose > 1) {
+        printf("Step4PushFrontierUp: tier %" PRITier " took %.3f seconds%s\n",
+               tier, GetWallTime() - step4_begin,
+               sort_frontiers ? " (sorted frontiers)" : "");
+    }
     Step5MarkDrawPositions();
     Step6SaveValues();
     if (options->compare && !CompareDb()) goto _bailout;
@@ -32,22 +32,52 @@
 #include "core/solvers/tier_solver/tier_worker/frontier.h"
 
 #include <assert.h>   // assert
+#include <lz4.h>      // LZ4_compress_default, LZ4_decompress_safe
 #include <stdbool.h>  // bool, true, false
 #include <stddef.h>   // NULL
-#include <stdint.h>   // int64_t
-#include <stdio.h>    // fprintf, stderr
-#include <stdlib.h>   // calloc, free
-#include <string.h>   // memset
+#include <stdint.h>   // int64_t, uint8_t, uint64_t
+#include <stdio.h>    // fprintf, stderr, FILE, tmpfile, fclose
+#include <stdlib.h>   // calloc, malloc, realloc, free
+#include <string.h>   // memcpy, memset
 
 #include "core/concurrency.h"
-#include "core/types/gamesman_types.h"  // PositionArray
+#include "core/misc.h"
+#include "core/types/gamesman_types.h"  // Position
 
 #ifdef _OPENMP
 #include <omp.h>
 #endif  // _OPENMP
 
+// Maximum number of bytes compressed as a single LZ4 block when spilling.
+static const int64_t kSpillChunkSize = 1 << 30;
+
+static int GetBytesPerPosition(Position max_position) {
+    int ret = 1;
+    while (ret < (int)sizeof(Position) &&
+           ((uint64_t)max_position >> (8 * ret)) > 0) {
+        ++ret;
+    }
+
+    return ret;
+}
+
+static void PackPosition(uint8_t *dest, Position position, int n) {
+    for (int i = 0; i < n; ++i) {
+        dest[i] = (uint8_t)((uint64_t)position >> (8 * i));
+    }
+}
+
+static Position UnpackPosition(const uint8_t *src, int n) {
+    uint64_t ret = 0;
+    for (int i = 0; i < n; ++i) {
+        ret |= (uint64_t)src[i] << (8 * i);
+    }
+
+    return (Position)ret;
+}
+
 static bool FrontierAllocateBuckets(Frontier *frontier, int size) {
-    frontier->buckets = (PositionArray *)calloc(size, sizeof(PositionArray));
+    frontier->buckets = (FrontierBucket *)calloc(size, sizeof(FrontierBucket));
     if (frontier->buckets == NULL) {
         fprintf(stderr, "FrontierInit: failed to calloc buckets.\n");
         return false;
@@ -76,13 +106,8 @@ static bool FrontierAllocateDividers(Frontier *frontier, int frontier_size,
     return true;
 }
 
-static void FrontierInitAllFields(Frontier *frontier) {
-    for (int i = 0; i < frontier->size; ++i) {
-        PositionArrayInit(&frontier->buckets[i]);
-    }
-}
-
-bool FrontierInit(Frontier *frontier, int frontier_size, int dividers_size) {
+bool FrontierInit(Frontier *frontier, int frontier_size, int dividers_size,
+                  Position max_position, int64_t spill_threshold) {
     bool success = true;
     memset(frontier, 0, sizeof(*frontier));
     success &= FrontierAllocateBuckets(frontier, frontier_size);
@@ -93,7 +118,9 @@ bool FrontierInit(Frontier *frontier, int frontier_size, int dividers_size) {
         // allocation is successfully completed.
         frontier->size = frontier_size;
         frontier->dividers_size = dividers_size;
-        FrontierInitAllFields(frontier);
+        frontier->bytes_per_position = GetBytesPerPosition(max_position);
+        frontier->pinned = -1;
+        frontier->spill_threshold = spill_threshold;
     } else {
         // Otherwise, pointers are either NULL or pointing
         // to spaces that can be freed with function free.
@@ -111,27 +138,217 @@ bool FrontierInit(Frontier *frontier, int frontier_size, int dividers_size) {
     return success;
 }
 
+static int64_t BucketMem(const Frontier *frontier, const FrontierBucket *b) {
+    return b->capacity * frontier->bytes_per_position;
+}
+
+static void BucketDestroy(Frontier *frontier, FrontierBucket *bucket) {
+    frontier->mem -= BucketMem(frontier, bucket);
+    free(bucket->data);
+    free(bucket->segments);
+    memset(bucket, 0, sizeof(*bucket));
+}
+
 void FrontierDestroy(Frontier *frontier) {
     // Buckets.
     if (frontier->buckets) {
         for (int i = 0; i < frontier->size; ++i) {
-            PositionArrayDestroy(&frontier->buckets[i]);
+            BucketDestroy(frontier, &frontier->buckets[i]);
         }
         free(frontier->buckets);
     }
 
     // Dividers.
     if (frontier->dividers) {
-        for (int i = 0; i < frontier->dividers_size; ++i) {
+        for (int i = 0; i < frontier->size; ++i) {
             free(frontier->dividers[i]);
         }
         free(frontier->dividers);
     }
 
+    // Temporary file is automatically removed when closed.
+    if (frontier->spill_file) fclose(frontier->spill_file);
+
     // Set all member pointers to NULL and all fields to 0.
     memset(frontier, 0, sizeof(*frontier));
 }
 
+// ---------------------------------- Spilling ---------------------------------
+
+static bool AppendSegment(FrontierBucket *bucket, int64_t offset,
+                          int64_t compressed_size, int64_t num_positions) {
+    FrontierSpillSegment *new_segments = (FrontierSpillSegment *)realloc(
+        bucket->segments,
+        (bucket->num_segments + 1) * sizeof(FrontierSpillSegment));
+    if (new_segments == NULL) return false;
+
+    bucket->segments = new_segments;
+    FrontierSpillSegment *segment = &bucket->segments[bucket->num_segments++];
+    segment->offset = offset;
+    segment->compressed_size = compressed_size;
+    segment->num_positions = num_positions;
+
+    return true;
+}
+
+static bool SpillBucket(Frontier *frontier, FrontierBucket *bucket) {
+    if (frontier->spill_file == NULL) {
+        frontier->spill_file = tmpfile();
+        if (frontier->spill_file == NULL) {
+            perror("tmpfile");
+            return false;
+        }
+    }
+
+    int bpp = frontier->bytes_per_position;
+    int64_t positions_per_chunk = kSpillChunkSize / bpp;
+    int64_t max_chunk_positions = bucket->size < positions_per_chunk
+                                      ? bucket->size
+                                      : positions_per_chunk;
+    int bound = LZ4_compressBound((int)(max_chunk_positions * bpp));
+    char *compressed = (char *)malloc(bound);
+    if (compressed == NULL) return false;
+
+    for (int64_t i = 0; i < bucket->size; i += positions_per_chunk) {
+        int64_t n = bucket->size - i < positions_per_chunk
+                        ? bucket->size - i
+                        : positions_per_chunk;
+        int compressed_size =
+            LZ4_compress_default((const char *)bucket->data + i * bpp,
+                                 compressed, (int)(n * bpp), bound);
+        if (compressed_size <= 0) {
+            fprintf(stderr, "SpillBucket: LZ4 compression failed\n");
+            free(compressed);
+            return false;
+        }
+
+        int error = GuardedFseek(frontier->spill_file,
+                                 (long)frontier->spill_file_size, SEEK_SET);
+        if (error == 0) {
+            error = GuardedFwrite(compressed, 1, compressed_size,
+                                  frontier->spill_file);
+        }
+        if (error != 0 || !AppendSegment(bucket, frontier->spill_file_size,
+                                         compressed_size, n)) {
+            free(compressed);
+            return false;
+        }
+        frontier->spill_file_size += compressed_size;
+        bucket->num_spilled += n;
+    }
+    free(compressed);
+
+    frontier->mem -= BucketMem(frontier, bucket);
+    free(bucket->data);
+    bucket->data = NULL;
+    bucket->size = bucket->capacity = 0;
+
+    return true;
+}
+
+// Returns the number of bytes allocated for the buckets of FRONTIER that may be
+// spilled. The pinned bucket is being processed and is not counted, as
+// spilling other buckets cannot reduce its size.
+static int64_t SpillableMem(const Frontier *frontier) {
+    if (frontier->pinned < 0) return frontier->mem;
+
+    return frontier->mem -
+           BucketMem(frontier, &frontier->buckets[frontier->pinned]);
+}
+
+// Spills the largest unpinned buckets until the memory usage of the unpinned
+// buckets of FRONTIER drops below half of its spill threshold.
+static bool FrontierSpill(Frontier *frontier) {
+    while (SpillableMem(frontier) > frontier->spill_threshold / 2) {
+        FrontierBucket *largest = NULL;
+        for (int i = 0; i < frontier->size; ++i) {
+            FrontierBucket *bucket = &frontier->buckets[i];
+            if (i == frontier->pinned || bucket->size == 0) continue;
+            if (largest == NULL || bucket->capacity > largest->capacity) {
+                largest = bucket;
+            }
+        }
+        if (largest == NULL) break;  // Nothing else can be spilled.
+        if (!SpillBucket(frontier, largest)) {
+            fprintf(stderr, "FrontierSpill: failed to spill bucket\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool FrontierLoadRemoteness(Frontier *frontier, int remoteness) {
+    frontier->pinned = remoteness;
+    FrontierBucket *bucket = &frontier->buckets[remoteness];
+    if (bucket->num_segments == 0) return true;
+
+    int bpp = frontier->bytes_per_position;
+    int64_t total = bucket->num_spilled + bucket->size;
+    uint8_t *data = (uint8_t *)malloc(total * bpp);
+    if (data == NULL) return false;
+
+    // Spilled positions precede those in memory.
+    int64_t offset = 0;
+    for (int64_t i = 0; i < bucket->num_segments; ++i) {
+        const FrontierSpillSegment *segment = &bucket->segments[i];
+        char *compressed = (char *)malloc(segment->compressed_size);
+        if (compressed == NULL) {
+            free(data);
+            return false;
+        }
+        int error = GuardedFseek(frontier->spill_file, (long)segment->offset,
+                                 SEEK_SET);
+        if (error == 0) {
+            error = GuardedFread(compressed, 1, segment->compressed_size,
+                                 frontier->spill_file, false);
+        }
+        int expected = (int)(segment->num_positions * bpp);
+        int decompressed =
+            error != 0 ? -1
+                       : LZ4_decompress_safe(compressed,
+                                             (char *)data + offset * bpp,
+                                             (int)segment->compressed_size,
+                                             expected);
+        free(compressed);
+        if (decompressed != expected) {
+            fprintf(stderr,
+                    "FrontierLoadRemoteness: failed to load spilled chunk\n");
+            free(data);
+            return false;
+        }
+        offset += segment->num_positions;
+    }
+    memcpy(data + offset * bpp, bucket->data, bucket->size * bpp);
+
+    frontier->mem += (total - bucket->capacity) * bpp;
+    free(bucket->data);
+    free(bucket->segments);
+    bucket->data = data;
+    bucket->size = bucket->capacity = total;
+    bucket->segments = NULL;
+    bucket->num_segments = bucket->num_spilled = 0;
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+static bool BucketExpand(Frontier *frontier, FrontierBucket *bucket) {
+    // Grow by a factor of 1.5 to limit the amount of unused space.
+    int64_t new_capacity = bucket->capacity + bucket->capacity / 2 + 16;
+    uint8_t *new_data = (uint8_t *)realloc(
+        bucket->data, new_capacity * frontier->bytes_per_position);
+    if (new_data == NULL) return false;
+
+    frontier->mem +=
+        (new_capacity - bucket->capacity) * frontier->bytes_per_position;
+    bucket->data = new_data;
+    bucket->capacity = new_capacity;
+
+    return true;
+}
+
 bool FrontierAdd(Frontier *frontier, Position position, int remoteness,
                  int child_tier_index) {
     // If this fails, there is a bug in tier solver's code.
@@ -147,12 +364,22 @@ bool FrontierAdd(Frontier *frontier, Position position, int remoteness,
     }
 
     // Push position into frontier.
-    bool success =
-        PositionArrayAppend(&frontier->buckets[remoteness], position);
-    if (!success) return false;
+    FrontierBucket *bucket = &frontier->buckets[remoteness];
+    if (bucket->size == bucket->capacity && !BucketExpand(frontier, bucket)) {
+        return false;
+    }
+    int bpp = frontier->bytes_per_position;
+    PackPosition(bucket->data + bucket->size * bpp, position, bpp);
+    ++bucket->size;
 
     // Update divider.
     ++frontier->dividers[remoteness][child_tier_index];
+
+    if (frontier->spill_threshold > 0 &&
+        SpillableMem(frontier) > frontier->spill_threshold) {
+        return FrontierSpill(frontier);
+    }
+
     return true;
 }
 
@@ -167,13 +394,128 @@ void FrontierAccumulateDividers(Frontier *frontier) {
     }
 }
 
+int64_t FrontierGetSize(const Frontier *frontier, int remoteness) {
+    const FrontierBucket *bucket = &frontier->buckets[remoteness];
+    return bucket->size + bucket->num_spilled;
+}
+
+// Chunks with fewer positions than this are sorted using insertion sort.
+enum { kInsertionSortThreshold = 32 };
+
+static bool IsSortedPacked(const uint8_t *data, int64_t n, int bpp) {
+    for (int64_t i = 1; i < n; ++i) {
+        if (UnpackPosition(data + (i - 1) * bpp, bpp) >
+            UnpackPosition(data + i * bpp, bpp)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void SwapPacked(uint8_t *a, uint8_t *b, int bpp) {
+    for (int i = 0; i < bpp; ++i) {
+        uint8_t tmp = a[i];
+        a[i] = b[i];
+        b[i] = tmp;
+    }
+}
+
+static void InsertionSortPacked(uint8_t *data, int64_t n, int bpp) {
+    for (int64_t i = 1; i < n; ++i) {
+        Position key = UnpackPosition(data + i * bpp, bpp);
+        int64_t j = i - 1;
+        while (j >= 0 && UnpackPosition(data + j * bpp, bpp) > key) {
+            memcpy(data + (j + 1) * bpp, data + j * bpp, bpp);
+            --j;
+        }
+        PackPosition(data + (j + 1) * bpp, key, bpp);
+    }
+}
+
+// Sorts the N positions packed in DATA, BPP bytes each, by byte DIGIT and all
+// less significant bytes in ascending order using an in-place MSD radix sort
+// (American flag sort). The positions are permuted by swapping them into their
+// buckets, so no scratch space is needed.
+static void RadixSortPacked(uint8_t *data, int64_t n, int bpp, int digit) {
+    if (n < kInsertionSortThreshold) {
+        InsertionSortPacked(data, n, bpp);
+        return;
+    }
+
+    int64_t counts[256] = {0};
+    for (int64_t i = 0; i < n; ++i) {
+        ++counts[data[i * bpp + digit]];
+    }
+
+    int64_t heads[256], tails[256];
+    int64_t sum = 0;
+    for (int d = 0; d < 256; ++d) {
+        heads[d] = sum;
+        sum += counts[d];
+        tails[d] = sum;
+    }
+    for (int d = 0; d < 256; ++d) {
+        while (heads[d] < tails[d]) {
+            uint8_t *position = data + heads[d] * bpp;
+            int dest = position[digit];
+            if (dest == d) {
+                ++heads[d];
+            } else {
+                SwapPacked(position, data + heads[dest]++ * bpp, bpp);
+            }
+        }
+    }
+    if (digit == 0) return;
+
+    int64_t begin = 0;
+    for (int d = 0; d < 256; ++d) {
+        if (counts[d] > 1) {
+            RadixSortPacked(data + begin * bpp, counts[d], bpp, digit - 1);
+        }
+        begin += counts[d];
+    }
+}
+
+void FrontierSortRemoteness(Frontier *frontier, int remoteness) {
+    FrontierBucket *bucket = &frontier->buckets[remoteness];
+    const int64_t *dividers = frontier->dividers[remoteness];
+    int bpp = frontier->bytes_per_position;
+
+    int64_t begin = 0;
+    for (int i = 0; i < frontier->dividers_size; ++i) {
+        int64_t n = dividers[i] - begin;
+        uint8_t *chunk = bucket->data + begin * bpp;
+        begin = dividers[i];
+        if (IsSortedPacked(chunk, n, bpp)) continue;
+
+        // Only sort by the bytes needed by the largest position in the chunk.
+        Position max = 0;
+        for (int64_t j = 0; j < n; ++j) {
+            Position position = UnpackPosition(chunk + j * bpp, bpp);
+            if (position > max) max = position;
+        }
+        RadixSortPacked(chunk, n, bpp, GetBytesPerPosition(max) - 1);
+    }
+}
+
 Position FrontierGetPosition(const Frontier *frontier, int remoteness,
                              int64_t i) {
-    return frontier->buckets[remoteness].array[i];
+    const FrontierBucket *bucket = &frontier->buckets[remoteness];
+    int bpp = frontier->bytes_per_position;
+    return UnpackPosition(bucket->data + i * bpp, bpp);
 }
 
 void FrontierFreeRemoteness(Frontier *frontier, int remoteness) {
-    PositionArrayDestroy(&frontier->buckets[remoteness]);
+    BucketDestroy(frontier, &frontier->buckets[remoteness]);
+    if (frontier->pinned == remoteness) frontier->pinned = -1;
     free(frontier->dividers[remoteness]);
     frontier->dividers[remoteness] = NULL;
 }
+
+void FrontierResetRemoteness(Frontier *frontier, int remoteness) {
+    BucketDestroy(frontier, &frontier->buckets[remoteness]);
+    if (frontier->pinned == remoteness) frontier->pinned = -1;
+    memset(frontier->dividers[remoteness], 0,
+           frontier->dividers_size * sizeof(int64_t));
+}
@@ -34,27 +34,67 @@
 #define GAMESMANONE_CORE_SOLVERS_TIER_SOLVER_FRONTIER_H_
 
 #include <stdbool.h>  // bool
-#include <stdint.h>   // int64_t
+#include <stdint.h>   // int64_t, uint8_t
+#include <stdio.h>    // FILE
 
-#include "core/types/gamesman_types.h"  // PositionArray
+#include "core/types/gamesman_types.h"  // Position
+
+/** @brief A chunk of positions spilled to the temporary file of a Frontier. */
+typedef struct FrontierSpillSegment {
+    int64_t offset;          /**< Offset to the compressed chunk in file. */
+    int64_t compressed_size; /**< Size of the compressed chunk in bytes. */
+    int64_t num_positions;   /**< Number of positions in the chunk. */
+} FrontierSpillSegment;
+
+/**
+ * @brief Positions of the same remoteness stored in a Frontier, packed using
+ * the minimum number of bytes needed to represent the largest position.
+ */
+typedef struct FrontierBucket {
+    /** Packed in-memory positions, \c bytes_per_position bytes each. */
+    uint8_t *data;
+
+    /** Number of positions currently held in memory. */
+    int64_t size;
+
+    /** Number of positions that \c data can hold before expanding. */
+    int64_t capacity;
+
+    /**
+     * Chunks of positions spilled to disk. Spilled positions always precede
+     * those in memory.
+     */
+    FrontierSpillSegment *segments;
+
+    /** Number of spilled chunks. */
+    int64_t num_segments;
+
+    /** Total number of spilled positions. */
+    int64_t num_spilled;
+} FrontierBucket;
 
 /**
  * @brief A Frontier is a dynamic 2D Position array which stores solved
  * positions that have not been used to deduce the values of their parents.
  *
- * @details A Frontier object contains an array of PositionArray objects,
- * where the i-th PositionArray stores solved but unprocessed Positions
- * with remoteness i.
+ * @details A Frontier object contains an array of FrontierBucket objects,
+ * where the i-th bucket stores solved but unprocessed Positions with remoteness
+ * i. To reduce the memory usage of the solver, positions are packed into the
+ * smallest number of bytes that can hold all positions of the current tier and
+ * its child tiers, and buckets grow by a factor of 1.5 instead of 2. If a spill
+ * threshold is set, the largest buckets are compressed and moved to a
+ * temporary file whenever the memory used by the buckets other than the one
+ * being processed exceeds the threshold. Spilled buckets are loaded back into
+ * memory by FrontierLoadRemoteness() before they are processed.
  */
 typedef struct Frontier {
     /**
-     * 2-dimensional Position array. The first dimension is fixed and set to
-     * the frontier_size passed to the FrontierInit() function. This is usually
-     * set to the maximum remoteness supported by GAMESMAN plus one. The second
-     * dimension can be dynamically expanded if needed, and the expansion
-     * process is handled by the PositionArray type.
+     * Array of position buckets. The size of the array is fixed and set to the
+     * frontier_size passed to the FrontierInit() function. This is usually
+     * set to the maximum remoteness supported by GAMESMAN plus one. Each bucket
+     * can be dynamically expanded if needed.
      */
-    PositionArray *buckets;
+    FrontierBucket *buckets;
 
     /**
      * A 2-dimensional integer array storing the "divider" values. Both
@@ -85,6 +125,24 @@ typedef struct Frontier {
 
     /** Number of dividers. */
     int dividers_size;
+
+    /** Number of bytes used to store each position. */
+    int bytes_per_position;
+
+    /** Index of the bucket loaded for processing, which may not be spilled. */
+    int pinned;
+
+    /** Number of bytes allocated for in-memory buckets. */
+    int64_t mem;
+
+    /** Spill threshold in bytes, or 0 if spilling is disabled. */
+    int64_t spill_threshold;
+
+    /** Temporary file holding the spilled chunks, or NULL if not created. */
+    FILE *spill_file;
+
+    /** Size of the temporary file in bytes. */
+    int64_t spill_file_size;
 } Frontier;
 
 /**
@@ -95,10 +153,16 @@ typedef struct Frontier {
  * set to the maximum remoteness supported by GAMESMAN plus one.
  * @param dividers_size Number of dividers to allocate. This should be set to
  * the number of child tiers of the current solving tier.
+ * @param max_position Largest position that will be added to the frontier,
+ * which determines the number of bytes used to store each position.
+ * @param spill_threshold Number of bytes of in-memory buckets, not counting
+ * the bucket being processed, beyond which the largest buckets are spilled to
+ * a temporary file, or 0 to disable spilling.
  * @return true on success,
  * @return false otherwise.
  */
-bool FrontierInit(Frontier *frontier, int frontier_size, int dividers_size);
+bool FrontierInit(Frontier *frontier, int frontier_size, int dividers_size,
+                  Position max_position, int64_t spill_threshold);
 
 /** @brief Destroys FRONTIER, freeing all allocated memory. */
 void FrontierDestroy(Frontier *frontier);
@@ -128,10 +192,51 @@ bool FrontierAdd(Frontier *frontier, Position position, int remoteness,
  */
 void FrontierAccumulateDividers(Frontier *frontier);
 
+/**
+ * @brief Loads the positions of remoteness \p remoteness that were spilled to
+ * disk back into memory and pins the bucket so that it will not be spilled
+ * again until it is freed. Must be called before the positions of the given
+ * \p remoteness are accessed.
+ *
+ * @param frontier Frontier to load from.
+ * @param remoteness Remoteness of the bucket to load.
+ * @return true on success,
+ * @return false on memory allocation, file system, or decompression failure.
+ */
+bool FrontierLoadRemoteness(Frontier *frontier, int remoteness);
+
+/**
+ * @brief Returns the number of positions of remoteness \p remoteness in
+ * \p frontier, including those that have been spilled to disk.
+ */
+int64_t FrontierGetSize(const Frontier *frontier, int remoteness);
+
+/**
+ * @brief Sorts the positions of remoteness \p remoteness loaded from each child
+ * tier in \p frontier in ascending order.
+ *
+ * @details Positions from different child tiers are not mixed, so the dividers
+ * remain valid after sorting. Each chunk is sorted in place on the packed
+ * positions using an MSD radix sort that only processes the bytes needed by
+ * the largest position in the chunk, and chunks that are already sorted are
+ * skipped. No additional memory is allocated. Processing a frontier in sorted
+ * order makes parent lookups and database writes mostly sequential, which
+ * reduces cache and TLB misses on large tiers.
+ *
+ * @note Assumes FrontierAccumulateDividers() and FrontierLoadRemoteness() have
+ * been called on \p frontier.
+ *
+ * @param frontier Frontier to sort.
+ * @param remoteness Remoteness of the bucket to sort.
+ */
+void FrontierSortRemoteness(Frontier *frontier, int remoteness);
+
 /**
  * @brief Returns the \p i -th position of remoteness \p remoteness in
  * \p frontier.
  *
+ * @note Assumes FrontierLoadRemoteness() has been called on \p frontier.
+ *
  * @param frontier Source frontier.
  * @param remoteness Remoteness of the position.
  * @param i Index of the position of the given \p remoteness inside the
@@ -148,4 +253,11 @@ Position FrontierGetPosition(const Frontier *frontier, int remoteness,
  */
 void FrontierFreeRemoteness(Frontier *frontier, int remoteness);
 
+/**
+ * @brief Deallocates the bucket for remoteness REMOTENESS in FRONTIER and
+ * resets its dividers to zero so that the bucket can be refilled with positions
+ * of the last child tier index.
+ */
+void FrontierResetRemoteness(Frontier *frontier, int remoteness);
+
 #endif  // GAMESMANONE_CORE_SOLVERS_TIER_SOLVER_FRONTIER_H_
@@ -30,11 +30,13 @@
 #include <stdbool.h>  // bool, true, false
 #include <stdint.h>   // intptr_t, int64_t
 #include <stdio.h>    // printf, fprintf, stderr
+#include <stdlib.h>   // calloc, free
 
 #include "core/concurrency.h"
 #include "core/constants.h"
 #include "core/data_structures/bitstream.h"
 #include "core/db/db_manager.h"
+#include "core/db/db_tier_summary.h"
 #include "core/misc.h"
 #include "core/solvers/tier_solver/tier_solver.h"
 #include "core/types/gamesman_types.h"
@@ -56,9 +58,31 @@ static intptr_t mem;            // Heap memory remaining for loading tiers.
 static Tier this_tier;          // The tier being solved.
 static int64_t this_tier_size;  // Size of the tier being solved.
 
+// Number of positions compared at once by CompareDb.
+enum { kProbeBatchSize = 1024 };
+
 // Canonical child tiers of the tier being solved.
 static TierArray canonical_child_tiers;
 
+// Handles to the loaded child tiers, in the same order as
+// canonical_child_tiers. The tier of each handle is kIllegalTier if the child
+// tier is not loaded in the current pass.
+static DbTierHandle *child_handles;
+
+// Summary of the most recently examined child tier.
+static DbTierSummary child_summary;
+
+// Largest remoteness among the child tiers loaded so far.
+static int child_remoteness_max;
+
+// Whether to solve for values only, in which case child remotenesses are
+// neither needed nor checked.
+static bool value_only;
+
+// Set if a child position without a remoteness is found during a full solve,
+// which happens if its tier was solved for values only.
+static ConcurrentBool value_only_child_found;
+
 // ------------------------------ Step0Initialize ------------------------------
 
 static int TierSizeComp(const void *t1, const void *t2) {
@@ -90,6 +114,13 @@ static bool Step0_0SetupChildTiers(void) {
     TierHashSetDestroy(&dedup);
     TierArrayDestroy(&child_tiers);
 
+    child_handles = (DbTierHandle *)calloc(canonical_child_tiers.size,
+                                           sizeof(DbTierHandle));
+    if (canonical_child_tiers.size > 0 && child_handles == NULL) return false;
+    for (int64_t i = 0; i < canonical_child_tiers.size; ++i) {
+        child_handles[i].tier = kIllegalTier;
+    }
+
     return true;
 }
 
@@ -99,6 +130,8 @@ static bool Step0Initialize(const TierSolverApi *api, Tier tier,
     mem = memlimit ? memlimit : GetPhysicalMemory() / 10 * 9;
     this_tier = tier;
     this_tier_size = api_internal->GetTierSize(tier);
+    child_remoteness_max = 0;
+    ConcurrentBoolInit(&value_only_child_found, false);
 
     // Setup the canonical child tiers array.
     if (!Step0_0SetupChildTiers()) return false;
@@ -123,29 +156,78 @@ static bool Step0Initialize(const TierSolverApi *api, Tier tier,
 
 // ------------------------------- Step1Iterate -------------------------------
 
-static bool Step1_0LoadChildTiers(BitStream *processed) {
-    // Assuming canonical_child_tiers have been sorted in ascending size order.
-    for (int64_t i = canonical_child_tiers.size - 1; i >= 0; --i) {
-        // Skip if already processed.
-        if (BitStreamGet(processed, i)) continue;
+// Returns the largest remoteness in the I-th canonical child tier, which must
+// be loaded.
+static int GetLoadedChildRemotenessMax(int64_t i) {
+    static const Value kAllValues[kNumValues] = {kUndecided, kLose, kDraw,
+                                                 kTie, kWin};
+    Tier child_tier = canonical_child_tiers.array[i];
+    const DbTierHandle *handle = &child_handles[i];
+
+    // Use the stored summary of the child tier if available.
+    int64_t size = api_internal->GetTierSize(child_tier);
+    if (DbManagerGetTierSummary(child_tier, size, &child_summary) ==
+        kNoError) {
+        return DbTierSummaryGetMaxRemoteness(&child_summary, kAllValues,
+                                             kNumValues);
+    }
 
-        // Check if the tier can be loaded.
-        Tier child_tier = canonical_child_tiers.array[i];
-        int64_t size = api_internal->GetTierSize(child_tier);
-        intptr_t required =
-            DbManagerTierMemUsage(canonical_child_tiers.array[i], size);
-        if (required > mem) continue;  // Not enough memory to load this tier.
-
-        // The tier can be loaded. Proceed to loading.
-        mem -= required;
-        BitStreamSet(processed, i);
-        int error = DbManagerLoadTier(child_tier, size);
-        if (error != kNoError) return false;
+    int remoteness_max = 0;
+    PRAGMA_OMP_PARALLEL_FOR_REDUCTION_MAX(remoteness_max)
+    for (Position pos = 0; pos < size; ++pos) {
+        int r = DbTierHandleGetRemoteness(handle, pos);
+        if (r > remoteness_max) remoteness_max = r;
+    }
+
+    return remoteness_max;
+}
+
+static bool Step1_0LoadChildTiers(BitStream *processed) {
+    // Loaded tiers may use less memory than reserved, for example if they are
+    // kept compressed, in which case the skipped tiers are tried again.
+    bool retry = true;
+    while (retry) {
+        retry = false;
+        // Assuming canonical_child_tiers have been sorted in ascending size
+        // order.
+        for (int64_t i = canonical_child_tiers.size - 1; i >= 0; --i) {
+            // Skip if already processed.
+            if (BitStreamGet(processed, i)) continue;
+
+            // Check if the tier can be loaded.
+            Tier child_tier = canonical_child_tiers.array[i];
+            int64_t size = api_internal->GetTierSize(child_tier);
+            intptr_t required = DbManagerTierMemUsage(child_tier, size);
+            if (required > mem) continue;  // Not enough memory to load it.
+
+            // The tier can be loaded. Proceed to loading.
+            mem -= required;
+            BitStreamSet(processed, i);
+            int error = DbManagerLoadTier(child_tier, size);
+            if (error != kNoError) return false;
+            error = DbManagerGetLoadedTierHandle(child_tier, &child_handles[i]);
+            if (error != kNoError) return false;
+            int r = GetLoadedChildRemotenessMax(i);
+            if (r > child_remoteness_max) child_remoteness_max = r;
+
+            // Give back the memory reserved but not used by the loaded tier.
+            intptr_t unused =
+                required - DbManagerLoadedTierMemUsage(child_tier, size);
+            mem += unused;
+            if (unused > 0) retry = true;
+        }
     }
 
     return true;
 }
 
+// Makes sure that the solving tier can store the remoteness of any parent of
+// the positions in the child tiers loaded so far, which is at most one plus
+// the largest remoteness among them.
+static bool Step1_1ReserveRemoteness(void) {
+    return DbManagerReserveRemoteness(child_remoteness_max + 1) == kNoError;
+}
+
 static bool IsCanonicalPosition(Position position) {
     TierPosition tier_position = {.tier = this_tier, .position = position};
     return api_internal->GetCanonicalPosition(tier_position) == position;
@@ -195,30 +277,53 @@ static int OutcomeCompare(Value v1, int r1, Value v2, int r2) {
     return (1 - (v1 == kLose) * 2) * (r2 - r1);
 }
 
-static void FindMinOutcome(const TierPositionArray *positions, Value *min_val,
+// Returns the handle to CHILD_TIER, or NULL if it is not loaded in the current
+// pass.
+static const DbTierHandle *GetLoadedChildHandle(Tier child_tier) {
+    for (int64_t i = 0; i < canonical_child_tiers.size; ++i) {
+        if (child_handles[i].tier == child_tier) return &child_handles[i];
+    }
+
+    return NULL;
+}
+
+// Returns false if, in a full solve, any of the POSITIONS in the loaded tiers
+// has a winning, losing, or tying value but no remoteness.
+static bool FindMinOutcome(const TierPositionArray *positions, Value *min_val,
                            int *min_remoteness) {
     // Initialize to best possible outcome: win in 0.
     *min_val = kWin;
     *min_remoteness = 0;
     for (int64_t i = 0; i < positions->size; ++i) {
-        Tier tier = positions->array[i].tier;
         Position pos = positions->array[i].position;
 
         // Skip this position if the tier it belongs to isn't loaded in this
         // iteration.
-        if (!DbManagerIsTierLoaded(tier)) continue;
-
-        Value value = DbManagerGetValueFromLoaded(tier, pos);
-        int remoteness = DbManagerGetRemotenessFromLoaded(tier, pos);
+        const DbTierHandle *handle =
+            GetLoadedChildHandle(positions->array[i].tier);
+        if (handle == NULL) continue;
+
+        Value value;
+        int remoteness;
+        DbTierHandleGetRecordFields(handle, pos, &value, &remoteness);
+        if (!value_only && remoteness == kUnknownRemoteness &&
+            value != kUndecided && value != kDraw) {
+            ConcurrentBoolStore(&value_only_child_found, true);
+            return false;
+        }
         if (OutcomeCompare(value, remoteness, *min_val, *min_remoteness) < 0) {
             *min_val = value;
             *min_remoteness = remoteness;
         }
     }
+
+    return true;
 }
 
-static void MaximizeParent(Position parent, Value child_value,
-                           int child_remoteness) {
+// Returns kNoError on success, or the error returned by
+// DbManagerSetRemoteness if the new remoteness cannot be stored.
+static int MaximizeParent(Position parent, Value child_value,
+                          int child_remoteness) {
     Value parent_value = DbManagerGetValue(parent);
     int parent_remoteness = DbManagerGetRemoteness(parent);
 
@@ -230,11 +335,13 @@ static void MaximizeParent(Position parent, Value child_value,
                        parent_new_remoteness) < 0) {
         // Maximize parent outcome.
         DbManagerSetValue(parent, parent_new_value);
-        DbManagerSetRemoteness(parent, parent_new_remoteness);
+        return DbManagerSetRemoteness(parent, parent_new_remoteness);
     }
+
+    return kNoError;
 }
 
-static bool Step1_1IterateOnePass(void) {
+static bool Step1_2IterateOnePass(void) {
     ConcurrentBool success;
     ConcurrentBoolInit(&success, true);
     PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_DYNAMIC(1024)
@@ -252,7 +359,9 @@ static bool Step1_1IterateOnePass(void) {
         if (primitive_value != kUndecided) {  // If primitive...
             // Set value immediately and continue to the next position.
             DbManagerSetValue(pos, primitive_value);
-            DbManagerSetRemoteness(pos, 0);
+            if (DbManagerSetRemoteness(pos, 0) != kNoError) {
+                ConcurrentBoolStore(&success, false);
+            }
             continue;
         }
 
@@ -264,24 +373,32 @@ static bool Step1_1IterateOnePass(void) {
         // Find the min child (with respect to the player at parent position.)
         Value min_child_value;
         int min_child_remoteness;
-        FindMinOutcome(&child_positions, &min_child_value,
-                       &min_child_remoteness);
+        bool found = FindMinOutcome(&child_positions, &min_child_value,
+                                    &min_child_remoteness);
         TierPositionArrayDestroy(&child_positions);
+        if (!found) {
+            ConcurrentBoolStore(&success, false);
+            continue;
+        }
 
         // Maximize the value of the parent position using the min child.
-        MaximizeParent(pos, min_child_value, min_child_remoteness);
+        if (MaximizeParent(pos, min_child_value, min_child_remoteness) !=
+            kNoError) {
+            ConcurrentBoolStore(&success, false);
+        }
     }
 
     return ConcurrentBoolLoad(&success);
 }
 
-static void Step1_2UnloadChildTiers(void) {
+static void Step1_3UnloadChildTiers(void) {
     for (int64_t i = 0; i < canonical_child_tiers.size; ++i) {
         Tier child_tier = canonical_child_tiers.array[i];
         if (DbManagerIsTierLoaded(child_tier)) {
-            DbManagerUnloadTier(child_tier);
             int64_t child_tier_size = api_internal->GetTierSize(child_tier);
-            mem += DbManagerTierMemUsage(child_tier, child_tier_size);
+            mem += DbManagerLoadedTierMemUsage(child_tier, child_tier_size);
+            DbManagerUnloadTier(child_tier);
+            child_handles[i].tier = kIllegalTier;
         }
     }
 }
@@ -293,17 +410,18 @@ static bool Step1Iterate(void) {
     do {
         // Load as many child tiers as possible in each iteration.
         if (!Step1_0LoadChildTiers(&processed)) goto _bailout;
+        if (!Step1_1ReserveRemoteness()) goto _bailout;
 
         // Do one pass of scanning.
-        if (!Step1_1IterateOnePass()) goto _bailout;
+        if (!Step1_2IterateOnePass()) goto _bailout;
 
         // Unload all child tiers.
-        Step1_2UnloadChildTiers();
+        Step1_3UnloadChildTiers();
     } while (BitStreamCount(&processed) < canonical_child_tiers.size);
     success = true;
 
 _bailout:
-    Step1_2UnloadChildTiers();
+    Step1_3UnloadChildTiers();
     BitStreamDestroy(&processed);
     return success;
 }
@@ -328,41 +446,61 @@ static void Step2FlushDb(void) {
 
 // --------------------------------- CompareDb ---------------------------------
 
-static bool CompareDb(void) {
-    DbProbe probe, ref_probe;
-    if (DbManagerProbeInit(&probe)) return false;
-    if (DbManagerRefProbeInit(&ref_probe)) {
-        DbManagerProbeDestroy(&probe);
-        return false;
+// Compares the SIZE positions of the current tier starting from BEGIN between
+// the current and the reference databases in one batch.
+static bool CompareDbBatch(DbProbe *probe, DbProbe *ref_probe, Position begin,
+                           int64_t size) {
+    TierPosition tier_positions[kProbeBatchSize];
+    Value ref_values[kProbeBatchSize], actual_values[kProbeBatchSize];
+    int ref_remotenesses[kProbeBatchSize];
+    int actual_remotenesses[kProbeBatchSize];
+    for (int64_t i = 0; i < size; ++i) {
+        tier_positions[i].tier = this_tier;
+        tier_positions[i].position = begin + i;
     }
+    DbManagerRefProbeRecordsBatch(ref_probe, size, tier_positions, ref_values,
+                                  ref_remotenesses);
+    DbManagerProbeRecordsBatch(probe, size, tier_positions, actual_values,
+                               actual_remotenesses);
 
-    bool success = true;
-    for (Position p = 0; p < this_tier_size; ++p) {
-        TierPosition tp = {.tier = this_tier, .position = p};
-        Value ref_value = DbManagerRefProbeValue(&ref_probe, tp);
-        if (ref_value == kUndecided) continue;
+    for (int64_t i = 0; i < size; ++i) {
+        if (ref_values[i] == kUndecided) continue;
 
-        Value actual_value = DbManagerProbeValue(&probe, tp);
-        if (actual_value != ref_value) {
+        Position p = begin + i;
+        if (actual_values[i] != ref_values[i]) {
             printf("CompareDb: inconsistent value at tier %" PRITier
                    " position %" PRIPos "\n",
                    this_tier, p);
-            success = false;
-            goto _bailout;
+            return false;
         }
 
-        int actual_remoteness = DbManagerProbeRemoteness(&probe, tp);
-        int ref_remoteness = DbManagerRefProbeRemoteness(&ref_probe, tp);
-        if (actual_remoteness != ref_remoteness) {
+        if (actual_remotenesses[i] != ref_remotenesses[i]) {
             printf("CompareDb: inconsistent remoteness at tier %" PRITier
                    " position %" PRIPos "\n",
                    this_tier, p);
-            success = false;
-            goto _bailout;
+            return false;
         }
     }
 
-_bailout:
+    return true;
+}
+
+static bool CompareDb(void) {
+    DbProbe probe, ref_probe;
+    if (DbManagerProbeInit(&probe)) return false;
+    if (DbManagerRefProbeInit(&ref_probe)) {
+        DbManagerProbeDestroy(&probe);
+        return false;
+    }
+
+    bool success = true;
+    for (Position begin = 0; success && begin < this_tier_size;
+         begin += kProbeBatchSize) {
+        int64_t size = this_tier_size - begin;
+        if (size > kProbeBatchSize) size = kProbeBatchSize;
+        success = CompareDbBatch(&probe, &ref_probe, begin, size);
+    }
+
     DbManagerProbeDestroy(&probe);
     DbManagerRefProbeDestroy(&ref_probe);
     if (success) {
@@ -382,6 +520,8 @@ static void Step3Cleanup(void) {
         if (DbManagerIsTierLoaded(child_tier)) DbManagerUnloadTier(child_tier);
     }
     TierArrayDestroy(&canonical_child_tiers);
+    free(child_handles);
+    child_handles = NULL;
     DbManagerFreeSolvingTier();
 }
 
@@ -400,8 +540,17 @@ int TierWorkerSolveITInternal(const TierSolverApi *api, Tier tier,
     }
 
     /* Immediate transition main algorithm. */
+    value_only = options->value_only;
     if (!Step0Initialize(api, tier, memlimit)) goto _bailout;
-    if (!Step1Iterate()) goto _bailout;
+    if (!Step1Iterate()) {
+        if (ConcurrentBoolLoad(&value_only_child_found)) {
+            fprintf(stderr,
+                    "TierWorkerSolveITInternal: a child tier of tier %" PRITier
+                    " was solved for values only. Re-solve the game with -f\n",
+                    tier);
+        }
+        goto _bailout;
+    }
     Step2FlushDb();
     if (options->compare && !CompareDb()) goto _bailout;
     if (solved != NULL) *solved = true;
@@ -0,0 +1,222 @@
+/**
+ * @file remoteness_index.c
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Implementation of the per-tier remoteness index.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/solvers/tier_solver/tier_worker/remoteness_index.h"
+
+#include <stdbool.h>  // bool, true, false
+#include <stddef.h>   // NULL
+#include <stdint.h>   // int64_t, uint8_t, uint64_t
+#include <stdlib.h>   // calloc, malloc, free
+
+#include "core/concurrency.h"
+#include "core/constants.h"
+#include "core/db/db_manager.h"
+#include "core/misc.h"
+#include "core/types/gamesman_types.h"
+
+// Include and use OpenMP if the _OPENMP flag is set.
+#ifdef _OPENMP
+#include <omp.h>
+#endif  // _OPENMP
+
+enum {
+    kNumKeys = 3 * kNumRemotenesses,  // Winning, losing, and tying.
+};
+
+static int GetKey(Value value, int remoteness) {
+    switch (value) {
+        case kWin:
+            return remoteness;
+        case kLose:
+            return kNumRemotenesses + remoteness;
+        case kTie:
+            return 2 * kNumRemotenesses + remoteness;
+        default:
+            return -1;
+    }
+}
+
+static int GetBytesPerPosition(Position max_position) {
+    int ret = 1;
+    while (ret < (int)sizeof(Position) &&
+           ((uint64_t)max_position >> (8 * ret)) > 0) {
+        ++ret;
+    }
+
+    return ret;
+}
+
+static void PackPosition(uint8_t *dest, Position position, int n) {
+    for (int i = 0; i < n; ++i) {
+        dest[i] = (uint8_t)((uint64_t)position >> (8 * i));
+    }
+}
+
+static Position UnpackPosition(const uint8_t *src, int n) {
+    uint64_t ret = 0;
+    for (int i = 0; i < n; ++i) {
+        ret |= (uint64_t)src[i] << (8 * i);
+    }
+
+    return (Position)ret;
+}
+
+static int GetNumParts(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else   // _OPENMP not defined.
+    return 1;
+#endif  // _OPENMP
+}
+
+// Scans positions BEGIN to END - 1 of the tier of HANDLE. If POSITIONS is NULL,
+// increments CURSORS[key] for each position of key. Otherwise, packs each
+// position of key into BPP bytes at entry CURSORS[key]++ of POSITIONS. Returns
+// false if an error occurred while reading the records of the loaded tier.
+static bool ScanPart(const DbTierHandle *handle, Position begin, Position end,
+                     int64_t *cursors, uint8_t *positions, int bpp) {
+    for (Position pos = begin; pos < end; ++pos) {
+        Value value;
+        int remoteness;
+        DbTierHandleGetRecordFields(handle, pos, &value, &remoteness);
+        if (value == kUndecided || value == kDraw) continue;
+        if (remoteness < 0 || remoteness > kRemotenessMax) return false;
+
+        int key = GetKey(value, remoteness);
+        if (key < 0) return false;  // Error reading value.
+        if (positions == NULL) {
+            ++cursors[key];
+        } else {
+            PackPosition(positions + cursors[key]++ * bpp, pos, bpp);
+        }
+    }
+
+    return true;
+}
+
+bool RemotenessIndexInit(RemotenessIndex *index, Tier tier, int64_t size) {
+    index->tier = tier;
+    index->positions = NULL;
+    index->bytes_per_position = GetBytesPerPosition(size > 0 ? size - 1 : 0);
+
+    DbTierHandle handle;
+    if (DbManagerGetLoadedTierHandle(tier, &handle) != kNoError) return false;
+    index->offsets = (int64_t *)calloc(kNumKeys + 1, sizeof(int64_t));
+    if (index->offsets == NULL) return false;
+
+    // The positions are split into one contiguous part per thread.
+    // cursors[p][key] is first used to count the positions of key in part p
+    // and then as the next index into the positions array at which to store
+    // such positions.
+    int num_parts = GetNumParts();
+    int64_t positions_per_part = RoundUpDivide(size, num_parts);
+    int64_t *cursors =
+        (int64_t *)calloc((size_t)num_parts * kNumKeys, sizeof(int64_t));
+    if (cursors == NULL) {
+        RemotenessIndexDestroy(index);
+        return false;
+    }
+
+    // Counting pass.
+    ConcurrentBool success;
+    ConcurrentBoolInit(&success, true);
+    PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_STATIC
+    for (int p = 0; p < num_parts; ++p) {
+        Position begin = p * positions_per_part;
+        Position end = begin + positions_per_part;
+        if (end > size) end = size;
+        if (!ScanPart(&handle, begin, end, &cursors[p * kNumKeys], NULL, 0)) {
+            ConcurrentBoolStore(&success, false);
+        }
+    }
+    if (!ConcurrentBoolLoad(&success)) goto _bailout;
+
+    // Exclusive prefix sums in (key, part) order, which keeps the positions of
+    // each key sorted.
+    int64_t total = 0;
+    for (int key = 0; key < kNumKeys; ++key) {
+        index->offsets[key] = total;
+        for (int p = 0; p < num_parts; ++p) {
+            int64_t count = cursors[p * kNumKeys + key];
+            cursors[p * kNumKeys + key] = total;
+            total += count;
+        }
+    }
+    index->offsets[kNumKeys] = total;
+
+    // Distribution pass.
+    int64_t num_entries = total > 0 ? total : 1;
+    int bpp = index->bytes_per_position;
+    index->positions = (uint8_t *)malloc(num_entries * bpp);
+    if (index->positions == NULL) {
+        ConcurrentBoolStore(&success, false);
+        goto _bailout;
+    }
+    PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_STATIC
+    for (int p = 0; p < num_parts; ++p) {
+        Position begin = p * positions_per_part;
+        Position end = begin + positions_per_part;
+        if (end > size) end = size;
+        if (!ScanPart(&handle, begin, end, &cursors[p * kNumKeys],
+                      index->positions, bpp)) {
+            ConcurrentBoolStore(&success, false);
+        }
+    }
+
+_bailout:
+    free(cursors);
+    if (!ConcurrentBoolLoad(&success)) {
+        RemotenessIndexDestroy(index);
+        return false;
+    }
+
+    return true;
+}
+
+void RemotenessIndexDestroy(RemotenessIndex *index) {
+    free(index->offsets);
+    index->offsets = NULL;
+    free(index->positions);
+    index->positions = NULL;
+}
+
+int64_t RemotenessIndexGetSize(const RemotenessIndex *index, Value value,
+                               int remoteness) {
+    int key = GetKey(value, remoteness);
+    if (key < 0) return 0;
+
+    return index->offsets[key + 1] - index->offsets[key];
+}
+
+Position RemotenessIndexGetPosition(const RemotenessIndex *index, Value value,
+                                    int remoteness, int64_t i) {
+    int key = GetKey(value, remoteness);
+
+    int bpp = index->bytes_per_position;
+
+    return UnpackPosition(index->positions + (index->offsets[key] + i) * bpp,
+                          bpp);
+}
@@ -0,0 +1,96 @@
+/**
+ * @file remoteness_index.h
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Per-tier index of solved positions sorted by value and remoteness,
+ * used to enumerate the solved positions of a child tier without loading them
+ * into frontiers.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAMESMANONE_CORE_SOLVERS_TIER_SOLVER_REMOTENESS_INDEX_H_
+#define GAMESMANONE_CORE_SOLVERS_TIER_SOLVER_REMOTENESS_INDEX_H_
+
+#include <stdbool.h>  // bool
+#include <stdint.h>   // int64_t, uint8_t
+
+#include "core/types/gamesman_types.h"
+
+/**
+ * @brief Index of the winning, losing, and tying positions of a tier sorted by
+ * value and remoteness.
+ *
+ * @details The index is built with a counting sort over all (value,
+ * remoteness) keys. Each position is packed into the fewest bytes that can
+ * hold the largest position of the tier, the same width a frontier uses, so the
+ * index takes about as much memory as the frontiers it replaces. Its advantage
+ * is speed rather than memory: the positions of each key are stored
+ * contiguously and are enumerated without further lookups. Drawing and
+ * undecided positions are not stored.
+ */
+typedef struct RemotenessIndex {
+    /** The indexed tier. */
+    Tier tier;
+
+    /** Positions of each key are stored in positions[offsets[key]] to
+     * positions[offsets[key + 1] - 1]. */
+    int64_t *offsets;
+
+    /** Positions sorted by key and then in ascending order, each packed into
+     * bytes_per_position bytes in little-endian order. */
+    uint8_t *positions;
+
+    /** Number of bytes used to store each position. */
+    int bytes_per_position;
+} RemotenessIndex;
+
+/**
+ * @brief Builds the remoteness index of TIER, which has SIZE positions and must
+ * have already been loaded using DbManagerLoadTier. The tier may be unloaded
+ * once the index is built.
+ *
+ * @param index Index to initialize.
+ * @param tier Loaded tier to index.
+ * @param size Number of positions in TIER.
+ * @return true on success,
+ * @return false otherwise.
+ */
+bool RemotenessIndexInit(RemotenessIndex *index, Tier tier, int64_t size);
+
+/** @brief Destroys the remoteness INDEX, freeing all allocated memory. */
+void RemotenessIndexDestroy(RemotenessIndex *index);
+
+/**
+ * @brief Returns the number of positions of VALUE and REMOTENESS in the
+ * indexed tier, or 0 if VALUE is not kWin, kLose, or kTie.
+ */
+int64_t RemotenessIndexGetSize(const RemotenessIndex *index, Value value,
+                               int remoteness);
+
+/**
+ * @brief Returns the I-th smallest position of VALUE and REMOTENESS in the
+ * indexed tier, where I is less than RemotenessIndexGetSize(INDEX, VALUE,
+ * REMOTENESS).
+ */
+Position RemotenessIndexGetPosition(const RemotenessIndex *index, Value value,
+                                    int remoteness, int64_t i);
+
+#endif  // GAMESMANONE_CORE_SOLVERS_TIER_SOLVER_REMOTENESS_INDEX_H_
@@ -35,9 +35,9 @@
 #include <stdbool.h>  // bool, true, false
 #include <stddef.h>   // NULL
 #include <stdint.h>   // int64_t
-#include <stdlib.h>   // malloc, free
 #include <string.h>   // memset
 
+#include "core/large_alloc.h"
 #include "core/types/gamesman_types.h"  // PositionArray, TierArray, TierPosition
 
 #ifdef _OPENMP
@@ -73,8 +73,8 @@ static bool InitOffsetMap(ReverseGraph *graph, const TierArray *child_tiers,
 
 static bool InitParentPositionArrays(ReverseGraph *graph) {
     // Assumes graph->size has been set.
-    graph->parents_of =
-        (PositionArray *)malloc(graph->size * sizeof(PositionArray));
+    graph->parents_of = (PositionArray *)LargeCalloc(
+        graph->size * sizeof(PositionArray));
     if (graph->parents_of == NULL) return false;
     for (int64_t i = 0; i < graph->size; ++i) {
         PositionArrayInit(&graph->parents_of[i]);
@@ -84,7 +84,8 @@ static bool InitParentPositionArrays(ReverseGraph *graph) {
 
 #ifdef _OPENMP
 static bool InitLocks(ReverseGraph *graph) {
-    graph->locks = (omp_lock_t *)malloc(graph->size * sizeof(omp_lock_t));
+    graph->locks =
+        (omp_lock_t *)LargeCalloc(graph->size * sizeof(omp_lock_t));
     if (graph->locks == NULL) return false;
     for (int64_t i = 0; i < graph->size; ++i) {
         omp_init_lock(&graph->locks[i]);
@@ -105,7 +106,7 @@ bool ReverseGraphInit(ReverseGraph *graph, const TierArray *child_tiers,
     }
 #ifdef _OPENMP
     if (!InitLocks(graph)) {
-        free(graph->parents_of);
+        LargeFree(graph->parents_of, graph->size * sizeof(PositionArray));
         graph->parents_of = NULL;
         TierHashMapDestroy(&graph->offset_map);
         return false;
@@ -122,9 +123,9 @@ void ReverseGraphDestroy(ReverseGraph *graph) {
             omp_destroy_lock(&graph->locks[i]);
 #endif  // _OPENMP
         }
-        free(graph->parents_of);
+        LargeFree(graph->parents_of, graph->size * sizeof(PositionArray));
 #ifdef _OPENMP
-        free(graph->locks);
+        LargeFree(graph->locks, graph->size * sizeof(omp_lock_t));
 #endif  // _OPENMP
     }
     graph->parents_of = NULL;
@@ -30,10 +30,12 @@
 #include <stdbool.h>  // bool, true, false
 #include <stdint.h>   // int32_t, int64_t
 #include <stdio.h>    // puts, printf, fprintf, stderr
+#include <stdlib.h>   // calloc, free
 
 #include "core/concurrency.h"
 #include "core/constants.h"
 #include "core/db/db_manager.h"
+#include "core/db/db_tier_summary.h"
 #include "core/misc.h"
 #include "core/solvers/tier_solver/tier_solver.h"
 #include "core/types/gamesman_types.h"
@@ -75,9 +77,16 @@ static int verbose;
 static Tier this_tier;          // The tier being solved.
 static int64_t this_tier_size;  // Size of the tier being solved.
 
+// Number of positions compared at once by CompareDb.
+enum { kProbeBatchSize = 1024 };
+
 // Child tiers of the tier being solved.
 static TierArray child_tiers;
 
+// Handles to the loaded child tiers, in the same order as child_tiers. The
+// tier of each handle is kIllegalTier until the child tier is loaded.
+static DbTierHandle *child_handles;
+
 // The maximum remoteness discovered at any winning/losing positions in the
 // child tiers of this tier.
 static int max_win_lose_remoteness;
@@ -86,6 +95,17 @@ static int max_win_lose_remoteness;
 // of this tier.
 static int max_tie_remoteness;
 
+// Summary of the most recently loaded child tier.
+static DbTierSummary child_summary;
+
+// Whether to solve for values only, in which case child remotenesses are
+// neither needed nor checked.
+static bool value_only;
+
+// Set if a child position without a remoteness is found during a full solve,
+// which happens if its tier was solved for values only.
+static ConcurrentBool value_only_child_found;
+
 // Last checkpoint time.
 static time_t prev_checkpoint;
 
@@ -114,6 +134,13 @@ static bool Step0_0SetupChildTiers(void) {
     TierHashSetDestroy(&dedup);
     TierArrayDestroy(&raw);
 
+    child_handles =
+        (DbTierHandle *)calloc(child_tiers.size, sizeof(DbTierHandle));
+    if (child_tiers.size > 0 && child_handles == NULL) return false;
+    for (int64_t i = 0; i < child_tiers.size; ++i) {
+        child_handles[i].tier = kIllegalTier;
+    }
+
     return true;
 }
 
@@ -137,6 +164,7 @@ static bool Step0Initialize(const TierSolverApi *api, Tier tier,
     this_tier_size = api_internal->GetTierSize(tier);
     max_win_lose_remoteness = 0;
     max_tie_remoteness = 0;
+    ConcurrentBoolInit(&value_only_child_found, false);
     checkpoint_save_cost = GetCheckpointSaveCostEstimate();
 
     return true;
@@ -144,21 +172,42 @@ static bool Step0Initialize(const TierSolverApi *api, Tier tier,
 
 // ----------------------------- Step1LoadChildren -----------------------------
 
+// Updates the largest remotenesses using the stored summary of CHILD_TIER of
+// SIZE positions. Returns false if the summary is not available.
+static bool Step1_0ReadChildSummary(Tier child_tier, int64_t size) {
+    static const Value kWinLose[] = {kWin, kLose};
+    static const Value kTieOnly[] = {kTie};
+
+    int error = DbManagerGetTierSummary(child_tier, size, &child_summary);
+    if (error != kNoError) return false;
+
+    int r = DbTierSummaryGetMaxRemoteness(&child_summary, kWinLose, 2);
+    if (r > max_win_lose_remoteness) max_win_lose_remoteness = r;
+    r = DbTierSummaryGetMaxRemoteness(&child_summary, kTieOnly, 1);
+    if (r > max_tie_remoteness) max_tie_remoteness = r;
+
+    return true;
+}
+
 static bool Step1LoadChildren(void) {
     for (int64_t i = 0; i < child_tiers.size; ++i) {
         Tier child_tier = child_tiers.array[i];
         int64_t size = api_internal->GetTierSize(child_tier);
         int error = DbManagerLoadTier(child_tier, size);
         if (error != kNoError) return false;
+        error = DbManagerGetLoadedTierHandle(child_tier, &child_handles[i]);
+        if (error != kNoError) return false;
+        if (Step1_0ReadChildSummary(child_tier, size)) continue;
 
-        // Scan for largest remotenesses
+        // Scan for largest remotenesses if the summary is not available.
+        const DbTierHandle *handle = &child_handles[i];
         PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_DYNAMIC(16)
         for (Position pos = 0; pos < size; ++pos) {
-            Value val = DbManagerGetValueFromLoaded(child_tier, pos);
+            Value val = DbTierHandleGetValue(handle, pos);
             switch (val) {
                 case kWin:
                 case kLose: {
-                    int r = DbManagerGetRemotenessFromLoaded(child_tier, pos);
+                    int r = DbTierHandleGetRemoteness(handle, pos);
                     if (r > max_win_lose_remoteness) {
                         max_win_lose_remoteness = r;
                     }
@@ -166,7 +215,7 @@ static bool Step1LoadChildren(void) {
                 }
 
                 case kTie: {
-                    int r = DbManagerGetRemotenessFromLoaded(child_tier, pos);
+                    int r = DbTierHandleGetRemoteness(handle, pos);
                     if (r > max_tie_remoteness) {
                         max_tie_remoteness = r;
                     }
@@ -210,7 +259,9 @@ static bool IsCanonicalPosition(Position position) {
     return api_internal->GetCanonicalPosition(tier_position) == position;
 }
 
-static void Step3ScanTier(void) {
+static bool Step3ScanTier(void) {
+    ConcurrentBool success;
+    ConcurrentBoolInit(&success, true);
     if (verbose > 1) PrintfAndFlush("Value iteration: scanning tier... ");
     PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_DYNAMIC(256)
     for (Position pos = 0; pos < this_tier_size; ++pos) {
@@ -227,14 +278,54 @@ static void Step3ScanTier(void) {
         if (value != kUndecided) {  // If tier_position is primitive...
             // Set its value immediately.
             DbManagerSetValue(pos, value);
-            DbManagerSetRemoteness(pos, 0);
+            if (DbManagerSetRemoteness(pos, 0) != kNoError) {
+                ConcurrentBoolStore(&success, false);
+            }
         }  // Otherwise, do nothing.
     }
     if (verbose > 1) puts("done");
+
+    return ConcurrentBoolLoad(&success);
 }
 
 // ------------------------------- Step4Iterate -------------------------------
 
+// Returns the handle to the loaded CHILD_TIER, or NULL if it is not loaded.
+static const DbTierHandle *GetChildHandle(Tier child_tier) {
+    for (int64_t i = 0; i < child_tiers.size; ++i) {
+        if (child_handles[i].tier == child_tier) return &child_handles[i];
+    }
+
+    return NULL;
+}
+
+// Stores the value and remoteness of CHILD, which is either in the solving
+// tier or in one of the loaded child tiers, into VALUE and REMOTENESS. Returns
+// false if CHILD has a winning, losing, or tying value but no remoteness.
+static bool GetChildRecord(TierPosition child, Value *value, int *remoteness) {
+    if (child.tier == this_tier) {
+        *value = DbManagerGetValue(child.position);
+        *remoteness = DbManagerGetRemoteness(child.position);
+        return true;
+    }
+
+    const DbTierHandle *handle = GetChildHandle(child.tier);
+    if (handle == NULL) {
+        *value = DbManagerGetValueFromLoaded(child.tier, child.position);
+        *remoteness =
+            DbManagerGetRemotenessFromLoaded(child.tier, child.position);
+    } else {
+        DbTierHandleGetRecordFields(handle, child.position, value, remoteness);
+    }
+    if (!value_only && *remoteness == kUnknownRemoteness &&
+        *value != kUndecided && *value != kDraw) {
+        ConcurrentBoolStore(&value_only_child_found, true);
+        return false;
+    }
+
+    return true;
+}
+
 static bool IterateWinLoseProcessPosition(int iteration, Position pos,
                                           bool *updated) {
     *updated = false;
@@ -249,15 +340,10 @@ static bool IterateWinLoseProcessPosition(int iteration, Position pos,
         TierPosition child_tier_position = child_positions.array[i];
         Value child_value;
         int child_remoteness;
-        if (child_tier_position.tier == this_tier) {
-            child_value = DbManagerGetValue(child_tier_position.position);
-            child_remoteness =
-                DbManagerGetRemoteness(child_tier_position.position);
-        } else {
-            child_value = DbManagerGetValueFromLoaded(
-                child_tier_position.tier, child_tier_position.position);
-            child_remoteness = DbManagerGetRemotenessFromLoaded(
-                child_tier_position.tier, child_tier_position.position);
+        if (!GetChildRecord(child_tier_position, &child_value,
+                            &child_remoteness)) {
+            TierPositionArrayDestroy(&child_positions);
+            return false;
         }
         switch (child_value) {
             case kUndecided:
@@ -269,10 +355,9 @@ static bool IterateWinLoseProcessPosition(int iteration, Position pos,
                 all_children_winning = false;
                 if (child_remoteness == iteration - 1) {
                     DbManagerSetValue(pos, kWin);
-                    DbManagerSetRemoteness(pos, iteration);
                     *updated = true;
                     TierPositionArrayDestroy(&child_positions);
-                    return true;
+                    return DbManagerSetRemoteness(pos, iteration) == kNoError;
                 }
                 break;
             case kWin:
@@ -288,13 +373,13 @@ static bool IterateWinLoseProcessPosition(int iteration, Position pos,
         }
     }
 
+    TierPositionArrayDestroy(&child_positions);
     if (all_children_winning && largest_win + 1 == iteration) {
         DbManagerSetValue(pos, kLose);
-        DbManagerSetRemoteness(pos, iteration);
         *updated = true;
+        return DbManagerSetRemoteness(pos, iteration) == kNoError;
     }
 
-    TierPositionArrayDestroy(&child_positions);
     return true;
 }
 
@@ -307,10 +392,12 @@ static bool CheckpointNeeded(time_t prev, time_t curr) {
 }
 
 static int CheckpointSave(int step, int remoteness) {
-    clock_t begin = clock();
+    // Checkpoints are compressed on all threads, so the cost is measured in
+    // wall time rather than in CPU time.
+    double begin = GetWallTime();
     CheckpointStatus ct = {.step = step, .remoteness = remoteness};
     int ret = DbManagerCheckpointSave(&ct, sizeof(ct));
-    checkpoint_save_cost = ((double)(clock() - begin)) / CLOCKS_PER_SEC;
+    checkpoint_save_cost = GetWallTime() - begin;
 
     return ret;
 }
@@ -337,6 +424,7 @@ static bool Step4_0IterateWinLose(int initial_remoteness) {
             if (CheckpointSave(kIteratingWinLose, i) != kNoError) return false;
             prev_checkpoint = time(NULL);
         }
+        if (DbManagerReserveRemoteness(i) != kNoError) return false;
 
         ConcurrentBoolStore(&updated, false);
         PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_DYNAMIC(128)
@@ -368,25 +456,21 @@ static bool IterateTieProcessPosition(int iteration, Position pos,
         TierPosition child_tier_position = child_positions.array[i];
         Value child_value;
         int child_remoteness;
-        if (child_tier_position.tier == this_tier) {
-            child_value = DbManagerGetValue(child_tier_position.position);
-            child_remoteness =
-                DbManagerGetRemoteness(child_tier_position.position);
-        } else {
-            child_value = DbManagerGetValueFromLoaded(
-                child_tier_position.tier, child_tier_position.position);
-            child_remoteness = DbManagerGetRemotenessFromLoaded(
-                child_tier_position.tier, child_tier_position.position);
+        if (!GetChildRecord(child_tier_position, &child_value,
+                            &child_remoteness)) {
+            TierPositionArrayDestroy(&child_positions);
+            return false;
         }
         if (child_value == kTie && child_remoteness == iteration - 1) {
             DbManagerSetValue(pos, kTie);
-            DbManagerSetRemoteness(pos, iteration);
             *updated = true;
             break;
         }
     }
 
     TierPositionArrayDestroy(&child_positions);
+    if (*updated) return DbManagerSetRemoteness(pos, iteration) == kNoError;
+
     return true;
 }
 
@@ -412,6 +496,7 @@ static bool Step4_1IterateTie(int initial_remoteness) {
             if (CheckpointSave(kIteratingTie, i) != kNoError) return false;
             prev_checkpoint = time(NULL);
         }
+        if (DbManagerReserveRemoteness(i) != kNoError) return false;
 
         ConcurrentBoolStore(&updated, false);
         PRAGMA_OMP_PARALLEL_FOR_SCHEDULE_DYNAMIC(256)
@@ -447,6 +532,7 @@ static bool Step4Iterate(int step, int remoteness) {
     // The child tiers are no longer needed.
     for (int64_t i = 0; i < child_tiers.size; ++i) {
         DbManagerUnloadTier(child_tiers.array[i]);
+        child_handles[i].tier = kIllegalTier;
     }
 
     return true;
@@ -501,41 +587,61 @@ static void Step6FlushDb(void) {
 
 // --------------------------------- CompareDb ---------------------------------
 
-static bool CompareDb(void) {
-    DbProbe probe, ref_probe;
-    if (DbManagerProbeInit(&probe)) return false;
-    if (DbManagerRefProbeInit(&ref_probe)) {
-        DbManagerProbeDestroy(&probe);
-        return false;
+// Compares the SIZE positions of the current tier starting from BEGIN between
+// the current and the reference databases in one batch.
+static bool CompareDbBatch(DbProbe *probe, DbProbe *ref_probe, Position begin,
+                           int64_t size) {
+    TierPosition tier_positions[kProbeBatchSize];
+    Value ref_values[kProbeBatchSize], actual_values[kProbeBatchSize];
+    int ref_remotenesses[kProbeBatchSize];
+    int actual_remotenesses[kProbeBatchSize];
+    for (int64_t i = 0; i < size; ++i) {
+        tier_positions[i].tier = this_tier;
+        tier_positions[i].position = begin + i;
     }
+    DbManagerRefProbeRecordsBatch(ref_probe, size, tier_positions, ref_values,
+                                  ref_remotenesses);
+    DbManagerProbeRecordsBatch(probe, size, tier_positions, actual_values,
+                               actual_remotenesses);
 
-    bool success = true;
-    for (Position p = 0; p < this_tier_size; ++p) {
-        TierPosition tp = {.tier = this_tier, .position = p};
-        Value ref_value = DbManagerRefProbeValue(&ref_probe, tp);
-        if (ref_value == kUndecided) continue;
+    for (int64_t i = 0; i < size; ++i) {
+        if (ref_values[i] == kUndecided) continue;
 
-        Value actual_value = DbManagerProbeValue(&probe, tp);
-        if (actual_value != ref_value) {
+        Position p = begin + i;
+        if (actual_values[i] != ref_values[i]) {
             printf("CompareDb: inconsistent value at tier %" PRITier
                    " position %" PRIPos "\n",
                    this_tier, p);
-            success = false;
-            goto _bailout;
+            return false;
         }
 
-        int actual_remoteness = DbManagerProbeRemoteness(&probe, tp);
-        int ref_remoteness = DbManagerRefProbeRemoteness(&ref_probe, tp);
-        if (actual_remoteness != ref_remoteness) {
+        if (actual_remotenesses[i] != ref_remotenesses[i]) {
             printf("CompareDb: inconsistent remoteness at tier %" PRITier
                    " position %" PRIPos "\n",
                    this_tier, p);
-            success = false;
-            goto _bailout;
+            return false;
         }
     }
 
-_bailout:
+    return true;
+}
+
+static bool CompareDb(void) {
+    DbProbe probe, ref_probe;
+    if (DbManagerProbeInit(&probe)) return false;
+    if (DbManagerRefProbeInit(&ref_probe)) {
+        DbManagerProbeDestroy(&probe);
+        return false;
+    }
+
+    bool success = true;
+    for (Position begin = 0; success && begin < this_tier_size;
+         begin += kProbeBatchSize) {
+        int64_t size = this_tier_size - begin;
+        if (size > kProbeBatchSize) size = kProbeBatchSize;
+        success = CompareDbBatch(&probe, &ref_probe, begin, size);
+    }
+
     DbManagerProbeDestroy(&probe);
     DbManagerRefProbeDestroy(&ref_probe);
     if (success) {
@@ -559,6 +665,8 @@ static bool Step7Cleanup(void) {
         if (DbManagerIsTierLoaded(child_tier)) DbManagerUnloadTier(child_tier);
     }
     TierArrayDestroy(&child_tiers);
+    free(child_handles);
+    child_handles = NULL;
     DbManagerFreeSolvingTier();
 
     return error == kNoError;
@@ -579,14 +687,21 @@ int TierWorkerSolveVIInternal(const TierSolverApi *api, Tier tier,
     }
 
     /* Value Iteration main algorithm. */
+    value_only = options->value_only;
     if (!Step0Initialize(api, tier, options->verbose)) goto _bailout;
     if (!Step1LoadChildren()) goto _bailout;
     CheckpointStatus ct = {.step = kNotStarted, .remoteness = -1};
     if (!Step2SetupSolvingTier(&ct)) goto _bailout;
 
     prev_checkpoint = time(NULL);  // Enable checkpoints from here.
-    if (ct.step <= kScanningTier) Step3ScanTier();
+    if (ct.step <= kScanningTier && !Step3ScanTier()) goto _bailout;
     if (ct.step <= kIteratingTie && !Step4Iterate(ct.step, ct.remoteness)) {
+        if (ConcurrentBoolLoad(&value_only_child_found)) {
+            fprintf(stderr,
+                    "TierWorkerSolveVIInternal: a child tier of tier %" PRITier
+                    " was solved for values only. Re-solve the game with -f\n",
+                    tier);
+        }
         goto _bailout;
     }
     if (!Step5MarkDrawPositions()) goto _bailout;
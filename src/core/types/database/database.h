@@ -32,10 +32,11 @@
 
 #include <stdbool.h>  // bool
 #include <stddef.h>   // size_t
-#include <stdint.h>   // int64_t, intptr_t
+#include <stdint.h>   // int8_t, int16_t, int64_t, intptr_t
 
 #include "core/types/base.h"
 #include "core/types/database/db_probe.h"
+#include "core/types/database/db_tier_handle.h"
 
 /** @brief Constants associated with the Database type. */
 enum DatabaseConstants {
@@ -63,6 +64,9 @@ enum DatabaseGameStatus {
 typedef int (*GetTierNameFunc)(Tier tier,
                                char name[static kDbFileNameLengthMax + 1]);
 
+/** @brief Summary of a solved tier, defined in core/db/db_tier_summary.h. */
+typedef struct DbTierSummary DbTierSummary;
+
 /**
  * @brief Generic Tier Database type.
  *
@@ -134,6 +138,43 @@ typedef struct Database {
      */
     int (*FreeSolvingTier)(void);
 
+    /**
+     * @brief Rewrites the stored DB of the solved TIER of SIZE positions in
+     * the storage format selected when the Database was initialized. Does
+     * nothing if TIER is already stored in that format.
+     * @note This function is optional. Set to NULL if the Database supports
+     * only one storage format.
+     * @note This function is part of the Solving API.
+     *
+     * @param tier Solved tier to convert.
+     * @param size Size of TIER in number of positions.
+     *
+     * @return \c kNoError on success, or
+     * @return non-zero error code otherwise.
+     */
+    int (*ConvertTier)(Tier tier, int64_t size);
+
+    /**
+     * @brief Builds the records of TIER of SIZE positions from the given
+     * arrays of VALUES and REMOTENESSES and writes them to permanent storage
+     * without going through the solving tier. Unlike the rest of the Solving
+     * API, this function keeps all of its state private and is therefore safe
+     * to call concurrently for distinct tiers.
+     * @note This function is optional. Set to NULL if tiers can only be
+     * written through the solving tier.
+     *
+     * @param tier Tier to write.
+     * @param size Size of TIER in number of positions.
+     * @param values Array of SIZE position values.
+     * @param remotenesses Array of SIZE non-negative position remotenesses.
+     *
+     * @return \c kNoError on success,
+     * @return \c kIllegalArgumentError if any remoteness is negative, or
+     * @return non-zero error code otherwise.
+     */
+    int (*WriteTier)(Tier tier, int64_t size, const int8_t *values,
+                     const int16_t *remotenesses);
+
     /**
      * @brief Sets the current game as solved.
      *
@@ -158,6 +199,17 @@ typedef struct Database {
      */
     int (*SetRemoteness)(Position position, int remoteness);
 
+    /**
+     * @brief Prepares the in-memory DB for storing remotenesses up to
+     * \p remoteness. Called outside of parallel regions before such
+     * remotenesses are set from multiple threads. May be set to NULL if the
+     * in-memory DB can always store all remotenesses.
+     * @note This function is part of the Solving API.
+     *
+     * @return 0 on success, non-zero error code otherwise.
+     */
+    int (*ReserveRemoteness)(int remoteness);
+
     /**
      * @brief Returns the value of the given \p position from in-memory DB.
      * @note This function is part of the Solving API.
@@ -235,6 +287,15 @@ typedef struct Database {
      */
     intptr_t (*TierMemUsage)(Tier tier, int64_t size);
 
+    /**
+     * @brief Returns the amount of memory in bytes actually used by the
+     * loaded \p tier of \p size positions, which may be much smaller than
+     * the estimate returned by \c TierMemUsage if the tier is kept compressed.
+     * @note This function is optional. Set to NULL if loaded tiers always use
+     * the amount of memory returned by \c TierMemUsage.
+     */
+    intptr_t (*LoadedTierMemUsage)(Tier tier, int64_t size);
+
     /**
      * @brief Loads the given \p tier of \p size positions into memory.
      * @param tier Tier to be loaded.
@@ -285,6 +346,24 @@ typedef struct Database {
      */
     int (*GetRemotenessFromLoaded)(Tier tier, Position position);
 
+    /**
+     * @brief Initializes \p handle for reading the loaded \p tier. The
+     * caller initializes \p handle->tier, \p handle->GetValue, and
+     * \p handle->GetRemoteness before calling this function, which sets
+     * \p handle->records and the associated layout fields if the records of
+     * \p tier are kept in a plain array, or sets \p handle->records to NULL
+     * otherwise. The handle remains valid until \p tier is unloaded.
+     * @note This function is optional. Set to NULL if loaded tiers can only
+     * be read through \c GetValueFromLoaded and \c GetRemotenessFromLoaded.
+     *
+     * @param tier A loaded tier.
+     * @param handle Handle to initialize.
+     *
+     * @return \c kNoError on success, or
+     * @return non-zero error code otherwise.
+     */
+    int (*GetLoadedTierHandle)(Tier tier, DbTierHandle *handle);
+
     // Probing API
 
     /**
@@ -331,6 +410,35 @@ typedef struct Database {
      */
     int (*ProbeRemoteness)(DbProbe *probe, TierPosition tier_position);
 
+    /**
+     * @brief Probes the values and, if REMOTENESSES is not NULL, the
+     * remotenesses of the SIZE tier positions in TIER_POSITIONS from permanent
+     * storage using PROBE, and stores them in VALUES and REMOTENESSES in the
+     * same order as TIER_POSITIONS.
+     * @details Implementations should group the tier positions by tier and by
+     * storage block so that each block is loaded and decoded at most once per
+     * batch, and read each record only once for both its value and its
+     * remoteness.
+     *
+     * @note This function is optional. If set to NULL, the Database Manager
+     * probes the tier positions sorted by tier and position using ProbeValue()
+     * and ProbeRemoteness().
+     *
+     * @param probe Database probe initialized using the ProbeInit() function.
+     * @param size Number of tier positions to probe.
+     * @param tier_positions Array of SIZE tier positions to probe.
+     * @param values (Output parameter) Array of SIZE values.
+     * @param remotenesses (Output parameter) Array of SIZE remotenesses, or
+     * NULL if only the values are needed.
+     *
+     * @return kNoError on success, or
+     * @return non-zero error code otherwise, in which case the results of the
+     * tier positions that failed are set to kErrorValue and kErrorRemoteness.
+     */
+    int (*ProbeRecordsBatch)(DbProbe *probe, int64_t size,
+                             const TierPosition *tier_positions, Value *values,
+                             int *remotenesses);
+
     /**
      * @brief Probes the current data path and returns the solving status of the
      * given TIER.
@@ -355,6 +463,19 @@ typedef struct Database {
      * status of the current game.
      */
     int (*GameStatus)(void);
+
+    /**
+     * @brief Reads the summary of the given solved \p tier of \p size
+     * positions, which was stored when the tier was flushed, into \p summary.
+     * @note This function is optional. Set to NULL if the Database does not
+     * store tier summaries.
+     *
+     * @return kNoError on success, or
+     * @return non-zero error code if no valid summary is stored for \p tier,
+     * in which case the caller should compute the statistics it needs from
+     * the records of \p tier instead.
+     */
+    int (*GetTierSummary)(Tier tier, int64_t size, DbTierSummary *summary);
 } Database;
 
 #endif  // GAMESMANONE_CORE_TYPES_DATABASE_DATABASE_H_
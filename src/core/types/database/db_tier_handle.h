@@ -0,0 +1,119 @@
+/**
+ * @file db_tier_handle.h
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Generic read-only handle to a tier loaded by a Database.
+ * @details A DbTierHandle is resolved once per loaded tier by the Database
+ * (see Database::GetLoadedTierHandle) so that solver workers may read records
+ * of the tier in their inner loops without looking up the tier by its ID on
+ * every access. If the Database keeps the records of the tier in a plain array,
+ * the inline accessors defined here read the array directly; otherwise, they
+ * fall back to the loading API of the Database.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAMESMANONE_CORE_TYPES_DATABASE_DB_TIER_HANDLE_H_
+#define GAMESMANONE_CORE_TYPES_DATABASE_DB_TIER_HANDLE_H_
+
+#include <stdint.h>  // uint8_t, uint16_t
+
+#include "core/types/base.h"
+
+/**
+ * @brief Read-only handle to a loaded tier. A handle stays valid until the
+ * tier is unloaded.
+ *
+ * @details If \c records is not NULL, the record of position \c p is the
+ * unsigned integer of \c record_size bytes at index \c p of \c records, whose
+ * bits above the lowest \c value_shift bits hold the value and whose bits in
+ * \c remoteness_mask hold the remoteness.
+ */
+typedef struct DbTierHandle {
+    Tier tier; /**< The loaded tier. */
+
+    /** Plain array of records of the tier, or NULL if the records must be read
+     * through \c GetValue and \c GetRemoteness. */
+    const void *records;
+    int record_size;     /**< Size of each record in bytes, 1 or 2. */
+    int value_shift;     /**< Position of the lowest value bit. */
+    int remoteness_mask; /**< Mask of the remoteness bits. */
+
+    /** Loading interface of the database, used if \c records is NULL. */
+    Value (*GetValue)(Tier tier, Position position);
+
+    /** Loading interface of the database, used if \c records is NULL. */
+    int (*GetRemoteness)(Tier tier, Position position);
+} DbTierHandle;
+
+/**
+ * @brief Returns the raw record of \p position from the plain record array of
+ * \p handle, which must not be NULL.
+ */
+static inline unsigned DbTierHandleGetRecord(const DbTierHandle *handle,
+                                             Position position) {
+    if (handle->record_size == 2) {
+        return ((const uint16_t *)handle->records)[position];
+    }
+
+    return ((const uint8_t *)handle->records)[position];
+}
+
+/** @brief Returns the value of \p position in the tier of \p handle. */
+static inline Value DbTierHandleGetValue(const DbTierHandle *handle,
+                                         Position position) {
+    if (handle->records == NULL) {
+        return handle->GetValue(handle->tier, position);
+    }
+
+    return (Value)(DbTierHandleGetRecord(handle, position) >>
+                   handle->value_shift);
+}
+
+/** @brief Returns the remoteness of \p position in the tier of \p handle. */
+static inline int DbTierHandleGetRemoteness(const DbTierHandle *handle,
+                                            Position position) {
+    if (handle->records == NULL) {
+        return handle->GetRemoteness(handle->tier, position);
+    }
+
+    return (int)(DbTierHandleGetRecord(handle, position) &
+                 (unsigned)handle->remoteness_mask);
+}
+
+/**
+ * @brief Stores both the value and the remoteness of \p position in the tier
+ * of \p handle into \p value and \p remoteness, reading the record only once.
+ */
+static inline void DbTierHandleGetRecordFields(const DbTierHandle *handle,
+                                               Position position, Value *value,
+                                               int *remoteness) {
+    if (handle->records == NULL) {
+        *value = handle->GetValue(handle->tier, position);
+        *remoteness = handle->GetRemoteness(handle->tier, position);
+        return;
+    }
+
+    unsigned record = DbTierHandleGetRecord(handle, position);
+    *value = (Value)(record >> handle->value_shift);
+    *remoteness = (int)(record & (unsigned)handle->remoteness_mask);
+}
+
+#endif  // GAMESMANONE_CORE_TYPES_DATABASE_DB_TIER_HANDLE_H_
@@ -154,6 +154,27 @@ typedef struct Solver {
      * @return Remoteness of TIER_POSITION.
      */
     int (*GetRemoteness)(TierPosition tier_position);
+
+    /**
+     * @brief Probes the values and, if REMOTENESSES is not NULL, the
+     * remotenesses of the SIZE tier positions in TIER_POSITIONS, and stores
+     * them in VALUES and REMOTENESSES in the same order as TIER_POSITIONS.
+     * Results in undefined behavior if any of the tier positions has not been
+     * solved, or is invalid or unreachable.
+     *
+     * @note This function is optional. If set to NULL, GetValue() and
+     * GetRemoteness() are called on each tier position instead.
+     *
+     * @param size Number of tier positions to probe.
+     * @param tier_positions Array of SIZE tier positions to probe.
+     * @param values (Output parameter) Array of SIZE values.
+     * @param remotenesses (Output parameter) Array of SIZE remotenesses, or
+     * NULL if only the values are needed.
+     *
+     * @return 0 on success, non-zero error code otherwise.
+     */
+    int (*GetRecordsBatch)(int64_t size, const TierPosition *tier_positions,
+                           Value *values, int *remotenesses);
 } Solver;
 
 #endif  // GAMESMANONE_CORE_TYPES_SOLVER_SOLVER_H_
@@ -26,11 +26,29 @@
 
 #include "lz4_utils.h"
 
-#include <lz4frame.h>  // LZ4F_*
-#include <stddef.h>    // size_t, NULL
-#include <stdint.h>    // int64_t
-#include <stdio.h>     // FILE, fopen, fread, fclose
-#include <stdlib.h>    // malloc, free
+#include <errno.h>      // errno, EINTR
+#include <lz4frame.h>   // LZ4F_*
+#include <stdbool.h>    // bool, true, false
+#include <stddef.h>     // size_t, NULL
+#include <stdint.h>     // int64_t, uint32_t, UINT32_MAX
+#include <stdio.h>      // FILE, fopen, fread, fclose
+#include <stdlib.h>     // malloc, calloc, free
+#include <string.h>     // memcmp, memcpy
+#include <sys/types.h>  // ssize_t, off_t
+#include <unistd.h>     // pread
+
+// Include and use OpenMP if the _OPENMP flag is set.
+#ifdef _OPENMP
+#include <omp.h>
+#define PRAGMA(X) _Pragma(#X)
+#define PRAGMA_OMP_PARALLEL_FOR_NUM_THREADS_REDUCTION(k, op, var) \
+    PRAGMA(omp parallel for num_threads(k) reduction(op : var))
+
+// Otherwise, the following macros do nothing.
+#else
+#define PRAGMA
+#define PRAGMA_OMP_PARALLEL_FOR_NUM_THREADS_REDUCTION(k, op, var)
+#endif  // _OPENMP
 
 // ================================= Constants =================================
 
@@ -47,6 +65,31 @@ static const LZ4F_preferences_t kLz4PreferencesTemplate = {
     {0, 0, 0}, /* reserved, must be set to 0 */
 };
 
+const int64_t kLz4UtilsParallelBlockSize = 256 << 10;  // 256 KiB.
+
+// Number of blocks compressed by each thread before the compressed blocks are
+// written to the output file. Bounds the size of the compression buffer.
+enum { kBlocksPerThreadPerBatch = 4 };
+
+// Size of the magic number and the frame size field of an LZ4 skippable frame.
+enum { kSkippableFrameHeaderSize = 8 };
+
+// Identifies the skippable frame that holds the block index of a container
+// created by Lz4UtilsParallelCompressStreams.
+static const char kParallelTag[8] = {'L', 'Z', '4', 'U', 'P', '\0', '\0', '1'};
+
+// ================================== Types ===================================
+
+// Contents of the skippable frame at the beginning of a parallel container,
+// followed by num_blocks + 1 file offsets. The i-th offset is the file offset
+// of the LZ4 frame of block i, and the last offset is the size of the file.
+typedef struct {
+    char tag[8];
+    int64_t block_size;
+    int64_t uncompressed_size;
+    int64_t num_blocks;
+} ParallelIndexHeader;
+
 // ========================== Common Helper Functions ==========================
 
 static void *GenericPointerShift(const void *p, size_t n) {
@@ -60,6 +103,24 @@ static int64_t GenericPointerDiff(const void *p1, const void *p2) {
 
 static size_t SizeMin(size_t a, size_t b) { return a < b ? a : b; }
 
+static int64_t Int64Min(int64_t a, int64_t b) { return a < b ? a : b; }
+
+static int GetNumThreads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else   // _OPENMP not defined
+    return 1;
+#endif  // _OPENMP
+}
+
+static int GetThreadId(void) {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else   // _OPENMP not defined, thread 0 is the only available thread.
+    return 0;
+#endif  // _OPENMP
+}
+
 /**
  * @brief Same as LZ4F_isError except a message explaining the error is printed
  * if \p code is an error.
@@ -173,6 +234,272 @@ int64_t Lz4UtilsCompressStream(const void *in, size_t in_size, int level,
     return Lz4UtilsCompressStreams(inputs, input_sizes, 1, level, ofname);
 }
 
+// ========================= Parallel Container Helpers ========================
+
+static void StoreLe32(void *dest, uint32_t x) {
+    unsigned char *bytes = (unsigned char *)dest;
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = (unsigned char)(x >> (8 * i));
+    }
+}
+
+static uint32_t LoadLe32(const void *src) {
+    const unsigned char *bytes = (const unsigned char *)src;
+    uint32_t ret = 0;
+    for (int i = 0; i < 4; ++i) {
+        ret |= (uint32_t)bytes[i] << (8 * i);
+    }
+
+    return ret;
+}
+
+static int64_t GetNumBlocks(int64_t size, int64_t block_size) {
+    return (size + block_size - 1) / block_size;
+}
+
+static int64_t GetBlockSize(const ParallelIndexHeader *header, int64_t i) {
+    return Int64Min(header->block_size,
+                    header->uncompressed_size - i * header->block_size);
+}
+
+// Returns the size of the index stored in the skippable frame of a parallel
+// container with NUM_BLOCKS blocks.
+static int64_t GetIndexSize(int64_t num_blocks) {
+    return (int64_t)sizeof(ParallelIndexHeader) +
+           (num_blocks + 1) * (int64_t)sizeof(int64_t);
+}
+
+// Returns a newly allocated array of N + 1 offsets, where the i-th offset is
+// the offset of the i-th stream in the concatenation of all streams, or NULL on
+// malloc failure.
+static int64_t *GetStreamStarts(const size_t *sizes, int n) {
+    int64_t *starts = (int64_t *)malloc((n + 1) * sizeof(int64_t));
+    if (starts == NULL) return NULL;
+
+    starts[0] = 0;
+    for (int i = 0; i < n; ++i) {
+        starts[i + 1] = starts[i] + (int64_t)sizes[i];
+    }
+
+    return starts;
+}
+
+// Returns the index of the stream that contains the byte at OFFSET of the
+// concatenation of N streams, which must be in range [0, STARTS[N]).
+static int FindStream(const int64_t *starts, int n, int64_t offset) {
+    // Invariant: starts[lo] <= offset < starts[hi].
+    int lo = 0, hi = n;
+    while (hi - lo > 1) {
+        int mid = lo + (hi - lo) / 2;
+        if (starts[mid] <= offset) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+// Returns a pointer to the SIZE bytes at OFFSET of the concatenation of N
+// streams STREAMS if they belong to the same stream, or NULL otherwise.
+static void *GetContiguousRange(const void *const *streams,
+                                const int64_t *starts, int n, int64_t offset,
+                                int64_t size) {
+    int i = FindStream(starts, n, offset);
+    if (starts[i + 1] < offset + size) return NULL;
+
+    return GenericPointerShift(streams[i], offset - starts[i]);
+}
+
+// Copies the SIZE bytes at OFFSET of the concatenation of N streams IN into
+// DEST.
+static void GatherStreams(void *dest, const void *const *in,
+                          const int64_t *starts, int n, int64_t offset,
+                          int64_t size) {
+    for (int i = FindStream(starts, n, offset); size > 0; ++i) {
+        int64_t count = Int64Min(starts[i + 1] - offset, size);
+        memcpy(dest, GenericPointerShift(in[i], offset - starts[i]), count);
+        dest = GenericPointerShift(dest, count);
+        offset += count;
+        size -= count;
+    }
+}
+
+// Copies SIZE bytes of SRC into the concatenation of N streams OUT starting at
+// OFFSET.
+static void ScatterStreams(void *const *out, const int64_t *starts, int n,
+                           int64_t offset, const void *src, int64_t size) {
+    for (int i = FindStream(starts, n, offset); size > 0; ++i) {
+        int64_t count = Int64Min(starts[i + 1] - offset, size);
+        memcpy(GenericPointerShift(out[i], offset - starts[i]), src, count);
+        src = GenericPointerShift(src, count);
+        offset += count;
+        size -= count;
+    }
+}
+
+// ====================== Lz4UtilsParallelCompressStreams ======================
+
+// Compresses block BLOCK of the concatenation of N streams IN into DEST of
+// capacity DEST_CAPACITY as a standalone LZ4 frame, and returns the size of the
+// frame or -1 on failure. STAGING must have space for one block and is used
+// only if the block spans multiple input streams.
+static int64_t CompressBlock(const ParallelIndexHeader *header, int64_t block,
+                             const void *const *in, const int64_t *starts,
+                             int n, const LZ4F_preferences_t *pref,
+                             void *staging, void *dest, size_t dest_capacity) {
+    int64_t offset = block * header->block_size;
+    int64_t size = GetBlockSize(header, block);
+    const void *src = GetContiguousRange(in, starts, n, offset, size);
+    if (src == NULL) {
+        GatherStreams(staging, in, starts, n, offset, size);
+        src = staging;
+    }
+
+    LZ4F_preferences_t block_pref = *pref;
+    block_pref.frameInfo.contentSize = (unsigned long long)size;
+    size_t frame_size =
+        LZ4F_compressFrame(dest, dest_capacity, src, size, &block_pref);
+    if (Lz4fIsErrorExplained(frame_size)) return -1;
+
+    return (int64_t)frame_size;
+}
+
+static int64_t ParallelCompressStreamsInternal(
+    const void *const *in, const int64_t *starts, int n,
+    const LZ4F_preferences_t *pref, FILE *f_out, ParallelIndexHeader *header,
+    int64_t *offsets, void *batch, size_t capacity, int64_t *batch_sizes,
+    int64_t batch_blocks, int num_threads, void *staging) {
+    // Leave space for the skippable frame that holds the block index, which is
+    // written once all blocks are compressed.
+    int64_t index_size = GetIndexSize(header->num_blocks);
+    int64_t pos = kSkippableFrameHeaderSize + index_size;
+    if (fseek(f_out, pos, SEEK_SET) != 0) return -3;
+
+    for (int64_t first = 0; first < header->num_blocks; first += batch_blocks) {
+        int64_t count = Int64Min(batch_blocks, header->num_blocks - first);
+        bool failed = false;
+
+        PRAGMA_OMP_PARALLEL_FOR_NUM_THREADS_REDUCTION(num_threads, ||, failed)
+        for (int64_t i = 0; i < count; ++i) {
+            void *thread_staging = NULL;
+            if (staging != NULL) {
+                thread_staging = GenericPointerShift(
+                    staging, (int64_t)GetThreadId() * header->block_size);
+            }
+            batch_sizes[i] = CompressBlock(
+                header, first + i, in, starts, n, pref, thread_staging,
+                GenericPointerShift(batch, i * capacity), capacity);
+            if (batch_sizes[i] < 0) failed = true;
+        }
+        if (failed) return -2;
+
+        for (int64_t i = 0; i < count; ++i) {
+            offsets[first + i] = pos;
+            size_t written = fwrite(GenericPointerShift(batch, i * capacity), 1,
+                                    batch_sizes[i], f_out);
+            if (written != (size_t)batch_sizes[i]) return -3;
+            pos += batch_sizes[i];
+        }
+    }
+    offsets[header->num_blocks] = pos;
+
+    unsigned char frame_header[kSkippableFrameHeaderSize];
+    StoreLe32(frame_header, LZ4F_MAGIC_SKIPPABLE_START);
+    StoreLe32(frame_header + 4, (uint32_t)index_size);
+    if (fseek(f_out, 0, SEEK_SET) != 0) return -3;
+    if (fwrite(frame_header, sizeof(frame_header), 1, f_out) != 1) return -3;
+    if (fwrite(header, sizeof(*header), 1, f_out) != 1) return -3;
+    if (fwrite(offsets, sizeof(int64_t), header->num_blocks + 1, f_out) !=
+        (size_t)(header->num_blocks + 1)) {
+        return -3;
+    }
+
+    return pos;
+}
+
+static int64_t ParallelCompressStreams(const void *const *in,
+                                       const size_t *in_sizes, int n,
+                                       int level, FILE *f_out) {
+    int64_t *starts = GetStreamStarts(in_sizes, n);
+    if (starts == NULL) return -2;
+
+    ParallelIndexHeader header = {
+        .block_size = kLz4UtilsParallelBlockSize,
+        .uncompressed_size = starts[n],
+        .num_blocks = GetNumBlocks(starts[n], kLz4UtilsParallelBlockSize),
+    };
+    memcpy(header.tag, kParallelTag, sizeof(kParallelTag));
+    if (GetIndexSize(header.num_blocks) > UINT32_MAX) {
+        free(starts);
+        return -2;
+    }
+
+    int num_threads = GetNumThreads();
+    int64_t batch_blocks = Int64Min(
+        (int64_t)num_threads * kBlocksPerThreadPerBatch, header.num_blocks);
+    if (batch_blocks < 1) batch_blocks = 1;
+    LZ4F_preferences_t preferences = kLz4PreferencesTemplate;
+    preferences.compressionLevel = level;
+    const size_t capacity =
+        LZ4F_compressFrameBound(header.block_size, &preferences);
+
+    int64_t *offsets =
+        (int64_t *)malloc((header.num_blocks + 1) * sizeof(int64_t));
+    void *batch = malloc(batch_blocks * capacity);
+    int64_t *batch_sizes = (int64_t *)malloc(batch_blocks * sizeof(int64_t));
+    // Blocks that span multiple streams are gathered into a staging buffer.
+    void *staging = NULL;
+    if (n > 1) staging = malloc(num_threads * header.block_size);
+    int64_t ret = -2;
+    if (offsets == NULL || batch == NULL || batch_sizes == NULL ||
+        (n > 1 && staging == NULL)) {
+        goto _bailout;
+    }
+
+    ret = ParallelCompressStreamsInternal(
+        in, starts, n, &preferences, f_out, &header, offsets, batch, capacity,
+        batch_sizes, batch_blocks, num_threads, staging);
+
+_bailout:
+    free(starts);
+    free(offsets);
+    free(batch);
+    free(batch_sizes);
+    free(staging);
+    return ret;
+}
+
+int64_t Lz4UtilsParallelCompressStreams(const void *const *in,
+                                        const size_t *in_sizes, int n,
+                                        int level, const char *ofname) {
+    if (n < 0 || (n > 0 && (in == NULL || in_sizes == NULL))) return -1;
+    for (int i = 0; i < n; ++i) {
+        if (in_sizes[i] > 0 && in[i] == NULL) return -1;
+    }
+
+    if (ofname == NULL) return -3;
+    FILE *const f_out = fopen(ofname, "wb");
+    if (f_out == NULL) return -3;
+
+    int64_t ret = ParallelCompressStreams(in, in_sizes, n, level, f_out);
+    if (fclose(f_out) != 0 && ret >= 0) ret = -3;
+
+    return ret;
+}
+
+// ====================== Lz4UtilsParallelCompressStream ======================
+
+int64_t Lz4UtilsParallelCompressStream(const void *in, size_t in_size,
+                                       int level, const char *ofname) {
+    const void *inputs[] = {in};
+    const size_t input_sizes[] = {in_size};
+
+    return Lz4UtilsParallelCompressStreams(inputs, input_sizes, 1, level,
+                                           ofname);
+}
+
 // =========================== Lz4UtilsCompressFile ===========================
 
 static int64_t CompressFileInternal(FILE *f_in, FILE *f_out, LZ4F_cctx *ctx,
@@ -331,6 +658,203 @@ static int64_t DecompressFileMultistream(FILE *f_in, void **out,
     return result;
 }
 
+// Reads exactly SIZE bytes at OFFSET of FD into BUF without moving the file
+// offset.
+static bool PreadFull(int fd, void *buf, int64_t size, int64_t offset) {
+    while (size > 0) {
+        ssize_t n = pread(fd, buf, (size_t)size, (off_t)offset);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        buf = GenericPointerShift(buf, n);
+        size -= n;
+        offset += n;
+    }
+
+    return true;
+}
+
+static bool IsValidParallelIndex(const ParallelIndexHeader *header,
+                                 const int64_t *offsets, int64_t file_size) {
+    int64_t index_end =
+        kSkippableFrameHeaderSize + GetIndexSize(header->num_blocks);
+    if (offsets[0] != index_end) return false;
+    if (offsets[header->num_blocks] != file_size) return false;
+    for (int64_t i = 0; i < header->num_blocks; ++i) {
+        if (offsets[i + 1] <= offsets[i]) return false;
+    }
+
+    return true;
+}
+
+// Reads the block index of F_IN into HEADER and *OFFSETS if F_IN is a parallel
+// container. Returns 1 if F_IN is a parallel container, 0 if it is not (F_IN is
+// then rewound to the beginning of the file), -2 on malloc failure, or -3 if
+// the index is corrupt.
+static int ReadParallelIndex(FILE *f_in, ParallelIndexHeader *header,
+                             int64_t **offsets) {
+    unsigned char frame_header[kSkippableFrameHeaderSize];
+    if (fread(frame_header, sizeof(frame_header), 1, f_in) != 1 ||
+        LoadLe32(frame_header) != LZ4F_MAGIC_SKIPPABLE_START ||
+        fread(header, sizeof(*header), 1, f_in) != 1 ||
+        memcmp(header->tag, kParallelTag, sizeof(kParallelTag)) != 0) {
+        rewind(f_in);
+        return 0;
+    }
+
+    if (header->block_size <= 0 || header->uncompressed_size < 0 ||
+        header->num_blocks !=
+            GetNumBlocks(header->uncompressed_size, header->block_size) ||
+        LoadLe32(frame_header + 4) != GetIndexSize(header->num_blocks)) {
+        return -3;
+    }
+
+    *offsets = (int64_t *)malloc((header->num_blocks + 1) * sizeof(int64_t));
+    if (*offsets == NULL) return -2;
+    if (fread(*offsets, sizeof(int64_t), header->num_blocks + 1, f_in) !=
+            (size_t)(header->num_blocks + 1) ||
+        fseek(f_in, 0, SEEK_END) != 0 ||
+        !IsValidParallelIndex(header, *offsets, ftell(f_in))) {
+        free(*offsets);
+        *offsets = NULL;
+        return -3;
+    }
+
+    return 1;
+}
+
+// Decompresses the LZ4 frame of SRC_SIZE bytes at SRC into DEST, which must
+// hold exactly DEST_SIZE bytes of uncompressed data. Returns 0 on success or
+// -4 on failure.
+static int DecompressFrame(LZ4F_dctx *dctx, void *dest, int64_t dest_size,
+                           const void *src, int64_t src_size) {
+    int64_t produced = 0, consumed = 0;
+    size_t lz4f_code = 1;
+    while (lz4f_code != 0) {
+        size_t dest_buffer_size = dest_size - produced;
+        size_t src_buffer_size = src_size - consumed;
+        lz4f_code = LZ4F_decompress(dctx, GenericPointerShift(dest, produced),
+                                    &dest_buffer_size,
+                                    GenericPointerShift(src, consumed),
+                                    &src_buffer_size, NULL);
+        if (Lz4fIsErrorExplained(lz4f_code)) break;
+        if (lz4f_code != 0 && dest_buffer_size == 0 && src_buffer_size == 0) {
+            break;  // Truncated frame.
+        }
+        produced += (int64_t)dest_buffer_size;
+        consumed += (int64_t)src_buffer_size;
+    }
+
+    if (lz4f_code != 0 || produced != dest_size || consumed != src_size) {
+        LZ4F_resetDecompressionContext(dctx);
+        return -4;
+    }
+
+    return 0;
+}
+
+// Decompresses block BLOCK of the parallel container FD into the concatenation
+// of N streams OUT. SRC must have space for the compressed block, and STAGING
+// must have space for one uncompressed block and is used only if the block
+// spans multiple output streams.
+static int DecompressBlock(int fd, const ParallelIndexHeader *header,
+                           const int64_t *offsets, int64_t block,
+                           void *const *out, const int64_t *starts, int n,
+                           LZ4F_dctx *dctx, void *src, void *staging) {
+    int64_t compressed_size = offsets[block + 1] - offsets[block];
+    if (!PreadFull(fd, src, compressed_size, offsets[block])) return -3;
+
+    int64_t offset = block * header->block_size;
+    int64_t size = GetBlockSize(header, block);
+    void *dest = GetContiguousRange((const void *const *)out, starts, n, offset,
+                                    size);
+    int error = DecompressFrame(dctx, dest ? dest : staging, size, src,
+                                compressed_size);
+    if (error != 0) return error;
+    if (dest == NULL) ScatterStreams(out, starts, n, offset, staging, size);
+
+    return 0;
+}
+
+static int64_t ParallelDecompressInternal(int fd,
+                                          const ParallelIndexHeader *header,
+                                          const int64_t *offsets,
+                                          void *const *out,
+                                          const int64_t *starts, int n,
+                                          LZ4F_dctx **dctxs, int num_threads,
+                                          void *src, int64_t src_capacity,
+                                          void *staging) {
+    // All error codes are negative. Keep the smallest one so that the result
+    // does not depend on the order in which the threads fail.
+    int ret = 0;
+    PRAGMA_OMP_PARALLEL_FOR_NUM_THREADS_REDUCTION(num_threads, min, ret)
+    for (int64_t i = 0; i < header->num_blocks; ++i) {
+        int64_t tid = GetThreadId();
+        void *thread_staging = NULL;
+        if (staging != NULL) {
+            thread_staging =
+                GenericPointerShift(staging, tid * header->block_size);
+        }
+        int error = DecompressBlock(
+            fd, header, offsets, i, out, starts, n, dctxs[tid],
+            GenericPointerShift(src, tid * src_capacity), thread_staging);
+        if (error < ret) ret = error;
+    }
+    if (ret != 0) return ret;
+
+    return header->uncompressed_size;
+}
+
+static int64_t ParallelDecompress(FILE *f_in, const ParallelIndexHeader *header,
+                                  const int64_t *offsets, void *const *out,
+                                  const size_t *out_sizes, int n) {
+    int64_t *starts = GetStreamStarts(out_sizes, n);
+    if (starts == NULL) return -2;
+    if (header->uncompressed_size > starts[n]) {
+        free(starts);
+        return -4;
+    }
+
+    int64_t src_capacity = 0;
+    for (int64_t i = 0; i < header->num_blocks; ++i) {
+        int64_t compressed_size = offsets[i + 1] - offsets[i];
+        if (compressed_size > src_capacity) src_capacity = compressed_size;
+    }
+
+    int num_threads = GetNumThreads();
+    LZ4F_dctx **dctxs = (LZ4F_dctx **)calloc(num_threads, sizeof(LZ4F_dctx *));
+    void *src = malloc(num_threads * src_capacity);
+    void *staging = NULL;
+    if (n > 1) staging = malloc(num_threads * header->block_size);
+    int64_t ret = -2;
+    if (dctxs == NULL || (src == NULL && src_capacity > 0) ||
+        (n > 1 && staging == NULL)) {
+        goto _bailout;
+    }
+    for (int i = 0; i < num_threads; ++i) {
+        size_t const dctx_status =
+            LZ4F_createDecompressionContext(&dctxs[i], LZ4F_VERSION);
+        if (Lz4fIsErrorExplained(dctx_status)) goto _bailout;
+    }
+
+    ret = ParallelDecompressInternal(fileno(f_in), header, offsets, out, starts,
+                                     n, dctxs, num_threads, src, src_capacity,
+                                     staging);
+
+_bailout:
+    if (dctxs != NULL) {
+        for (int i = 0; i < num_threads; ++i) {
+            LZ4F_freeDecompressionContext(dctxs[i]); /* supports free on NULL */
+        }
+    }
+    free(dctxs);
+    free(src);
+    free(staging);
+    free(starts);
+    return ret;
+}
+
 int64_t Lz4UtilsDecompressFileMultistream(const char *ifname, void **out,
                                           const size_t *out_sizes, int n) {
     if (n > 0 && (out == NULL || out_sizes == NULL)) return -4;
@@ -342,7 +866,17 @@ int64_t Lz4UtilsDecompressFileMultistream(const char *ifname, void **out,
     FILE *const f_in = fopen(ifname, "rb");
     if (f_in == NULL) return -1;
 
-    const int64_t ret = DecompressFileMultistream(f_in, out, out_sizes, n);
+    // Files created by Lz4UtilsParallelCompressStreams are decompressed in
+    // parallel. Otherwise, the file is assumed to contain a single LZ4 frame.
+    ParallelIndexHeader header;
+    int64_t *offsets = NULL;
+    int64_t ret = ReadParallelIndex(f_in, &header, &offsets);
+    if (ret == 1) {
+        ret = ParallelDecompress(f_in, &header, offsets, out, out_sizes, n);
+    } else if (ret == 0) {
+        ret = DecompressFileMultistream(f_in, out, out_sizes, n);
+    }
+    free(offsets);
     fclose(f_in);
 
     return ret;
@@ -30,6 +30,10 @@
 #include <stddef.h>  // size_t
 #include <stdint.h>  // int64_t
 
+/** @brief Uncompressed size of each independently compressed block in files
+ * created by \c Lz4UtilsParallelCompressStreams. */
+extern const int64_t kLz4UtilsParallelBlockSize;
+
 /**
  * @brief Concatenates and compresses \p n input streams using level \p level
  * LZ4 frame compression, stores the compressed result as file of name \p
@@ -69,6 +73,52 @@ int64_t Lz4UtilsCompressStreams(const void *const *in, const size_t *in_sizes,
 int64_t Lz4UtilsCompressStream(const void *in, size_t in_size, int level,
                                const char *ofname);
 
+/**
+ * @brief Same as \c Lz4UtilsCompressStreams, except that the concatenated input
+ * is split into blocks of \c kLz4UtilsParallelBlockSize bytes that are
+ * compressed independently on all available OpenMP threads.
+ *
+ * @details The output file is a sequence of LZ4 frames, one per block,
+ * preceded by an LZ4 skippable frame that holds the uncompressed size of the
+ * data and the file offset of each block. The file therefore remains readable
+ * by the standard \c lz4 command line tool, while the index allows
+ * \c Lz4UtilsDecompressFileMultistream and \c Lz4UtilsDecompressFile to
+ * decompress all blocks in parallel and any block to be located without
+ * decoding the ones before it.
+ *
+ * @param in Array of \p n input buffers.
+ * @param in_sizes Array of \p n sizes, where in_sizes[i] is the size of the
+ * i-th input buffer.
+ * @param n Number of input buffers in total.
+ * @param level LZ4 compression level.
+ * @param ofname Output file name.
+ * @return Size of the compressed file on success,
+ * @return -1 if either \p in or \p in_sizes is \c NULL but \p n is non-zero OR
+ * if in[i] is NULL but in_sizes[i] is non-NULL for any i in range [0, n);
+ * @return -2 if failed to allocate memory for compression; or
+ * @return -3 if failed to create or write to the output file.
+ */
+int64_t Lz4UtilsParallelCompressStreams(const void *const *in,
+                                        const size_t *in_sizes, int n,
+                                        int level, const char *ofname);
+
+/**
+ * @brief Same as \c Lz4UtilsCompressStream, except that the input is
+ * compressed in parallel into an indexed container. See
+ * \c Lz4UtilsParallelCompressStreams for details.
+ *
+ * @param in Input buffer.
+ * @param in_size Size of the input buffer.
+ * @param level LZ4 compression level.
+ * @param ofname Output file name.
+ * @return Size of the compressed file on success,
+ * @return -1 if \p in is \c NULL but \p in_size is non-zero,
+ * @return -2 if failed to allocate memory for compression, or
+ * @return -3 if failed to create or write to the output file.
+ */
+int64_t Lz4UtilsParallelCompressStream(const void *in, size_t in_size,
+                                       int level, const char *ofname);
+
 /**
  * @brief Compresses the input file of name \p ifname using level \p level LZ4
  * frame compression, stores the compressed stream as file of name \p ofname,
@@ -86,25 +136,10 @@ int64_t Lz4UtilsCompressFile(const char *ifname, int level, const char *ofname);
 
 /**
  * @brief Decompresses the input file of name \p ifname, which is assumed to
- * contain exactly one LZ4 frame, and stores the uncompresses data in \p out of
- * size \p out_size.
- *
- * @param ifname Input compressed file name.
- * @param out (Output parameter) output buffer.
- * @param out_size Size of the output buffer.
- * @return Number of bytes of uncompressed data written to \p out;
- * @return -1 if failed to open input file;
- * @return -2 if failed to allocate memory;
- * @return -3 if input file is corrupt or an error occurred when reading the
- * input file;
- * @return -4 if failed to decompress due to, for example, not enough output
- * buffer capacity.
- */
-
-/**
- * @brief Decompresses the input file of name \p ifname, which is assumed to
- * contain exactly one LZ4 frame compressed from \p n input buffers of sizes
- * specified by \p out_sizes, and stores the uncompresses streams in \p out.
+ * contain either exactly one LZ4 frame or an indexed container created by
+ * \c Lz4UtilsParallelCompressStreams compressed from \p n input buffers of
+ * sizes specified by \p out_sizes, and stores the uncompresses streams in
+ * \p out. Indexed containers are decompressed in parallel.
  *
  * @param ifname Input compressed file name.
  * @param out (Output parameter) array of output buffers.
@@ -125,8 +160,9 @@ int64_t Lz4UtilsDecompressFileMultistream(const char *ifname, void **out,
 
 /**
  * @brief Decompresses the input file of name \p ifname, which is assumed to
- * contain exactly one LZ4 frame, and stores the uncompresses data in \p out of
- * size \p out_size.
+ * contain either exactly one LZ4 frame or an indexed container created by
+ * \c Lz4UtilsParallelCompressStream, and stores the uncompresses data in
+ * \p out of size \p out_size.
  *
  * @param ifname Input compressed file name.
  * @param out (Output parameter) output buffer.
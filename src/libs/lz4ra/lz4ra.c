@@ -0,0 +1,376 @@
+/**
+ * @file lz4ra.c
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief Implementation of LZ4 block-indexed files with random access.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "libs/lz4ra/lz4ra.h"
+
+#include <errno.h>      // errno, ENOENT, EINTR
+#include <fcntl.h>      // open, O_RDONLY
+#include <lz4.h>        // LZ4_compress_fast, LZ4_decompress_safe
+#include <lz4hc.h>      // LZ4_compress_HC, LZ4HC_CLEVEL_MIN
+#include <stdbool.h>    // bool, true, false
+#include <stddef.h>     // size_t, NULL
+#include <stdint.h>     // int64_t
+#include <stdio.h>      // FILE, fopen, fwrite, fseek, fclose, fprintf
+#include <stdlib.h>     // malloc, calloc, free
+#include <string.h>     // memcmp, memcpy
+#include <sys/types.h>  // ssize_t, off_t
+#include <unistd.h>     // pread, close
+
+// Include and use OpenMP if the _OPENMP flag is set.
+#ifdef _OPENMP
+#include <omp.h>
+#define PRAGMA(X) _Pragma(#X)
+#define PRAGMA_OMP_PARALLEL_FOR_NUM_THREADS_REDUCTION(k, op, var) \
+    PRAGMA(omp parallel for num_threads(k) reduction(op : var))
+
+// Otherwise, the following macros do nothing.
+#else
+#define PRAGMA
+#define PRAGMA_OMP_PARALLEL_FOR_NUM_THREADS_REDUCTION(k, op, var)
+#endif  // _OPENMP
+
+// ================================= Constants =================================
+
+const int64_t kLz4raDefaultBlockSize = 64 << 10;  // 64 KiB.
+
+static const char kMagic[8] = {'L', 'Z', '4', 'R', 'A', '\0', '\0', '1'};
+
+// Number of blocks compressed by each thread before the compressed blocks are
+// written to the output file. Bounds the size of the compression buffer.
+enum { kBlocksPerThreadPerBatch = 16 };
+
+// ================================== Types ===================================
+
+typedef struct {
+    char magic[8];
+    int64_t block_size;
+    int64_t uncompressed_size;
+    int64_t num_blocks;
+} Lz4raHeader;
+
+struct Lz4raFile {
+    int fd;
+    Lz4raHeader header;
+    int64_t *offsets;  // File offsets of the blocks, num_blocks + 1 entries.
+};
+
+// ========================== Common Helper Functions ==========================
+
+static void *GenericPointerShift(const void *p, int64_t n) {
+    return (void *)((char *)p + n);
+}
+
+static int64_t Int64Min(int64_t a, int64_t b) { return a < b ? a : b; }
+
+static int64_t GetNumBlocks(int64_t size, int64_t block_size) {
+    return (size + block_size - 1) / block_size;
+}
+
+static int64_t GetBlockSize(const Lz4raHeader *header, int64_t i) {
+    return Int64Min(header->block_size,
+                    header->uncompressed_size - i * header->block_size);
+}
+
+// Reads exactly SIZE bytes at OFFSET of FD into BUF without moving the file
+// offset.
+static bool PreadFull(int fd, void *buf, int64_t size, int64_t offset) {
+    while (size > 0) {
+        ssize_t n = pread(fd, buf, (size_t)size, (off_t)offset);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        buf = GenericPointerShift(buf, n);
+        size -= n;
+        offset += n;
+    }
+
+    return true;
+}
+
+// ============================ Lz4raCompressStream ============================
+
+// Compresses SRC_SIZE bytes of SRC into DEST of capacity DEST_CAPACITY and
+// returns the compressed size, or -1 on failure. Stores SRC as is if it cannot
+// be compressed.
+static int CompressBlock(const void *src, int src_size, void *dest,
+                         int dest_capacity, int level) {
+    int size;
+    if (level >= LZ4HC_CLEVEL_MIN) {
+        size = LZ4_compress_HC((const char *)src, (char *)dest, src_size,
+                               dest_capacity, level);
+    } else {
+        int acceleration = level < 0 ? -level : 1;
+        size = LZ4_compress_fast((const char *)src, (char *)dest, src_size,
+                                 dest_capacity, acceleration);
+    }
+    if (size <= 0) return -1;
+    if (size >= src_size) {
+        memcpy(dest, src, src_size);
+        size = src_size;
+    }
+
+    return size;
+}
+
+static int64_t CompressStreamInternal(FILE *f_out, Lz4raHeader *header,
+                                      int64_t *offsets, int level,
+                                      int num_threads, const void *in,
+                                      void *batch, int *batch_sizes,
+                                      int64_t batch_blocks) {
+    int capacity = LZ4_compressBound((int)header->block_size);
+
+    // Leave space for the header and the block index, which are written once
+    // all blocks are compressed.
+    int64_t index_size = (header->num_blocks + 1) * (int64_t)sizeof(int64_t);
+    int64_t pos = (int64_t)sizeof(Lz4raHeader) + index_size;
+    if (fseek(f_out, pos, SEEK_SET) != 0) return -3;
+
+    for (int64_t first = 0; first < header->num_blocks; first += batch_blocks) {
+        int64_t count = Int64Min(batch_blocks, header->num_blocks - first);
+        bool failed = false;
+
+        PRAGMA_OMP_PARALLEL_FOR_NUM_THREADS_REDUCTION(num_threads, ||, failed)
+        for (int64_t i = 0; i < count; ++i) {
+            int64_t block = first + i;
+            batch_sizes[i] = CompressBlock(
+                GenericPointerShift(in, block * header->block_size),
+                (int)GetBlockSize(header, block),
+                GenericPointerShift(batch, i * capacity), capacity, level);
+            if (batch_sizes[i] < 0) failed = true;
+        }
+        if (failed) return -2;
+
+        for (int64_t i = 0; i < count; ++i) {
+            offsets[first + i] = pos;
+            size_t written = fwrite(GenericPointerShift(batch, i * capacity), 1,
+                                    batch_sizes[i], f_out);
+            if (written != (size_t)batch_sizes[i]) return -3;
+            pos += batch_sizes[i];
+        }
+    }
+    offsets[header->num_blocks] = pos;
+
+    if (fseek(f_out, 0, SEEK_SET) != 0) return -3;
+    if (fwrite(header, sizeof(*header), 1, f_out) != 1) return -3;
+    if (fwrite(offsets, index_size, 1, f_out) != 1) return -3;
+
+    return pos;
+}
+
+int64_t Lz4raCompressStream(const char *ofname, int64_t block_size, int level,
+                            int num_threads, const void *in, size_t in_size) {
+    if (block_size <= 0 || block_size > LZ4_MAX_INPUT_SIZE) return -1;
+    if (in == NULL && in_size > 0) return -1;
+    if (num_threads < 1) num_threads = 1;
+
+    Lz4raHeader header = {
+        .block_size = block_size,
+        .uncompressed_size = (int64_t)in_size,
+        .num_blocks = GetNumBlocks((int64_t)in_size, block_size),
+    };
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    int64_t batch_blocks =
+        Int64Min((int64_t)num_threads * kBlocksPerThreadPerBatch,
+                 header.num_blocks);
+    if (batch_blocks < 1) batch_blocks = 1;
+
+    int64_t *offsets =
+        (int64_t *)malloc((header.num_blocks + 1) * sizeof(int64_t));
+    void *batch = malloc(batch_blocks * LZ4_compressBound((int)block_size));
+    int *batch_sizes = (int *)malloc(batch_blocks * sizeof(int));
+    int64_t ret = -2;
+    if (offsets == NULL || batch == NULL || batch_sizes == NULL) goto _bailout;
+
+    FILE *f_out = fopen(ofname, "wb");
+    if (f_out == NULL) {
+        ret = -3;
+        goto _bailout;
+    }
+    ret = CompressStreamInternal(f_out, &header, offsets, level, num_threads,
+                                 in, batch, batch_sizes, batch_blocks);
+    if (fclose(f_out) != 0 && ret >= 0) ret = -3;
+
+_bailout:
+    free(offsets);
+    free(batch);
+    free(batch_sizes);
+    return ret;
+}
+
+// ============================== Lz4raFileOpen ===============================
+
+static bool IsValidFile(const Lz4raFile *file, int64_t file_size) {
+    const Lz4raHeader *header = &file->header;
+    int64_t index_end = (int64_t)sizeof(Lz4raHeader) +
+                        (header->num_blocks + 1) * (int64_t)sizeof(int64_t);
+    if (file->offsets[0] != index_end) return false;
+    if (file->offsets[header->num_blocks] != file_size) return false;
+    for (int64_t i = 0; i < header->num_blocks; ++i) {
+        int64_t size = file->offsets[i + 1] - file->offsets[i];
+        if (size <= 0 || size > GetBlockSize(header, i)) return false;
+    }
+
+    return true;
+}
+
+Lz4raFile *Lz4raFileOpen(const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd == -1) {
+        if (errno != ENOENT) perror("open");
+        return NULL;
+    }
+
+    Lz4raFile *file = (Lz4raFile *)calloc(1, sizeof(Lz4raFile));
+    if (file == NULL) {
+        close(fd);
+        return NULL;
+    }
+    file->fd = fd;
+
+    // Read and validate the header.
+    Lz4raHeader *header = &file->header;
+    if (!PreadFull(fd, header, sizeof(*header), 0) ||
+        memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+        header->block_size <= 0 || header->block_size > LZ4_MAX_INPUT_SIZE ||
+        header->uncompressed_size < 0 ||
+        header->num_blocks !=
+            GetNumBlocks(header->uncompressed_size, header->block_size)) {
+        fprintf(stderr, "Lz4raFileOpen: %s is not a valid LZ4RA file\n",
+                filename);
+        goto _bailout;
+    }
+
+    // Load the block index.
+    int64_t index_size = (header->num_blocks + 1) * (int64_t)sizeof(int64_t);
+    file->offsets = (int64_t *)malloc(index_size);
+    if (file->offsets == NULL) goto _bailout;
+    off_t file_size = lseek(fd, 0, SEEK_END);
+    if (file_size < 0 ||
+        !PreadFull(fd, file->offsets, index_size, sizeof(*header)) ||
+        !IsValidFile(file, (int64_t)file_size)) {
+        fprintf(stderr, "Lz4raFileOpen: %s is corrupt\n", filename);
+        goto _bailout;
+    }
+
+    return file;
+
+_bailout:
+    Lz4raFileClose(file);
+    return NULL;
+}
+
+int Lz4raFileClose(Lz4raFile *file) {
+    if (file == NULL) return 0;
+
+    int ret = close(file->fd);
+    free(file->offsets);
+    free(file);
+
+    return ret == 0 ? 0 : -1;
+}
+
+int64_t Lz4raFileGetSize(const Lz4raFile *file) {
+    return file->header.uncompressed_size;
+}
+
+// ========================== Lz4raFileDecodeBlock ===========================
+
+int Lz4raFileLocateBlock(const Lz4raFile *file, int64_t offset,
+                         Lz4raBlockInfo *info) {
+    if (offset < 0 || offset >= file->header.uncompressed_size) return -1;
+
+    info->number = offset / file->header.block_size;
+    info->uncompressed_offset = info->number * file->header.block_size;
+    info->uncompressed_size = GetBlockSize(&file->header, info->number);
+
+    return 0;
+}
+
+int Lz4raFileDecodeBlock(void *dest, const Lz4raFile *file,
+                         const Lz4raBlockInfo *info) {
+    if (info->number < 0 || info->number >= file->header.num_blocks) return -1;
+
+    int64_t offset = file->offsets[info->number];
+    int compressed_size = (int)(file->offsets[info->number + 1] - offset);
+    int size = (int)GetBlockSize(&file->header, info->number);
+
+    // Uncompressed blocks are read directly into DEST.
+    if (compressed_size == size) {
+        return PreadFull(file->fd, dest, size, offset) ? 0 : -3;
+    }
+
+    void *compressed = malloc(compressed_size);
+    if (compressed == NULL) return -2;
+
+    int ret = -3;
+    if (PreadFull(file->fd, compressed, compressed_size, offset)) {
+        int decompressed_size = LZ4_decompress_safe(
+            (const char *)compressed, (char *)dest, compressed_size, size);
+        if (decompressed_size == size) ret = 0;
+    }
+    free(compressed);
+
+    return ret;
+}
+
+// =========================== Lz4raFileDecompress ============================
+
+int64_t Lz4raFileDecompress(void *dest, size_t size, int num_threads,
+                            const Lz4raFile *file) {
+    const Lz4raHeader *header = &file->header;
+    if (header->uncompressed_size > (int64_t)size) return -4;
+    if (num_threads < 1) num_threads = 1;
+
+    // All error codes are negative. Keep the smallest one so that the result
+    // does not depend on the order in which the threads fail.
+    int ret = 0;
+    PRAGMA_OMP_PARALLEL_FOR_NUM_THREADS_REDUCTION(num_threads, min, ret)
+    for (int64_t i = 0; i < header->num_blocks; ++i) {
+        Lz4raBlockInfo info = {
+            .number = i,
+            .uncompressed_offset = i * header->block_size,
+            .uncompressed_size = GetBlockSize(header, i),
+        };
+        int error = Lz4raFileDecodeBlock(
+            GenericPointerShift(dest, info.uncompressed_offset), file, &info);
+        if (error < ret) ret = error;
+    }
+    if (ret != 0) return ret;
+
+    return header->uncompressed_size;
+}
+
+int64_t Lz4raDecompressFile(void *dest, size_t size, int num_threads,
+                            const char *filename) {
+    Lz4raFile *file = Lz4raFileOpen(filename);
+    if (file == NULL) return -1;
+
+    int64_t ret = Lz4raFileDecompress(dest, size, num_threads, file);
+    Lz4raFileClose(file);
+
+    return ret;
+}
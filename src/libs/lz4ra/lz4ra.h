@@ -0,0 +1,186 @@
+/**
+ * @file lz4ra.h
+ * @author Robert Shi (robertyishi@berkeley.edu)
+ * @author GamesCrafters Research Group, UC Berkeley
+ *         Supervised by Dan Garcia <ddgarcia@cs.berkeley.edu>
+ * @brief LZ4 block-indexed files with random access.
+ * @version 1.0.0
+ * @date 2026-10-17
+ *
+ * @copyright This file is part of GAMESMAN, The Finite, Two-person
+ * Perfect-Information Game Generator released under the GPL:
+ *
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GAMESMANONE_LIB_LZ4RA_LZ4RA_H_
+#define GAMESMANONE_LIB_LZ4RA_LZ4RA_H_
+
+#include <stddef.h>  // size_t
+#include <stdint.h>  // int64_t
+
+/**
+ * @brief An LZ4RA file stores a stream as a sequence of independently
+ * LZ4-compressed blocks of a fixed uncompressed size, preceded by a header and
+ * an index of block offsets. Any block can be located in constant time and
+ * decompressed without touching the rest of the file, which makes random
+ * reads take tens of microseconds instead of the milliseconds required to
+ * decode a full XZ block.
+ *
+ * @details File layout:
+ *
+ *     [header][offsets[0], ..., offsets[num_blocks]][block 0][block 1]...
+ *
+ * offsets[i] is the file offset of compressed block i, and offsets[num_blocks]
+ * is the size of the file. Blocks that LZ4 cannot shrink are stored
+ * uncompressed, which is detected by a compressed size equal to the
+ * uncompressed size of the block.
+ */
+
+// ============================== Compression API ==============================
+
+/** @brief Default uncompressed block size of LZ4RA files. */
+extern const int64_t kLz4raDefaultBlockSize;
+
+/**
+ * @brief Compresses \p in_size bytes of \p in into blocks of \p block_size
+ * bytes using \p num_threads threads, and stores the result as file of name
+ * \p ofname. If a file of name \p ofname already exists, it will be
+ * overwritten.
+ *
+ * @param ofname Output file name.
+ * @param block_size Size of each uncompressed block in bytes.
+ * @param level LZ4 compression level. Levels below \c LZ4HC_CLEVEL_MIN use the
+ * fast LZ4 compressor, with negative levels trading compression ratio for
+ * speed. Higher levels use LZ4 HC.
+ * @param num_threads Number of threads to use. Non-positive values are treated
+ * as 1.
+ * @param in Input buffer.
+ * @param in_size Size of the input buffer in bytes.
+ * @return Size of the compressed file on success;
+ * @return -1 if \p block_size is invalid or \p in is \c NULL but \p in_size is
+ * non-zero;
+ * @return -2 on malloc failure or compression error; or
+ * @return -3 if failed to create or write to the output file.
+ */
+int64_t Lz4raCompressStream(const char *ofname, int64_t block_size, int level,
+                            int num_threads, const void *in, size_t in_size);
+
+// ============================= Decompression API =============================
+
+/** @brief Read-only LZ4RA file with random access ability. */
+typedef struct Lz4raFile Lz4raFile;
+
+/** @brief Location of a block within the uncompressed stream of a Lz4raFile. */
+typedef struct Lz4raBlockInfo {
+    /** Zero-based index of the block in the file. */
+    int64_t number;
+
+    /** Uncompressed offset of the first byte of the block. */
+    int64_t uncompressed_offset;
+
+    /** Size of the block in uncompressed bytes. */
+    int64_t uncompressed_size;
+} Lz4raBlockInfo;
+
+/**
+ * @brief Opens a read-only \c Lz4raFile of name \p filename and loads its block
+ * index into memory.
+ *
+ * @param filename Name of the LZ4RA file.
+ * @return Pointer to the opened file, which must be closed using
+ * \c Lz4raFileClose;
+ * @return \c NULL if the file does not exist, cannot be read, or is not a valid
+ * LZ4RA file. No error message is printed if the file does not exist.
+ */
+Lz4raFile *Lz4raFileOpen(const char *filename);
+
+/**
+ * @brief Closes the given \c Lz4raFile. Does nothing if \p file is \c NULL.
+ *
+ * @param file File to close.
+ * @return 0 on success, or
+ * @return -1 on failure.
+ */
+int Lz4raFileClose(Lz4raFile *file);
+
+/** @brief Returns the uncompressed size of \p file in bytes. */
+int64_t Lz4raFileGetSize(const Lz4raFile *file);
+
+/**
+ * @brief Locates the block of \p file that contains the uncompressed byte at
+ * \p offset and stores its location into \p info.
+ *
+ * @param file Target file.
+ * @param offset Uncompressed offset into \p file.
+ * @param info Output parameter for the location of the block.
+ * @return 0 on success, or
+ * @return -1 if \p offset is out of bounds.
+ */
+int Lz4raFileLocateBlock(const Lz4raFile *file, int64_t offset,
+                         Lz4raBlockInfo *info);
+
+/**
+ * @brief Decompresses the block of \p file described by \p info into \p dest,
+ * which is assumed to have at least \p info->uncompressed_size bytes. Blocks
+ * are read using \c pread, so this function may be called concurrently on the
+ * same \p file from multiple threads.
+ *
+ * @param dest Destination buffer.
+ * @param file Source file.
+ * @param info Location of the block as returned by \c Lz4raFileLocateBlock.
+ * @return 0 on success, or
+ * @return -1 if \p info does not describe a block of \p file, or
+ * @return -2 on malloc failure, or
+ * @return -3 if failed to read or decode the block.
+ */
+int Lz4raFileDecodeBlock(void *dest, const Lz4raFile *file,
+                         const Lz4raBlockInfo *info);
+
+/**
+ * @brief Decompresses all blocks of \p file into \p dest using \p num_threads
+ * threads.
+ *
+ * @param dest Destination buffer of size at least \p size bytes.
+ * @param size Size of the destination buffer in bytes.
+ * @param num_threads Number of threads to use. Non-positive values are treated
+ * as 1.
+ * @param file Source file.
+ * @return Number of bytes decompressed on success;
+ * @return -2 on malloc failure;
+ * @return -3 if failed to read or decode a block; or
+ * @return -4 if the uncompressed size of \p file exceeds \p size.
+ */
+int64_t Lz4raFileDecompress(void *dest, size_t size, int num_threads,
+                            const Lz4raFile *file);
+
+/**
+ * @brief Decompresses the LZ4RA file of name \p filename into \p dest using
+ * \p num_threads threads.
+ *
+ * @param dest Destination buffer of size at least \p size bytes.
+ * @param size Size of the destination buffer in bytes.
+ * @param num_threads Number of threads to use. Non-positive values are treated
+ * as 1.
+ * @param filename Name of the input file.
+ * @return Number of bytes decompressed on success;
+ * @return -1 if failed to open file of name \p filename;
+ * @return -2 on malloc failure;
+ * @return -3 if failed to read or decode a block; or
+ * @return -4 if the uncompressed size of the file exceeds \p size.
+ */
+int64_t Lz4raDecompressFile(void *dest, size_t size, int num_threads,
+                            const char *filename);
+
+#endif  // GAMESMANONE_LIB_LZ4RA_LZ4RA_H_
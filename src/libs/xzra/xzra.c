@@ -33,6 +33,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>  // pread
 
 // ========================= Common Helper Functions ==========================
 
@@ -671,17 +672,32 @@ static bool DecodeBlock(uint8_t *out, lzma_block *block,
     return true;
 }
 
-static int XzraDecodeBlock(uint8_t *out, const lzma_index_iter *iter, FILE *f) {
-    // Seek to block.
-    fseek(f, (int64_t)iter->block.compressed_file_offset, SEEK_SET);
+// Reads SIZE bytes at OFFSET of file descriptor FD into BUF without moving the
+// file position, so that multiple threads may read from the same file.
+static bool XzraPreadFull(int fd, void *buf, size_t size, int64_t offset) {
+    uint8_t *dest = (uint8_t *)buf;
+    while (size > 0) {
+        ssize_t count = pread(fd, dest, size, (off_t)offset);
+        if (count <= 0) {
+            if (count < 0 && errno == EINTR) continue;
+            return false;
+        }
+        dest += count;
+        offset += count;
+        size -= (size_t)count;
+    }
+
+    return true;
+}
 
+static int XzraDecodeBlock(uint8_t *out, const lzma_index_iter *iter, FILE *f) {
     // Allocate space for compressed block.
     uint8_t *block_buf = (uint8_t *)malloc(iter->block.total_size);
     if (block_buf == NULL) return 2;
 
     // Read compressed block into buffer.
-    size_t count = fread(block_buf, 1, iter->block.total_size, f);
-    if (count != iter->block.total_size) {
+    if (!XzraPreadFull(fileno(f), block_buf, iter->block.total_size,
+                       (int64_t)iter->block.compressed_file_offset)) {
         free(block_buf);
         return 3;
     }
@@ -821,3 +837,31 @@ size_t XzraFileRead(void *dest, size_t size, XzraFile *file) {
 // ================================ XzraFileEOF ================================
 
 bool XzraFileEOF(const XzraFile *file) { return file->eof; }
+
+int XzraFileLocateBlock(XzraFile *file, int64_t offset, XzraBlockInfo *info) {
+    if (offset < 0) return -1;
+
+    lzma_index_iter iter;
+    if (XzraRetrieveBlock(&iter, file->index, (size_t)offset) != 0) return -1;
+
+    info->number = (int64_t)iter.block.number_in_file - 1;
+    info->uncompressed_offset = (int64_t)iter.block.uncompressed_file_offset;
+    info->uncompressed_size = (int64_t)iter.block.uncompressed_size;
+
+    return 0;
+}
+
+int XzraFileDecodeBlock(void *dest, XzraFile *file, const XzraBlockInfo *info) {
+    lzma_index_iter iter;
+    if (info->uncompressed_offset < 0 ||
+        XzraRetrieveBlock(&iter, file->index,
+                          (size_t)info->uncompressed_offset) != 0 ||
+        (int64_t)iter.block.number_in_file - 1 != info->number) {
+        return -1;
+    }
+
+    int error = XzraDecodeBlock((uint8_t *)dest, &iter, file->file);
+    if (error == 2) return -2;
+
+    return error == 0 ? 0 : -3;
+}
@@ -200,6 +200,18 @@ enum XzraSeekOrigin {
     XZRA_SEEK_CUR = 1, /* Seek from current position.  */
 };
 
+/** @brief Location of a block within the uncompressed stream of an XzraFile. */
+typedef struct XzraBlockInfo {
+    /** Zero-based index of the block in the file. */
+    int64_t number;
+
+    /** Uncompressed offset of the first byte of the block. */
+    int64_t uncompressed_offset;
+
+    /** Size of the block in uncompressed bytes. */
+    int64_t uncompressed_size;
+} XzraBlockInfo;
+
 /**
  * @brief Opens a read-only \c XzraFile of name \p filename.
  *
@@ -273,4 +285,35 @@ size_t XzraFileRead(void *dest, size_t size, XzraFile *file);
  */
 bool XzraFileEOF(const XzraFile *file);
 
+/**
+ * @brief Locates the block of \p file that contains the uncompressed byte at
+ * \p offset and stores its location into \p info.
+ *
+ * @param file Target file.
+ * @param offset Uncompressed offset into \p file.
+ * @param info Output parameter for the location of the block.
+ * @return 0 on success, or
+ * @return -1 if \p offset is out of bounds.
+ */
+int XzraFileLocateBlock(XzraFile *file, int64_t offset, XzraBlockInfo *info);
+
+/**
+ * @brief Decompresses the block of \p file described by \p info into \p dest,
+ * which is assumed to have at least \p info->uncompressed_size bytes. The
+ * internal block buffer and file position of \p file are not affected, which
+ * allows the caller to keep its own cache of decompressed blocks. Blocks are
+ * read using \c pread, so this function and \c XzraFileLocateBlock may be
+ * called concurrently on the same \p file from multiple threads as long as no
+ * other function is called on \p file at the same time.
+ *
+ * @param dest Destination buffer.
+ * @param file Source file.
+ * @param info Location of the block as returned by \c XzraFileLocateBlock.
+ * @return 0 on success, or
+ * @return -1 if \p info does not describe a block of \p file, or
+ * @return -2 on malloc failure, or
+ * @return -3 if failed to read or decode the block.
+ */
+int XzraFileDecodeBlock(void *dest, XzraFile *file, const XzraBlockInfo *info);
+
 #endif  // GAMESMANONE_LIB_XZRA_XZRA_H_